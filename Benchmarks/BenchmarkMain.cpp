@@ -0,0 +1,98 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#if defined(GSIO_BENCHMARK_BUILD)
+
+#include "BenchmarkUtils.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace GS;
+using namespace GS::Benchmark;
+
+namespace
+{
+	struct RegisteredBenchmark
+	{
+		const char* Name;
+		const char* Description;
+		BenchmarkFunc Func;
+	};
+
+	std::vector<RegisteredBenchmark>& get_registered_benchmarks()
+	{
+		static std::vector<RegisteredBenchmark> Benchmarks;
+		return Benchmarks;
+	}
+}
+
+GS::Benchmark::BenchmarkRegistration::BenchmarkRegistration(const char* Name, const char* Description, BenchmarkFunc Func)
+{
+	get_registered_benchmarks().push_back(RegisteredBenchmark{ Name, Description, Func });
+}
+
+
+static void print_usage()
+{
+	printf("usage: gradientspace_io_bench [--list] [--tris N] [--threads N] [--repeat N] [--tmp DIR] [--obj PATH] [--stl PATH] [name-filter ...]\n");
+	printf("  runs every benchmark whose name contains one of the filters (all benchmarks if no filters are given)\n");
+}
+
+int main(int argc, char** argv)
+{
+	BenchmarkContext Context;
+	Context.MaxThreads = std::max((int)std::thread::hardware_concurrency(), 1);
+	bool bListOnly = false;
+	std::vector<std::string> Filters;
+
+	for (int k = 1; k < argc; ++k) {
+		std::string Arg = argv[k];
+		bool bHaveValue = (k + 1 < argc);
+		if (Arg == "--list")
+			bListOnly = true;
+		else if (Arg == "--tris" && bHaveValue)
+			Context.NumTriangles = std::max(atoi(argv[++k]), 8);
+		else if (Arg == "--threads" && bHaveValue)
+			Context.MaxThreads = std::max(atoi(argv[++k]), 1);
+		else if (Arg == "--repeat" && bHaveValue)
+			Context.Repeats = std::max(atoi(argv[++k]), 1);
+		else if (Arg == "--tmp" && bHaveValue)
+			Context.TempDirectory = argv[++k];
+		else if (Arg == "--obj" && bHaveValue)
+			Context.InputOBJ = argv[++k];
+		else if (Arg == "--stl" && bHaveValue)
+			Context.InputSTL = argv[++k];
+		else if (Arg.size() > 0 && Arg[0] == '-') {
+			print_usage();
+			return 1;
+		}
+		else
+			Filters.push_back(Arg);
+	}
+
+	int NumRun = 0;
+	for (const RegisteredBenchmark& Benchmark : get_registered_benchmarks()) {
+		bool bSelected = Filters.empty();
+		for (const std::string& Filter : Filters)
+			bSelected = bSelected || (strstr(Benchmark.Name, Filter.c_str()) != nullptr);
+		if (!bSelected)
+			continue;
+		if (bListOnly) {
+			printf("%-32s %s\n", Benchmark.Name, Benchmark.Description);
+			continue;
+		}
+		printf("%s (%d triangles, best of %d): %s\n", Benchmark.Name, Context.NumTriangles, Context.Repeats, Benchmark.Description);
+		fflush(stdout);
+		Benchmark.Func(Context);
+		NumRun++;
+	}
+	if (!bListOnly && NumRun == 0) {
+		print_usage();
+		return 1;
+	}
+	return 0;
+}
+
+#endif
@@ -0,0 +1,263 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#if defined(GSIO_BENCHMARK_BUILD)
+
+#include "BenchmarkUtils.h"
+#include "MeshIO/OBJWriter.h"
+#include "MeshIO/STLWriter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
+
+using namespace GS;
+
+
+double GS::Benchmark::time_best_of(int Repeats, const std::function<void()>& Func, const std::function<void()>& Setup)
+{
+	double BestTime = 0;
+	for (int k = 0; k < std::max(Repeats, 1); ++k) {
+		if (Setup)
+			Setup();
+		auto StartTime = std::chrono::steady_clock::now();
+		Func();
+		double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+		BestTime = (k == 0) ? Seconds : std::min(BestTime, Seconds);
+	}
+	return BestTime;
+}
+
+
+size_t GS::Benchmark::get_peak_rss_bytes()
+{
+#if defined(__linux__)
+	// getrusage() ru_maxrss is not affected by reset_peak_rss(), but VmHWM is
+	FILE* StatusFile = fopen("/proc/self/status", "r");
+	if (StatusFile != nullptr) {
+		char Line[256];
+		size_t PeakKB = 0;
+		while (fgets(Line, sizeof(Line), StatusFile) != nullptr)
+			if (sscanf(Line, "VmHWM: %zu kB", &PeakKB) == 1)
+				break;
+		fclose(StatusFile);
+		if (PeakKB > 0)
+			return PeakKB * 1024;
+	}
+#endif
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS Counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &Counters, sizeof(Counters)))
+		return (size_t)Counters.PeakWorkingSetSize;
+	return 0;
+#else
+	struct rusage Usage;
+	if (getrusage(RUSAGE_SELF, &Usage) != 0)
+		return 0;
+#ifdef __APPLE__
+	return (size_t)Usage.ru_maxrss;			// bytes on macOS
+#else
+	return (size_t)Usage.ru_maxrss * 1024;	// kilobytes on Linux
+#endif
+#endif
+}
+
+
+bool GS::Benchmark::reset_peak_rss()
+{
+#if defined(__linux__)
+	FILE* ClearRefsFile = fopen("/proc/self/clear_refs", "w");
+	if (ClearRefsFile == nullptr)
+		return false;
+	bool bOK = (fputs("5", ClearRefsFile) >= 0);
+	return (fclose(ClearRefsFile) == 0) && bOK;
+#else
+	return false;
+#endif
+}
+
+
+size_t GS::Benchmark::get_file_size(const std::string& Path)
+{
+	std::error_code ErrorCode;
+	uintmax_t Size = std::filesystem::file_size(Path, ErrorCode);
+	return (ErrorCode) ? 0 : (size_t)Size;
+}
+
+
+bool GS::Benchmark::drop_file_cache(const std::string& Path)
+{
+#if defined(__linux__)
+	int fd = ::open(Path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	::fdatasync(fd);
+	bool bOK = (::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0);
+	::close(fd);
+	return bOK;
+#else
+	(void)Path;
+	return false;
+#endif
+}
+
+
+void GS::Benchmark::print_timing(const std::string& Label, double Seconds, size_t NumBytes)
+{
+	if (NumBytes > 0)
+		printf("  %-48s %9.3f ms  %8.1f MB/s\n", Label.c_str(), Seconds * 1000.0, ((double)NumBytes / (1024.0 * 1024.0)) / std::max(Seconds, 1e-9));
+	else
+		printf("  %-48s %9.3f ms\n", Label.c_str(), Seconds * 1000.0);
+	fflush(stdout);
+}
+
+
+void GS::Benchmark::time_cold_and_warm(const BenchmarkContext& Context, const std::string& Label, const std::string& Path, const std::function<void()>& Read)
+{
+	size_t FileSize = get_file_size(Path);
+	bool bDropped = true;
+	double ColdSeconds = time_best_of(Context.Repeats, Read, [&]() { bDropped = drop_file_cache(Path) && bDropped; });
+	if (bDropped)
+		print_timing(Label + " (cold)", ColdSeconds, FileSize);
+	Read();
+	print_timing(Label + " (warm)", time_best_of(Context.Repeats, Read), FileSize);
+}
+
+
+void GS::Benchmark::measure_mesh_load(const BenchmarkContext& Context, const std::string& Label, size_t FileSize, const std::function<void()>& Load)
+{
+	bool bHavePeak = reset_peak_rss();
+	size_t StartPeak = get_peak_rss_bytes();
+	Load();
+	size_t Peak = get_peak_rss_bytes();
+	double Seconds = time_best_of(Context.Repeats, Load);
+	print_timing(Label, Seconds, FileSize);
+	if (bHavePeak)
+		printf("  %-48s %9.1f MB (%.1f MB above start)\n", (Label + " peak RSS").c_str(), (double)Peak / (1024.0 * 1024.0), (double)(Peak - std::min(Peak, StartPeak)) / (1024.0 * 1024.0));
+	else
+		printf("  %-48s %9.1f MB (process peak, includes test file generation)\n", (Label + " peak RSS").c_str(), (double)Peak / (1024.0 * 1024.0));
+}
+
+
+std::vector<int> GS::Benchmark::get_thread_counts(const BenchmarkContext& Context)
+{
+	std::vector<int> Counts;
+	int MaxThreads = std::max(Context.MaxThreads, 1);
+	for (int k = 1; k < MaxThreads; k *= 2)
+		Counts.push_back(k);
+	Counts.push_back(MaxThreads);
+	return Counts;
+}
+
+
+void GS::Benchmark::make_test_mesh(int NumTriangles, DenseMesh& MeshOut)
+{
+	// NumU x NumV torus grid, 2 triangles per cell. V wraps around with a UV seam
+	int NumV = std::max((int)std::sqrt((double)std::max(NumTriangles, 8) / 8.0), 2);
+	int NumU = std::max(NumTriangles / (2 * NumV), 3);
+	int NumVertices = NumU * NumV;
+	int TriCount = 2 * NumU * NumV;
+	const double R = 10.0, r = 3.0, TwoPi = 6.283185307179586;
+
+	MeshOut.Resize(NumVertices, TriCount);
+	std::vector<Vector3f> Normals(NumVertices);
+	for (int i = 0; i < NumU; ++i) {
+		double u = TwoPi * (double)i / (double)NumU;
+		for (int j = 0; j < NumV; ++j) {
+			double v = TwoPi * (double)j / (double)NumV;
+			double rr = r + 0.2 * std::sin(5 * u) * std::cos(3 * v);
+			MeshOut.SetPosition(i * NumV + j, Vector3d((R + rr * std::cos(v)) * std::cos(u), (R + rr * std::cos(v)) * std::sin(u), rr * std::sin(v)));
+			Normals[i * NumV + j] = Vector3f((float)(std::cos(v) * std::cos(u)), (float)(std::cos(v) * std::sin(u)), (float)std::sin(v));
+		}
+	}
+
+	auto vertex_uv = [&](int i, int j) { return Vector2f((float)i / (float)NumU, (float)j / (float)NumV); };
+	auto vertex_color = [&](int i, int j) { return Color4b((uint8_t)(i * 255 / NumU), (uint8_t)(j * 255 / NumV), 128, 255); };
+
+	int ti = 0;
+	for (int i = 0; i < NumU; ++i) {
+		int i1 = (i + 1) % NumU;
+		for (int j = 0; j < NumV; ++j) {
+			int j1 = (j + 1) % NumV;
+			int a = i * NumV + j, b = i1 * NumV + j, c = i1 * NumV + j1, d = i * NumV + j1;
+			// UVs at the seam use (i+1, NumV) so that the seam vertices get two distinct UVs
+			int CellI[4] = { i, i + 1, i + 1, i };
+			int CellJ[4] = { j, j, j + 1, j + 1 };
+			int Verts[4] = { a, b, c, d };
+			const int TriCorners[2][3] = { {0, 1, 2}, {0, 2, 3} };
+			for (int k = 0; k < 2; ++k) {
+				TriVtxUVs UVs; TriVtxNormals TriNormals; TriVtxColors Colors;
+				Index3i Tri;
+				for (int m = 0; m < 3; ++m) {
+					int Corner = TriCorners[k][m];
+					Tri[m] = Verts[Corner];
+					UVs[m] = vertex_uv(CellI[Corner], CellJ[Corner]);
+					TriNormals[m] = Normals[Verts[Corner]];
+					Colors[m] = vertex_color(CellI[Corner] % NumU, CellJ[Corner] % NumV);
+				}
+				MeshOut.SetTriangle(ti, Tri);
+				MeshOut.SetTriGroup(ti, (i * 4) / NumU);
+				MeshOut.SetTriVtxUVs(ti, UVs);
+				MeshOut.SetTriVtxNormals(ti, TriNormals);
+				MeshOut.SetTriVtxColors(ti, Colors);
+				ti++;
+			}
+		}
+	}
+}
+
+
+std::string GS::Benchmark::get_temp_file_path(const BenchmarkContext& Context, const std::string& Name)
+{
+	std::filesystem::path Dir = (Context.TempDirectory.empty()) ? std::filesystem::temp_directory_path() : std::filesystem::path(Context.TempDirectory);
+	return (Dir / Name).string();
+}
+
+static std::string make_temp_path(const GS::Benchmark::BenchmarkContext& Context, const std::string& Name)
+{
+	return GS::Benchmark::get_temp_file_path(Context, "gsio_bench_" + std::to_string(Context.NumTriangles) + "_" + Name);
+}
+
+std::string GS::Benchmark::get_test_obj_path(const BenchmarkContext& Context)
+{
+	if (!Context.InputOBJ.empty())
+		return Context.InputOBJ;
+	std::string Path = make_temp_path(Context, "mesh.obj");
+	if (get_file_size(Path) == 0) {
+		DenseMesh Mesh;
+		make_test_mesh(Context.NumTriangles, Mesh);
+		auto TextWriter = GS::FileTextWriter::OpenFile(Path);
+		OBJWriter::WriteOptions WriteOptions;
+		WriteOptions.NumThreads = std::max(Context.MaxThreads, 1);
+		if (!TextWriter || !OBJWriter::WriteOBJ(TextWriter, Mesh, WriteOptions))
+			fprintf(stderr, "failed to write test OBJ file %s\n", Path.c_str());
+	}
+	return Path;
+}
+
+std::string GS::Benchmark::get_test_stl_path(const BenchmarkContext& Context, bool bBinary)
+{
+	if (!Context.InputSTL.empty())
+		return Context.InputSTL;
+	std::string Path = make_temp_path(Context, (bBinary) ? "binary.stl" : "ascii.stl");
+	if (get_file_size(Path) == 0) {
+		DenseMesh Mesh;
+		make_test_mesh(Context.NumTriangles, Mesh);
+		if (!STLWriter::WriteSTL(Path, Mesh, "mesh", bBinary))
+			fprintf(stderr, "failed to write test STL file %s\n", Path.c_str());
+	}
+	return Path;
+}
+
+#endif
@@ -0,0 +1,86 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#pragma once
+
+#include "Mesh/DenseMesh.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * Support code for the gradientspace_io_bench executable (see CMakeLists.txt, GSIO_BUILD_BENCHMARKS).
+ * Benchmarks are registered with GSIO_BENCHMARK() and run by name from the command line.
+ */
+namespace GS::Benchmark
+{
+
+struct BenchmarkContext
+{
+	//! triangle count of the generated test mesh
+	int NumTriangles = 2000000;
+	//! benchmarks with a thread count run 1, 2, 4, ... up to MaxThreads
+	int MaxThreads = 1;
+	//! each timing is the best of this many runs
+	int Repeats = 3;
+	//! generated test files are written here
+	std::string TempDirectory;
+	//! if set, used instead of the generated OBJ/STL test files
+	std::string InputOBJ;
+	std::string InputSTL;
+};
+
+using BenchmarkFunc = void(*)(const BenchmarkContext&);
+
+struct BenchmarkRegistration
+{
+	BenchmarkRegistration(const char* Name, const char* Description, BenchmarkFunc Func);
+};
+
+#define GSIO_BENCHMARK(Name, Description) \
+	static void Name(const GS::Benchmark::BenchmarkContext& Context); \
+	static GS::Benchmark::BenchmarkRegistration Name##_Registration(#Name, Description, Name); \
+	static void Name(const GS::Benchmark::BenchmarkContext& Context)
+
+
+//! run Func Repeats times and return the fastest wall-clock time in seconds. Setup (if set) is called before each run and is not timed
+double time_best_of(int Repeats, const std::function<void()>& Func, const std::function<void()>& Setup = nullptr);
+
+//! peak resident set size of the process since start, or since the last successful reset_peak_rss()
+size_t get_peak_rss_bytes();
+
+//! reset the peak resident set size to the current size. Returns false if not supported on this platform (currently Linux only)
+bool reset_peak_rss();
+
+size_t get_file_size(const std::string& Path);
+
+//! evict Path from the OS page cache, so the next read comes from storage. Returns false if not supported on this platform
+bool drop_file_cache(const std::string& Path);
+
+//! print "Label: time, throughput" where throughput is NumBytes/Seconds (omitted if NumBytes is 0)
+void print_timing(const std::string& Label, double Seconds, size_t NumBytes = 0);
+
+//! time Read with Path evicted from the OS file cache before each run (cold, if supported), and with Path cached (warm), and print both
+void time_cold_and_warm(const BenchmarkContext& Context, const std::string& Label, const std::string& Path, const std::function<void()>& Read);
+
+//! run Load once to measure its peak memory (if supported), then time it, and print both. FileSize is used for the throughput
+void measure_mesh_load(const BenchmarkContext& Context, const std::string& Label, size_t FileSize, const std::function<void()>& Load);
+
+//! thread counts 1, 2, 4, ... up to Context.MaxThreads (always including MaxThreads)
+std::vector<int> get_thread_counts(const BenchmarkContext& Context);
+
+/**
+ * Generate a torus with about NumTriangles triangles, with per-vertex-smooth normals,
+ * per-corner UVs (with a seam), vertex colors and 4 triangle groups
+ */
+void make_test_mesh(int NumTriangles, DenseMesh& MeshOut);
+
+//! path of a file called Name in Context.TempDirectory (or the system temp directory)
+std::string get_temp_file_path(const BenchmarkContext& Context, const std::string& Name);
+
+//! the test mesh of Context, written as OBJ (with normals, UVs and vertex colors) to Context.TempDirectory on first use, or Context.InputOBJ
+std::string get_test_obj_path(const BenchmarkContext& Context);
+
+//! the test mesh of Context, written as binary or ASCII STL to Context.TempDirectory on first use, or Context.InputSTL
+std::string get_test_stl_path(const BenchmarkContext& Context, bool bBinary);
+
+}  // end namespace GS::Benchmark
@@ -0,0 +1,66 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#if defined(GSIO_BENCHMARK_BUILD)
+
+#include "BenchmarkUtils.h"
+#include "MeshIO/CompressedMesh.h"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace GS;
+using namespace GS::Benchmark;
+
+
+// size of the DenseMesh arrays filled by DecodeMesh(), used as the "output bytes" of decode throughput
+static size_t get_dense_mesh_bytes(const DenseMesh& Mesh)
+{
+	size_t NumVertices = (size_t)Mesh.GetVertexCount(), NumTriangles = (size_t)Mesh.GetTriangleCount();
+	return NumVertices * sizeof(Vector3d) + NumTriangles * (sizeof(Index3i) + sizeof(int) + sizeof(TriVtxUVs) + sizeof(TriVtxNormals) + sizeof(TriVtxColors));
+}
+
+
+GSIO_BENCHMARK(compressed_mesh, "EncodeMesh size vs binary STL, and Encode/DecodeMesh time (1..N threads), for default and high-precision options")
+{
+	DenseMesh Mesh;
+	make_test_mesh(Context.NumTriangles, Mesh);
+	size_t BinarySTLBytes = 84 + 50 * (size_t)Mesh.GetTriangleCount();
+	size_t OutputBytes = get_dense_mesh_bytes(Mesh);
+	printf("  %d vertices, %d triangles, binary STL %.1f MB, DenseMesh %.1f MB\n", Mesh.GetVertexCount(), Mesh.GetTriangleCount(),
+		(double)BinarySTLBytes / (1024.0 * 1024.0), (double)OutputBytes / (1024.0 * 1024.0));
+
+	struct Variant { const char* Label; int PositionBits; int NormalBits; int UVBits; };
+	const Variant Variants[] = {
+		{ "default (16/10/12 bits)", 16, 10, 12 },
+		{ "high precision (24/16/20 bits)", 24, 16, 20 },
+	};
+	for (const Variant& Variant : Variants)
+	{
+		printf("  %s\n", Variant.Label);
+		CompressedMesh::EncodeOptions EncodeOptions;
+		EncodeOptions.PositionBits = Variant.PositionBits;
+		EncodeOptions.NormalBits = Variant.NormalBits;
+		EncodeOptions.UVBits = Variant.UVBits;
+		EncodeOptions.NumThreads = std::max(Context.MaxThreads, 1);
+		std::vector<uint8_t> Encoded;
+		double Seconds = time_best_of(Context.Repeats, [&]() {
+			if (!CompressedMesh::EncodeMesh(Mesh, Encoded, EncodeOptions))
+				fprintf(stderr, "EncodeMesh failed\n");
+		});
+		print_timing("EncodeMesh " + std::to_string(EncodeOptions.NumThreads) + " threads", Seconds);
+		printf("  %-48s %9.1f MB  %8.1fx smaller than binary STL\n", "encoded size", (double)Encoded.size() / (1024.0 * 1024.0),
+			(double)BinarySTLBytes / (double)std::max(Encoded.size(), (size_t)1));
+
+		for (int NumThreads : get_thread_counts(Context)) {
+			CompressedMesh::DecodeOptions DecodeOptions;
+			DecodeOptions.NumThreads = NumThreads;
+			DenseMesh Decoded;
+			Seconds = time_best_of(Context.Repeats, [&]() {
+				if (!CompressedMesh::DecodeMesh(Encoded.data(), Encoded.size(), Decoded, DecodeOptions))
+					fprintf(stderr, "DecodeMesh failed\n");
+			});
+			print_timing("DecodeMesh " + std::to_string(NumThreads) + " threads (MB/s of output)", Seconds, OutputBytes);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,98 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#if defined(GSIO_BENCHMARK_BUILD)
+
+#include "BenchmarkUtils.h"
+#include "MeshIO/float_parsing.h"
+
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+using namespace GS;
+using namespace GS::Benchmark;
+
+
+// NumLines vertex-coordinate lines "x y z", in the printf Format that OBJ/STL exporters typically write
+static std::string make_coordinate_text(int NumLines, const char* Format)
+{
+	std::mt19937 Random(31337);
+	std::uniform_real_distribution<double> Distribution(-1000.0, 1000.0);
+	std::string Text;
+	Text.reserve((size_t)NumLines * 40);
+	char Line[128];
+	for (int k = 0; k < NumLines; ++k) {
+		int Length = snprintf(Line, sizeof(Line), Format, Distribution(Random), Distribution(Random), Distribution(Random));
+		Text.append(Line, (size_t)Length);
+	}
+	return Text;
+}
+
+template<typename ParseFunc>
+static void time_line_parser(const BenchmarkContext& Context, const std::string& Label, const std::string& Text, ParseFunc Parse)
+{
+	double Checksum = 0;
+	double Seconds = time_best_of(Context.Repeats, [&]() {
+		Checksum = 0;
+		const char* Cur = Text.data();
+		const char* End = Cur + Text.size();
+		while (Cur < End) {
+			double Values[3] = { 0,0,0 };
+			Cur = Parse(Cur, End, Values);
+			Checksum += Values[0] + Values[1] + Values[2];
+			while (Cur < End && *Cur == '\n')
+				Cur++;
+		}
+	});
+	print_timing(Label + " (checksum " + std::to_string(Checksum) + ")", Seconds, Text.size());
+}
+
+static void run_float_parsing_benchmark(const BenchmarkContext& Context, const char* Format)
+{
+	std::string Text = make_coordinate_text(Context.NumTriangles, Format);
+
+	time_line_parser(Context, "parse_real_list", Text, [](const char* Cur, const char* End, double* Values) {
+		const char* LineEnd = (const char*)memchr(Cur, '\n', (size_t)(End - Cur));
+		LineEnd = (LineEnd) ? LineEnd : End;
+		parse_real_list(Cur, LineEnd, Values, 3);
+		return LineEnd;
+	});
+	time_line_parser(Context, "parse_real", Text, [](const char* Cur, const char* End, double* Values) {
+		for (int j = 0; j < 3; ++j) {
+			Cur = parse_real(Cur, End, Values[j]);
+			while (Cur < End && *Cur == ' ')
+				Cur++;
+		}
+		return Cur;
+	});
+	time_line_parser(Context, "std::strtod", Text, [](const char* Cur, const char* /*End*/, double* Values) {
+		char* Next = const_cast<char*>(Cur);
+		for (int j = 0; j < 3; ++j)
+			Values[j] = std::strtod(Next, &Next);
+		return (const char*)Next;
+	});
+#if defined(__cpp_lib_to_chars)
+	time_line_parser(Context, "std::from_chars", Text, [](const char* Cur, const char* End, double* Values) {
+		for (int j = 0; j < 3; ++j) {
+			Cur = std::from_chars(Cur, End, Values[j]).ptr;
+			while (Cur < End && *Cur == ' ')
+				Cur++;
+		}
+		return Cur;
+	});
+#endif
+}
+
+
+GSIO_BENCHMARK(float_parse_fixed, "parse 3 numbers per line, %f format, vs strtod and from_chars")
+{
+	run_float_parsing_benchmark(Context, "%f %f %f\n");
+}
+
+GSIO_BENCHMARK(float_parse_roundtrip, "parse 3 numbers per line, 17 significant digits, vs strtod and from_chars")
+{
+	run_float_parsing_benchmark(Context, "%.17g %.17g %.17g\n");
+}
+
+#endif
@@ -0,0 +1,53 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#if defined(GSIO_BENCHMARK_BUILD)
+
+#include "BenchmarkUtils.h"
+#include "MeshIO/GLBWriter.h"
+#include "MeshIO/OBJWriter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+using namespace GS;
+using namespace GS::Benchmark;
+
+
+GSIO_BENCHMARK(glb_write, "WriteGLB (buffered/mapped) vs WriteOBJ, time and file size for 1..N threads")
+{
+	DenseMesh Mesh;
+	make_test_mesh(Context.NumTriangles, Mesh);
+	std::string GLBPath = get_temp_file_path(Context, "gsio_bench_write.glb");
+	std::string OBJPath = get_temp_file_path(Context, "gsio_bench_write.obj");
+
+	for (int NumThreads : get_thread_counts(Context)) {
+		OBJWriter::WriteOptions OBJOptions;
+		OBJOptions.NumThreads = NumThreads;
+		double Seconds = time_best_of(Context.Repeats, [&]() {
+			auto TextWriter = GS::FileTextWriter::OpenFile(OBJPath);
+			if (!TextWriter || !OBJWriter::WriteOBJ(TextWriter, Mesh, OBJOptions))
+				fprintf(stderr, "WriteOBJ failed on %s\n", OBJPath.c_str());
+		});
+		print_timing("WriteOBJ " + std::to_string(NumThreads) + " threads", Seconds, get_file_size(OBJPath));
+
+		for (bool bMapped : { false, true }) {
+			GLBWriter::WriteOptions GLBOptions;
+			GLBOptions.NumThreads = NumThreads;
+			GLBOptions.bUseMemoryMappedIO = bMapped;
+			Seconds = time_best_of(Context.Repeats, [&]() {
+				if (!GLBWriter::WriteGLB(GLBPath, Mesh, GLBOptions))
+					fprintf(stderr, "WriteGLB failed on %s\n", GLBPath.c_str());
+			});
+			print_timing(std::string("WriteGLB ") + ((bMapped) ? "mapped" : "buffered") + ", " + std::to_string(NumThreads) + " threads", Seconds, get_file_size(GLBPath));
+		}
+	}
+
+	size_t OBJSize = get_file_size(OBJPath), GLBSize = get_file_size(GLBPath);
+	printf("  %-48s %9.1f MB\n", "OBJ size", (double)OBJSize / (1024.0 * 1024.0));
+	printf("  %-48s %9.1f MB  %8.1fx smaller than OBJ\n", "GLB size", (double)GLBSize / (1024.0 * 1024.0),
+		(double)OBJSize / (double)std::max(GLBSize, (size_t)1));
+	std::filesystem::remove(GLBPath);
+	std::filesystem::remove(OBJPath);
+}
+
+#endif
@@ -0,0 +1,83 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#if defined(GSIO_BENCHMARK_BUILD)
+
+#include "BenchmarkUtils.h"
+#include "MeshIO/BinaryMeshCache.h"
+#include "MeshIO/OBJReader.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+using namespace GS;
+using namespace GS::Benchmark;
+
+
+GSIO_BENCHMARK(mesh_cache_load_obj, "ReadCacheFile(OBJFormatData) (mapped/buffered, with/without checksums) vs ReadOBJ, on cold- and warm-cache files")
+{
+	std::string OBJPath = get_test_obj_path(Context);
+	std::string CachePath = get_temp_file_path(Context, "gsio_bench_obj.gsmcache");
+	if (!drop_file_cache(OBJPath))
+		printf("  file cache cannot be dropped on this platform, only warm-cache timings are reported\n");
+
+	OBJReader::ReadOptions OBJOptions;
+	OBJOptions.NumThreads = std::max(Context.MaxThreads, 1);
+	time_cold_and_warm(Context, "ReadOBJ " + std::to_string(OBJOptions.NumThreads) + " threads", OBJPath, [&]() {
+		OBJFormatData OBJData;
+		if (!OBJReader::ReadOBJ(OBJPath, OBJData, OBJOptions))
+			fprintf(stderr, "ReadOBJ failed on %s\n", OBJPath.c_str());
+	});
+
+	{
+		OBJFormatData OBJData;
+		if (!OBJReader::ReadOBJ(OBJPath, OBJData, OBJOptions) || !BinaryMeshCache::WriteCacheFile(CachePath, OBJData))
+			fprintf(stderr, "failed to write cache file %s\n", CachePath.c_str());
+	}
+	printf("  OBJ %.1f MB, cache %.1f MB\n", (double)get_file_size(OBJPath) / (1024.0 * 1024.0), (double)get_file_size(CachePath) / (1024.0 * 1024.0));
+
+	for (bool bMapped : { true, false }) {
+		for (bool bVerify : { false, true }) {
+			BinaryMeshCache::ReadOptions Options;
+			Options.bUseMemoryMappedIO = bMapped;
+			Options.bVerifyChecksums = bVerify;
+			std::string Label = std::string("ReadCacheFile ") + ((bMapped) ? "mapped" : "buffered") + ((bVerify) ? " + checksums" : "");
+			time_cold_and_warm(Context, Label, CachePath, [&]() {
+				OBJFormatData OBJData;
+				if (!BinaryMeshCache::ReadCacheFile(CachePath, OBJData, Options))
+					fprintf(stderr, "ReadCacheFile failed on %s\n", CachePath.c_str());
+			});
+		}
+	}
+	std::filesystem::remove(CachePath);
+}
+
+
+GSIO_BENCHMARK(mesh_cache_load_dense_mesh, "ReadCacheFile(DenseMesh) vs ReadOBJToDenseMesh, on cold- and warm-cache files")
+{
+	std::string OBJPath = get_test_obj_path(Context);
+	std::string CachePath = get_temp_file_path(Context, "gsio_bench_mesh.gsmcache");
+	if (!drop_file_cache(OBJPath))
+		printf("  file cache cannot be dropped on this platform, only warm-cache timings are reported\n");
+
+	OBJReader::ReadOptions OBJOptions;
+	OBJOptions.NumThreads = std::max(Context.MaxThreads, 1);
+	time_cold_and_warm(Context, "ReadOBJToDenseMesh " + std::to_string(OBJOptions.NumThreads) + " threads", OBJPath, [&]() {
+		DenseMesh Mesh;
+		if (!OBJReader::ReadOBJToDenseMesh(OBJPath, Mesh, OBJOptions))
+			fprintf(stderr, "ReadOBJToDenseMesh failed on %s\n", OBJPath.c_str());
+	});
+
+	{
+		DenseMesh Mesh;
+		if (!OBJReader::ReadOBJToDenseMesh(OBJPath, Mesh, OBJOptions) || !BinaryMeshCache::WriteCacheFile(CachePath, Mesh))
+			fprintf(stderr, "failed to write cache file %s\n", CachePath.c_str());
+	}
+	time_cold_and_warm(Context, "ReadCacheFile mapped", CachePath, [&]() {
+		DenseMesh Mesh;
+		if (!BinaryMeshCache::ReadCacheFile(CachePath, Mesh))
+			fprintf(stderr, "ReadCacheFile failed on %s\n", CachePath.c_str());
+	});
+	std::filesystem::remove(CachePath);
+}
+
+#endif
@@ -0,0 +1,37 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#if defined(GSIO_BENCHMARK_BUILD)
+
+#include "BenchmarkUtils.h"
+#include "MeshIO/OBJReader.h"
+
+#include <cstdio>
+
+using namespace GS;
+using namespace GS::Benchmark;
+
+
+GSIO_BENCHMARK(obj_load_dense_mesh, "OBJ to DenseMesh: ReadOBJ + OBJFormatDataToDenseMesh vs fused ReadOBJToDenseMesh, time and peak RSS")
+{
+	std::string Path = get_test_obj_path(Context);
+	size_t FileSize = get_file_size(Path);
+	OBJReader::ReadOptions Options;
+	Options.NumThreads = Context.MaxThreads;
+
+	int NumTriangles = 0;
+	measure_mesh_load(Context, "ReadOBJ + OBJFormatDataToDenseMesh", FileSize, [&]() {
+		DenseMesh Mesh;
+		OBJFormatData OBJData;
+		OBJReader::ReadOBJ(Path, OBJData, Options);
+		OBJFormatDataToDenseMesh(OBJData, Mesh);
+		NumTriangles = Mesh.GetTriangleCount();
+	});
+	measure_mesh_load(Context, "ReadOBJToDenseMesh", FileSize, [&]() {
+		DenseMesh Mesh;
+		if (!OBJReader::ReadOBJToDenseMesh(Path, Mesh, Options))
+			fprintf(stderr, "ReadOBJToDenseMesh failed on %s\n", Path.c_str());
+		if (Mesh.GetTriangleCount() != NumTriangles)
+			fprintf(stderr, "ReadOBJToDenseMesh triangle count %d does not match two-step load %d\n", Mesh.GetTriangleCount(), NumTriangles);
+	});
+}
+
+#endif
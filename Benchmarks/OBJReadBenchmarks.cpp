@@ -0,0 +1,76 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#if defined(GSIO_BENCHMARK_BUILD)
+
+#include "BenchmarkUtils.h"
+#include "MeshIO/OBJReader.h"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace GS;
+using namespace GS::Benchmark;
+
+
+GSIO_BENCHMARK(obj_read_scaling, "ReadOBJ wall time for 1..N threads (chunked parse + deterministic merge)")
+{
+	std::string Path = get_test_obj_path(Context);
+	size_t FileSize = get_file_size(Path);
+	size_t NumFaces = 0;
+	for (int NumThreads : get_thread_counts(Context)) {
+		OBJReader::ReadOptions Options;
+		Options.NumThreads = NumThreads;
+		double Seconds = time_best_of(Context.Repeats, [&]() {
+			OBJFormatData OBJData;
+			if (!OBJReader::ReadOBJ(Path, OBJData, Options))
+				fprintf(stderr, "ReadOBJ failed on %s\n", Path.c_str());
+			NumFaces = OBJData.FaceStream.size();
+		});
+		print_timing("ReadOBJ " + std::to_string(NumThreads) + " threads", Seconds, FileSize);
+	}
+	printf("  %zu faces\n", NumFaces);
+}
+
+
+// bytes of the arrays of OBJData, ie the memory the parsed file keeps after ReadOBJ returns
+static size_t get_obj_data_bytes(const OBJFormatData& OBJData)
+{
+	return OBJData.VertexPositions.size() * sizeof(Vector3d) + OBJData.VertexColors.size() * sizeof(Vector3f)
+		+ OBJData.Normals.size() * sizeof(Vector3d) + OBJData.UVs.size() * sizeof(Vector2d)
+		+ (OBJData.Triangles.Positions.size() + OBJData.Triangles.Normals.size() + OBJData.Triangles.UVs.size()) * sizeof(Index3i)
+		+ (OBJData.Quads.Positions.size() + OBJData.Quads.Normals.size() + OBJData.Quads.UVs.size()) * sizeof(Index4i)
+		+ OBJData.Polygons.Offsets.size() * sizeof(int64_t)
+		+ (OBJData.Polygons.Positions.size() + OBJData.Polygons.Normals.size() + OBJData.Polygons.UVs.size()) * sizeof(int)
+		+ OBJData.FaceStream.size() * sizeof(OBJFace);
+}
+
+
+GSIO_BENCHMARK(obj_read_attributes, "ReadOBJ with ReadOptions attribute flags (all, no colors, no normals, no UVs, positions only), time, peak RSS and stored size")
+{
+	std::string Path = get_test_obj_path(Context);
+	size_t FileSize = get_file_size(Path);
+	struct Variant { const char* Label; bool bVertexColors; bool bNormals; bool bUVs; };
+	const Variant Variants[] = {
+		{ "all attributes", true, true, true },
+		{ "no vertex colors", false, true, true },
+		{ "no normals", true, false, true },
+		{ "no UVs", true, true, false },
+		{ "positions only", false, false, false },
+	};
+	for (const Variant& Variant : Variants) {
+		OBJReader::ReadOptions Options;
+		Options.NumThreads = std::max(Context.MaxThreads, 1);
+		Options.bVertexColors = Variant.bVertexColors;
+		Options.bNormals = Variant.bNormals;
+		Options.bUVs = Variant.bUVs;
+		size_t StoredBytes = 0;
+		measure_mesh_load(Context, std::string("ReadOBJ ") + Variant.Label, FileSize, [&]() {
+			OBJFormatData OBJData;
+			if (!OBJReader::ReadOBJ(Path, OBJData, Options))
+				fprintf(stderr, "ReadOBJ failed on %s\n", Path.c_str());
+			StoredBytes = get_obj_data_bytes(OBJData);
+		});
+		printf("  %-48s %9.1f MB\n", (std::string("ReadOBJ ") + Variant.Label + " stored").c_str(), (double)StoredBytes / (1024.0 * 1024.0));
+	}
+}
+
+#endif
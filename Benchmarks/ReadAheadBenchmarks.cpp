@@ -0,0 +1,61 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#if defined(GSIO_BENCHMARK_BUILD)
+
+#include "BenchmarkUtils.h"
+#include "MeshIO/OBJReader.h"
+#include "MeshIO/STLReader.h"
+
+#include <cstdio>
+
+using namespace GS;
+using namespace GS::Benchmark;
+
+
+GSIO_BENCHMARK(obj_read_cold_cache, "ReadOBJ with memory-mapped, buffered and async read-ahead I/O, on cold- and warm-cache files")
+{
+	std::string Path = get_test_obj_path(Context);
+	if (!drop_file_cache(Path))
+		printf("  file cache cannot be dropped on this platform, only warm-cache timings are reported\n");
+
+	struct Variant { const char* Label; bool bMapped; bool bReadAhead; size_t BlockSize; int QueueDepth; };
+	const Variant Variants[] = {
+		{ "memory-mapped", true, false, 0, 0 },
+		{ "buffered read", false, false, 0, 0 },
+		{ "read-ahead 4MB x 3", false, true, 4 << 20, 3 },
+		{ "read-ahead 16MB x 4", false, true, 16 << 20, 4 },
+	};
+	for (const Variant& Variant : Variants) {
+		OBJReader::ReadOptions Options;
+		Options.bUseMemoryMappedIO = Variant.bMapped;
+		Options.bUseAsyncReadAhead = Variant.bReadAhead;
+		if (Variant.bReadAhead) {
+			Options.ReadAheadBlockSize = Variant.BlockSize;
+			Options.ReadAheadQueueDepth = Variant.QueueDepth;
+		}
+		time_cold_and_warm(Context, std::string("ReadOBJ ") + Variant.Label, Path, [&]() {
+			OBJFormatData OBJData;
+			if (!OBJReader::ReadOBJ(Path, OBJData, Options))
+				fprintf(stderr, "ReadOBJ failed on %s\n", Path.c_str());
+		});
+	}
+}
+
+
+GSIO_BENCHMARK(stl_ascii_read_cold_cache, "single-threaded ASCII ReadSTL with and without async read-ahead, on cold- and warm-cache files")
+{
+	std::string Path = get_test_stl_path(Context, false);
+	if (!drop_file_cache(Path))
+		printf("  file cache cannot be dropped on this platform, only warm-cache timings are reported\n");
+
+	for (bool bReadAhead : { false, true }) {
+		STLReader::ReadOptions Options;
+		Options.bUseAsyncReadAhead = bReadAhead;
+		time_cold_and_warm(Context, (bReadAhead) ? "ReadSTL read-ahead 4MB x 3" : "ReadSTL memory-mapped", Path, [&]() {
+			STLReader::STLMeshData STLMesh;
+			if (!STLReader::ReadSTL(Path, STLMesh, Options))
+				fprintf(stderr, "ReadSTL failed on %s\n", Path.c_str());
+		});
+	}
+}
+
+#endif
@@ -0,0 +1,110 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#if defined(GSIO_BENCHMARK_BUILD)
+
+#include "BenchmarkUtils.h"
+#include "MeshIO/STLReader.h"
+
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace GS;
+using namespace GS::Benchmark;
+using namespace GS::STLReader;
+
+
+/**
+ * Reference ASCII STL reader with the structure of the original line-based ReadSTL_Ascii:
+ * one line at a time through a stdio line reader, each token copied into a separate buffer,
+ * keywords compared with strncmp, and each float dispatched into the triangle through a switch.
+ */
+static bool read_stl_ascii_line_based(const std::string& Path, STLMeshData& STLMeshOut)
+{
+	FILE* File = fopen(Path.c_str(), "r");
+	if (File == nullptr)
+		return false;
+	constexpr int MaxTokenSize = 64;
+	char LineBuffer[4096];
+	char Token[MaxTokenSize];
+	STLTriangle CurTriangle;
+	int NumFloats = 0;
+	bool bOK = true;
+	while (bOK && fgets(LineBuffer, sizeof(LineBuffer), File) != nullptr)
+	{
+		const char* Cur = LineBuffer;
+		bool bFirstToken = true;
+		bool bFloatLine = false;
+		while (true)
+		{
+			while (*Cur == ' ' || *Cur == '\t')
+				Cur++;
+			if (*Cur == '\0' || *Cur == '\r' || *Cur == '\n')
+				break;
+			int TokenLength = 0;
+			while (*Cur != '\0' && *Cur != ' ' && *Cur != '\t' && *Cur != '\r' && *Cur != '\n' && TokenLength < MaxTokenSize-1)
+				Token[TokenLength++] = *Cur++;
+			Token[TokenLength] = '\0';
+
+			if (bFloatLine) {
+				float Value = 0;
+				if (std::from_chars(Token, Token + TokenLength, Value).ec != std::errc()) {
+					bOK = false;
+					break;
+				}
+				switch (NumFloats++ % 12) {
+				case 0: CurTriangle.Normal.X = Value; break;
+				case 1: CurTriangle.Normal.Y = Value; break;
+				case 2: CurTriangle.Normal.Z = Value; break;
+				case 3: CurTriangle.Vertex1.X = Value; break;
+				case 4: CurTriangle.Vertex1.Y = Value; break;
+				case 5: CurTriangle.Vertex1.Z = Value; break;
+				case 6: CurTriangle.Vertex2.X = Value; break;
+				case 7: CurTriangle.Vertex2.Y = Value; break;
+				case 8: CurTriangle.Vertex2.Z = Value; break;
+				case 9: CurTriangle.Vertex3.X = Value; break;
+				case 10: CurTriangle.Vertex3.Y = Value; break;
+				default: CurTriangle.Vertex3.Z = Value; break;
+				}
+			}
+			else if (strncmp(Token, "normal", MaxTokenSize) == 0 || strncmp(Token, "vertex", MaxTokenSize) == 0) {
+				bFloatLine = true;
+			}
+			else if (bFirstToken && strncmp(Token, "endfacet", MaxTokenSize) == 0) {
+				STLMeshOut.Triangles.push_back(CurTriangle);
+				CurTriangle = STLTriangle();
+			}
+			bFirstToken = false;
+		}
+	}
+	fclose(File);
+	return bOK;
+}
+
+
+GSIO_BENCHMARK(stl_ascii_read, "ASCII ReadSTL single-pass scanner (1..N threads) vs a line-based reference reader")
+{
+	std::string Path = get_test_stl_path(Context, false);
+	size_t FileSize = get_file_size(Path);
+
+	size_t NumReferenceTriangles = 0;
+	double Seconds = time_best_of(Context.Repeats, [&]() {
+		STLMeshData STLMesh;
+		read_stl_ascii_line_based(Path, STLMesh);
+		NumReferenceTriangles = STLMesh.Triangles.size();
+	});
+	print_timing("line-based reference", Seconds, FileSize);
+
+	for (int NumThreads : get_thread_counts(Context)) {
+		STLReader::ReadOptions Options;
+		Options.NumThreads = NumThreads;
+		Seconds = time_best_of(Context.Repeats, [&]() {
+			STLMeshData STLMesh;
+			if (!STLReader::ReadSTL(Path, STLMesh, Options) || STLMesh.Triangles.size() != NumReferenceTriangles)
+				fprintf(stderr, "ReadSTL failed or triangle count does not match reference reader on %s\n", Path.c_str());
+		});
+		print_timing("ReadSTL " + std::to_string(NumThreads) + " threads", Seconds, FileSize);
+	}
+}
+
+#endif
@@ -0,0 +1,48 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#if defined(GSIO_BENCHMARK_BUILD)
+
+#include "BenchmarkUtils.h"
+#include "MeshIO/STLReader.h"
+
+#include <cstdio>
+
+using namespace GS;
+using namespace GS::Benchmark;
+using namespace GS::STLReader;
+
+
+GSIO_BENCHMARK(stl_weld, "STLMeshToDenseMesh triangle soup vs exact and tolerance vertex welding, 1..N threads (use --tris 10000000 for large files)")
+{
+	std::string Path = get_test_stl_path(Context, true);
+	STLMeshData STLMesh;
+	if (!STLReader::ReadSTL(Path, STLMesh)) {
+		fprintf(stderr, "ReadSTL failed on %s\n", Path.c_str());
+		return;
+	}
+
+	int NumVertices = 0;
+	double Seconds = time_best_of(Context.Repeats, [&]() {
+		DenseMesh Mesh;
+		STLMeshToDenseMesh(STLMesh, Mesh);
+		NumVertices = Mesh.GetVertexCount();
+	});
+	print_timing("no welding, " + std::to_string(NumVertices) + " vertices", Seconds);
+
+	for (double Tolerance : { 0.0, 1e-4 }) {
+		for (int NumThreads : get_thread_counts(Context)) {
+			STLToDenseMeshOptions Options;
+			Options.bWeldVertices = true;
+			Options.WeldTolerance = Tolerance;
+			Options.NumThreads = NumThreads;
+			Seconds = time_best_of(Context.Repeats, [&]() {
+				DenseMesh Mesh;
+				STLMeshToDenseMesh(STLMesh, Mesh, Options);
+				NumVertices = Mesh.GetVertexCount();
+			});
+			std::string Label = (Tolerance > 0) ? "tolerance 1e-4 weld, " : "exact weld, ";
+			print_timing(Label + std::to_string(NumThreads) + " threads, " + std::to_string(NumVertices) + " vertices", Seconds);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,109 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#if defined(GSIO_BENCHMARK_BUILD)
+
+#include "BenchmarkUtils.h"
+#include "MeshIO/number_formatting.h"
+#include "MeshIO/OBJWriter.h"
+#include "MeshIO/STLWriter.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+
+using namespace GS;
+using namespace GS::Benchmark;
+using namespace GS::NumberFormatting;
+
+
+//! ITextWriter that only counts the characters and lines it is given, so formatting can be timed without file I/O
+class CountingTextWriter : public ITextWriter
+{
+public:
+	size_t NumChars = 0;
+	size_t NumLines = 0;
+	virtual bool WriteToken(const char* Token) override { NumChars += strlen(Token); return true; }
+	virtual bool WriteLine(const char* Line) override { NumChars += strlen(Line) + 1; NumLines++; return true; }
+	virtual bool WriteEndOfLine() override { NumChars++; NumLines++; return true; }
+};
+
+
+GSIO_BENCHMARK(text_format_reals, "format 'v x y z' lines with TextFormatBuffer (each precision mode) vs snprintf(\"%f\")")
+{
+	std::mt19937 Random(31337);
+	std::uniform_real_distribution<double> Distribution(-1000.0, 1000.0);
+	std::vector<Vector3d> Positions((size_t)Context.NumTriangles);
+	for (Vector3d& Position : Positions)
+		Position = Vector3d(Distribution(Random), Distribution(Random), Distribution(Random));
+
+	CountingTextWriter Writer;
+	double Seconds = time_best_of(Context.Repeats, [&]() {
+		Writer = CountingTextWriter();
+		char LineBuffer[1024];
+		for (const Vector3d& Position : Positions) {
+			snprintf(LineBuffer, sizeof(LineBuffer), "v %f %f %f", Position.X, Position.Y, Position.Z);
+			Writer.WriteLine(LineBuffer);
+		}
+	});
+	print_timing("snprintf %f + WriteLine", Seconds, Writer.NumChars);
+
+	const std::pair<const char*, ERealPrecisionMode> Modes[] = {
+		{ "fixed 6 digits", ERealPrecisionMode::FixedDigits },
+		{ "shortest round-trip", ERealPrecisionMode::ShortestRoundTrip },
+		{ "float32", ERealPrecisionMode::Float32 } };
+	for (const auto& Mode : Modes) {
+		RealFormatOptions RealFormat;
+		RealFormat.Mode = Mode.second;
+		Seconds = time_best_of(Context.Repeats, [&]() {
+			Writer = CountingTextWriter();
+			TextFormatBuffer Output(RealFormat);
+			for (const Vector3d& Position : Positions) {
+				Output.AppendChar('v');
+				Output.AppendReals(&Position.X, 3);
+				Output.AppendEndOfLine();
+				Output.FlushIfFull(Writer);
+			}
+			Output.Flush(Writer);
+		});
+		print_timing(std::string("TextFormatBuffer ") + Mode.first, Seconds, Writer.NumChars);
+	}
+}
+
+
+GSIO_BENCHMARK(text_format_writers, "WriteOBJ(DenseMesh) and ASCII WriteSTL to a file, for each precision mode and 1..N threads")
+{
+	DenseMesh Mesh;
+	make_test_mesh(Context.NumTriangles, Mesh);
+	std::string OBJPath = get_temp_file_path(Context, "gsio_bench_write.obj");
+	std::string STLPath = get_temp_file_path(Context, "gsio_bench_write.stl");
+
+	const std::pair<const char*, ERealPrecisionMode> Modes[] = {
+		{ "fixed 6 digits", ERealPrecisionMode::FixedDigits },
+		{ "shortest round-trip", ERealPrecisionMode::ShortestRoundTrip } };
+	for (const auto& Mode : Modes) {
+		for (int NumThreads : get_thread_counts(Context)) {
+			OBJWriter::WriteOptions Options;
+			Options.RealFormat.Mode = Mode.second;
+			Options.NumThreads = NumThreads;
+			double Seconds = time_best_of(Context.Repeats, [&]() {
+				auto TextWriter = GS::FileTextWriter::OpenFile(OBJPath);
+				if (!TextWriter || !OBJWriter::WriteOBJ(TextWriter, Mesh, Options))
+					fprintf(stderr, "WriteOBJ failed on %s\n", OBJPath.c_str());
+			});
+			print_timing(std::string("WriteOBJ ") + Mode.first + ", " + std::to_string(NumThreads) + " threads", Seconds, get_file_size(OBJPath));
+		}
+
+		RealFormatOptions RealFormat;
+		RealFormat.Mode = Mode.second;
+		double Seconds = time_best_of(Context.Repeats, [&]() {
+			auto TextWriter = GS::FileTextWriter::OpenFile(STLPath);
+			if (!TextWriter || !STLWriter::WriteSTL(TextWriter, Mesh, "mesh", RealFormat))
+				fprintf(stderr, "WriteSTL failed on %s\n", STLPath.c_str());
+		});
+		print_timing(std::string("ASCII WriteSTL ") + Mode.first, Seconds, get_file_size(STLPath));
+	}
+	std::filesystem::remove(OBJPath);
+	std::filesystem::remove(STLPath);
+}
+
+#endif
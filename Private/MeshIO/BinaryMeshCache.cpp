@@ -0,0 +1,633 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#include "MeshIO/BinaryMeshCache.h"
+#include "MeshIO/MappedFileBuffer.h"
+#include "MeshIO/MappedFileWriter.h"
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+using namespace GS;
+using namespace GS::BinaryMeshCache;
+
+
+static_assert(sizeof(FileHeader) == 64, "BinaryMeshCache FileHeader layout");
+static_assert(sizeof(SectionEntry) == 32, "BinaryMeshCache SectionEntry layout");
+static_assert(sizeof(PackedFace) == 8, "BinaryMeshCache PackedFace layout");
+
+// OBJFormatData arrays are stored with a direct copy of their memory
+static_assert(sizeof(Vector3d) == 24 && sizeof(Vector3f) == 12 && sizeof(Vector2d) == 16, "BinaryMeshCache requires packed vector types");
+static_assert(sizeof(Index3i) == 12 && sizeof(Index4i) == 16, "BinaryMeshCache requires packed index types");
+
+static constexpr char CacheFileMagic[8] = { 'G', 'S', 'M', 'C', 'A', 'C', 'H', 'E' };
+static constexpr uint32_t CacheByteOrderMark = 0x01020304;
+
+
+static uint64_t rotate_left(uint64_t Value, int Bits)
+{
+	return (Value << Bits) | (Value >> (64 - Bits));
+}
+
+/**
+ * 64-bit checksum of a section. Four independent multiply-rotate lanes over 8-byte words, so it runs
+ * at close to memory bandwidth. This only detects corruption/truncation, it is not a cryptographic hash.
+ */
+static uint64_t compute_section_checksum(const char* Data, size_t NumBytes)
+{
+	const uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+	const uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+	uint64_t Lanes[4] = { Prime1, Prime2, ~Prime1, ~Prime2 };
+
+	size_t Offset = 0;
+	for (; Offset + 32 <= NumBytes; Offset += 32)
+	{
+		for (int k = 0; k < 4; ++k)
+		{
+			uint64_t Word;
+			memcpy(&Word, Data + Offset + 8*k, 8);
+			Lanes[k] = rotate_left(Lanes[k] + Word * Prime2, 31) * Prime1;
+		}
+	}
+
+	uint64_t Hash = (uint64_t)NumBytes * Prime1;
+	for (int k = 0; k < 4; ++k)
+		Hash = rotate_left(Hash ^ (rotate_left(Lanes[k], 7*k + 1) * Prime2), 27) * Prime1;
+	for (; Offset < NumBytes; ++Offset)
+		Hash = rotate_left(Hash ^ ((uint64_t)(uint8_t)Data[Offset] * Prime2), 23) * Prime1;
+
+	Hash ^= Hash >> 29;
+	return Hash * Prime2 ^ (Hash >> 32);
+}
+
+static size_t align_offset(size_t Offset)
+{
+	return (Offset + SectionAlignment - 1) & ~(SectionAlignment - 1);
+}
+
+
+
+// section to be written, either pointing at caller-owned memory or at packed Storage
+struct PendingSection
+{
+	ESection Section;
+	uint32_t ElementSize = 0;
+	size_t ElementCount = 0;
+	const void* Data = nullptr;
+	std::vector<char> Storage;
+
+	size_t NumBytes() const { return (size_t)ElementSize * ElementCount; }
+};
+
+/**
+ * Collects the sections of a cache file, and then lays them out and writes them.
+ * Empty sections are not written, readers treat missing sections as empty.
+ */
+class CacheFileBuilder
+{
+public:
+	std::vector<PendingSection> Sections;
+
+	template<typename ElementType>
+	void AddArray(ESection Section, const ElementType* Data, size_t Count)
+	{
+		if (Count == 0)
+			return;
+		PendingSection& New = Sections.emplace_back();
+		New.Section = Section;
+		New.ElementSize = (uint32_t)sizeof(ElementType);
+		New.ElementCount = Count;
+		New.Data = Data;
+	}
+
+	template<typename ElementType>
+	void AddArray(ESection Section, const unsafe_vector<ElementType>& Values)
+	{
+		if (Values.size() > 0)
+			AddArray(Section, &Values[0], Values.size());
+	}
+
+	//! add a section with (zero-initialized) owned storage, and return the storage to be filled
+	char* AddPacked(ESection Section, uint32_t ElementSize, size_t Count)
+	{
+		if (Count == 0)
+			return nullptr;
+		PendingSection& New = Sections.emplace_back();
+		New.Section = Section;
+		New.ElementSize = ElementSize;
+		New.ElementCount = Count;
+		New.Storage.resize((size_t)ElementSize * Count, 0);
+		New.Data = New.Storage.data();
+		return New.Storage.data();
+	}
+
+	/**
+	 * add a string table section: uint64 Count, uint64 Offsets[Count+1], then the characters of
+	 * all strings. String i is the characters [Offsets[i], Offsets[i+1]) of the character block.
+	 */
+	template<typename GetStringFunc>
+	void AddStrings(ESection Section, size_t Count, GetStringFunc GetString)
+	{
+		if (Count == 0)
+			return;
+		std::vector<uint64_t> Offsets(Count + 1, 0);
+		for (size_t k = 0; k < Count; ++k)
+			Offsets[k+1] = Offsets[k] + GetString(k).size();
+		size_t TableBytes = sizeof(uint64_t) * (Count + 2);
+		char* Dest = AddPacked(Section, 1, TableBytes + (size_t)Offsets[Count]);
+		uint64_t Count64 = (uint64_t)Count;
+		memcpy(Dest, &Count64, sizeof(uint64_t));
+		memcpy(Dest + sizeof(uint64_t), Offsets.data(), sizeof(uint64_t) * (Count + 1));
+		for (size_t k = 0; k < Count; ++k) {
+			const std::string& String = GetString(k);
+			if (String.size() > 0)
+				memcpy(Dest + TableBytes + Offsets[k], String.data(), String.size());
+		}
+	}
+
+	bool Write(const std::string& Path, EContentType ContentType, const WriteOptions& Options)
+	{
+		size_t NumSections = Sections.size();
+		std::vector<char> Prefix(sizeof(FileHeader) + NumSections * sizeof(SectionEntry), 0);
+		FileHeader* Header = reinterpret_cast<FileHeader*>(Prefix.data());
+		SectionEntry* Entries = reinterpret_cast<SectionEntry*>(Prefix.data() + sizeof(FileHeader));
+
+		size_t Offset = align_offset(Prefix.size());
+		size_t FileSize = Prefix.size();
+		for (size_t k = 0; k < NumSections; ++k)
+		{
+			const PendingSection& Section = Sections[k];
+			Entries[k].SectionID = (uint32_t)Section.Section;
+			Entries[k].ElementSize = Section.ElementSize;
+			Entries[k].ElementCount = (uint64_t)Section.ElementCount;
+			Entries[k].Offset = (uint64_t)Offset;
+			Entries[k].Checksum = (Options.bWriteChecksums) ?
+				compute_section_checksum((const char*)Section.Data, Section.NumBytes()) : 0;
+			FileSize = Offset + Section.NumBytes();
+			Offset = align_offset(FileSize);
+		}
+
+		memcpy(Header->Magic, CacheFileMagic, 8);
+		Header->Version = FormatVersion;
+		Header->ContentType = (uint32_t)ContentType;
+		Header->ByteOrderMark = CacheByteOrderMark;
+		Header->NumSections = (uint32_t)NumSections;
+		Header->Flags = (Options.bWriteChecksums) ? FileHeader::FlagChecksums : 0;
+		Header->SectionTableOffset = sizeof(FileHeader);
+		Header->FileSize = (uint64_t)FileSize;
+
+		MappedFileWriter Writer;
+		if (!Writer.Open(Path, FileSize, Options.bUseMemoryMappedIO))
+			return false;
+
+		if (Writer.IsMapped())
+		{
+			// preallocated file contents are zero, so padding does not need to be written
+			char* Dest = Writer.Data();
+			memcpy(Dest, Prefix.data(), Prefix.size());
+			for (size_t k = 0; k < NumSections; ++k)
+				memcpy(Dest + Entries[k].Offset, Sections[k].Data, Sections[k].NumBytes());
+			return Writer.Close();
+		}
+
+		const char Padding[SectionAlignment] = {};
+		bool bWritesOK = Writer.WriteBytes(Prefix.data(), Prefix.size());
+		size_t WrittenBytes = Prefix.size();
+		for (size_t k = 0; k < NumSections && bWritesOK; ++k)
+		{
+			bWritesOK = bWritesOK && Writer.WriteBytes(Padding, (size_t)Entries[k].Offset - WrittenBytes);
+			bWritesOK = bWritesOK && Writer.WriteBytes(Sections[k].Data, Sections[k].NumBytes());
+			WrittenBytes = (size_t)Entries[k].Offset + Sections[k].NumBytes();
+		}
+		return Writer.Close() && bWritesOK;
+	}
+};
+
+
+
+bool GS::BinaryMeshCache::WriteCacheFile(const std::string& Path, const OBJFormatData& OBJData, const WriteOptions& Options)
+{
+	CacheFileBuilder Builder;
+	Builder.AddStrings(ESection::HeaderComments, OBJData.HeaderComments.size(), [&](size_t k) -> const std::string& { return OBJData.HeaderComments[k]; });
+	Builder.AddArray(ESection::VertexPositions, OBJData.VertexPositions);
+	Builder.AddArray(ESection::VertexColors, OBJData.VertexColors);
+	Builder.AddArray(ESection::Normals, OBJData.Normals);
+	Builder.AddArray(ESection::UVs, OBJData.UVs);
+	Builder.AddArray(ESection::TrianglePositions, OBJData.Triangles.Positions);
+	Builder.AddArray(ESection::TriangleNormals, OBJData.Triangles.Normals);
+	Builder.AddArray(ESection::TriangleUVs, OBJData.Triangles.UVs);
+	Builder.AddArray(ESection::QuadPositions, OBJData.Quads.Positions);
+	Builder.AddArray(ESection::QuadNormals, OBJData.Quads.Normals);
+	Builder.AddArray(ESection::QuadUVs, OBJData.Quads.UVs);
+	Builder.AddArray(ESection::PolygonOffsets, OBJData.Polygons.Offsets);
+	Builder.AddArray(ESection::PolygonPositions, OBJData.Polygons.Positions);
+	Builder.AddArray(ESection::PolygonNormals, OBJData.Polygons.Normals);
+	Builder.AddArray(ESection::PolygonUVs, OBJData.Polygons.UVs);
+
+	size_t NumFaces = OBJData.FaceStream.size();
+	PackedFace* Faces = reinterpret_cast<PackedFace*>(Builder.AddPacked(ESection::FaceStream, sizeof(PackedFace), NumFaces));
+	for (size_t fid = 0; fid < NumFaces; ++fid)
+	{
+		const OBJFace& Face = OBJData.FaceStream[fid];
+		Faces[fid].TypeAndIndex = (uint32_t)Face.FaceType | ((uint32_t)Face.FaceIndex << 4);
+		Faces[fid].GroupID = Face.GroupID;
+	}
+
+	Builder.AddStrings(ESection::GroupNames, OBJData.Groups.size(), [&](size_t k) -> const std::string& { return OBJData.Groups[k].GroupName; });
+	Builder.AddStrings(ESection::MaterialNames, OBJData.Materials.size(), [&](size_t k) -> const std::string& { return OBJData.Materials[k].MaterialName; });
+
+	return Builder.Write(Path, EContentType::OBJFormatData, Options);
+}
+
+
+bool GS::BinaryMeshCache::WriteCacheFile(const std::string& Path, const STLReader::STLMeshData& STLMesh, const WriteOptions& Options)
+{
+	using namespace GS::STLReader;
+	CacheFileBuilder Builder;
+	Builder.AddArray(ESection::STLHeader, STLMesh.Header.data(), STLMesh.Header.size());
+
+	// copy the fields individually so that struct padding is written as zeros (and the checksum is deterministic)
+	size_t NumTriangles = STLMesh.Triangles.size();
+	char* Dest = Builder.AddPacked(ESection::STLTriangles, sizeof(STLTriangle), NumTriangles);
+	for (size_t k = 0; k < NumTriangles; ++k, Dest += sizeof(STLTriangle))
+	{
+		const STLTriangle& Triangle = STLMesh.Triangles[k];
+		memcpy(Dest + offsetof(STLTriangle, Normal), &Triangle.Normal, sizeof(Vector3f));
+		memcpy(Dest + offsetof(STLTriangle, Vertex1), &Triangle.Vertex1, sizeof(Vector3f));
+		memcpy(Dest + offsetof(STLTriangle, Vertex2), &Triangle.Vertex2, sizeof(Vector3f));
+		memcpy(Dest + offsetof(STLTriangle, Vertex3), &Triangle.Vertex3, sizeof(Vector3f));
+		memcpy(Dest + offsetof(STLTriangle, Attribute), &Triangle.Attribute, sizeof(uint16_t));
+	}
+
+	return Builder.Write(Path, EContentType::STLMeshData, Options);
+}
+
+
+bool GS::BinaryMeshCache::WriteCacheFile(const std::string& Path, const DenseMesh& Mesh, const WriteOptions& Options)
+{
+	CacheFileBuilder Builder;
+	size_t NumVertices = (size_t)Mesh.GetVertexCount();
+	size_t NumTriangles = (size_t)Mesh.GetTriangleCount();
+
+	double* Positions = reinterpret_cast<double*>(Builder.AddPacked(ESection::MeshPositions, 3 * sizeof(double), NumVertices));
+	for (size_t vid = 0; vid < NumVertices; ++vid) {
+		Vector3d Position = Mesh.GetPosition((int)vid);
+		Positions[3*vid] = Position.X; Positions[3*vid+1] = Position.Y; Positions[3*vid+2] = Position.Z;
+	}
+
+	int* Triangles = reinterpret_cast<int*>(Builder.AddPacked(ESection::MeshTriangles, 3 * sizeof(int), NumTriangles));
+	int* Groups = reinterpret_cast<int*>(Builder.AddPacked(ESection::MeshTriGroups, sizeof(int), NumTriangles));
+	float* UVs = reinterpret_cast<float*>(Builder.AddPacked(ESection::MeshTriVtxUVs, 6 * sizeof(float), NumTriangles));
+	float* Normals = reinterpret_cast<float*>(Builder.AddPacked(ESection::MeshTriVtxNormals, 9 * sizeof(float), NumTriangles));
+	uint8_t* Colors = reinterpret_cast<uint8_t*>(Builder.AddPacked(ESection::MeshTriVtxColors, 12, NumTriangles));
+	for (size_t tid = 0; tid < NumTriangles; ++tid)
+	{
+		Index3i Tri = Mesh.GetTriangle((int)tid);
+		TriVtxUVs TriUVs = Mesh.GetTriVtxUVs((int)tid);
+		TriVtxNormals TriNormals = Mesh.GetTriVtxNormals((int)tid);
+		TriVtxColors TriColors = Mesh.GetTriVtxColors((int)tid);
+		Groups[tid] = Mesh.GetTriGroup((int)tid);
+		for (int j = 0; j < 3; ++j)
+		{
+			Triangles[3*tid + j] = Tri[j];
+			UVs[6*tid + 2*j] = TriUVs[j].X; UVs[6*tid + 2*j + 1] = TriUVs[j].Y;
+			Normals[9*tid + 3*j] = TriNormals[j].X; Normals[9*tid + 3*j + 1] = TriNormals[j].Y; Normals[9*tid + 3*j + 2] = TriNormals[j].Z;
+			Colors[12*tid + 4*j] = TriColors[j].R; Colors[12*tid + 4*j + 1] = TriColors[j].G;
+			Colors[12*tid + 4*j + 2] = TriColors[j].B; Colors[12*tid + 4*j + 3] = TriColors[j].A;
+		}
+	}
+
+	return Builder.Write(Path, EContentType::DenseMesh, Options);
+}
+
+
+
+
+GS::BinaryMeshCache::BinaryMeshCacheView::BinaryMeshCacheView()
+{
+}
+
+GS::BinaryMeshCache::BinaryMeshCacheView::~BinaryMeshCacheView()
+{
+	Close();
+}
+
+void GS::BinaryMeshCache::BinaryMeshCacheView::Close()
+{
+	File.reset();
+	FileData = nullptr;
+	Header = nullptr;
+	Sections = nullptr;
+}
+
+bool GS::BinaryMeshCache::BinaryMeshCacheView::Open(const std::string& Path, const ReadOptions& Options)
+{
+	Close();
+	File = std::make_unique<MappedFileBuffer>();
+	if (!File->Open(Path, Options.bUseMemoryMappedIO)) {
+		Close();
+		return false;
+	}
+
+	const char* Data = File->Data();
+	size_t Size = File->Size();
+	const FileHeader* FileHeaderPtr = reinterpret_cast<const FileHeader*>(Data);
+	bool bValid = (Size >= sizeof(FileHeader))
+		&& memcmp(FileHeaderPtr->Magic, CacheFileMagic, 8) == 0
+		&& FileHeaderPtr->Version == FormatVersion
+		&& FileHeaderPtr->ByteOrderMark == CacheByteOrderMark
+		&& FileHeaderPtr->FileSize == (uint64_t)Size
+		&& FileHeaderPtr->SectionTableOffset % alignof(SectionEntry) == 0
+		&& FileHeaderPtr->SectionTableOffset <= Size
+		&& FileHeaderPtr->NumSections <= (Size - FileHeaderPtr->SectionTableOffset) / sizeof(SectionEntry);
+	if (!bValid) {
+		Close();
+		return false;
+	}
+
+	// all sections must be aligned and inside the file, so GetSection() does not need to check them
+	const SectionEntry* Entries = reinterpret_cast<const SectionEntry*>(Data + FileHeaderPtr->SectionTableOffset);
+	for (uint32_t k = 0; k < FileHeaderPtr->NumSections && bValid; ++k)
+	{
+		const SectionEntry& Entry = Entries[k];
+		bValid = (Entry.ElementSize > 0)
+			&& (Entry.Offset % SectionAlignment == 0)
+			&& (Entry.Offset <= Size)
+			&& (Entry.ElementCount <= (Size - Entry.Offset) / Entry.ElementSize);
+	}
+	if (!bValid) {
+		Close();
+		return false;
+	}
+
+	FileData = Data;
+	Header = FileHeaderPtr;
+	Sections = Entries;
+
+	if (Options.bVerifyChecksums && HasChecksums())
+	{
+		for (uint32_t k = 0; k < Header->NumSections; ++k) {
+			if (!VerifySectionChecksum(Sections[k])) {
+				Close();
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+const SectionEntry* GS::BinaryMeshCache::BinaryMeshCacheView::FindSection(ESection Section) const
+{
+	if (Header == nullptr)
+		return nullptr;
+	for (uint32_t k = 0; k < Header->NumSections; ++k)
+		if (Sections[k].SectionID == (uint32_t)Section)
+			return &Sections[k];
+	return nullptr;
+}
+
+bool GS::BinaryMeshCache::BinaryMeshCacheView::VerifySectionChecksum(const SectionEntry& Entry) const
+{
+	if (Header == nullptr || !HasChecksums())
+		return false;
+	return compute_section_checksum(FileData + Entry.Offset, (size_t)(Entry.ElementSize * Entry.ElementCount)) == Entry.Checksum;
+}
+
+
+
+// copy a section into Values. A missing section is empty, a section with a mismatched element size is an error
+template<typename ElementType>
+static bool read_section_array(const BinaryMeshCacheView& View, ESection Section, unsafe_vector<ElementType>& Values)
+{
+	Values.clear();
+	const SectionEntry* Entry = View.FindSection(Section);
+	if (Entry == nullptr)
+		return true;
+	size_t Count = 0;
+	const ElementType* Data = View.GetSection<ElementType>(Section, Count);
+	if (Data == nullptr)
+		return (Entry->ElementCount == 0);
+	Values.resize(Count);
+	memcpy(&Values[0], Data, Count * sizeof(ElementType));
+	return true;
+}
+
+// read a string table section written by CacheFileBuilder::AddStrings(), calling AddString(const char*, size_t) for each string
+template<typename AddStringFunc>
+static bool read_section_strings(const BinaryMeshCacheView& View, ESection Section, AddStringFunc AddString)
+{
+	size_t NumBytes = 0;
+	const char* Data = View.GetSection<char>(Section, NumBytes);
+	if (Data == nullptr)
+		return (View.FindSection(Section) == nullptr);
+	if (NumBytes < 2 * sizeof(uint64_t))
+		return false;
+	uint64_t Count;
+	memcpy(&Count, Data, sizeof(uint64_t));
+	if (Count > NumBytes / sizeof(uint64_t) - 2)
+		return false;
+	size_t TableBytes = sizeof(uint64_t) * ((size_t)Count + 2);
+	const uint64_t* Offsets = reinterpret_cast<const uint64_t*>(Data + sizeof(uint64_t));
+	for (size_t k = 0; k < Count; ++k)
+	{
+		if (Offsets[k] > Offsets[k+1] || Offsets[k+1] > NumBytes - TableBytes)
+			return false;
+		AddString(Data + TableBytes + Offsets[k], (size_t)(Offsets[k+1] - Offsets[k]));
+	}
+	return true;
+}
+
+
+/**
+ * Check the cross-array invariants of OBJFormatData that the section bounds checks do not cover, so that
+ * a corrupt (or hand-crafted) cache file cannot produce out-of-bounds access in code that consumes the data:
+ * per-face attribute arrays are empty or parallel to the position indices, polygon offsets are a valid
+ * CSR table, and each FaceStream entry references an existing face.
+ */
+static bool is_valid_obj_format_data(const OBJFormatData& OBJData)
+{
+	auto IsValidAttribute = [](size_t AttributeSize, size_t NumIndices) { return AttributeSize == 0 || AttributeSize == NumIndices; };
+	const OBJTriangleList& Triangles = OBJData.Triangles;
+	const OBJQuadList& Quads = OBJData.Quads;
+	if (!IsValidAttribute(Triangles.Normals.size(), Triangles.size()) || !IsValidAttribute(Triangles.UVs.size(), Triangles.size())
+		|| !IsValidAttribute(Quads.Normals.size(), Quads.size()) || !IsValidAttribute(Quads.UVs.size(), Quads.size()))
+		return false;
+
+	const OBJPolygonList& Polygons = OBJData.Polygons;
+	size_t NumPolygonIndices = Polygons.Positions.size();
+	if (!IsValidAttribute(Polygons.Normals.size(), NumPolygonIndices) || !IsValidAttribute(Polygons.UVs.size(), NumPolygonIndices))
+		return false;
+	size_t NumOffsets = Polygons.Offsets.size();
+	if (NumOffsets == 0)
+	{
+		if (NumPolygonIndices > 0)
+			return false;
+	}
+	else
+	{
+		if (Polygons.Offsets[0] != 0 || Polygons.Offsets[NumOffsets-1] != (int64_t)NumPolygonIndices)
+			return false;
+		for (size_t k = 1; k < NumOffsets; ++k)
+			if (Polygons.Offsets[k] < Polygons.Offsets[k-1])
+				return false;
+	}
+
+	const size_t NumTypeFaces[3] = { Triangles.size(), Quads.size(), Polygons.size() };
+	size_t NumFaces = OBJData.FaceStream.size();
+	for (size_t fid = 0; fid < NumFaces; ++fid)
+	{
+		const OBJFace& Face = OBJData.FaceStream[fid];
+		if (Face.FaceType > 2 || (size_t)Face.FaceIndex >= NumTypeFaces[Face.FaceType])
+			return false;
+	}
+	return true;
+}
+
+
+bool GS::BinaryMeshCache::ReadCacheFile(const std::string& Path, OBJFormatData& OBJDataOut, const ReadOptions& Options)
+{
+	OBJDataOut = OBJFormatData();
+
+	BinaryMeshCacheView View;
+	if (!View.Open(Path, Options) || View.GetContentType() != EContentType::OBJFormatData)
+		return false;
+
+	bool bOK = read_section_strings(View, ESection::HeaderComments, [&](const char* String, size_t Length) {
+		OBJDataOut.HeaderComments.push_back(std::string(String, Length));
+	});
+	bOK = bOK && read_section_array(View, ESection::VertexPositions, OBJDataOut.VertexPositions);
+	bOK = bOK && read_section_array(View, ESection::VertexColors, OBJDataOut.VertexColors);
+	bOK = bOK && read_section_array(View, ESection::Normals, OBJDataOut.Normals);
+	bOK = bOK && read_section_array(View, ESection::UVs, OBJDataOut.UVs);
+	bOK = bOK && read_section_array(View, ESection::TrianglePositions, OBJDataOut.Triangles.Positions);
+	bOK = bOK && read_section_array(View, ESection::TriangleNormals, OBJDataOut.Triangles.Normals);
+	bOK = bOK && read_section_array(View, ESection::TriangleUVs, OBJDataOut.Triangles.UVs);
+	bOK = bOK && read_section_array(View, ESection::QuadPositions, OBJDataOut.Quads.Positions);
+	bOK = bOK && read_section_array(View, ESection::QuadNormals, OBJDataOut.Quads.Normals);
+	bOK = bOK && read_section_array(View, ESection::QuadUVs, OBJDataOut.Quads.UVs);
+	bOK = bOK && read_section_array(View, ESection::PolygonOffsets, OBJDataOut.Polygons.Offsets);
+	bOK = bOK && read_section_array(View, ESection::PolygonPositions, OBJDataOut.Polygons.Positions);
+	bOK = bOK && read_section_array(View, ESection::PolygonNormals, OBJDataOut.Polygons.Normals);
+	bOK = bOK && read_section_array(View, ESection::PolygonUVs, OBJDataOut.Polygons.UVs);
+
+	size_t NumFaces = 0;
+	const PackedFace* Faces = View.GetSection<PackedFace>(ESection::FaceStream, NumFaces);
+	bOK = bOK && (Faces != nullptr || View.FindSection(ESection::FaceStream) == nullptr);
+	if (bOK && NumFaces > 0)
+	{
+		OBJDataOut.FaceStream.resize(NumFaces);
+		for (size_t fid = 0; fid < NumFaces; ++fid)
+		{
+			OBJFace& Face = OBJDataOut.FaceStream[fid];
+			Face.FaceType = (uint8_t)(Faces[fid].TypeAndIndex & 0xF);
+			Face.FaceIndex = Faces[fid].TypeAndIndex >> 4;
+			Face.GroupID = Faces[fid].GroupID;
+		}
+	}
+
+	bOK = bOK && read_section_strings(View, ESection::GroupNames, [&](const char* String, size_t Length) {
+		OBJGroup Group;
+		Group.GroupName = std::string(String, Length);
+		OBJDataOut.Groups.add(Group);
+	});
+	bOK = bOK && read_section_strings(View, ESection::MaterialNames, [&](const char* String, size_t Length) {
+		OBJMaterial Material;
+		Material.MaterialName = std::string(String, Length);
+		OBJDataOut.Materials.add(Material);
+	});
+
+	bOK = bOK && is_valid_obj_format_data(OBJDataOut);
+	if (!bOK)
+		OBJDataOut = OBJFormatData();
+	return bOK;
+}
+
+
+bool GS::BinaryMeshCache::ReadCacheFile(const std::string& Path, STLReader::STLMeshData& STLMeshOut, const ReadOptions& Options)
+{
+	using namespace GS::STLReader;
+	STLMeshOut = STLMeshData();
+
+	BinaryMeshCacheView View;
+	if (!View.Open(Path, Options) || View.GetContentType() != EContentType::STLMeshData)
+		return false;
+
+	size_t HeaderSize = 0, NumTriangles = 0;
+	const char* Header = View.GetSection<char>(ESection::STLHeader, HeaderSize);
+	const STLTriangle* Triangles = View.GetSection<STLTriangle>(ESection::STLTriangles, NumTriangles);
+	if (Triangles == nullptr && View.FindSection(ESection::STLTriangles) != nullptr)
+		return false;		// STLTriangle layout differs from the writer
+
+	if (HeaderSize > 0)
+		STLMeshOut.Header.assign(Header, Header + HeaderSize);
+	if (NumTriangles > 0)
+		STLMeshOut.Triangles.assign(Triangles, Triangles + NumTriangles);
+	return true;
+}
+
+
+bool GS::BinaryMeshCache::ReadCacheFile(const std::string& Path, DenseMesh& MeshOut, const ReadOptions& Options)
+{
+	BinaryMeshCacheView View;
+	if (!View.Open(Path, Options) || View.GetContentType() != EContentType::DenseMesh)
+		return false;
+
+	struct PackedVector3d { double X, Y, Z; };
+	struct PackedTriVtxUVs { float Values[6]; };
+	struct PackedTriVtxNormals { float Values[9]; };
+	struct PackedTriVtxColors { uint8_t Values[12]; };
+
+	size_t NumVertices = 0, NumTriangles = 0, NumGroups = 0, NumUVs = 0, NumNormals = 0, NumColors = 0;
+	const PackedVector3d* Positions = View.GetSection<PackedVector3d>(ESection::MeshPositions, NumVertices);
+	const Index3i* Triangles = View.GetSection<Index3i>(ESection::MeshTriangles, NumTriangles);
+	const int* Groups = View.GetSection<int>(ESection::MeshTriGroups, NumGroups);
+	const PackedTriVtxUVs* UVs = View.GetSection<PackedTriVtxUVs>(ESection::MeshTriVtxUVs, NumUVs);
+	const PackedTriVtxNormals* Normals = View.GetSection<PackedTriVtxNormals>(ESection::MeshTriVtxNormals, NumNormals);
+	const PackedTriVtxColors* Colors = View.GetSection<PackedTriVtxColors>(ESection::MeshTriVtxColors, NumColors);
+
+	// per-triangle sections must be missing or have one element per triangle
+	auto IsValidTriangleSection = [&](const void* Data, size_t Count) { return Data == nullptr || Count == NumTriangles; };
+	if ((NumVertices > 0 && Positions == nullptr) || (NumTriangles > 0 && Triangles == nullptr)
+		|| !IsValidTriangleSection(Groups, NumGroups) || !IsValidTriangleSection(UVs, NumUVs)
+		|| !IsValidTriangleSection(Normals, NumNormals) || !IsValidTriangleSection(Colors, NumColors))
+		return false;
+
+	// vertex indices must reference existing vertices (the unsigned comparison also rejects negative indices)
+	for (size_t tid = 0; tid < NumTriangles; ++tid)
+	{
+		const Index3i& Tri = Triangles[tid];
+		if ((size_t)(unsigned int)Tri.A >= NumVertices || (size_t)(unsigned int)Tri.B >= NumVertices || (size_t)(unsigned int)Tri.C >= NumVertices)
+			return false;
+	}
+
+	MeshOut.Resize((int)NumVertices, (int)NumTriangles);
+	for (size_t vid = 0; vid < NumVertices; ++vid)
+		MeshOut.SetPosition((int)vid, Vector3d(Positions[vid].X, Positions[vid].Y, Positions[vid].Z));
+
+	for (size_t tid = 0; tid < NumTriangles; ++tid)
+	{
+		MeshOut.SetTriangle((int)tid, Triangles[tid]);
+		if (Groups != nullptr)
+			MeshOut.SetTriGroup((int)tid, Groups[tid]);
+		if (UVs != nullptr) {
+			TriVtxUVs TriUVs;
+			for (int j = 0; j < 3; ++j)
+				TriUVs[j] = Vector2f(UVs[tid].Values[2*j], UVs[tid].Values[2*j+1]);
+			MeshOut.SetTriVtxUVs((int)tid, TriUVs);
+		}
+		if (Normals != nullptr) {
+			TriVtxNormals TriNormals;
+			for (int j = 0; j < 3; ++j)
+				TriNormals[j] = Vector3f(Normals[tid].Values[3*j], Normals[tid].Values[3*j+1], Normals[tid].Values[3*j+2]);
+			MeshOut.SetTriVtxNormals((int)tid, TriNormals);
+		}
+		if (Colors != nullptr) {
+			TriVtxColors TriColors;
+			for (int j = 0; j < 3; ++j) {
+				TriColors[j].R = Colors[tid].Values[4*j]; TriColors[j].G = Colors[tid].Values[4*j+1];
+				TriColors[j].B = Colors[tid].Values[4*j+2]; TriColors[j].A = Colors[tid].Values[4*j+3];
+			}
+			MeshOut.SetTriVtxColors((int)tid, TriColors);
+		}
+	}
+	return true;
+}
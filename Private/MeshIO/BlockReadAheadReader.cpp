@@ -0,0 +1,139 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#include "MeshIO/BlockReadAheadReader.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable:4996) // disable secure-crt warnings for this file
+#endif
+
+using namespace GS;
+
+
+BlockReadAheadReader::~BlockReadAheadReader()
+{
+	Close();
+}
+
+
+bool BlockReadAheadReader::Open(const std::string& Path, size_t BlockSizeIn, int QueueDepth)
+{
+	Close();
+
+	FilePtr = fopen(Path.c_str(), "rb");
+	if (!FilePtr)
+		return false;
+	// blocks are read directly into our buffers, so stdio buffering would just add a copy
+	setvbuf(FilePtr, nullptr, _IONBF, 0);
+
+	BlockSize = std::max(BlockSizeIn, (size_t)4096);
+	Ring.resize(std::max(QueueDepth, 2));
+	for (Block& RingBlock : Ring)
+		RingBlock.Data.resize(BlockSize);
+
+	NumFilled = ReadIndex = WriteIndex = 0;
+	bReaderDone = bReadError = bStopRequested = false;
+	bHaveCurrentBlock = false;
+
+	ReaderThread = std::thread([this]() { reader_thread_func(); });
+	return true;
+}
+
+
+void BlockReadAheadReader::Close()
+{
+	if (ReaderThread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> Lock(RingLock);
+			bStopRequested = true;
+		}
+		RingSignal.notify_all();
+		ReaderThread.join();
+	}
+	if (FilePtr)
+	{
+		fclose(FilePtr);
+		FilePtr = nullptr;
+	}
+	Ring = std::vector<Block>();
+	bHaveCurrentBlock = false;
+}
+
+
+void BlockReadAheadReader::reader_thread_func()
+{
+	int NumBlocks = (int)Ring.size();
+	bool bDone = false;
+	while (!bDone)
+	{
+		int FillIndex = 0;
+		{
+			std::unique_lock<std::mutex> Lock(RingLock);
+			RingSignal.wait(Lock, [&]() { return NumFilled < NumBlocks || bStopRequested; });
+			if (bStopRequested)
+				break;
+			FillIndex = WriteIndex;
+		}
+
+		// the consumer does not touch blocks that are not filled, so we can read without the lock
+		Block& FillBlock = Ring[FillIndex];
+		FillBlock.Size = fread(FillBlock.Data.data(), 1, BlockSize, FilePtr);
+		bDone = (FillBlock.Size < BlockSize);
+
+		{
+			std::lock_guard<std::mutex> Lock(RingLock);
+			if (FillBlock.Size > 0) {
+				NumFilled++;
+				WriteIndex = (WriteIndex + 1) % NumBlocks;
+			}
+			if (bDone) {
+				bReaderDone = true;
+				bReadError = (ferror(FilePtr) != 0);
+			}
+		}
+		RingSignal.notify_all();
+	}
+}
+
+
+bool BlockReadAheadReader::NextBlock(const char*& BlockDataOut, size_t& BlockSizeOut)
+{
+	BlockDataOut = nullptr;
+	BlockSizeOut = 0;
+	if (Ring.size() == 0)
+		return false;
+
+	std::unique_lock<std::mutex> Lock(RingLock);
+	if (bHaveCurrentBlock)
+	{
+		// release previous block to the reader thread
+		NumFilled--;
+		ReadIndex = (ReadIndex + 1) % (int)Ring.size();
+		bHaveCurrentBlock = false;
+		RingSignal.notify_all();
+	}
+
+	RingSignal.wait(Lock, [&]() { return NumFilled > 0 || bReaderDone; });
+	if (NumFilled == 0)
+		return false;
+
+	bHaveCurrentBlock = true;
+	BlockDataOut = Ring[ReadIndex].Data.data();
+	BlockSizeOut = Ring[ReadIndex].Size;
+	return true;
+}
+
+
+bool BlockReadAheadReader::HasReadError() const
+{
+	std::lock_guard<std::mutex> Lock(RingLock);
+	return bReadError;
+}
+
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
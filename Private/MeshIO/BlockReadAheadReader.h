@@ -0,0 +1,118 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#pragma once
+
+#include "GradientspaceIOPlatform.h"
+
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+
+
+namespace GS
+{
+
+/**
+ * Sequential file reader that reads large blocks on a background thread into a ring of
+ * QueueDepth buffers, while the caller consumes previously-read blocks. This overlaps disk
+ * (or network) I/O with parsing, which matters on slow or cold-cache storage.
+ *
+ * Blocks can be consumed directly with NextBlock(), or as ranges of complete lines with ReadLineRanges().
+ */
+class BlockReadAheadReader
+{
+public:
+	static constexpr size_t DefaultBlockSize = 4 << 20;
+	static constexpr int DefaultQueueDepth = 3;
+
+	BlockReadAheadReader() = default;
+	~BlockReadAheadReader();
+
+	BlockReadAheadReader(const BlockReadAheadReader&) = delete;
+	BlockReadAheadReader& operator=(const BlockReadAheadReader&) = delete;
+
+	//! open file and start reading blocks in the background. QueueDepth is clamped to at least 2.
+	bool Open(const std::string& Path, size_t BlockSize = DefaultBlockSize, int QueueDepth = DefaultQueueDepth);
+	void Close();
+
+	/**
+	 * Wait for the next block of the file. The block stays valid until the next call to NextBlock() or Close().
+	 * Returns false at the end of the file, or if a read error occurred (see HasReadError()).
+	 */
+	bool NextBlock(const char*& BlockDataOut, size_t& BlockSizeOut);
+
+	/**
+	 * Read the rest of the file and pass it to LinesFunc(const char* Start, const char* End) in consecutive
+	 * ranges that only contain complete lines (except at the end of the file). Lines that span a block
+	 * boundary are copied into a temporary buffer. LinesFunc returns false to stop reading.
+	 * Returns false if a read error occurred.
+	 */
+	template<typename LinesFuncType>
+	bool ReadLineRanges(LinesFuncType&& LinesFunc)
+	{
+		std::vector<char> PartialLine;
+		const char* Block = nullptr;
+		size_t BlockSize = 0;
+		bool bContinue = true;
+		while (bContinue && NextBlock(Block, BlockSize))
+		{
+			const char* Cur = Block;
+			const char* BlockEnd = Block + BlockSize;
+			if (PartialLine.size() > 0)
+			{
+				const char* LineEnd = (const char*)memchr(Cur, '\n', BlockSize);
+				if (LineEnd == nullptr) {
+					PartialLine.insert(PartialLine.end(), Cur, BlockEnd);
+					continue;
+				}
+				PartialLine.insert(PartialLine.end(), Cur, LineEnd + 1);
+				bContinue = LinesFunc((const char*)PartialLine.data(), (const char*)PartialLine.data() + PartialLine.size());
+				PartialLine.clear();
+				Cur = LineEnd + 1;
+			}
+
+			// split block after last line end
+			const char* CompleteEnd = BlockEnd;
+			while (CompleteEnd > Cur && CompleteEnd[-1] != '\n')
+				CompleteEnd--;
+			if (bContinue && CompleteEnd > Cur)
+				bContinue = LinesFunc(Cur, CompleteEnd);
+			PartialLine.assign(CompleteEnd, BlockEnd);
+		}
+		if (bContinue && PartialLine.size() > 0)
+			LinesFunc((const char*)PartialLine.data(), (const char*)PartialLine.data() + PartialLine.size());
+		return !HasReadError();
+	}
+
+	bool HasReadError() const;
+
+protected:
+	FILE* FilePtr = nullptr;
+	size_t BlockSize = DefaultBlockSize;
+
+	struct Block
+	{
+		std::vector<char> Data;
+		size_t Size = 0;
+	};
+	std::vector<Block> Ring;
+
+	std::thread ReaderThread;
+	mutable std::mutex RingLock;
+	std::condition_variable RingSignal;
+	int NumFilled = 0;			// number of blocks read but not yet released by the consumer
+	int ReadIndex = 0;			// next block returned to consumer
+	int WriteIndex = 0;			// next block filled by reader thread
+	bool bReaderDone = false;
+	bool bReadError = false;
+	bool bStopRequested = false;
+	bool bHaveCurrentBlock = false;		// consumer is holding block ReadIndex
+
+	void reader_thread_func();
+};
+
+
+}  // end namespace GS
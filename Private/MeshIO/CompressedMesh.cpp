@@ -0,0 +1,943 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#include "MeshIO/CompressedMesh.h"
+#include "MeshIO/parallel_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include <stdio.h>
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable:4996) // disable secure-crt warnings for this file
+#endif
+
+using namespace GS;
+using namespace GS::CompressedMesh;
+
+
+static constexpr char CompressedMeshMagic[4] = { 'G', 'S', 'Q', 'M' };
+static constexpr uint32_t CompressedMeshVersion = 1;
+
+// attribute streams, in file order
+enum class EStream
+{
+	Indices = 0,
+	PositionX = 1,
+	PositionY = 2,
+	PositionZ = 3,
+	NormalU = 4,
+	NormalV = 5,
+	UVU = 6,
+	UVV = 7,
+	Colors = 8,
+	Groups = 9,
+	NumStreams = 10
+};
+static constexpr int NumStreams = (int)EStream::NumStreams;
+
+static constexpr uint8_t FlagColors = 1;
+static constexpr uint8_t FlagGroups = 2;
+
+
+
+//
+// variable-length integers (LEB128) and zigzag mapping of signed deltas
+//
+
+static void append_varint(std::vector<uint8_t>& Out, uint64_t Value)
+{
+	while (Value >= 0x80) {
+		Out.push_back((uint8_t)(Value | 0x80));
+		Value >>= 7;
+	}
+	Out.push_back((uint8_t)Value);
+}
+
+static uint64_t zigzag_encode(int64_t Value)
+{
+	return ((uint64_t)Value << 1) ^ (uint64_t)(Value >> 63);
+}
+
+static int64_t zigzag_decode(uint64_t Value)
+{
+	return (int64_t)(Value >> 1) ^ -(int64_t)(Value & 1);
+}
+
+// length (1-4) of a varint, indexed by the continuation bits of its first 4 bytes, or 0 if it is longer
+static constexpr uint8_t VarintLengthTable[16] = { 1, 2, 1, 3, 1, 2, 1, 4, 1, 2, 1, 3, 1, 2, 1, 0 };
+static constexpr uint32_t VarintValueMasks[5] = { 0, 0x7F, 0x3FFF, 0x1FFFFF, 0xFFFFFFF };
+
+// bounds-checked sequential reader. Reads past the end return 0 and set bError
+struct ByteReader
+{
+	const uint8_t* Ptr = nullptr;
+	const uint8_t* End = nullptr;
+	bool bError = false;
+
+	uint64_t ReadVarint()
+	{
+		// most values of the delta-coded streams are single bytes
+		if (Ptr < End && *Ptr < 0x80)
+			return *Ptr++;
+		// varints of up to 4 bytes (28 bits) are decoded without a per-byte loop: the continuation bits
+		// of the next 4 bytes are gathered into a 4-bit table index (the multiply moves bits 7,15,23,31
+		// to bits 28-31 without carries), and the 7-bit groups are shifted together and masked to length
+		if (End - Ptr >= 4)
+		{
+			uint32_t Word = (uint32_t)Ptr[0] | ((uint32_t)Ptr[1] << 8) | ((uint32_t)Ptr[2] << 16) | ((uint32_t)Ptr[3] << 24);
+			int Length = VarintLengthTable[((Word & 0x80808080u) * 0x00204081u) >> 28];
+			if (Length > 0)
+			{
+				uint32_t Value = (Word & 0x7F) | ((Word >> 1) & 0x3F80) | ((Word >> 2) & 0x1FC000) | ((Word >> 3) & 0xFE00000);
+				Ptr += Length;
+				return Value & VarintValueMasks[Length];
+			}
+		}
+		uint64_t Value = 0;
+		for (int Shift = 0; Shift < 64; Shift += 7)
+		{
+			if (Ptr >= End) {
+				bError = true;
+				return 0;
+			}
+			uint8_t Byte = *Ptr++;
+			Value |= (uint64_t)(Byte & 0x7F) << Shift;
+			if ((Byte & 0x80) == 0)
+				return Value;
+		}
+		bError = true;
+		return 0;
+	}
+
+	int64_t ReadSignedVarint() { return zigzag_decode(ReadVarint()); }
+
+	bool ReadBytes(void* Dest, size_t NumBytes)
+	{
+		if ((size_t)(End - Ptr) < NumBytes) {
+			bError = true;
+			return false;
+		}
+		memcpy(Dest, Ptr, NumBytes);
+		Ptr += NumBytes;
+		return true;
+	}
+
+	template<typename T>
+	T Read()
+	{
+		T Value{};
+		ReadBytes(&Value, sizeof(T));
+		return Value;
+	}
+};
+
+template<typename T>
+static void append_value(std::vector<uint8_t>& Out, const T& Value)
+{
+	const uint8_t* Bytes = (const uint8_t*)&Value;
+	Out.insert(Out.end(), Bytes, Bytes + sizeof(T));
+}
+
+
+
+//
+// order-0 rANS entropy coder with byte-wise renormalization and four interleaved states
+// (after "rans_byte" by F. Giesen). Symbol frequencies are normalized to sum to RansScale.
+//
+
+static constexpr uint32_t RansScaleBits = 12;
+static constexpr uint32_t RansScale = 1u << RansScaleBits;
+static constexpr uint32_t RansLowerBound = 1u << 23;
+static constexpr int RansNumStates = 4;
+
+static void normalize_frequencies(const uint64_t Counts[256], uint64_t Total, uint32_t Freqs[256])
+{
+	int64_t Sum = 0;
+	int MaxSymbol = 0;
+	for (int s = 0; s < 256; ++s)
+	{
+		Freqs[s] = (Counts[s] == 0) ? 0 : std::max((uint32_t)((Counts[s] * RansScale) / Total), 1u);
+		Sum += Freqs[s];
+		if (Counts[s] > Counts[MaxSymbol])
+			MaxSymbol = s;
+	}
+
+	// fix up the rounding error on the most frequent symbol, or if there are too many rare
+	// symbols that were rounded up to 1, take the excess from the symbols that can spare it
+	int64_t Excess = Sum - (int64_t)RansScale;
+	if ((int64_t)Freqs[MaxSymbol] - Excess >= 1)
+	{
+		Freqs[MaxSymbol] = (uint32_t)((int64_t)Freqs[MaxSymbol] - Excess);
+		return;
+	}
+	while (Excess > 0)
+	{
+		for (int s = 0; s < 256 && Excess > 0; ++s) {
+			if (Freqs[s] > 1) {
+				Freqs[s]--;
+				Excess--;
+			}
+		}
+	}
+}
+
+static void rans_encode(const std::vector<uint8_t>& Input, std::vector<uint8_t>& Out)
+{
+	size_t NumSymbols = Input.size();
+	uint64_t Counts[256] = {};
+	for (uint8_t Symbol : Input)
+		Counts[Symbol]++;
+	uint32_t Freqs[256], Starts[256];
+	normalize_frequencies(Counts, NumSymbols, Freqs);
+	uint32_t CumulativeFreq = 0;
+	for (int s = 0; s < 256; ++s) {
+		Starts[s] = CumulativeFreq;
+		CumulativeFreq += Freqs[s];
+	}
+
+	int NumUsedSymbols = 0;
+	for (int s = 0; s < 256; ++s)
+		NumUsedSymbols += (Freqs[s] > 0) ? 1 : 0;
+	append_varint(Out, (uint64_t)NumUsedSymbols);
+	for (int s = 0; s < 256; ++s) {
+		if (Freqs[s] > 0) {
+			Out.push_back((uint8_t)s);
+			append_varint(Out, Freqs[s]);
+		}
+	}
+
+	// symbols are encoded in reverse, and bytes are written backwards from the end of the buffer.
+	// Each symbol emits at most 2 bytes (when its frequency is 1)
+	std::vector<uint8_t> Buffer(2 * NumSymbols + 4 * RansNumStates);
+	uint8_t* Ptr = Buffer.data() + Buffer.size();
+	uint32_t States[RansNumStates] = { RansLowerBound, RansLowerBound, RansLowerBound, RansLowerBound };
+	for (size_t i = NumSymbols; i-- > 0; )
+	{
+		uint32_t& State = States[i % RansNumStates];
+		uint8_t Symbol = Input[i];
+		uint32_t Freq = Freqs[Symbol];
+		uint32_t MaxState = ((RansLowerBound >> RansScaleBits) << 8) * Freq;
+		while (State >= MaxState) {
+			*--Ptr = (uint8_t)(State & 0xFF);
+			State >>= 8;
+		}
+		State = ((State / Freq) << RansScaleBits) + (State % Freq) + Starts[Symbol];
+	}
+	// the decoder reads state 0 first
+	for (int k = RansNumStates - 1; k >= 0; --k) {
+		Ptr -= 4;
+		memcpy(Ptr, &States[k], 4);
+	}
+	Out.insert(Out.end(), Ptr, Buffer.data() + Buffer.size());
+}
+
+static bool rans_decode(ByteReader& Reader, size_t NumSymbols, uint8_t* Output)
+{
+	// per-slot decode table, so each symbol needs a single lookup
+	struct DecodeSlot
+	{
+		uint16_t Freq;
+		uint16_t Bias;		// Slot - Start of the symbol
+		uint8_t Symbol;
+	};
+	bool bSymbolUsed[256] = {};
+	int NumUsedSymbols = (int)Reader.ReadVarint();
+	if (NumUsedSymbols < 1 || NumUsedSymbols > 256)
+		return false;
+	uint32_t CumulativeFreq = 0;
+	std::vector<DecodeSlot> Slots(RansScale);
+	for (int k = 0; k < NumUsedSymbols; ++k)
+	{
+		uint8_t Symbol = Reader.Read<uint8_t>();
+		uint64_t Freq = Reader.ReadVarint();
+		if (Reader.bError || Freq == 0 || Freq > RansScale - CumulativeFreq || bSymbolUsed[Symbol])
+			return false;
+		bSymbolUsed[Symbol] = true;
+		for (uint32_t j = 0; j < (uint32_t)Freq; ++j)
+			Slots[CumulativeFreq + j] = DecodeSlot{ (uint16_t)Freq, (uint16_t)j, Symbol };
+		CumulativeFreq += (uint32_t)Freq;
+	}
+	if (CumulativeFreq != RansScale)
+		return false;
+
+	uint32_t States[RansNumStates];
+	if (!Reader.ReadBytes(States, sizeof(States)))
+		return false;
+	// a valid stream returns all states to their initial value
+	auto IsFinalState = [&]() {
+		return States[0] == RansLowerBound && States[1] == RansLowerBound && States[2] == RansLowerBound && States[3] == RansLowerBound;
+	};
+
+	// a single symbol has frequency RansScale, so encoding it does not change the state
+	if (NumUsedSymbols == 1) {
+		memset(Output, Slots[0].Symbol, NumSymbols);
+		return IsFinalState();
+	}
+
+	const uint8_t* Ptr = Reader.Ptr;
+	const uint8_t* End = Reader.End;
+	const DecodeSlot* SlotTable = Slots.data();
+	auto DecodeSymbol = [&](uint32_t& State, uint8_t& SymbolOut)
+	{
+		const DecodeSlot& Slot = SlotTable[State & (RansScale - 1)];
+		SymbolOut = Slot.Symbol;
+		State = Slot.Freq * (State >> RansScaleBits) + Slot.Bias;
+		while (State < RansLowerBound) {
+			if (Ptr >= End)
+				return false;
+			State = (State << 8) | *Ptr++;
+		}
+		return true;
+	};
+	// the decode of each interleaved state only depends on itself, so they can overlap. The states are
+	// copied to locals, otherwise the byte stores to Output may alias States and force a reload per symbol
+	size_t NumBlocks = NumSymbols / RansNumStates;
+	uint32_t State0 = States[0], State1 = States[1], State2 = States[2], State3 = States[3];
+	for (size_t i = 0; i < NumBlocks; ++i)
+	{
+		uint8_t* BlockOutput = Output + RansNumStates * i;
+		if (!DecodeSymbol(State0, BlockOutput[0]) || !DecodeSymbol(State1, BlockOutput[1])
+			|| !DecodeSymbol(State2, BlockOutput[2]) || !DecodeSymbol(State3, BlockOutput[3]))
+			return false;
+	}
+	States[0] = State0; States[1] = State1; States[2] = State2; States[3] = State3;
+	for (size_t i = NumBlocks * RansNumStates; i < NumSymbols; ++i)
+		if (!DecodeSymbol(States[i % RansNumStates], Output[i]))
+			return false;
+	Reader.Ptr = Ptr;
+	return IsFinalState();
+}
+
+
+// stream container: [uint8 Mode][varint RawSize][varint PayloadSize][payload]. Mode 0 is raw bytes, Mode 1 is rANS
+static void encode_stream(const std::vector<uint8_t>& Raw, std::vector<uint8_t>& Out)
+{
+	std::vector<uint8_t> Payload;
+	if (Raw.size() > 0)
+		rans_encode(Raw, Payload);
+	bool bStoreRaw = (Payload.size() >= Raw.size());
+	Out.push_back(bStoreRaw ? 0 : 1);
+	append_varint(Out, Raw.size());
+	const std::vector<uint8_t>& Stored = (bStoreRaw) ? Raw : Payload;
+	append_varint(Out, Stored.size());
+	Out.insert(Out.end(), Stored.begin(), Stored.end());
+}
+
+struct EncodedStreamView
+{
+	uint8_t Mode = 0;
+	size_t RawSize = 0;
+	const uint8_t* Payload = nullptr;
+	size_t PayloadSize = 0;
+};
+
+static bool decode_stream(const EncodedStreamView& Stream, std::vector<uint8_t>& RawOut)
+{
+	RawOut.resize(Stream.RawSize);
+	if (Stream.Mode == 0)
+	{
+		if (Stream.PayloadSize != Stream.RawSize)
+			return false;
+		if (Stream.RawSize > 0)
+			memcpy(RawOut.data(), Stream.Payload, Stream.RawSize);
+		return true;
+	}
+	ByteReader Reader{ Stream.Payload, Stream.Payload + Stream.PayloadSize };
+	return rans_decode(Reader, Stream.RawSize, RawOut.data()) && Reader.Ptr == Reader.End;
+}
+
+
+
+//
+// quantization
+//
+
+struct QuantizationGrid
+{
+	double Min = 0;
+	double Step = 1;
+
+	//! returns false if the range MaxValue - MinValue is not finite, eg if either bound is inf/NaN
+	bool Initialize(double MinValue, double MaxValue, int Bits)
+	{
+		if (!std::isfinite(MaxValue - MinValue))
+			return false;
+		Min = MinValue;
+		double MaxQuantized = (double)((1ull << Bits) - 1);
+		Step = (MaxValue > MinValue) ? ((MaxValue - MinValue) / MaxQuantized) : 1.0;
+		return true;
+	}
+	int64_t Quantize(double Value, int Bits) const
+	{
+		double Quantized = std::floor((Value - Min) / Step + 0.5);
+		return (int64_t)std::clamp(Quantized, 0.0, (double)((1ull << Bits) - 1));
+	}
+	double Dequantize(int64_t Value) const
+	{
+		return Min + (double)Value * Step;
+	}
+};
+
+// map a unit normal to the [-1,1]^2 octahedral parameterization, and quantize each component to Bits
+static void encode_octahedral(const Vector3f& Normal, int Bits, int64_t& U, int64_t& V)
+{
+	double X = Normal.X, Y = Normal.Y, Z = Normal.Z;
+	double L1 = std::abs(X) + std::abs(Y) + std::abs(Z);
+	if (L1 == 0 || !std::isfinite(L1)) {
+		X = 0; Y = 0; Z = 1; L1 = 1;
+	}
+	X /= L1; Y /= L1; Z /= L1;
+	if (Z < 0) {
+		double FoldX = (1.0 - std::abs(Y)) * ((X >= 0) ? 1.0 : -1.0);
+		double FoldY = (1.0 - std::abs(X)) * ((Y >= 0) ? 1.0 : -1.0);
+		X = FoldX; Y = FoldY;
+	}
+	double MaxQuantized = (double)((1 << Bits) - 1);
+	U = (int64_t)std::floor((X * 0.5 + 0.5) * MaxQuantized + 0.5);
+	V = (int64_t)std::floor((Y * 0.5 + 0.5) * MaxQuantized + 0.5);
+}
+
+// inverse of encode_octahedral(). Scale is 2 / (2^Bits - 1). Single precision is sufficient for the at most 16-bit components
+static Vector3f decode_octahedral(int64_t U, int64_t V, float Scale)
+{
+	float X = (float)U * Scale - 1.0f;
+	float Y = (float)V * Scale - 1.0f;
+	float Z = 1.0f - std::abs(X) - std::abs(Y);
+	if (Z < 0) {
+		float UnfoldX = (1.0f - std::abs(Y)) * ((X >= 0) ? 1.0f : -1.0f);
+		float UnfoldY = (1.0f - std::abs(X)) * ((Y >= 0) ? 1.0f : -1.0f);
+		X = UnfoldX; Y = UnfoldY;
+	}
+	float InvLength = 1.0f / std::sqrt(X*X + Y*Y + Z*Z);
+	return Vector3f(X * InvLength, Y * InvLength, Z * InvLength);
+}
+
+// Per-corner attributes are predicted from the value at the previous corner of the same vertex, which is
+// identical wherever the attribute is shared across the vertex, or from the previous corner at the first use of the vertex.
+// ValueType only needs to hold the quantized values, the narrower int32_t is measurably faster to decode for UVs
+template<int NumComponents, typename ValueType = int64_t>
+struct CornerPredictor
+{
+	std::vector<ValueType> VertexValues;
+	ValueType PrevValues[NumComponents] = {};
+
+	explicit CornerPredictor(int NumVertices) : VertexValues(NumComponents * (size_t)NumVertices, 0) {}
+
+	const ValueType* Predict(int Vertex, bool bFirstUse) const
+	{
+		return (bFirstUse) ? PrevValues : &VertexValues[NumComponents * (size_t)Vertex];
+	}
+	template<typename InputType>
+	void Update(int Vertex, const InputType* Values)
+	{
+		for (int c = 0; c < NumComponents; ++c)
+			PrevValues[c] = VertexValues[NumComponents * (size_t)Vertex + c] = (ValueType)Values[c];
+	}
+};
+
+// Predicted + Delta with wraparound, which is exact for valid streams and has no signed overflow for invalid ones
+template<typename ValueType>
+static ValueType add_prediction(ValueType Predicted, int64_t Delta)
+{
+	using UnsignedType = std::make_unsigned_t<ValueType>;
+	return (ValueType)((UnsignedType)Predicted + (UnsignedType)(uint64_t)Delta);
+}
+
+// byte-wise (ie modulo 256 per byte) addition of two packed RGBA colors
+static uint32_t add_packed_bytes(uint32_t A, uint32_t B)
+{
+	return ((A & 0x7F7F7F7Fu) + (B & 0x7F7F7F7Fu)) ^ ((A ^ B) & 0x80808080u);
+}
+
+// interleave the low 10 bits of Value with two zero bits between each
+static uint32_t spread_morton_bits(uint32_t Value)
+{
+	Value &= 0x3FF;
+	Value = (Value | (Value << 16)) & 0x030000FF;
+	Value = (Value | (Value << 8)) & 0x0300F00F;
+	Value = (Value | (Value << 4)) & 0x030C30C3;
+	Value = (Value | (Value << 2)) & 0x09249249;
+	return Value;
+}
+
+
+
+bool GS::CompressedMesh::EncodeMesh(const DenseMesh& Mesh, std::vector<uint8_t>& EncodedOut, const EncodeOptions& Options)
+{
+	EncodedOut.clear();
+	int PositionBits = Options.PositionBits, NormalBits = Options.NormalBits, UVBits = Options.UVBits;
+	if (PositionBits < 1 || PositionBits > 30 || NormalBits < 0 || NormalBits == 1 || NormalBits > 16 || UVBits < 0 || UVBits > 24)
+		return false;
+
+	int NumThreads = get_num_worker_threads(Options.NumThreads);
+	int NumVertices = Mesh.GetVertexCount();
+	int NumTriangles = Mesh.GetTriangleCount();
+	for (int tid = 0; tid < NumTriangles; ++tid) {
+		Index3i Tri = Mesh.GetTriangle(tid);
+		for (int j = 0; j < 3; ++j)
+			if (Tri[j] < 0 || Tri[j] >= NumVertices)
+				return false;
+	}
+
+	// quantize positions over the bounding box. inf/NaN values cannot be quantized, and are rejected
+	// here (std::min/max would skip NaN), as is a bounding box whose extent overflows
+	double BoundsMin[3] = { 0, 0, 0 }, BoundsMax[3] = { 0, 0, 0 };
+	for (int vid = 0; vid < NumVertices; ++vid)
+	{
+		Vector3d Position = Mesh.GetPosition(vid);
+		for (int k = 0; k < 3; ++k) {
+			if (!std::isfinite(Position[k]))
+				return false;
+			BoundsMin[k] = (vid == 0) ? Position[k] : std::min(BoundsMin[k], Position[k]);
+			BoundsMax[k] = (vid == 0) ? Position[k] : std::max(BoundsMax[k], Position[k]);
+		}
+	}
+	QuantizationGrid PositionGrid[3];
+	for (int k = 0; k < 3; ++k)
+		if (!PositionGrid[k].Initialize(BoundsMin[k], BoundsMax[k], PositionBits))
+			return false;
+
+	// UVs are quantized over their bounds in the same way, which are computed up front so that inf/NaN UVs are rejected before any encoding work
+	QuantizationGrid UVGrid[2];
+	if (UVBits > 0)
+	{
+		double UVMin[2] = { 0, 0 }, UVMax[2] = { 0, 0 };
+		for (int tid = 0; tid < NumTriangles; ++tid)
+		{
+			TriVtxUVs UVs = Mesh.GetTriVtxUVs(tid);
+			for (int j = 0; j < 3; ++j) {
+				double Values[2] = { UVs[j].X, UVs[j].Y };
+				for (int c = 0; c < 2; ++c) {
+					if (!std::isfinite(Values[c]))
+						return false;
+					UVMin[c] = (tid == 0 && j == 0) ? Values[c] : std::min(UVMin[c], Values[c]);
+					UVMax[c] = (tid == 0 && j == 0) ? Values[c] : std::max(UVMax[c], Values[c]);
+				}
+			}
+		}
+		for (int c = 0; c < 2; ++c)
+			UVGrid[c].Initialize(UVMin[c], UVMax[c], UVBits);		// float UVs cannot overflow the range
+	}
+	std::vector<int64_t> QuantizedPositions(3 * (size_t)NumVertices);
+	parallel_for_ranges((size_t)NumVertices, NumThreads, NumThreads, [&](int, size_t Start, size_t End)
+	{
+		for (size_t vid = Start; vid < End; ++vid) {
+			Vector3d Position = Mesh.GetPosition((int)vid);
+			for (int k = 0; k < 3; ++k)
+				QuantizedPositions[3*vid + k] = PositionGrid[k].Quantize(Position[k], PositionBits);
+		}
+	});
+
+	// sort triangles by the Morton code of their quantized centroid
+	std::vector<int> TriangleOrder(NumTriangles);
+	for (int tid = 0; tid < NumTriangles; ++tid)
+		TriangleOrder[tid] = tid;
+	if (Options.bReorderTriangles && NumTriangles > 1)
+	{
+		int MortonShift = std::max(PositionBits - 10, 0);
+		std::vector<std::pair<uint32_t, int>> Keys(NumTriangles);
+		parallel_for_ranges((size_t)NumTriangles, NumThreads, NumThreads, [&](int, size_t Start, size_t End)
+		{
+			for (size_t tid = Start; tid < End; ++tid) {
+				Index3i Tri = Mesh.GetTriangle((int)tid);
+				uint32_t Code = 0;
+				for (int k = 0; k < 3; ++k) {
+					int64_t Centroid = (QuantizedPositions[3*(size_t)Tri.A + k] + QuantizedPositions[3*(size_t)Tri.B + k] + QuantizedPositions[3*(size_t)Tri.C + k]) / 3;
+					Code |= spread_morton_bits((uint32_t)(Centroid >> MortonShift)) << k;
+				}
+				Keys[tid] = { Code, (int)tid };
+			}
+		});
+		parallel_sort(Keys, NumThreads, [](const std::pair<uint32_t, int>& A, const std::pair<uint32_t, int>& B) { return A < B; });
+		for (int k = 0; k < NumTriangles; ++k)
+			TriangleOrder[k] = Keys[k].second;
+	}
+
+	// number vertices in order of first use, so each corner is either the next new vertex, one of the
+	// vertices of the previous triangle, or a back-reference relative to the next new vertex
+	std::vector<int> NewVertexIndex(NumVertices, -1);
+	std::vector<int> VertexOrder;
+	VertexOrder.reserve(NumVertices);
+	std::vector<int> CornerVertices(3 * (size_t)NumTriangles);
+	std::vector<uint8_t> CornerFirstUse(3 * (size_t)NumTriangles);
+	std::vector<uint8_t> Streams[NumStreams];
+	std::vector<uint8_t>& IndexStream = Streams[(int)EStream::Indices];
+	IndexStream.reserve(3 * (size_t)NumTriangles);
+	int PrevTriangle[3] = { -1, -1, -1 };
+	for (int k = 0; k < NumTriangles; ++k)
+	{
+		Index3i Tri = Mesh.GetTriangle(TriangleOrder[k]);
+		for (int j = 0; j < 3; ++j)
+		{
+			int& NewIndex = NewVertexIndex[Tri[j]];
+			size_t Corner = 3 * (size_t)k + j;
+			CornerFirstUse[Corner] = (NewIndex < 0) ? 1 : 0;
+			if (NewIndex < 0) {
+				NewIndex = (int)VertexOrder.size();
+				VertexOrder.push_back(Tri[j]);
+				IndexStream.push_back(0);
+			}
+			else
+			{
+				int PrevCorner = 0;
+				while (PrevCorner < 3 && PrevTriangle[PrevCorner] != NewIndex)
+					PrevCorner++;
+				append_varint(IndexStream, (PrevCorner < 3) ? (uint64_t)(1 + PrevCorner) : (uint64_t)(3 + VertexOrder.size() - NewIndex));
+			}
+			CornerVertices[Corner] = NewIndex;
+		}
+		for (int j = 0; j < 3; ++j)
+			PrevTriangle[j] = CornerVertices[3 * (size_t)k + j];
+	}
+	// unreferenced vertices are kept, after all referenced vertices
+	for (int vid = 0; vid < NumVertices; ++vid)
+		if (NewVertexIndex[vid] < 0)
+			VertexOrder.push_back(vid);
+
+	int64_t PrevPosition[3] = { 0, 0, 0 };
+	for (int vid : VertexOrder)
+	{
+		for (int k = 0; k < 3; ++k) {
+			int64_t Value = QuantizedPositions[3*(size_t)vid + k];
+			append_varint(Streams[(int)EStream::PositionX + k], zigzag_encode(Value - PrevPosition[k]));
+			PrevPosition[k] = Value;
+		}
+	}
+
+	if (NormalBits > 0)
+	{
+		CornerPredictor<2> Predictor(NumVertices);
+		for (int k = 0; k < NumTriangles; ++k)
+		{
+			TriVtxNormals Normals = Mesh.GetTriVtxNormals(TriangleOrder[k]);
+			for (int j = 0; j < 3; ++j) {
+				size_t Corner = 3 * (size_t)k + j;
+				int64_t Octahedral[2];
+				encode_octahedral(Normals[j], NormalBits, Octahedral[0], Octahedral[1]);
+				const int64_t* Predicted = Predictor.Predict(CornerVertices[Corner], CornerFirstUse[Corner]);
+				for (int c = 0; c < 2; ++c)
+					append_varint(Streams[(int)EStream::NormalU + c], zigzag_encode(Octahedral[c] - Predicted[c]));
+				Predictor.Update(CornerVertices[Corner], Octahedral);
+			}
+		}
+	}
+
+	if (UVBits > 0)
+	{
+		CornerPredictor<2, int32_t> Predictor(NumVertices);
+		for (int k = 0; k < NumTriangles; ++k)
+		{
+			TriVtxUVs UVs = Mesh.GetTriVtxUVs(TriangleOrder[k]);
+			for (int j = 0; j < 3; ++j) {
+				size_t Corner = 3 * (size_t)k + j;
+				int64_t Quantized[2] = { UVGrid[0].Quantize(UVs[j].X, UVBits), UVGrid[1].Quantize(UVs[j].Y, UVBits) };
+				const int32_t* Predicted = Predictor.Predict(CornerVertices[Corner], CornerFirstUse[Corner]);
+				for (int c = 0; c < 2; ++c)
+					append_varint(Streams[(int)EStream::UVU + c], zigzag_encode(Quantized[c] - Predicted[c]));
+				Predictor.Update(CornerVertices[Corner], Quantized);
+			}
+		}
+	}
+
+	if (Options.bStoreColors)
+	{
+		// byte-wise deltas, ie modulo 256
+		CornerPredictor<4> Predictor(NumVertices);
+		std::vector<uint8_t>& ColorStream = Streams[(int)EStream::Colors];
+		ColorStream.reserve(12 * (size_t)NumTriangles);
+		for (int k = 0; k < NumTriangles; ++k)
+		{
+			TriVtxColors Colors = Mesh.GetTriVtxColors(TriangleOrder[k]);
+			for (int j = 0; j < 3; ++j) {
+				size_t Corner = 3 * (size_t)k + j;
+				int64_t Values[4] = { Colors[j].R, Colors[j].G, Colors[j].B, Colors[j].A };
+				const int64_t* Predicted = Predictor.Predict(CornerVertices[Corner], CornerFirstUse[Corner]);
+				for (int c = 0; c < 4; ++c)
+					ColorStream.push_back((uint8_t)(Values[c] - Predicted[c]));
+				Predictor.Update(CornerVertices[Corner], Values);
+			}
+		}
+	}
+
+	if (Options.bStoreGroups)
+	{
+		int64_t Prev = 0;
+		for (int k = 0; k < NumTriangles; ++k) {
+			int64_t GroupID = Mesh.GetTriGroup(TriangleOrder[k]);
+			append_varint(Streams[(int)EStream::Groups], zigzag_encode(GroupID - Prev));
+			Prev = GroupID;
+		}
+	}
+
+	// entropy-code the streams independently
+	std::vector<uint8_t> EncodedStreams[NumStreams];
+	parallel_for_blocks(NumStreams, NumThreads, [&](int StreamIndex)
+	{
+		encode_stream(Streams[StreamIndex], EncodedStreams[StreamIndex]);
+	});
+
+	EncodedOut.insert(EncodedOut.end(), CompressedMeshMagic, CompressedMeshMagic + 4);
+	append_value(EncodedOut, CompressedMeshVersion);
+	append_value(EncodedOut, (uint32_t)NumVertices);
+	append_value(EncodedOut, (uint32_t)NumTriangles);
+	EncodedOut.push_back((uint8_t)PositionBits);
+	EncodedOut.push_back((uint8_t)NormalBits);
+	EncodedOut.push_back((uint8_t)UVBits);
+	EncodedOut.push_back((uint8_t)((Options.bStoreColors ? FlagColors : 0) | (Options.bStoreGroups ? FlagGroups : 0)));
+	for (int k = 0; k < 3; ++k) {
+		append_value(EncodedOut, PositionGrid[k].Min);
+		append_value(EncodedOut, PositionGrid[k].Step);
+	}
+	for (int c = 0; c < 2; ++c) {
+		append_value(EncodedOut, UVGrid[c].Min);
+		append_value(EncodedOut, UVGrid[c].Step);
+	}
+	for (int k = 0; k < NumStreams; ++k)
+		EncodedOut.insert(EncodedOut.end(), EncodedStreams[k].begin(), EncodedStreams[k].end());
+	return true;
+}
+
+
+bool GS::CompressedMesh::EncodeMesh(const OBJFormatData& OBJData, std::vector<uint8_t>& EncodedOut, const EncodeOptions& Options)
+{
+	DenseMesh Mesh;
+	OBJToDenseMeshOptions MeshOptions;
+	MeshOptions.NumThreads = Options.NumThreads;
+	OBJFormatDataToDenseMesh(OBJData, Mesh, MeshOptions);
+	return EncodeMesh(Mesh, EncodedOut, Options);
+}
+
+
+
+bool GS::CompressedMesh::DecodeMesh(const uint8_t* Data, size_t NumBytes, DenseMesh& MeshOut, const DecodeOptions& Options)
+{
+	ByteReader Reader{ Data, Data + NumBytes };
+	char Magic[4] = {};
+	Reader.ReadBytes(Magic, 4);
+	uint32_t Version = Reader.Read<uint32_t>();
+	uint32_t NumVertices = Reader.Read<uint32_t>();
+	uint32_t NumTriangles = Reader.Read<uint32_t>();
+	int PositionBits = Reader.Read<uint8_t>();
+	int NormalBits = Reader.Read<uint8_t>();
+	int UVBits = Reader.Read<uint8_t>();
+	uint8_t Flags = Reader.Read<uint8_t>();
+	QuantizationGrid PositionGrid[3], UVGrid[2];
+	for (int k = 0; k < 3; ++k) {
+		PositionGrid[k].Min = Reader.Read<double>();
+		PositionGrid[k].Step = Reader.Read<double>();
+	}
+	for (int c = 0; c < 2; ++c) {
+		UVGrid[c].Min = Reader.Read<double>();
+		UVGrid[c].Step = Reader.Read<double>();
+	}
+	if (Reader.bError || memcmp(Magic, CompressedMeshMagic, 4) != 0 || Version != CompressedMeshVersion
+		|| NumVertices > (uint32_t)INT32_MAX || NumTriangles > (uint32_t)INT32_MAX
+		|| PositionBits < 1 || PositionBits > 30 || NormalBits == 1 || NormalBits > 16 || UVBits > 24)
+		return false;
+
+	// no stream has more than one 64-bit varint per (vertex or triangle corner) and component, so larger sizes can only come from invalid data
+	uint64_t MaxRawStreamSize = 10ull * 4 * (3ull * NumTriangles + NumVertices);
+
+	EncodedStreamView StreamViews[NumStreams];
+	for (int k = 0; k < NumStreams; ++k)
+	{
+		StreamViews[k].Mode = Reader.Read<uint8_t>();
+		uint64_t RawSize = Reader.ReadVarint();
+		uint64_t PayloadSize = Reader.ReadVarint();
+		if (Reader.bError || StreamViews[k].Mode > 1 || RawSize > MaxRawStreamSize || PayloadSize > (uint64_t)(Reader.End - Reader.Ptr))
+			return false;
+		StreamViews[k].RawSize = (size_t)RawSize;
+		StreamViews[k].PayloadSize = (size_t)PayloadSize;
+		StreamViews[k].Payload = Reader.Ptr;
+		Reader.Ptr += StreamViews[k].PayloadSize;
+	}
+
+	// each index, position and per-corner attribute value is at least one byte of its stream, so the
+	// header counts must be consistent with the stream sizes before the streams and mesh are allocated
+	auto RawSize = [&](EStream Stream) { return (uint64_t)StreamViews[(int)Stream].RawSize; };
+	uint64_t NumCorners = 3ull * NumTriangles;
+	bool bStreamSizesValid = RawSize(EStream::Indices) >= NumCorners
+		&& RawSize(EStream::PositionX) >= NumVertices && RawSize(EStream::PositionY) >= NumVertices && RawSize(EStream::PositionZ) >= NumVertices
+		&& (NormalBits == 0 || (RawSize(EStream::NormalU) >= NumCorners && RawSize(EStream::NormalV) >= NumCorners))
+		&& (UVBits == 0 || (RawSize(EStream::UVU) >= NumCorners && RawSize(EStream::UVV) >= NumCorners))
+		&& ((Flags & FlagColors) == 0 || RawSize(EStream::Colors) == 4 * NumCorners)
+		&& ((Flags & FlagGroups) == 0 || RawSize(EStream::Groups) >= NumTriangles);
+	if (!bStreamSizesValid)
+		return false;
+
+	int NumThreads = get_num_worker_threads(Options.NumThreads);
+	std::vector<uint8_t> Streams[NumStreams];
+	bool bStreamValid[NumStreams];
+	parallel_for_blocks(NumStreams, NumThreads, [&](int StreamIndex)
+	{
+		bStreamValid[StreamIndex] = decode_stream(StreamViews[StreamIndex], Streams[StreamIndex]);
+	});
+	for (int k = 0; k < NumStreams; ++k)
+		if (!bStreamValid[k])
+			return false;
+
+	auto MakeStreamReader = [&](EStream Stream) {
+		const std::vector<uint8_t>& Bytes = Streams[(int)Stream];
+		return ByteReader{ Bytes.data(), Bytes.data() + Bytes.size() };
+	};
+
+	MeshOut.Resize((int)NumVertices, (int)NumTriangles);
+
+	ByteReader PositionReaders[3] = { MakeStreamReader(EStream::PositionX), MakeStreamReader(EStream::PositionY), MakeStreamReader(EStream::PositionZ) };
+	int64_t PrevPosition[3] = { 0, 0, 0 };
+	for (uint32_t vid = 0; vid < NumVertices; ++vid)
+	{
+		double Values[3];
+		for (int k = 0; k < 3; ++k) {
+			PrevPosition[k] += PositionReaders[k].ReadSignedVarint();
+			Values[k] = PositionGrid[k].Dequantize(PrevPosition[k]);
+		}
+		MeshOut.SetPosition((int)vid, Vector3d(Values[0], Values[1], Values[2]));
+	}
+
+	ByteReader IndexReader = MakeStreamReader(EStream::Indices);
+	std::vector<int> CornerVertices(3 * (size_t)NumTriangles);
+	std::vector<uint8_t> CornerFirstUse(3 * (size_t)NumTriangles);
+	int64_t NextNewVertex = 0;
+	Index3i PrevTriangle(-1, -1, -1);
+	for (uint32_t tid = 0; tid < NumTriangles; ++tid)
+	{
+		Index3i Tri;
+		for (int j = 0; j < 3; ++j)
+		{
+			uint64_t Code = IndexReader.ReadVarint();
+			int64_t Vertex = (Code == 0) ? NextNewVertex++ :
+				(Code <= 3) ? (int64_t)PrevTriangle[(int)Code - 1] : (NextNewVertex - (int64_t)(Code - 3));
+			if (Vertex < 0 || Vertex >= (int64_t)NumVertices)
+				return false;
+			Tri[j] = (int)Vertex;
+			CornerVertices[3 * (size_t)tid + j] = (int)Vertex;
+			CornerFirstUse[3 * (size_t)tid + j] = (Code == 0) ? 1 : 0;
+		}
+		MeshOut.SetTriangle((int)tid, Tri);
+		PrevTriangle = Tri;
+	}
+
+	// the per-triangle attributes only depend on the decoded corners, so each is decoded by its own task
+	bool bAttributeValid[4] = { true, true, true, true };
+	parallel_for_blocks(4, NumThreads, [&](int Attribute)
+	{
+		if (Attribute == 0 && NormalBits > 0)
+		{
+			ByteReader Readers[2] = { MakeStreamReader(EStream::NormalU), MakeStreamReader(EStream::NormalV) };
+			CornerPredictor<2> Predictor((int)NumVertices);
+			float OctahedralScale = (float)(2.0 / (double)((1 << NormalBits) - 1));
+			for (uint32_t tid = 0; tid < NumTriangles; ++tid)
+			{
+				TriVtxNormals Normals;
+				for (int j = 0; j < 3; ++j) {
+					size_t Corner = 3 * (size_t)tid + j;
+					const int64_t* Predicted = Predictor.Predict(CornerVertices[Corner], CornerFirstUse[Corner]);
+					int64_t Octahedral[2];
+					for (int c = 0; c < 2; ++c)
+						Octahedral[c] = add_prediction(Predicted[c], Readers[c].ReadSignedVarint());
+					Predictor.Update(CornerVertices[Corner], Octahedral);
+					Normals[j] = decode_octahedral(Octahedral[0], Octahedral[1], OctahedralScale);
+				}
+				MeshOut.SetTriVtxNormals((int)tid, Normals);
+			}
+			bAttributeValid[Attribute] = !Readers[0].bError && !Readers[1].bError;
+		}
+		else if (Attribute == 1 && UVBits > 0)
+		{
+			ByteReader Readers[2] = { MakeStreamReader(EStream::UVU), MakeStreamReader(EStream::UVV) };
+			CornerPredictor<2, int32_t> Predictor((int)NumVertices);
+			for (uint32_t tid = 0; tid < NumTriangles; ++tid)
+			{
+				TriVtxUVs UVs;
+				for (int j = 0; j < 3; ++j) {
+					size_t Corner = 3 * (size_t)tid + j;
+					const int32_t* Predicted = Predictor.Predict(CornerVertices[Corner], CornerFirstUse[Corner]);
+					int32_t Quantized[2];
+					for (int c = 0; c < 2; ++c)
+						Quantized[c] = add_prediction(Predicted[c], Readers[c].ReadSignedVarint());
+					Predictor.Update(CornerVertices[Corner], Quantized);
+					UVs[j] = Vector2f((float)UVGrid[0].Dequantize(Quantized[0]), (float)UVGrid[1].Dequantize(Quantized[1]));
+				}
+				MeshOut.SetTriVtxUVs((int)tid, UVs);
+			}
+			bAttributeValid[Attribute] = !Readers[0].bError && !Readers[1].bError;
+		}
+		else if (Attribute == 2 && (Flags & FlagColors))
+		{
+			ByteReader Reader = MakeStreamReader(EStream::Colors);
+			// same prediction as CornerPredictor<4>, with the 4 bytes of each color packed into one word
+			std::vector<uint32_t> VertexColors(NumVertices, 0);
+			uint32_t PrevColor = 0;
+			for (uint32_t tid = 0; tid < NumTriangles; ++tid)
+			{
+				TriVtxColors Colors;
+				for (int j = 0; j < 3; ++j) {
+					size_t Corner = 3 * (size_t)tid + j;
+					const uint8_t* Delta = Reader.Ptr + 4 * Corner;
+					uint32_t Predicted = (CornerFirstUse[Corner]) ? PrevColor : VertexColors[CornerVertices[Corner]];
+					uint32_t Color = add_packed_bytes(Predicted,
+						(uint32_t)Delta[0] | ((uint32_t)Delta[1] << 8) | ((uint32_t)Delta[2] << 16) | ((uint32_t)Delta[3] << 24));
+					PrevColor = VertexColors[CornerVertices[Corner]] = Color;
+					Colors[j].R = (uint8_t)Color; Colors[j].G = (uint8_t)(Color >> 8); Colors[j].B = (uint8_t)(Color >> 16); Colors[j].A = (uint8_t)(Color >> 24);
+				}
+				MeshOut.SetTriVtxColors((int)tid, Colors);
+			}
+		}
+		else if (Attribute == 3 && (Flags & FlagGroups))
+		{
+			ByteReader Reader = MakeStreamReader(EStream::Groups);
+			int64_t GroupID = 0;
+			for (uint32_t tid = 0; tid < NumTriangles; ++tid) {
+				GroupID += Reader.ReadSignedVarint();
+				MeshOut.SetTriGroup((int)tid, (int)GroupID);
+			}
+			bAttributeValid[Attribute] = !Reader.bError;
+		}
+	});
+
+	bool bReadError = IndexReader.bError;
+	for (int k = 0; k < 3; ++k)
+		bReadError = bReadError || PositionReaders[k].bError;
+	for (int k = 0; k < 4; ++k)
+		bReadError = bReadError || !bAttributeValid[k];
+	return !bReadError;
+}
+
+
+
+bool GS::CompressedMesh::WriteCompressedMesh(const std::string& Path, const DenseMesh& Mesh, const EncodeOptions& Options)
+{
+	std::vector<uint8_t> Encoded;
+	if (!EncodeMesh(Mesh, Encoded, Options))
+		return false;
+	FILE* File = fopen(Path.c_str(), "wb");
+	if (File == nullptr)
+		return false;
+	bool bWriteOK = fwrite(Encoded.data(), 1, Encoded.size(), File) == Encoded.size();
+	return (fclose(File) == 0) && bWriteOK;
+}
+
+bool GS::CompressedMesh::ReadCompressedMesh(const std::string& Path, DenseMesh& MeshOut, const DecodeOptions& Options)
+{
+	FILE* File = fopen(Path.c_str(), "rb");
+	if (File == nullptr)
+		return false;
+	std::vector<uint8_t> Encoded;
+	uint8_t Buffer[1 << 16];
+	size_t NumRead = 0;
+	while ((NumRead = fread(Buffer, 1, sizeof(Buffer), File)) > 0)
+		Encoded.insert(Encoded.end(), Buffer, Buffer + NumRead);
+	bool bReadOK = (ferror(File) == 0);
+	fclose(File);
+	return bReadOK && DecodeMesh(Encoded.data(), Encoded.size(), MeshOut, Options);
+}
+
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
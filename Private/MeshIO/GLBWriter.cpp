@@ -0,0 +1,549 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#include "MeshIO/GLBWriter.h"
+#include "MeshIO/MappedFileWriter.h"
+#include "MeshIO/number_formatting.h"
+#include "MeshIO/parallel_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+using namespace GS;
+using namespace GS::GLBWriter;
+
+
+static constexpr uint32_t GLBMagic = 0x46546C67;			// "glTF"
+static constexpr uint32_t GLBChunkTypeJSON = 0x4E4F534A;	// "JSON"
+static constexpr uint32_t GLBChunkTypeBIN = 0x004E4942;		// "BIN\0"
+static constexpr size_t GLBHeaderSize = 12;
+static constexpr size_t GLBChunkHeaderSize = 8;
+// elements packed per block in streamed output
+static constexpr size_t GLBBlockElements = 1 << 16;
+
+// glTF accessor component types and buffer view targets
+static constexpr int GLTF_UNSIGNED_BYTE = 5121;
+static constexpr int GLTF_UNSIGNED_SHORT = 5123;
+static constexpr int GLTF_UNSIGNED_INT = 5125;
+static constexpr int GLTF_FLOAT = 5126;
+static constexpr int GLTF_ARRAY_BUFFER = 34962;
+static constexpr int GLTF_ELEMENT_ARRAY_BUFFER = 34963;
+
+// attribute values of a glTF vertex, used to split mesh vertices. Keys are compared bitwise, so they are zero-filled and disabled attributes are zero
+struct GLBVertexKey
+{
+	int Vertex;
+	Vector3f Normal;
+	Vector2f UV;
+	Color4b Color;
+};
+
+enum class EGLBSection
+{
+	Positions = 0,
+	Normals = 1,
+	UVs = 2,
+	Colors = 3,
+	Indices = 4
+};
+static constexpr int GLBNumSections = 5;
+
+// vertices with more corners than this are split by sorting their corner keys, rather than comparing each corner to all distinct keys
+static constexpr size_t MaxLinearSplitCorners = 32;
+
+/**
+ * Number the distinct keys of Corners[0,NumCorners) (which are in increasing order) in order of first occurrence,
+ * by sorting (key,corner) pairs, and set IndicesOut[Corner] to the number of each corner's key. Returns the number of distinct keys.
+ */
+template<typename KeyType, typename GetKeyFuncType>
+static int number_keys_by_sorting(const uint32_t* Corners, size_t NumCorners, GetKeyFuncType& GetKey,
+	std::vector<std::pair<KeyType, uint32_t>>& SortedKeys, std::vector<int>& IndicesOut)
+{
+	SortedKeys.resize(NumCorners);
+	for (size_t k = 0; k < NumCorners; ++k)
+		SortedKeys[k] = std::pair<KeyType, uint32_t>(GetKey(Corners[k]), Corners[k]);
+	std::sort(SortedKeys.begin(), SortedKeys.end(), [](const std::pair<KeyType, uint32_t>& A, const std::pair<KeyType, uint32_t>& B)
+	{
+		int KeyCompare = memcmp(&A.first, &B.first, sizeof(KeyType));
+		return (KeyCompare != 0) ? (KeyCompare < 0) : (A.second < B.second);
+	});
+	// each run of equal keys starts with its first corner, number the runs in order of first corner
+	std::vector<std::pair<uint32_t, size_t>> RunFirstCorners;
+	for (size_t k = 0; k < NumCorners; ++k)
+		if (k == 0 || memcmp(&SortedKeys[k-1].first, &SortedKeys[k].first, sizeof(KeyType)) != 0)
+			RunFirstCorners.push_back(std::pair<uint32_t, size_t>(SortedKeys[k].second, k));
+	std::sort(RunFirstCorners.begin(), RunFirstCorners.end());
+	for (size_t r = 0; r < RunFirstCorners.size(); ++r)
+	{
+		size_t k = RunFirstCorners[r].second;
+		do {
+			IndicesOut[SortedKeys[k].second] = (int)r;
+			k++;
+		} while (k < NumCorners && memcmp(&SortedKeys[k-1].first, &SortedKeys[k].first, sizeof(KeyType)) == 0);
+	}
+	return (int)RunFirstCorners.size();
+}
+
+/**
+ * Split mesh vertices into one output vertex per distinct key of the corners (ie triangle-vertices) that use them.
+ * Corners are bucketed by mesh vertex with a counting sort, and the few corners of each vertex are then compared
+ * directly, which is much faster than sorting all the corner keys. Output vertices are numbered in mesh vertex order,
+ * and then in order of first use within each mesh vertex, so the result does not depend on NumThreads.
+ * GetCornerVertex(c) returns the mesh vertex of corner c, and GetKey(c) its KeyType, which is compared bitwise.
+ * Sets CornerVerticesOut to the output vertex of each corner and VertexCornersOut to the first corner of each output vertex.
+ * Returns the number of output vertices.
+ */
+template<typename KeyType, typename GetCornerVertexFuncType, typename GetKeyFuncType>
+static size_t split_vertices_by_corner_key(size_t NumCorners, int NumMeshVertices, int NumThreads,
+	GetCornerVertexFuncType GetCornerVertex, GetKeyFuncType GetKey,
+	std::vector<int>& CornerVerticesOut, std::vector<uint32_t>& VertexCornersOut)
+{
+	// corners sorted by mesh vertex, in corner order for each vertex
+	std::vector<size_t> VertexCornerStarts((size_t)NumMeshVertices + 1, 0);
+	for (size_t c = 0; c < NumCorners; ++c)
+		VertexCornerStarts[GetCornerVertex(c) + 1]++;
+	for (int vid = 0; vid < NumMeshVertices; ++vid)
+		VertexCornerStarts[vid + 1] += VertexCornerStarts[vid];
+	std::vector<uint32_t> SortedCorners(NumCorners);
+	{
+		std::vector<size_t> InsertPos(VertexCornerStarts.begin(), VertexCornerStarts.end() - 1);
+		for (size_t c = 0; c < NumCorners; ++c)
+			SortedCorners[InsertPos[GetCornerVertex(c)]++] = (uint32_t)c;
+	}
+
+	// number the distinct keys of each vertex. CornerVerticesOut temporarily stores the index of each corner's key within its vertex
+	CornerVerticesOut.resize(NumCorners);
+	std::vector<int> VertexSplitCounts(NumMeshVertices, 0);
+	int NumBlocks = std::max(NumThreads, 1) * 4;
+	parallel_for_ranges((size_t)NumMeshVertices, NumBlocks, NumThreads, [&](int, size_t StartVertex, size_t EndVertex)
+	{
+		std::vector<KeyType> UniqueKeys;
+		std::vector<std::pair<KeyType, uint32_t>> SortedKeys;
+		for (size_t vid = StartVertex; vid < EndVertex; ++vid)
+		{
+			size_t NumVertexCorners = VertexCornerStarts[vid + 1] - VertexCornerStarts[vid];
+			if (NumVertexCorners > MaxLinearSplitCorners)
+			{
+				VertexSplitCounts[vid] = number_keys_by_sorting<KeyType>(&SortedCorners[VertexCornerStarts[vid]], NumVertexCorners, GetKey, SortedKeys, CornerVerticesOut);
+				continue;
+			}
+			UniqueKeys.clear();
+			for (size_t k = VertexCornerStarts[vid]; k < VertexCornerStarts[vid + 1]; ++k)
+			{
+				uint32_t Corner = SortedCorners[k];
+				KeyType Key = GetKey(Corner);
+				size_t KeyIndex = 0;
+				while (KeyIndex < UniqueKeys.size() && memcmp(&UniqueKeys[KeyIndex], &Key, sizeof(KeyType)) != 0)
+					KeyIndex++;
+				if (KeyIndex == UniqueKeys.size())
+					UniqueKeys.push_back(Key);
+				CornerVerticesOut[Corner] = (int)KeyIndex;
+			}
+			VertexSplitCounts[vid] = (int)UniqueKeys.size();
+		}
+	});
+
+	std::vector<size_t> VertexFirstSplit((size_t)NumMeshVertices + 1, 0);
+	for (int vid = 0; vid < NumMeshVertices; ++vid)
+		VertexFirstSplit[vid + 1] = VertexFirstSplit[vid] + (size_t)VertexSplitCounts[vid];
+	size_t NumSplitVertices = VertexFirstSplit.back();
+
+	// corners of each vertex are in corner order, so the first corner with each key sets VertexCornersOut
+	VertexCornersOut.resize(NumSplitVertices);
+	parallel_for_ranges((size_t)NumMeshVertices, NumBlocks, NumThreads, [&](int, size_t StartVertex, size_t EndVertex)
+	{
+		for (size_t vid = StartVertex; vid < EndVertex; ++vid)
+		{
+			int NextKeyIndex = 0;
+			for (size_t k = VertexCornerStarts[vid]; k < VertexCornerStarts[vid + 1]; ++k)
+			{
+				uint32_t Corner = SortedCorners[k];
+				int KeyIndex = CornerVerticesOut[Corner];
+				if (KeyIndex == NextKeyIndex) {
+					VertexCornersOut[VertexFirstSplit[vid] + KeyIndex] = Corner;
+					NextKeyIndex++;
+				}
+				CornerVerticesOut[Corner] = (int)(VertexFirstSplit[vid] + KeyIndex);
+			}
+		}
+	});
+	return NumSplitVertices;
+}
+
+
+/**
+ * Everything needed to write the GLB file: triangles sorted by group, the split vertices, and the
+ * offset and size of each section of the binary buffer.
+ */
+struct GLBMeshLayout
+{
+	bool bNormals = false;
+	bool bUVs = false;
+	bool bColors = false;
+	bool bFlipUVs = true;
+
+	std::vector<int> SortedTriangles;
+	std::vector<int> GroupIDs;
+	std::vector<size_t> GroupStarts;		// primitive k is sorted triangles [GroupStarts[k], GroupStarts[k+1])
+
+	std::vector<int> CornerVertices;		// glTF vertex of each corner of the sorted triangles
+	std::vector<uint32_t> VertexCorners;	// first sorted corner of each glTF vertex
+	size_t NumVertices = 0;
+	size_t IndexSize = 4;
+	Vector3f BoundsMin, BoundsMax;
+
+	size_t SectionCounts[GLBNumSections] = {};
+	size_t SectionElementSizes[GLBNumSections] = {};
+	size_t SectionOffsets[GLBNumSections] = {};
+	size_t BufferSize = 0;
+
+	void Build(const DenseMesh& Mesh, const WriteOptions& Options, int NumThreads)
+	{
+		bNormals = Options.bNormals;
+		bUVs = Options.bUVs;
+		bColors = Options.bVertexColors;
+		bFlipUVs = Options.bFlipUVs;
+
+		size_t NumTriangles = (size_t)Mesh.GetTriangleCount();
+		parallel_stable_sort_by_key(NumTriangles, NumThreads, [&](size_t tid) { return Mesh.GetTriGroup((int)tid); }, SortedTriangles);
+		for (size_t k = 0; k < NumTriangles; ++k) {
+			int GroupID = Mesh.GetTriGroup(SortedTriangles[k]);
+			if (GroupIDs.empty() || GroupIDs.back() != GroupID) {
+				GroupIDs.push_back(GroupID);
+				GroupStarts.push_back(k);
+			}
+		}
+		GroupStarts.push_back(NumTriangles);
+
+		NumVertices = split_vertices_by_corner_key<GLBVertexKey>(3 * NumTriangles, Mesh.GetVertexCount(), NumThreads,
+			[&](size_t Corner) { return Mesh.GetTriangle(SortedTriangles[Corner / 3])[(int)(Corner % 3)]; },
+			[&](size_t Corner) { return GetCornerKey(Mesh, SortedTriangles[Corner / 3], (int)(Corner % 3)); },
+			CornerVertices, VertexCorners);
+		// max index value is reserved (for primitive restart), so it cannot be used as a vertex index
+		IndexSize = (NumVertices <= 0xFFFF) ? 2 : 4;
+
+		ComputeBounds(Mesh, NumThreads);
+
+		SectionCounts[(int)EGLBSection::Positions] = NumVertices;
+		SectionElementSizes[(int)EGLBSection::Positions] = 3 * sizeof(float);
+		SectionCounts[(int)EGLBSection::Normals] = (bNormals) ? NumVertices : 0;
+		SectionElementSizes[(int)EGLBSection::Normals] = 3 * sizeof(float);
+		SectionCounts[(int)EGLBSection::UVs] = (bUVs) ? NumVertices : 0;
+		SectionElementSizes[(int)EGLBSection::UVs] = 2 * sizeof(float);
+		SectionCounts[(int)EGLBSection::Colors] = (bColors) ? NumVertices : 0;
+		SectionElementSizes[(int)EGLBSection::Colors] = 4;
+		SectionCounts[(int)EGLBSection::Indices] = NumTriangles;
+		SectionElementSizes[(int)EGLBSection::Indices] = 3 * IndexSize;
+		// vertex sections have 4-byte elements, so only the index section may need padding to keep the buffer size a multiple of 4
+		for (int k = 0; k < GLBNumSections; ++k) {
+			SectionOffsets[k] = BufferSize;
+			BufferSize += SectionCounts[k] * SectionElementSizes[k];
+		}
+		BufferSize = (BufferSize + 3) & ~(size_t)3;
+	}
+
+	GLBVertexKey GetCornerKey(const DenseMesh& Mesh, int tid, int j) const
+	{
+		GLBVertexKey Key;
+		memset((void*)&Key, 0, sizeof(GLBVertexKey));
+		Key.Vertex = Mesh.GetTriangle(tid)[j];
+		if (bNormals)
+			Key.Normal = Mesh.GetTriVtxNormals(tid)[j];
+		if (bUVs)
+			Key.UV = Mesh.GetTriVtxUVs(tid)[j];
+		if (bColors)
+			Key.Color = Mesh.GetTriVtxColors(tid)[j];
+		return Key;
+	}
+
+	GLBVertexKey GetVertex(const DenseMesh& Mesh, size_t Vertex) const
+	{
+		uint32_t Corner = VertexCorners[Vertex];
+		return GetCornerKey(Mesh, SortedTriangles[Corner / 3], (int)(Corner % 3));
+	}
+
+	void ComputeBounds(const DenseMesh& Mesh, int NumThreads)
+	{
+		BoundsMin = BoundsMax = Vector3f::Zero();
+		if (NumVertices == 0)
+			return;
+		int NumBlocks = std::max(NumThreads, 1) * 4;
+		std::vector<Vector3f> BlockMin(NumBlocks), BlockMax(NumBlocks);
+		std::vector<uint8_t> BlockUsed(NumBlocks, 0);
+		parallel_for_ranges(NumVertices, NumBlocks, NumThreads, [&](int Block, size_t Start, size_t End)
+		{
+			Vector3f Min = (Vector3f)Mesh.GetPosition(GetVertex(Mesh, Start).Vertex), Max = Min;
+			for (size_t i = Start + 1; i < End; ++i) {
+				Vector3f Position = (Vector3f)Mesh.GetPosition(GetVertex(Mesh, i).Vertex);
+				for (int k = 0; k < 3; ++k) {
+					Min[k] = std::min(Min[k], Position[k]);
+					Max[k] = std::max(Max[k], Position[k]);
+				}
+			}
+			BlockMin[Block] = Min;
+			BlockMax[Block] = Max;
+			BlockUsed[Block] = 1;
+		});
+		bool bFirst = true;
+		for (int Block = 0; Block < NumBlocks; ++Block) {
+			if (BlockUsed[Block] == 0)
+				continue;
+			for (int k = 0; k < 3; ++k) {
+				BoundsMin[k] = (bFirst) ? BlockMin[Block][k] : std::min(BoundsMin[k], BlockMin[Block][k]);
+				BoundsMax[k] = (bFirst) ? BlockMax[Block][k] : std::max(BoundsMax[k], BlockMax[Block][k]);
+			}
+			bFirst = false;
+		}
+	}
+};
+
+
+// pack elements [Start,End) of Section into Dest. Values are written in native (little-endian) byte order
+static void pack_glb_section(const DenseMesh& Mesh, const GLBMeshLayout& Layout, EGLBSection Section, size_t Start, size_t End, char* Dest)
+{
+	if (Section == EGLBSection::Indices)
+	{
+		for (size_t k = Start; k < End; ++k)
+		{
+			const int* Indices = &Layout.CornerVertices[3 * k];
+			if (Layout.IndexSize == 2) {
+				uint16_t Short[3] = { (uint16_t)Indices[0], (uint16_t)Indices[1], (uint16_t)Indices[2] };
+				memcpy(Dest, Short, sizeof(Short));
+			}
+			else
+				memcpy(Dest, Indices, 3 * sizeof(int));
+			Dest += 3 * Layout.IndexSize;
+		}
+		return;
+	}
+
+	for (size_t i = Start; i < End; ++i)
+	{
+		GLBVertexKey Vertex = Layout.GetVertex(Mesh, i);
+		if (Section == EGLBSection::Positions) {
+			Vector3f Position = (Vector3f)Mesh.GetPosition(Vertex.Vertex);
+			memcpy(Dest, &Position.X, 3 * sizeof(float));
+			Dest += 3 * sizeof(float);
+		}
+		else if (Section == EGLBSection::Normals) {
+			Vector3f Normal = Vertex.Normal;
+			float Length = std::sqrt(Normal.X * Normal.X + Normal.Y * Normal.Y + Normal.Z * Normal.Z);
+			Normal = (Length > 0 && std::isfinite(Length)) ? Vector3f(Normal.X / Length, Normal.Y / Length, Normal.Z / Length) : Vector3f(0, 0, 1);
+			memcpy(Dest, &Normal.X, 3 * sizeof(float));
+			Dest += 3 * sizeof(float);
+		}
+		else if (Section == EGLBSection::UVs) {
+			float UV[2] = { Vertex.UV.X, (Layout.bFlipUVs) ? (1.0f - Vertex.UV.Y) : Vertex.UV.Y };
+			memcpy(Dest, UV, 2 * sizeof(float));
+			Dest += 2 * sizeof(float);
+		}
+		else {
+			uint8_t Color[4] = { Vertex.Color.R, Vertex.Color.G, Vertex.Color.B, Vertex.Color.A };
+			memcpy(Dest, Color, 4);
+			Dest += 4;
+		}
+	}
+}
+
+
+static void append_json_real(std::string& JSON, float Value)
+{
+	RealFormatOptions Format;
+	Format.Mode = ERealPrecisionMode::ShortestRoundTrip;
+	char Buffer[NumberFormatting::MaxRealLength];
+	char* End = NumberFormatting::format_real(Buffer, Value, Format);
+	JSON.append(Buffer, End);
+}
+
+// build the glTF JSON for Layout, padded with spaces to a multiple of 4 bytes
+static std::string make_glb_json(const GLBMeshLayout& Layout)
+{
+	std::string JSON = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"gradientspace_glb\"},\"scene\":0,";
+	if (Layout.GroupIDs.empty())
+	{
+		JSON += "\"scenes\":[{}]}";
+		JSON.append((4 - JSON.size() % 4) % 4, ' ');
+		return JSON;
+	}
+	JSON += "\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],";
+
+	// one buffer view per non-empty section. Vertex attribute accessors are shared by all primitives
+	const char* AttributeNames[4] = { "POSITION", "NORMAL", "TEXCOORD_0", "COLOR_0" };
+	std::string BufferViews, Accessors, Attributes;
+	int NumViews = 0;
+	for (int k = 0; k < 4; ++k)
+	{
+		if (Layout.SectionCounts[k] == 0)
+			continue;
+		if (NumViews > 0) {
+			BufferViews += ",";
+			Accessors += ",";
+			Attributes += ",";
+		}
+		BufferViews += "{\"buffer\":0,\"byteOffset\":" + std::to_string(Layout.SectionOffsets[k]) + ",\"byteLength\":"
+			+ std::to_string(Layout.SectionCounts[k] * Layout.SectionElementSizes[k]) + ",\"target\":" + std::to_string(GLTF_ARRAY_BUFFER) + "}";
+		Accessors += "{\"bufferView\":" + std::to_string(NumViews) + ",\"count\":" + std::to_string(Layout.NumVertices);
+		if (k == (int)EGLBSection::Colors)
+			Accessors += ",\"componentType\":" + std::to_string(GLTF_UNSIGNED_BYTE) + ",\"normalized\":true,\"type\":\"VEC4\"";
+		else
+			Accessors += ",\"componentType\":" + std::to_string(GLTF_FLOAT) + ",\"type\":\"" + ((k == (int)EGLBSection::UVs) ? "VEC2" : "VEC3") + "\"";
+		if (k == (int)EGLBSection::Positions) {
+			Accessors += ",\"min\":[";
+			for (int j = 0; j < 3; ++j) {
+				append_json_real(Accessors, Layout.BoundsMin[j]);
+				Accessors += (j < 2) ? "," : "],\"max\":[";
+			}
+			for (int j = 0; j < 3; ++j) {
+				append_json_real(Accessors, Layout.BoundsMax[j]);
+				Accessors += (j < 2) ? "," : "]";
+			}
+		}
+		Accessors += "}";
+		Attributes += "\"" + std::string(AttributeNames[k]) + "\":" + std::to_string(NumViews);
+		NumViews++;
+	}
+	int NumAttributeAccessors = NumViews;
+
+	int IndicesSection = (int)EGLBSection::Indices;
+	BufferViews += ",{\"buffer\":0,\"byteOffset\":" + std::to_string(Layout.SectionOffsets[IndicesSection]) + ",\"byteLength\":"
+		+ std::to_string(Layout.SectionCounts[IndicesSection] * Layout.SectionElementSizes[IndicesSection]) + ",\"target\":" + std::to_string(GLTF_ELEMENT_ARRAY_BUFFER) + "}";
+	int IndexComponentType = (Layout.IndexSize == 2) ? GLTF_UNSIGNED_SHORT : GLTF_UNSIGNED_INT;
+	std::string Primitives;
+	for (size_t k = 0; k < Layout.GroupIDs.size(); ++k)
+	{
+		size_t FirstTriangle = Layout.GroupStarts[k];
+		size_t NumTriangles = Layout.GroupStarts[k+1] - FirstTriangle;
+		Accessors += ",{\"bufferView\":" + std::to_string(NumViews) + ",\"byteOffset\":" + std::to_string(FirstTriangle * 3 * Layout.IndexSize)
+			+ ",\"count\":" + std::to_string(3 * NumTriangles) + ",\"componentType\":" + std::to_string(IndexComponentType) + ",\"type\":\"SCALAR\"}";
+		if (k > 0)
+			Primitives += ",";
+		Primitives += "{\"attributes\":{" + Attributes + "},\"indices\":" + std::to_string(NumAttributeAccessors + (int)k)
+			+ ",\"mode\":4,\"extras\":{\"group\":" + std::to_string(Layout.GroupIDs[k]) + "}}";
+	}
+
+	JSON += "\"meshes\":[{\"primitives\":[" + Primitives + "]}],";
+	JSON += "\"buffers\":[{\"byteLength\":" + std::to_string(Layout.BufferSize) + "}],";
+	JSON += "\"bufferViews\":[" + BufferViews + "],";
+	JSON += "\"accessors\":[" + Accessors + "]}";
+	JSON.append((4 - JSON.size() % 4) % 4, ' ');
+	return JSON;
+}
+
+// GLB file header, JSON chunk, and BIN chunk header (if there is a binary buffer)
+static std::string make_glb_header(const GLBMeshLayout& Layout, size_t& FileSizeOut)
+{
+	std::string JSON = make_glb_json(Layout);
+	FileSizeOut = GLBHeaderSize + GLBChunkHeaderSize + JSON.size() + ((Layout.BufferSize > 0) ? (GLBChunkHeaderSize + Layout.BufferSize) : 0);
+
+	std::string Header(GLBHeaderSize + GLBChunkHeaderSize, '\0');
+	uint32_t Fields[5] = { GLBMagic, 2, (uint32_t)FileSizeOut, (uint32_t)JSON.size(), GLBChunkTypeJSON };
+	memcpy(&Header[0], Fields, sizeof(Fields));
+	Header += JSON;
+	if (Layout.BufferSize > 0) {
+		uint32_t ChunkFields[2] = { (uint32_t)Layout.BufferSize, GLBChunkTypeBIN };
+		Header.append((const char*)ChunkFields, sizeof(ChunkFields));
+	}
+	return Header;
+}
+
+/**
+ * Write the GLB file via WriteFunc(const char* Data, size_t NumBytes). Each section is packed in batches
+ * of NumThreads blocks, each block packed by one thread, and passed to WriteFunc in file order.
+ */
+template<typename WriteFuncType>
+static bool write_glb_blocked(const DenseMesh& Mesh, const GLBMeshLayout& Layout, const std::string& Header, int NumThreads, WriteFuncType WriteFunc)
+{
+	bool bWritesOK = WriteFunc(Header.data(), Header.size());
+	std::vector<char> Buffer;
+	size_t BufferEnd = 0;
+	for (int Section = 0; Section < GLBNumSections && bWritesOK; ++Section)
+	{
+		size_t Count = Layout.SectionCounts[Section];
+		size_t ElementSize = Layout.SectionElementSizes[Section];
+		size_t NumBlocks = (Count + GLBBlockElements - 1) / GLBBlockElements;
+		size_t BatchBlocks = std::max((size_t)1, std::min((size_t)NumThreads, NumBlocks));
+		Buffer.resize(std::max(Buffer.size(), BatchBlocks * GLBBlockElements * ElementSize));
+		for (size_t BatchStart = 0; BatchStart < NumBlocks && bWritesOK; BatchStart += BatchBlocks)
+		{
+			int NumBatchBlocks = (int)std::min(BatchBlocks, NumBlocks - BatchStart);
+			size_t BatchStartElement = BatchStart * GLBBlockElements;
+			size_t BatchEndElement = std::min(Count, (BatchStart + NumBatchBlocks) * GLBBlockElements);
+			parallel_for_blocks(NumBatchBlocks, NumThreads, [&](int k)
+			{
+				size_t StartElement = BatchStartElement + (size_t)k * GLBBlockElements;
+				size_t EndElement = std::min(BatchEndElement, StartElement + GLBBlockElements);
+				pack_glb_section(Mesh, Layout, (EGLBSection)Section, StartElement, EndElement, &Buffer[(size_t)k * GLBBlockElements * ElementSize]);
+			});
+			bWritesOK = WriteFunc(Buffer.data(), (BatchEndElement - BatchStartElement) * ElementSize);
+		}
+		BufferEnd += Count * ElementSize;
+	}
+	if (bWritesOK && BufferEnd < Layout.BufferSize) {
+		const char Padding[4] = { 0, 0, 0, 0 };
+		bWritesOK = WriteFunc(Padding, Layout.BufferSize - BufferEnd);
+	}
+	return bWritesOK;
+}
+
+
+
+
+bool GS::GLBWriter::WriteGLB(
+	const std::string& Filename,
+	const DenseMesh& Mesh,
+	const WriteOptions& Options)
+{
+	int NumThreads = get_num_worker_threads(Options.NumThreads);
+	GLBMeshLayout Layout;
+	Layout.Build(Mesh, Options, NumThreads);
+	size_t FileSize = 0;
+	std::string Header = make_glb_header(Layout, FileSize);
+	if (FileSize > (size_t)UINT32_MAX)
+		return false;
+
+	// output size is known exactly, so the file can be preallocated and optionally written through a mapping
+	MappedFileWriter Writer;
+	if (!Writer.Open(Filename, FileSize, Options.bUseMemoryMappedIO))
+		return false;
+	if (Writer.IsMapped()) {
+		char* Dest = Writer.Data();
+		memcpy(Dest, Header.data(), Header.size());
+		char* BufferDest = Dest + Header.size();
+		for (int Section = 0; Section < GLBNumSections; ++Section)
+		{
+			char* SectionDest = BufferDest + Layout.SectionOffsets[Section];
+			size_t ElementSize = Layout.SectionElementSizes[Section];
+			parallel_for_ranges(Layout.SectionCounts[Section], NumThreads, NumThreads, [&](int, size_t Start, size_t End)
+			{
+				pack_glb_section(Mesh, Layout, (EGLBSection)Section, Start, End, SectionDest + Start * ElementSize);
+			});
+		}
+		size_t SectionsEnd = Layout.SectionOffsets[GLBNumSections-1] + Layout.SectionCounts[GLBNumSections-1] * Layout.SectionElementSizes[GLBNumSections-1];
+		memset(BufferDest + SectionsEnd, 0, Layout.BufferSize - SectionsEnd);
+		return Writer.Close();
+	}
+	bool bWritesOK = write_glb_blocked(Mesh, Layout, Header, NumThreads, [&](const char* Data, size_t NumBytes) {
+		return Writer.WriteBytes(Data, NumBytes);
+	});
+	return Writer.Close() && bWritesOK;
+}
+
+
+bool GS::GLBWriter::WriteGLB(
+	IBinaryWriter& BinaryWriter,
+	const DenseMesh& Mesh,
+	const WriteOptions& Options)
+{
+	int NumThreads = get_num_worker_threads(Options.NumThreads);
+	GLBMeshLayout Layout;
+	Layout.Build(Mesh, Options, NumThreads);
+	size_t FileSize = 0;
+	std::string Header = make_glb_header(Layout, FileSize);
+	if (FileSize > (size_t)UINT32_MAX)
+		return false;
+	return write_glb_blocked(Mesh, Layout, Header, NumThreads, [&](const char* Data, size_t NumBytes) {
+		return BinaryWriter.WriteBytes(Data, NumBytes);
+	});
+}
@@ -0,0 +1,179 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#include "MeshIO/MappedFileBuffer.h"
+
+#include <filesystem>
+#include <stdio.h>
+
+#if defined(_WIN32)
+	#if defined(GSIO_EMBEDDED_UE_BUILD)
+		#include "Windows/AllowWindowsPlatformTypes.h"
+	#endif
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+	#if defined(GSIO_EMBEDDED_UE_BUILD)
+		#include "Windows/HideWindowsPlatformTypes.h"
+	#endif
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable:4996) // disable secure-crt warnings for this file
+#endif
+
+using namespace GS;
+
+
+MappedFileBuffer::~MappedFileBuffer()
+{
+	Close();
+}
+
+
+bool MappedFileBuffer::Open(const std::string& Path, bool bAllowMemoryMap)
+{
+	Close();
+
+	std::error_code ErrorCode;
+	std::filesystem::path FilePath(Path);
+	bool bIsRegularFile = std::filesystem::is_regular_file(FilePath, ErrorCode);
+	if (!bIsRegularFile || !bAllowMemoryMap)
+		return ReadIntoHeapBuffer(Path);
+
+	uintmax_t FileSize = std::filesystem::file_size(FilePath, ErrorCode);
+	if (ErrorCode)
+		return ReadIntoHeapBuffer(Path);
+	if (FileSize == 0)
+		return true;		// empty file is valid, but cannot be mapped
+
+#if defined(_WIN32)
+	HANDLE hFile = CreateFileW(FilePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+	HANDLE hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (hMapping == nullptr) {
+		CloseHandle(hFile);
+		return ReadIntoHeapBuffer(Path);
+	}
+	void* MappedPtr = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+	if (MappedPtr == nullptr) {
+		CloseHandle(hMapping);
+		CloseHandle(hFile);
+		return ReadIntoHeapBuffer(Path);
+	}
+	FileHandle = hFile;
+	MappingHandle = hMapping;
+#else
+	int fd = open(Path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	void* MappedPtr = mmap(nullptr, (size_t)FileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	// mapping holds its own reference to the file, so we can close the descriptor immediately
+	close(fd);
+	if (MappedPtr == MAP_FAILED)
+		return ReadIntoHeapBuffer(Path);
+#endif
+
+	DataPtr = (const char*)MappedPtr;
+	DataSize = (size_t)FileSize;
+	bIsMapped = true;
+	return true;
+}
+
+
+bool MappedFileBuffer::ReadIntoHeapBuffer(const std::string& Path)
+{
+	FILE* FilePtr = fopen(Path.c_str(), "rb");
+	if (!FilePtr)
+		return false;
+
+	// size is not known in advance for pipes/etc, so grow in large blocks
+	constexpr size_t BlockSize = 1 << 20;
+	size_t NumRead = 0;
+	bool bDone = false;
+	while (!bDone)
+	{
+		HeapBuffer.resize(NumRead + BlockSize);
+		size_t BlockRead = fread(&HeapBuffer[NumRead], 1, BlockSize, FilePtr);
+		NumRead += BlockRead;
+		bDone = (BlockRead < BlockSize);
+	}
+	bool bReadError = (ferror(FilePtr) != 0);
+	fclose(FilePtr);
+
+	HeapBuffer.resize(NumRead);
+	DataPtr = HeapBuffer.data();
+	DataSize = NumRead;
+	bIsMapped = false;
+	return !bReadError;
+}
+
+
+void MappedFileBuffer::AdviseSequential(bool bTryHugePages)
+{
+	if (!bIsMapped)
+		return;
+#if !defined(_WIN32)
+	madvise((void*)DataPtr, DataSize, MADV_SEQUENTIAL);
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	if (bTryHugePages)
+		madvise((void*)DataPtr, DataSize, MADV_HUGEPAGE);
+#endif
+#endif
+	// on Windows, FILE_FLAG_SEQUENTIAL_SCAN was passed when the file was opened
+}
+
+
+void MappedFileBuffer::DiscardPages(size_t Offset, size_t NumBytes)
+{
+	if (!bIsMapped || Offset >= DataSize)
+		return;
+	NumBytes = (NumBytes < DataSize - Offset) ? NumBytes : (DataSize - Offset);
+#if defined(_WIN32)
+	static const size_t PageSize = []() { SYSTEM_INFO Info; GetSystemInfo(&Info); return (size_t)Info.dwPageSize; }();
+#else
+	static const size_t PageSize = (size_t)sysconf(_SC_PAGESIZE);
+#endif
+	// mapping starts on a page boundary, so only the offsets need to be rounded
+	size_t Start = (Offset + PageSize - 1) & ~(PageSize - 1);
+	size_t End = (Offset + NumBytes) & ~(PageSize - 1);
+	if (End <= Start)
+		return;
+#if defined(_WIN32)
+	// unlocking pages that are not locked removes them from the working set
+	VirtualUnlock((void*)(DataPtr + Start), End - Start);
+#else
+	madvise((void*)(DataPtr + Start), End - Start, MADV_DONTNEED);
+#endif
+}
+
+
+void MappedFileBuffer::Close()
+{
+	if (bIsMapped)
+	{
+#if defined(_WIN32)
+		UnmapViewOfFile(DataPtr);
+		CloseHandle((HANDLE)MappingHandle);
+		CloseHandle((HANDLE)FileHandle);
+		MappingHandle = FileHandle = nullptr;
+#else
+		munmap((void*)DataPtr, DataSize);
+#endif
+	}
+	HeapBuffer = std::vector<char>();
+	DataPtr = nullptr;
+	DataSize = 0;
+	bIsMapped = false;
+}
+
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
@@ -0,0 +1,67 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#pragma once
+
+#include "GradientspaceIOPlatform.h"
+
+#include <string>
+#include <vector>
+
+
+namespace GS
+{
+
+/**
+ * Read-only view of the full contents of a file. Regular files are memory-mapped,
+ * other files (pipes, devices, etc), or files opened with bAllowMemoryMap=false,
+ * are read into an internal heap buffer with large buffered reads.
+ *
+ * Data() is *not* null-terminated, all parsing must be bounded by Data()+Size().
+ */
+class MappedFileBuffer
+{
+public:
+	MappedFileBuffer() = default;
+	~MappedFileBuffer();
+
+	MappedFileBuffer(const MappedFileBuffer&) = delete;
+	MappedFileBuffer& operator=(const MappedFileBuffer&) = delete;
+
+	bool Open(const std::string& Path, bool bAllowMemoryMap = true);
+	void Close();
+
+	const char* Data() const { return DataPtr; }
+	size_t Size() const { return DataSize; }
+	bool IsMapped() const { return bIsMapped; }
+
+	/**
+	 * Hint to the OS that the buffer will be read front-to-back (ie aggressive read-ahead
+	 * and early page eviction). If bTryHugePages, also request transparent huge pages
+	 * where supported (Linux only). No-op for heap-buffered files.
+	 */
+	void AdviseSequential(bool bTryHugePages = true);
+
+	/**
+	 * Remove the whole pages inside [Offset, Offset+NumBytes) of a mapped file from the process
+	 * working set, eg the part of the file that a front-to-back parser has already consumed.
+	 * The mapping is read-only, so the contents are unchanged and pages are re-read from the
+	 * file if they are accessed again. No-op for heap-buffered files.
+	 */
+	void DiscardPages(size_t Offset, size_t NumBytes);
+
+protected:
+	const char* DataPtr = nullptr;
+	size_t DataSize = 0;
+	bool bIsMapped = false;
+
+	std::vector<char> HeapBuffer;
+
+#if defined(_WIN32)
+	void* FileHandle = nullptr;
+	void* MappingHandle = nullptr;
+#endif
+
+	bool ReadIntoHeapBuffer(const std::string& Path);
+};
+
+
+}  // end namespace GS
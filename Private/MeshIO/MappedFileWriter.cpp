@@ -0,0 +1,178 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#include "MeshIO/MappedFileWriter.h"
+
+#include <filesystem>
+
+#if defined(_WIN32)
+	#if defined(GSIO_EMBEDDED_UE_BUILD)
+		#include "Windows/AllowWindowsPlatformTypes.h"
+	#endif
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+	#include <io.h>
+	#if defined(GSIO_EMBEDDED_UE_BUILD)
+		#include "Windows/HideWindowsPlatformTypes.h"
+	#endif
+#else
+	#include <errno.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable:4996) // disable secure-crt warnings for this file
+#endif
+
+using namespace GS;
+
+
+MappedFileWriter::~MappedFileWriter()
+{
+	Close();
+}
+
+
+#if !defined(_WIN32)
+// reserve disk blocks for [0,Size) of fd. Returns false only if the filesystem reported it is out of space,
+// if preallocation is not supported the file is just extended (or left as-is if bExtend is false)
+static bool preallocate_file(int fd, size_t Size, bool bExtend)
+{
+#if defined(__linux__)
+	int Result = posix_fallocate(fd, 0, (off_t)Size);
+	if (Result == 0)
+		return true;
+	if (Result == ENOSPC || Result == EFBIG)
+		return false;
+#endif
+	return (bExtend) ? (ftruncate(fd, (off_t)Size) == 0) : true;
+}
+#endif
+
+
+bool MappedFileWriter::Open(const std::string& Path, size_t Size, bool bAllowMemoryMap)
+{
+	Close();
+
+	std::error_code ErrorCode;
+	std::filesystem::path FilePath(Path);
+	bool bIsSpecialFile = std::filesystem::exists(FilePath, ErrorCode) && !std::filesystem::is_regular_file(FilePath, ErrorCode);
+	if (!bAllowMemoryMap || Size == 0 || bIsSpecialFile)
+		return OpenStream(Path, Size);
+
+#if defined(_WIN32)
+	HANDLE hFile = CreateFileW(FilePath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr,
+		CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+	// mapping a file with an explicit size extends the file to that size
+	HANDLE hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)Size >> 32), (DWORD)((uint64_t)Size & 0xFFFFFFFF), nullptr);
+	if (hMapping == nullptr) {
+		CloseHandle(hFile);
+		return OpenStream(Path, Size);
+	}
+	void* MappedPtr = MapViewOfFile(hMapping, FILE_MAP_WRITE, 0, 0, 0);
+	if (MappedPtr == nullptr) {
+		CloseHandle(hMapping);
+		CloseHandle(hFile);
+		return OpenStream(Path, Size);
+	}
+	FileHandle = hFile;
+	MappingHandle = hMapping;
+#else
+	int fd = open(Path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return false;
+	// writing to a mapped page with no backing disk block raises SIGBUS, so space must be reserved up-front
+	if (!preallocate_file(fd, Size, true)) {
+		close(fd);
+		return false;
+	}
+	void* MappedPtr = mmap(nullptr, Size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (MappedPtr == MAP_FAILED)
+		return OpenStream(Path, Size);
+#endif
+
+	DataPtr = (char*)MappedPtr;
+	DataSize = Size;
+	bIsMapped = true;
+	return true;
+}
+
+
+bool MappedFileWriter::OpenStream(const std::string& Path, size_t Size)
+{
+	FilePtr = fopen(Path.c_str(), "wb");
+	if (!FilePtr)
+		return false;
+	// callers write in large blocks, so stdio buffering only adds a copy
+	setvbuf(FilePtr, nullptr, _IONBF, 0);
+
+	// reserve space without changing the end-of-file, so that a partial write leaves a short file
+#if defined(_WIN32)
+	FILE_ALLOCATION_INFO AllocationInfo;
+	AllocationInfo.AllocationSize.QuadPart = (LONGLONG)Size;
+	SetFileInformationByHandle((HANDLE)_get_osfhandle(_fileno(FilePtr)), FileAllocationInfo, &AllocationInfo, sizeof(AllocationInfo));
+#else
+	std::error_code ErrorCode;
+	if (std::filesystem::is_regular_file(std::filesystem::path(Path), ErrorCode) && Size > 0) {
+		if (!preallocate_file(fileno(FilePtr), Size, false)) {
+			fclose(FilePtr);
+			FilePtr = nullptr;
+			return false;
+		}
+	}
+#endif
+
+	DataSize = Size;
+	bIsMapped = false;
+	bWriteError = false;
+	return true;
+}
+
+
+bool MappedFileWriter::WriteBytes(const void* Data, size_t NumBytes)
+{
+	if (FilePtr == nullptr)
+		return false;
+	bool bOK = (fwrite(Data, 1, NumBytes, FilePtr) == NumBytes);
+	bWriteError = bWriteError || !bOK;
+	return bOK;
+}
+
+
+bool MappedFileWriter::Close()
+{
+	bool bOK = true;
+	if (bIsMapped)
+	{
+#if defined(_WIN32)
+		bOK = (FlushViewOfFile(DataPtr, 0) != 0);
+		UnmapViewOfFile(DataPtr);
+		CloseHandle((HANDLE)MappingHandle);
+		CloseHandle((HANDLE)FileHandle);
+		MappingHandle = FileHandle = nullptr;
+#else
+		bOK = (munmap((void*)DataPtr, DataSize) == 0);
+#endif
+	}
+	if (FilePtr != nullptr)
+	{
+		bOK = (fclose(FilePtr) == 0) && !bWriteError;
+		FilePtr = nullptr;
+	}
+	DataPtr = nullptr;
+	DataSize = 0;
+	bIsMapped = false;
+	bWriteError = false;
+	return bOK;
+}
+
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
@@ -0,0 +1,59 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#pragma once
+
+#include "GradientspaceIOPlatform.h"
+
+#include <stdio.h>
+#include <string>
+
+
+namespace GS
+{
+
+/**
+ * Write-only output file of known size. The file is created (or truncated) and disk space
+ * for Size bytes is preallocated where the platform supports it. If bAllowMemoryMap, the file
+ * is then memory-mapped and the caller fills Data()[0..Size) directly, possibly from multiple
+ * threads. Otherwise, or if mapping fails, the contents must be written sequentially with WriteBytes().
+ *
+ * Writes to a mapped file cannot report errors, so preallocation failure (eg disk full) is
+ * reported by Open() where possible. Close() returns false if any WriteBytes() call failed.
+ */
+class MappedFileWriter
+{
+public:
+	MappedFileWriter() = default;
+	~MappedFileWriter();
+
+	MappedFileWriter(const MappedFileWriter&) = delete;
+	MappedFileWriter& operator=(const MappedFileWriter&) = delete;
+
+	bool Open(const std::string& Path, size_t Size, bool bAllowMemoryMap = true);
+	bool Close();
+
+	//! writable view of the file contents, only available if IsMapped()
+	char* Data() { return DataPtr; }
+	size_t Size() const { return DataSize; }
+	bool IsMapped() const { return bIsMapped; }
+
+	//! append NumBytes to the file. Only valid if !IsMapped()
+	bool WriteBytes(const void* Data, size_t NumBytes);
+
+protected:
+	char* DataPtr = nullptr;
+	size_t DataSize = 0;
+	bool bIsMapped = false;
+
+	FILE* FilePtr = nullptr;
+	bool bWriteError = false;
+
+#if defined(_WIN32)
+	void* FileHandle = nullptr;
+	void* MappingHandle = nullptr;
+#endif
+
+	bool OpenStream(const std::string& Path, size_t Size);
+};
+
+
+}  // end namespace GS
@@ -1,18 +1,109 @@
 // Copyright Gradientspace Corp. All Rights Reserved.
 #include "MeshIO/OBJFormatData.h"
 #include "Mesh/MeshAttributeUtils.h"
+#include "MeshIO/parallel_utils.h"
 
 #include <vector>
 #include <unordered_set>
 #include <unordered_map>
 #include <algorithm>
+#include <cmath>
+#include <limits>
 
 
 using namespace GS;
 
-void GS::DenseMeshToOBJFormatData(const DenseMesh& Mesh, OBJFormatData& OBJDataOut)
+
+OBJPolygon GS::OBJPolygonList::operator[](size_t PolygonIndex) const
+{
+	int64_t Start = Offsets[PolygonIndex];
+	OBJPolygon Polygon;
+	Polygon.NumVertices = (int)(Offsets[PolygonIndex+1] - Start);
+	Polygon.Positions = &Positions[Start];
+	Polygon.Normals = (Normals.size() > 0) ? &Normals[Start] : nullptr;
+	Polygon.UVs = (UVs.size() > 0) ? &UVs[Start] : nullptr;
+	return Polygon;
+}
+
+void GS::OBJPolygonList::clear()
+{
+	Offsets.clear();
+	Positions.clear();
+	Normals.clear();
+	UVs.clear();
+}
+
+void GS::OBJPolygonList::reserve(size_t NumPolygons, size_t NumIndices, bool bNormals, bool bUVs)
+{
+	Offsets.reserve(NumPolygons + 1);
+	Positions.reserve(NumIndices);
+	if (bNormals)
+		Normals.reserve(NumIndices);
+	if (bUVs)
+		UVs.reserve(NumIndices);
+}
+
+size_t GS::OBJPolygonList::add(int NumVertices, const int* PositionIndices, const int* NormalIndices, const int* UVIndices)
+{
+	if (Offsets.size() == 0)
+		Offsets.add(0);
+	size_t PolygonIndex = Offsets.size() - 1;
+	size_t IndexStart = Positions.size();
+
+	// normals/UVs are allocated on first use, with -1 for all previous polygons
+	if (NormalIndices != nullptr && Normals.size() == 0 && IndexStart > 0) {
+		Normals.resize(IndexStart);
+		for (size_t k = 0; k < IndexStart; ++k)
+			Normals[k] = -1;
+	}
+	if (UVIndices != nullptr && UVs.size() == 0 && IndexStart > 0) {
+		UVs.resize(IndexStart);
+		for (size_t k = 0; k < IndexStart; ++k)
+			UVs[k] = -1;
+	}
+	bool bAddNormals = (NormalIndices != nullptr) || (Normals.size() > 0);
+	bool bAddUVs = (UVIndices != nullptr) || (UVs.size() > 0);
+
+	for (int j = 0; j < NumVertices; ++j)
+		Positions.add(PositionIndices[j]);
+	if (bAddNormals) {
+		for (int j = 0; j < NumVertices; ++j)
+			Normals.add( (NormalIndices != nullptr) ? NormalIndices[j] : -1 );
+	}
+	if (bAddUVs) {
+		for (int j = 0; j < NumVertices; ++j)
+			UVs.add( (UVIndices != nullptr) ? UVIndices[j] : -1 );
+	}
+
+	Offsets.add((int64_t)Positions.size());
+	return PolygonIndex;
+}
+
+
+/**
+ * Deduplication key of a float normal/UV. parallel_index_unique_keys() compares keys bitwise, so -0 is
+ * folded to +0 to match the by-value comparison of AttributeCompressor, and all NaNs are folded to
+ * a single quiet NaN, so that NaN values are merged independent of their payload bits.
+ */
+template<typename VectorType>
+static VectorType get_float_dedup_key(VectorType Value)
+{
+	constexpr int NumComponents = (int)(sizeof(VectorType) / sizeof(float));
+	float* Components = &Value.X;
+	for (int k = 0; k < NumComponents; ++k)
+	{
+		if (Components[k] == 0)
+			Components[k] = 0.0f;
+		else if (std::isnan(Components[k]))
+			Components[k] = std::numeric_limits<float>::quiet_NaN();
+	}
+	return Value;
+}
+
+void GS::DenseMeshToOBJFormatData(const DenseMesh& Mesh, OBJFormatData& OBJDataOut, const DenseMeshToOBJOptions& Options)
 {
 	bool bWantNormals = true, bWantUVs = true, bWantVtxColors = true;
+	int NumThreads = get_num_worker_threads(Options.NumThreads);
 
 	int NumVertices = Mesh.GetVertexCount();
 	OBJDataOut.VertexPositions.reserve(NumVertices);
@@ -20,6 +111,7 @@ void GS::DenseMeshToOBJFormatData(const DenseMesh& Mesh, OBJFormatData& OBJDataO
 		OBJDataOut.VertexPositions.add(Mesh.GetPosition(vi));
 
 	int NumTriangles = Mesh.GetTriangleCount();
+	size_t NumCorners = 3 * (size_t)NumTriangles;
 
 	if (bWantVtxColors)
 	{
@@ -37,63 +129,44 @@ void GS::DenseMeshToOBJFormatData(const DenseMesh& Mesh, OBJFormatData& OBJDataO
 			OBJDataOut.VertexColors.add(ColorBlender.GetVertexValue(vi));
 	}
 
-	struct MeshTri
-	{
-		int Index;
-		int Group;
-		bool operator<(const MeshTri& Other) const { return Group < Other.Group; }
-	};
-	std::vector<MeshTri> Triangles;
-	std::unordered_set<int> AllGroupIDs;
-
-	Triangles.reserve(NumTriangles);
-	for (int ti = 0; ti < NumTriangles; ++ti)
-	{
-		int GroupID = Mesh.GetTriGroup(ti);
-		AllGroupIDs.insert(GroupID);
-		Triangles.push_back({ ti, GroupID });
-	}
-
-	[[maybe_unused]] bool bHaveGroups = AllGroupIDs.size() > 1;
-	std::stable_sort(Triangles.begin(), Triangles.end());
+	// triangles are sorted by group, in triangle order within each group
+	std::vector<int> SortedTriangles;
+	parallel_stable_sort_by_key((size_t)NumTriangles, NumThreads,
+		[&](size_t ti) { return Mesh.GetTriGroup((int)ti); }, SortedTriangles);
 
+	// per-corner indices into the deduplicated Normals and UVs
 	bool bHaveNormalIndexMap = false;
-	AttributeCompressor<Vector3d> NormalsIndex;
+	std::vector<int> CornerNormals;
 	if (bWantNormals)
 	{
-		for (int ti = 0; ti < NumTriangles; ++ti)
-		{
-			TriVtxNormals VtxNormals = Mesh.GetTriVtxNormals(ti);
-			for (int j = 0; j < 3; ++j)
-				NormalsIndex.InsertValue( (Vector3d)VtxNormals[j] );
-		}
-		OBJDataOut.Normals = std::move(NormalsIndex.UniqueValues);
+		std::vector<uint32_t> NormalCorners;
+		int NumNormals = parallel_index_unique_keys<Vector3f>(NumCorners, NumThreads,
+			[&](size_t Corner) { return get_float_dedup_key(Mesh.GetTriVtxNormals((int)(Corner/3))[(int)(Corner%3)]); }, CornerNormals, &NormalCorners);
+		OBJDataOut.Normals.resize(NumNormals);
+		for (int ni = 0; ni < NumNormals; ++ni)
+			OBJDataOut.Normals[ni] = (Vector3d)Mesh.GetTriVtxNormals((int)(NormalCorners[ni]/3))[(int)(NormalCorners[ni]%3)];
 		bHaveNormalIndexMap = true;
 	}
 
 	bool bHaveUVIndexMap = false;
-	AttributeCompressor<Vector2d> UVsIndex;
+	std::vector<int> CornerUVs;
 	if (bWantUVs)
 	{
-		for (int ti = 0; ti < NumTriangles; ++ti)
-		{
-			TriVtxUVs VtxUVs = Mesh.GetTriVtxUVs(ti);
-			for (int j = 0; j < 3; ++j)
-				UVsIndex.InsertValue((Vector2d)VtxUVs[j]);
-		}
-		OBJDataOut.UVs = std::move(UVsIndex.UniqueValues);
+		std::vector<uint32_t> UVCorners;
+		int NumUVs = parallel_index_unique_keys<Vector2f>(NumCorners, NumThreads,
+			[&](size_t Corner) { return get_float_dedup_key(Mesh.GetTriVtxUVs((int)(Corner/3))[(int)(Corner%3)]); }, CornerUVs, &UVCorners);
+		OBJDataOut.UVs.resize(NumUVs);
+		for (int ui = 0; ui < NumUVs; ++ui)
+			OBJDataOut.UVs[ui] = (Vector2d)Mesh.GetTriVtxUVs((int)(UVCorners[ui]/3))[(int)(UVCorners[ui]%3)];
 		bHaveUVIndexMap = true;
 	}
 
 	OBJDataOut.FaceStream.reserve(NumTriangles);
-	OBJDataOut.Triangles.reserve(NumTriangles);
+	OBJDataOut.Triangles.reserve(NumTriangles, bHaveNormalIndexMap, bHaveUVIndexMap);
 
-	//int CurGroupID = std::numeric_limits<int>::max();
 	for ( int k = 0; k < NumTriangles; ++k )
 	{
-		const MeshTri& SortedTri = Triangles[k];
-
-		int ti = SortedTri.Index;
+		int ti = SortedTriangles[k];
 		Index3i TriVertices = Mesh.GetTriangle(ti);
 
 		OBJTriangle NewTri;
@@ -102,22 +175,21 @@ void GS::DenseMeshToOBJFormatData(const DenseMesh& Mesh, OBJFormatData& OBJDataO
 		NewTri.Normals = Index3i(-1,-1,-1);
 		if (bHaveNormalIndexMap)
 		{
-			TriVtxNormals VtxNormals = Mesh.GetTriVtxNormals(ti);
 			for (int j = 0; j < 3; ++j)
-				NewTri.Normals[j] = NormalsIndex.GetIndexForValue( (Vector3d)VtxNormals[j], false );
+				NewTri.Normals[j] = CornerNormals[3*(size_t)ti + j];
 		}
 
 		NewTri.UVs = Index3i(-1, -1, -1);
 		if (bHaveUVIndexMap)
 		{
-			TriVtxUVs VtxUvs = Mesh.GetTriVtxUVs(ti);
 			for (int j = 0; j < 3; ++j)
-				NewTri.UVs[j] = UVsIndex.GetIndexForValue( (Vector2d)VtxUvs[j], false );
+				NewTri.UVs[j] = CornerUVs[3*(size_t)ti + j];
 		}
 
 		OBJFace Face;
 		Face.FaceType = 0;
 		Face.FaceIndex = (uint32_t)OBJDataOut.Triangles.size();
+		Face.GroupID = Mesh.GetTriGroup(ti);
 		OBJDataOut.FaceStream.add(Face);
 		OBJDataOut.Triangles.add(NewTri);
 	}
@@ -165,78 +237,299 @@ void GS::OBJFormatDataToDenseMesh(const OBJFormatData& OBJData, DenseMesh& MeshO
 	// for now do simple polygon tessellation where count can be predicted
 	int NumPolygons = (int)OBJData.Polygons.size();
 	for (int pi = 0; pi < NumPolygons; ++pi) {
-		TotalNumTriangles += (int)OBJData.Polygons[pi].Positions.size() - 2;
+		TotalNumTriangles += OBJData.Polygons.GetVertexCount(pi) - 2;
 	}
 
+	int NumThreads = get_num_worker_threads(Options.NumThreads);
+	int NumBlocks = (NumThreads > 1) ? (NumThreads * 4) : 1;
+
 	MeshOut.Resize(NumVertices, TotalNumTriangles);
+	parallel_for_ranges((size_t)NumVertices, NumBlocks, NumThreads, [&](int, size_t Start, size_t End)
+	{
+		for (size_t vid = Start; vid < End; ++vid)
+			MeshOut.SetPosition((int)vid, OBJData.VertexPositions[vid]);
+	});
+
+	// If the file only has triangles, and all their attribute indices are valid, the per-corner
+	// range checks and face-type dispatch can be skipped. The validity test is a min/max
+	// reduction over the contiguous index arrays.
+	const OBJTriangleList& Triangles = OBJData.Triangles;
+	bool bTrianglesFastPath = (OBJData.Quads.size() == 0 && OBJData.Polygons.size() == 0)
+		&& (!bWantUVs || Triangles.HasUVs()) && (!bWantNormals || Triangles.HasNormals());
+	if (bTrianglesFastPath)
+	{
+		auto IsIndexArrayInRange = [&](const unsafe_vector<Index3i>& Indices, int MaxIndex)
+		{
+			std::vector<uint8_t> BlockInRange(NumBlocks, 1);
+			parallel_for_ranges(Indices.size(), NumBlocks, NumThreads, [&](int BlockIndex, size_t Start, size_t End)
+			{
+				int MinIndex = 0, MaxFound = 0;
+				for (size_t k = Start; k < End; ++k)
+				{
+					const Index3i& Tri = Indices[k];
+					MinIndex = std::min(MinIndex, std::min(Tri.A, std::min(Tri.B, Tri.C)));
+					MaxFound = std::max(MaxFound, std::max(Tri.A, std::max(Tri.B, Tri.C)));
+				}
+				BlockInRange[BlockIndex] = (MinIndex >= 0 && MaxFound < MaxIndex) ? 1 : 0;
+			});
+			return std::all_of(BlockInRange.begin(), BlockInRange.end(), [](uint8_t b) { return b != 0; });
+		};
+		bTrianglesFastPath = (!bWantUVs || IsIndexArrayInRange(Triangles.UVs, NumUVs))
+			&& (!bWantNormals || IsIndexArrayInRange(Triangles.Normals, NumNormals))
+			&& (!bWantVertexColors || IsIndexArrayInRange(Triangles.Positions, NumColors));
+	}
 
-	for (int vid = 0; vid < OBJData.VertexPositions.size(); ++vid)
-		MeshOut.SetPosition(vid, OBJData.VertexPositions[vid]);
+	// emit the triangles of faces [FaceStart,FaceEnd), starting at output triangle tid
+	auto EmitFaces = [&](int FaceStart, int FaceEnd, int tid)
+	{
+		for (int fid = FaceStart; fid < FaceEnd; ++fid) {
+			int FaceType = OBJData.FaceStream[fid].FaceType;
+			int TypeIndex = (int)OBJData.FaceStream[fid].FaceIndex;
+			int FaceGroupID = OBJData.FaceStream[fid].GroupID;
+			if (FaceType == 0 && bTrianglesFastPath)
+			{
+				Index3i TriV = Triangles.Positions[TypeIndex];
+				MeshOut.SetTriangle(tid, TriV);
+				MeshOut.SetTriGroup(tid, FaceGroupID);
+				if (bWantUVs) {
+					Index3i TriUV = Triangles.UVs[TypeIndex];
+					TriVtxUVs UVs;
+					for (int j = 0; j < 3; ++j)
+						UVs[j] = (Vector2f)OBJData.UVs[TriUV[j]];
+					MeshOut.SetTriVtxUVs(tid, UVs);
+				}
+				if (bWantNormals) {
+					Index3i TriN = Triangles.Normals[TypeIndex];
+					TriVtxNormals Normals;
+					for (int j = 0; j < 3; ++j)
+						Normals[j] = (Vector3f)OBJData.Normals[TriN[j]];
+					MeshOut.SetTriVtxNormals(tid, Normals);
+				}
+				if (bWantVertexColors) {
+					TriVtxColors Colors;
+					for (int j = 0; j < 3; ++j)
+						Colors[j] = Color4b(OBJData.VertexColors[TriV[j]]);
+					MeshOut.SetTriVtxColors(tid, Colors);
+				}
+				tid++;
+			}
+			else if (FaceType == 0) 
+			{
+				const OBJTriangle& Tri = OBJData.Triangles[TypeIndex];
+				Index3i TriV = Tri.Positions;
+				MeshOut.SetTriangle(tid, TriV);
+				MeshOut.SetTriGroup(tid, FaceGroupID);
+				if (bWantUVs)
+					MeshOut.SetTriVtxUVs(tid, get_uv_tri(Tri.UVs));
+				if (bWantNormals)
+					MeshOut.SetTriVtxNormals(tid, get_normal_tri(Tri.Normals));
+				if (bWantVertexColors)
+					MeshOut.SetTriVtxColors(tid, get_color_tri(TriV));
+				tid++;
+			}
+			else if (FaceType == 1)
+			{
+				const OBJQuad& Quad = OBJData.Quads[TypeIndex];
+				MeshOut.SetTriangle(tid, Index3i(Quad.Positions.A, Quad.Positions.B, Quad.Positions.C));
+				MeshOut.SetTriGroup(tid, FaceGroupID);
+				if (bWantUVs)
+					MeshOut.SetTriVtxUVs(tid, get_uv_tri( Index3i(Quad.UVs.A, Quad.UVs.B, Quad.UVs.C) ));
+				if (bWantNormals)
+					MeshOut.SetTriVtxNormals(tid, get_normal_tri( Index3i(Quad.Normals.A, Quad.Normals.B, Quad.Normals.C) ));
+				if (bWantVertexColors)
+					MeshOut.SetTriVtxColors(tid, get_color_tri( Index3i(Quad.Positions.A, Quad.Positions.B, Quad.Positions.C) ));
+				tid++;
+				MeshOut.SetTriangle(tid, Index3i(Quad.Positions.A, Quad.Positions.C, Quad.Positions.D));
+				MeshOut.SetTriGroup(tid, FaceGroupID);
+				if (bWantUVs)
+					MeshOut.SetTriVtxUVs(tid, get_uv_tri( Index3i(Quad.UVs.A, Quad.UVs.C, Quad.UVs.D) ));
+				if (bWantNormals)
+					MeshOut.SetTriVtxNormals(tid, get_normal_tri( Index3i(Quad.Normals.A, Quad.Normals.C, Quad.Normals.D) ));
+				if (bWantVertexColors)
+					MeshOut.SetTriVtxColors(tid, get_color_tri(Index3i(Quad.Positions.A, Quad.Positions.C, Quad.Positions.D)) );
+				tid++;
+			}
+			else if (FaceType == 2)
+			{
+				OBJPolygon Poly = OBJData.Polygons[TypeIndex];
+				int NumV = Poly.NumVertices;
+				auto poly_tri = [&](const int* Indices, int i) {
+					return (Indices != nullptr) ? Index3i(Indices[0], Indices[i], Indices[i+1]) : Index3i(-1, -1, -1);
+				};
+				for (int i = 1; i < NumV - 1; ++i) {
+					MeshOut.SetTriangle(tid, Index3i(Poly.Positions[0], Poly.Positions[i], Poly.Positions[i+1]) );
+					MeshOut.SetTriGroup(tid, FaceGroupID);
+					if (bWantUVs)
+						MeshOut.SetTriVtxUVs(tid, get_uv_tri( poly_tri(Poly.UVs, i) ));
+					if (bWantNormals)
+						MeshOut.SetTriVtxNormals(tid, get_normal_tri( poly_tri(Poly.Normals, i) ));
+					if (bWantVertexColors)
+						MeshOut.SetTriVtxColors(tid, get_color_tri( Index3i(Poly.Positions[0], Poly.Positions[i], Poly.Positions[i+1]) ));
+					tid++;
+				}
+			}
+		}
+		return tid;
+	};
+
+	// each block of faces starts at the sum of the triangle counts of all previous blocks
+	auto GetFaceTriangleCount = [&](const OBJFace& Face)
+	{
+		switch (Face.FaceType) {
+			case 0: return 1;
+			case 1: return 2;
+			case 2: return std::max(OBJData.Polygons.GetVertexCount(Face.FaceIndex) - 2, 0);
+			default: return 0;
+		}
+	};
+	std::vector<int> BlockTriangleStarts(NumBlocks + 1, 0);
+
+	// emit the triangles of faces [FaceStart,FaceEnd), starting at output triangle tid, and return the next tid
+	auto EmitFaceRange = [&](int FaceStart, int FaceEnd, int tid)
+	{
+		if (NumBlocks == 1)
+			return EmitFaces(FaceStart, FaceEnd, tid);
 
-	int tid = 0;
-	for (int fid = 0; fid < OBJData.FaceStream.size(); ++fid) {
-		int FaceType = OBJData.FaceStream[fid].FaceType;
-		int TypeIndex = (int)OBJData.FaceStream[fid].FaceIndex;
-		int FaceGroupID = OBJData.FaceStream[fid].GroupID;
-		if (FaceType == 0) 
+		size_t NumRangeFaces = (size_t)(FaceEnd - FaceStart);
+		parallel_for_ranges(NumRangeFaces, NumBlocks, NumThreads, [&](int BlockIndex, size_t Start, size_t End)
 		{
-			const OBJTriangle& Tri = OBJData.Triangles[TypeIndex];
-			Index3i TriV = Tri.Positions;
-			MeshOut.SetTriangle(tid, TriV);
-			MeshOut.SetTriGroup(tid, FaceGroupID);
-			if (bWantUVs)
-				MeshOut.SetTriVtxUVs(tid, get_uv_tri(Tri.UVs));
-			if (bWantNormals)
-				MeshOut.SetTriVtxNormals(tid, get_normal_tri(Tri.Normals));
-			if (bWantVertexColors)
-				MeshOut.SetTriVtxColors(tid, get_color_tri(TriV));
-			tid++;
+			int NumBlockTriangles = 0;
+			for (size_t fid = FaceStart + Start; fid < FaceStart + End; ++fid)
+				NumBlockTriangles += GetFaceTriangleCount(OBJData.FaceStream[fid]);
+			BlockTriangleStarts[BlockIndex+1] = NumBlockTriangles;
+		});
+		BlockTriangleStarts[0] = tid;
+		for (int k = 0; k < NumBlocks; ++k)
+			BlockTriangleStarts[k+1] += BlockTriangleStarts[k];
+
+		parallel_for_ranges(NumRangeFaces, NumBlocks, NumThreads, [&](int BlockIndex, size_t Start, size_t End)
+		{
+			EmitFaces(FaceStart + (int)Start, FaceStart + (int)End, BlockTriangleStarts[BlockIndex]);
+		});
+		return BlockTriangleStarts[NumBlocks];
+	};
+
+	EmitFaceRange(0, NumFaces, 0);
+}
+
+
+
+void GS::OBJFormatDataToPolyMesh(const OBJFormatData& OBJData, PolyMesh& MeshOut, const OBJToPolyMeshOptions& Options)
+{
+	const int UseNormalSet = 0;
+	const int UseUVSet = 0;
+	const int UseColorSet = 0;
+	const int UseGroupSet = 0;
+
+	int NumVertices = (int)OBJData.VertexPositions.size();
+	int NumNormals = (int)OBJData.Normals.size();
+	bool bWantNormals = (Options.bIgnoreNormals == false && NumNormals > 0);
+	int NumUVs = (int)OBJData.UVs.size();
+	bool bWantUVs = (Options.bIgnoreUVs == false && NumUVs > 0);
+	int NumColors = (int)OBJData.VertexColors.size();
+	bool bWantVertexColors = (Options.bIgnoreColors == false && NumColors > 0);
+
+	// PolyMesh faces are appended one at a time, so only the face storage can be sized up front, from the OBJ face list sizes
+	int NumFaces = (int)OBJData.FaceStream.size();
+	MeshOut = PolyMesh();
+	MeshOut.ReserveVertices(NumVertices);
+	MeshOut.ReserveFaces((int)OBJData.Triangles.size(), (int)OBJData.Quads.size(), (int)OBJData.Polygons.size());
+
+	for (int vi = 0; vi < NumVertices; ++vi)
+		MeshOut.AddVertex(OBJData.VertexPositions[vi]);
+
+	MeshOut.SetNumFaceGroupSets(UseGroupSet + 1);
+	if (bWantNormals)
+	{
+		MeshOut.SetNumNormalSets(UseNormalSet + 1);
+		for (int ni = 0; ni < NumNormals; ++ni)
+			MeshOut.AddNormal((Vector3f)OBJData.Normals[ni], UseNormalSet);
+	}
+	if (bWantUVs)
+	{
+		MeshOut.SetNumUVSets(UseUVSet + 1);
+		for (int ui = 0; ui < NumUVs; ++ui)
+			MeshOut.AddUV((Vector2f)OBJData.UVs[ui], UseUVSet);
+	}
+	if (bWantVertexColors)
+	{
+		MeshOut.SetNumColorSets(UseColorSet + 1);
+		for (int ci = 0; ci < NumColors; ++ci) {
+			const Vector3f& Color = OBJData.VertexColors[ci];
+			MeshOut.AddColor(Vector4f(Color.X, Color.Y, Color.Z, 1.0f), UseColorSet);
 		}
-		else if (FaceType == 1)
+	}
+
+	// missing/invalid attribute indices reference a default element, which is appended on first use
+	int DefaultNormal = -1, DefaultUV = -1, DefaultColor = -1;
+	auto get_normal_index = [&](int Index) {
+		if (Index >= 0 && Index < NumNormals) return Index;
+		if (DefaultNormal < 0) DefaultNormal = MeshOut.AddNormal(Vector3f::UnitZ(), UseNormalSet);
+		return DefaultNormal;
+	};
+	auto get_uv_index = [&](int Index) {
+		if (Index >= 0 && Index < NumUVs) return Index;
+		if (DefaultUV < 0) DefaultUV = MeshOut.AddUV(Vector2f::Zero(), UseUVSet);
+		return DefaultUV;
+	};
+	auto get_color_index = [&](int VertexIndex) {
+		if (VertexIndex >= 0 && VertexIndex < NumColors) return VertexIndex;
+		if (DefaultColor < 0) DefaultColor = MeshOut.AddColor(Vector4f(1.0f, 1.0f, 1.0f, 1.0f), UseColorSet);
+		return DefaultColor;
+	};
+
+	// set the group and per-face-vertex attribute indices of a new face. Normals/UVs may be null (ie all missing)
+	auto set_face_attributes = [&](int NewFaceIndex, int GroupID, int NumFaceVertices, const int* Positions, const int* Normals, const int* UVs)
+	{
+		MeshOut.SetFaceGroup(NewFaceIndex, GroupID, UseGroupSet);
+		PolyMesh::Face NewFace = MeshOut.GetFace(NewFaceIndex);
+		for (int j = 0; j < NumFaceVertices; ++j)
 		{
-			const OBJQuad& Quad = OBJData.Quads[TypeIndex];
-			MeshOut.SetTriangle(tid, Index3i(Quad.Positions.A, Quad.Positions.B, Quad.Positions.C));
-			MeshOut.SetTriGroup(tid, FaceGroupID);
-			if (bWantUVs)
-				MeshOut.SetTriVtxUVs(tid, get_uv_tri( Index3i(Quad.UVs.A, Quad.UVs.B, Quad.UVs.C) ));
 			if (bWantNormals)
-				MeshOut.SetTriVtxNormals(tid, get_normal_tri( Index3i(Quad.Normals.A, Quad.Normals.B, Quad.Normals.C) ));
-			if (bWantVertexColors)
-				MeshOut.SetTriVtxColors(tid, get_color_tri( Index3i(Quad.Positions.A, Quad.Positions.B, Quad.Positions.C) ));
-			tid++;
-			MeshOut.SetTriangle(tid, Index3i(Quad.Positions.A, Quad.Positions.C, Quad.Positions.D));
-			MeshOut.SetTriGroup(tid, FaceGroupID);
+				MeshOut.SetFaceVertexNormalIndex(NewFace, j, get_normal_index((Normals != nullptr) ? Normals[j] : -1), UseNormalSet);
 			if (bWantUVs)
-				MeshOut.SetTriVtxUVs(tid, get_uv_tri( Index3i(Quad.UVs.A, Quad.UVs.C, Quad.UVs.D) ));
-			if (bWantNormals)
-				MeshOut.SetTriVtxNormals(tid, get_normal_tri( Index3i(Quad.Normals.A, Quad.Normals.C, Quad.Normals.D) ));
+				MeshOut.SetFaceVertexUVIndex(NewFace, j, get_uv_index((UVs != nullptr) ? UVs[j] : -1), UseUVSet);
 			if (bWantVertexColors)
-				MeshOut.SetTriVtxColors(tid, get_color_tri(Index3i(Quad.Positions.A, Quad.Positions.C, Quad.Positions.D)) );
-			tid++;
+				MeshOut.SetFaceVertexColorIndex(NewFace, j, get_color_index(Positions[j]), UseColorSet);
 		}
-		else if (FaceType == 2)
+	};
+
+	const OBJTriangleList& Triangles = OBJData.Triangles;
+	const OBJQuadList& Quads = OBJData.Quads;
+	std::vector<int> PolygonPositions;
+	for (int fid = 0; fid < NumFaces; ++fid)
+	{
+		const OBJFace& Face = OBJData.FaceStream[fid];
+		int TypeIndex = (int)Face.FaceIndex;
+		if (Face.FaceType == 0)
 		{
-			const OBJPolygon& Poly = OBJData.Polygons[TypeIndex];
-			int NumV = (int)Poly.Positions.size();
-			for (int i = 1; i < NumV - 1; ++i) {
-				MeshOut.SetTriangle(tid, Index3i(Poly.Positions[0], Poly.Positions[i], Poly.Positions[i+1]) );
-				MeshOut.SetTriGroup(tid, FaceGroupID);
-				if (bWantUVs)
-					MeshOut.SetTriVtxUVs(tid, get_uv_tri( Index3i(Poly.UVs[0], Poly.UVs[i], Poly.UVs[i+1]) ));
-				if (bWantNormals)
-					MeshOut.SetTriVtxNormals(tid, get_normal_tri( Index3i(Poly.Normals[0], Poly.Normals[i], Poly.Normals[i+1]) ));
-				if (bWantVertexColors)
-					MeshOut.SetTriVtxColors(tid, get_color_tri( Index3i(Poly.Positions[0], Poly.Positions[i], Poly.Positions[i+1]) ));
-				tid++;
-			}
+			const Index3i& Positions = Triangles.Positions[TypeIndex];
+			int NewFaceIndex = MeshOut.AddTriangle(Positions);
+			set_face_attributes(NewFaceIndex, (int)Face.GroupID, 3, &Positions.A,
+				Triangles.HasNormals() ? &Triangles.Normals[TypeIndex].A : nullptr,
+				Triangles.HasUVs() ? &Triangles.UVs[TypeIndex].A : nullptr);
+		}
+		else if (Face.FaceType == 1)
+		{
+			const Index4i& Positions = Quads.Positions[TypeIndex];
+			int NewFaceIndex = MeshOut.AddQuad(Positions);
+			set_face_attributes(NewFaceIndex, (int)Face.GroupID, 4, &Positions.A,
+				Quads.HasNormals() ? &Quads.Normals[TypeIndex].A : nullptr,
+				Quads.HasUVs() ? &Quads.UVs[TypeIndex].A : nullptr);
+		}
+		else if (Face.FaceType == 2)
+		{
+			OBJPolygon Poly = OBJData.Polygons[TypeIndex];
+			if (Poly.NumVertices < 3)
+				continue;		// degenerate polygon
+			PolygonPositions.assign(Poly.Positions, Poly.Positions + Poly.NumVertices);
+			int NewFaceIndex = MeshOut.AddPolygon(PolygonPositions);
+			set_face_attributes(NewFaceIndex, (int)Face.GroupID, Poly.NumVertices, Poly.Positions, Poly.Normals, Poly.UVs);
 		}
-
 	}
-
 }
 
 
-
 void GS::PolyMeshToOBJFormatData(const PolyMesh& Mesh, OBJFormatData& OBJDataOut)
 {
 	bool bWantNormals = true;
@@ -323,9 +616,11 @@ void GS::PolyMeshToOBJFormatData(const PolyMesh& Mesh, OBJFormatData& OBJDataOut
 
 
 	OBJDataOut.FaceStream.reserve(NumFaces);
-	OBJDataOut.Triangles.reserve(Mesh.GetTriangleCount());
-	OBJDataOut.Quads.reserve(Mesh.GetQuadCount());
-	OBJDataOut.Polygons.reserve(Mesh.GetPolygonCount());
+	OBJDataOut.Triangles.reserve(Mesh.GetTriangleCount(), bHaveNormals, bHaveUVs);
+	OBJDataOut.Quads.reserve(Mesh.GetQuadCount(), bHaveNormals, bHaveUVs);
+	OBJDataOut.Polygons.reserve(Mesh.GetPolygonCount(), 5 * Mesh.GetPolygonCount(), bHaveNormals, bHaveUVs);
+
+	std::vector<int> PolygonPositions, PolygonNormals, PolygonUVs;
 
 	//int CurGroupID = std::numeric_limits<int>::max();
 	for (int k = 0; k < NumFaces; ++k)
@@ -380,24 +675,24 @@ void GS::PolyMeshToOBJFormatData(const PolyMesh& Mesh, OBJFormatData& OBJDataOut
 			int NumFaceVertices = Mesh.GetNumFaceVertices(Face);
 
 			const PolyMesh::Polygon& SourcePoly = Mesh.GetPolygon(Face);
-			OBJPolygon NewPolygon;
-			NewPolygon.Positions.resize(NumFaceVertices);
+			PolygonPositions.resize(NumFaceVertices);
 			for (int j = 0; j < NumFaceVertices; ++j)
-				NewPolygon.Positions[j] = SourcePoly.Vertices[j];
+				PolygonPositions[j] = SourcePoly.Vertices[j];
+			PolygonNormals.resize(NumFaceVertices);
+			PolygonUVs.resize(NumFaceVertices);
 
 			if (bHaveNormals) {
-				NewPolygon.Normals.resize(NumFaceVertices);
 				for (int j = 0; j < NumFaceVertices; ++j)
-					NewPolygon.Normals[j] = Mesh.GetFaceVertexNormalIndex(Face, j, UseNormalSet);
+					PolygonNormals[j] = Mesh.GetFaceVertexNormalIndex(Face, j, UseNormalSet);
 			}
 
 			if (bHaveUVs) {
-				NewPolygon.UVs.resize(NumFaceVertices);
 				for (int j = 0; j < NumFaceVertices; ++j)
-					NewPolygon.UVs[j] = Mesh.GetFaceVertexUVIndex(Face, j, UseUVSet);
+					PolygonUVs[j] = Mesh.GetFaceVertexUVIndex(Face, j, UseUVSet);
 			}
 
-			OBJFaceIndex = (int)OBJDataOut.Polygons.add(std::move(NewPolygon));
+			OBJFaceIndex = (int)OBJDataOut.Polygons.add(NumFaceVertices, PolygonPositions.data(),
+				(bHaveNormals) ? PolygonNormals.data() : nullptr, (bHaveUVs) ? PolygonUVs.data() : nullptr);
 		}
 		if (OBJFaceIndex == -1) 
 			continue;
@@ -8,10 +8,15 @@
 #include <algorithm>
 #include <cctype>
 #include <cstdlib>
+#include <cstdio>
 
 #include <filesystem>
-#include <stdio.h>
 
+#include "MeshIO/BlockReadAheadReader.h"
+#include "MeshIO/MappedFileBuffer.h"
+#include "MeshIO/float_parsing.h"
+#include "MeshIO/parallel_utils.h"
+#include "MeshIO/parse_result_cache.h"
 #include "MeshIO/parse_utils.h"
 
 #if defined(_MSC_VER)
@@ -28,209 +33,856 @@ struct OBJParsingState
 	int CurrentGroupID = 0;
 
 	bool bHaveMeshmixerGroupIDs = false;
+
+	bool bMayBeInFileHeader = true;
+
+	// number of faces appended before the first mm_gid comment was seen. When parsing a
+	// chunk of a larger file, the group IDs of these faces are relative to the (unknown)
+	// group ID at the start of the chunk.
+	int NumFacesBeforeMeshmixerGroupID = -1;
 };
 
 
-// returns char* ptr to character after next space, and index
-static char* find_after_next_space(char* String, int* first_space_index = nullptr)
+static void parse_vertex(const char* Start, const char* End, OBJReader::OBJVertex& Vertex, bool bParseColors)
 {
-	int i = 0;
-	while ( !is_line_space(String[i]) && String[i] != null_char )
+	const char* Cur = find_next_token(Start, End);
+	double XYZ[3] = { 0,0,0 };
+	parse_real_list(Cur, End, XYZ, 3);
+	Vertex.Position = Vector3d(XYZ[0], XYZ[1], XYZ[2]);
+
+	Vertex.bHaveColor = (bParseColors && Cur < End);
+	if (Vertex.bHaveColor)
 	{
-		i++;
+		float RGB[3] = { 0,0,0 };
+		parse_real_list(Cur, End, RGB, 3);
+		Vertex.Color = Vector3f(RGB[0], RGB[1], RGB[2]);
 	}
-	if (first_space_index != nullptr)
-		*first_space_index = i;
+}
 
-	while (is_line_space(String[i]))
-		i++;
-	if (String[i] == null_char) 
-		return nullptr;
+static Vector3d parse_normal(const char* Start, const char* End)
+{
+	const char* Cur = find_next_token(Start, End);
+	double N[3] = { 0,0,0 };
+	parse_real_list(Cur, End, N, 3);
+	return Vector3d(N[0], N[1], N[2]);
+}
 
-	return (String + i);
+static Vector2d parse_uv(const char* Start, const char* End)
+{
+	const char* Cur = find_next_token(Start, End);
+	double UV[2] = { 0,0 };
+	parse_real_list(Cur, End, UV, 2);
+	return Vector2d(UV[0], UV[1]);
 }
 
 
-static void append_vertex(char* String, GS::OBJFormatData& Data)
+/**
+ * Accumulates parsed elements and passes them to an IOBJVisitor in batches. Only one type of
+ * element is buffered at a time, and it is flushed whenever a different type of element is
+ * added, so the visitor sees all events in file order.
+ */
+class OBJEventBatcher
 {
-	char* coord_x = find_after_next_space(String);
-	char* coord_y = find_after_next_space(coord_x);
-	char* coord_z = find_after_next_space(coord_y);
-	double X = (coord_x != nullptr) ? std::strtod(coord_x, nullptr) : 0;
-	double Y = (coord_y != nullptr) ? std::strtod(coord_y, nullptr) : 0;
-	double Z = (coord_z != nullptr) ? std::strtod(coord_z, nullptr) : 0;
+public:
+	static constexpr size_t MaxBatchSize = 1024;
 
-	Data.VertexPositions.add(Vector3d(X, Y, Z));
+	OBJEventBatcher(OBJReader::IOBJVisitor& VisitorIn) : Visitor(VisitorIn)
+	{
+		Vertices.reserve(MaxBatchSize);
+		Normals.reserve(MaxBatchSize);
+		UVs.reserve(MaxBatchSize);
+		Faces.reserve(MaxBatchSize);
+		FaceOffsets.reserve(MaxBatchSize);
+		FacePositions.reserve(MaxBatchSize*4);
+	}
 
-	char* color_r = find_after_next_space(coord_z);
-	if (color_r != nullptr)
+	OBJReader::OBJVertex& AppendVertex()
 	{
-		char* color_g = find_after_next_space(color_r);
-		char* color_b = find_after_next_space(color_g);
-		float R = (color_r != nullptr) ? std::strtof(color_r, nullptr) : 0;
-		float G = (color_g != nullptr) ? std::strtof(color_g, nullptr) : 0;
-		float B = (color_b != nullptr) ? std::strtof(color_b, nullptr) : 0;
-		Data.VertexColors.add(Vector3f(R, G, B));
+		begin_batch(EBatchType::Vertices);
+		Vertices.resize(Vertices.size() + 1);
+		return Vertices.back();
+	}
+	void AppendNormal(const Vector3d& Normal)
+	{
+		begin_batch(EBatchType::Normals);
+		Normals.push_back(Normal);
+	}
+	void AppendUV(const Vector2d& UV)
+	{
+		begin_batch(EBatchType::UVs);
+		UVs.push_back(UV);
+	}
+
+	//! count a vn/vt line that is not parsed. Reported to the visitor when the current batch is flushed, so it does not split batches
+	void SkipLine()
+	{
+		NumSkippedLines++;
+	}
+
+	/**
+	 * parse face line into (0-based) position/normal/uv indices. Normal and UV indices are
+	 * skipped if bParseNormals/bParseUVs are false, or if not all face vertices have them.
+	 */
+	void ParseAndAppendFace(const char* Start, const char* End, bool bParseNormals, bool bParseUVs)
+	{
+		begin_batch(EBatchType::Faces);
+
+		FaceRecord Face;
+		Face.PositionStart = (int)FacePositions.size();
+		Face.NormalStart = (int)FaceNormals.size();
+		Face.UVStart = (int)FaceUVs.size();
+
+		bool bParseAttributes = bParseNormals || bParseUVs;
+
+		// vertex group is either just an integer vertex index, or vertidx//normalidx, or vertidx/uvidx, or vertidx/uvidx/normalidx
+		const char* next_vertex_group = find_next_token(Start, End);
+		while (next_vertex_group < End)
+		{
+			const char* group_end = find_token_end(next_vertex_group, End);
+
+			FacePositions.push_back( parse_int(next_vertex_group, group_end) - 1 );
+
+			const char* first_slash = (bParseAttributes) ? find_char(next_vertex_group, group_end, '/') : group_end;
+			if (first_slash < group_end)
+			{
+				if (first_slash+1 < group_end && first_slash[1] == '/')
+				{
+					// have two slashes in a row, second index is the normal
+					if (bParseNormals)
+						FaceNormals.push_back( parse_int(first_slash + 2, group_end) - 1 );
+				}
+				else
+				{
+					if (bParseUVs)
+						FaceUVs.push_back( parse_int(first_slash + 1, group_end) - 1 );
+
+					const char* second_slash = (bParseNormals) ? find_char(first_slash + 1, group_end, '/') : group_end;
+					if (second_slash < group_end)
+						FaceNormals.push_back( parse_int(second_slash + 1, group_end) - 1 );
+				}
+			}
+
+			next_vertex_group = skip_line_space(group_end, End);
+		}
+
+		int NumVertices = (int)FacePositions.size() - Face.PositionStart;
+		if (NumVertices == 0)
+			return;
+		if ((int)FaceNormals.size() - Face.NormalStart != NumVertices) {
+			FaceNormals.resize(Face.NormalStart);
+			Face.NormalStart = -1;
+		}
+		if ((int)FaceUVs.size() - Face.UVStart != NumVertices) {
+			FaceUVs.resize(Face.UVStart);
+			Face.UVStart = -1;
+		}
+		FaceOffsets.push_back(Face);
+
+		if (FaceOffsets.size() >= MaxBatchSize)
+			Flush();
+	}
+
+	void Flush()
+	{
+		switch (CurrentBatch)
+		{
+		case EBatchType::Vertices:
+			Visitor.OnVertices(Vertices.data(), Vertices.size());
+			Vertices.clear();
+			break;
+		case EBatchType::Normals:
+			Visitor.OnNormals(Normals.data(), Normals.size());
+			Normals.clear();
+			break;
+		case EBatchType::UVs:
+			Visitor.OnUVs(UVs.data(), UVs.size());
+			UVs.clear();
+			break;
+		case EBatchType::Faces:
+			flush_faces();
+			break;
+		default:
+			break;
+		}
+		CurrentBatch = EBatchType::None;
+		if (NumSkippedLines > 0) {
+			Visitor.OnSkippedLines(NumSkippedLines);
+			NumSkippedLines = 0;
+		}
+	}
+
+	// unbatched events flush any pending batch first
+	OBJReader::IOBJVisitor& GetVisitor()
+	{
+		Flush();
+		return Visitor;
+	}
+
+protected:
+	OBJReader::IOBJVisitor& Visitor;
+
+	enum class EBatchType
+	{
+		None, Vertices, Normals, UVs, Faces
+	};
+	EBatchType CurrentBatch = EBatchType::None;
+	size_t NumSkippedLines = 0;
+
+	std::vector<OBJReader::OBJVertex> Vertices;
+	std::vector<Vector3d> Normals;
+	std::vector<Vector2d> UVs;
+
+	// faces are stored as flat index arrays, and views into them are created on flush
+	struct FaceRecord
+	{
+		int PositionStart;
+		int NormalStart;		// -1 if no normals
+		int UVStart;			// -1 if no UVs
+	};
+	std::vector<FaceRecord> FaceOffsets;
+	std::vector<int> FacePositions;
+	std::vector<int> FaceNormals;
+	std::vector<int> FaceUVs;
+	std::vector<OBJPolygon> Faces;
+
+	void begin_batch(EBatchType BatchType)
+	{
+		if (CurrentBatch != BatchType)
+			Flush();
+		else if (BatchType != EBatchType::Faces && current_batch_size() >= MaxBatchSize)
+			Flush();
+		CurrentBatch = BatchType;
+	}
+
+	size_t current_batch_size() const
+	{
+		switch (CurrentBatch)
+		{
+		case EBatchType::Vertices: return Vertices.size();
+		case EBatchType::Normals: return Normals.size();
+		case EBatchType::UVs: return UVs.size();
+		default: return 0;
+		}
+	}
+
+	void flush_faces()
+	{
+		size_t NumFaces = FaceOffsets.size();
+		Faces.resize(NumFaces);
+		for (size_t k = 0; k < NumFaces; ++k)
+		{
+			const FaceRecord& Face = FaceOffsets[k];
+			int NextStart = (k+1 < NumFaces) ? FaceOffsets[k+1].PositionStart : (int)FacePositions.size();
+			Faces[k].NumVertices = NextStart - Face.PositionStart;
+			Faces[k].Positions = &FacePositions[Face.PositionStart];
+			Faces[k].Normals = (Face.NormalStart >= 0) ? &FaceNormals[Face.NormalStart] : nullptr;
+			Faces[k].UVs = (Face.UVStart >= 0) ? &FaceUVs[Face.UVStart] : nullptr;
+		}
+		if (NumFaces > 0)
+			Visitor.OnFaces(Faces.data(), NumFaces);
+		FaceOffsets.clear();
+		FacePositions.clear();
+		FaceNormals.clear();
+		FaceUVs.clear();
+	}
+};
+
+
+/**
+ * Tokenize all lines in [BufferStart,BufferEnd) and pass them to Visitor. Lines are tokenized in-place
+ * in the buffer, which is not modified and does not need to be null-terminated.
+ */
+static void visit_obj_buffer(
+	const char* BufferStart, const char* BufferEnd,
+	OBJEventBatcher& Batcher,
+	const OBJReader::ReadOptions& Options)
+{
+	const char* LineStart = BufferStart;
+	while (LineStart < BufferEnd)
+	{
+		const char* LineEnd = find_line_end(LineStart, BufferEnd);
+		const char* NextLineStart = (LineEnd < BufferEnd) ? LineEnd + 1 : BufferEnd;
+
+		const char* Start = LineStart;
+		const char* End = LineEnd;
+		LineStart = NextLineStart;
+
+		trim_line_span(Start, End);
+		if (Start == End) continue;		// empty line
+
+		if (Start[0] == '#' || Start[0] == '/') {
+			Batcher.GetVisitor().OnComment(std::string_view(Start, End - Start));
+			continue;
+		}
+
+		char Next = (End - Start > 1) ? Start[1] : null_char;
+		if (Start[0] == 'v')
+		{
+			if (Next == 'n')
+			{
+				if (Options.bNormals)
+					Batcher.AppendNormal(parse_normal(Start, End));
+				else
+					Batcher.SkipLine();
+			}
+			else if (Next == 't')
+			{
+				if (Options.bUVs)
+					Batcher.AppendUV(parse_uv(Start, End));
+				else
+					Batcher.SkipLine();
+			}
+			else
+			{
+				parse_vertex(Start, End, Batcher.AppendVertex(), Options.bVertexColors);
+			}
+		}
+		else if (Start[0] == 'f')
+		{
+			Batcher.ParseAndAppendFace(Start, End, Options.bNormals, Options.bUVs);
+		}
+		else if (Start[0] == 'g')
+		{
+			const char* NameStart = find_next_token(Start, End);
+			Batcher.GetVisitor().OnGroup(std::string_view(NameStart, End - NameStart));
+		}
+		else if (End - Start > 6 && memcmp(Start, "usemtl", 6) == 0 && is_line_space(Start[6]))
+		{
+			const char* NameStart = find_next_token(Start, End);
+			Batcher.GetVisitor().OnMaterial(std::string_view(NameStart, End - NameStart));
+		}
+		else
+		{
+			Batcher.GetVisitor().OnOtherLine(std::string_view(Start, End - Start));
+		}
 	}
 }
 
-static void append_normal(char* String, GS::OBJFormatData& Data)
+static void visit_obj_buffer(
+	const char* BufferStart, const char* BufferEnd,
+	OBJReader::IOBJVisitor& Visitor,
+	const OBJReader::ReadOptions& Options)
 {
-	char* coord_nx = find_after_next_space(String);
-	char* coord_ny = find_after_next_space(coord_nx);
-	char* coord_nz = find_after_next_space(coord_ny);
-	double NX = (coord_nx != nullptr) ? std::strtod(coord_nx, nullptr) : 0;
-	double NY = (coord_ny != nullptr) ? std::strtod(coord_ny, nullptr) : 0;
-	double NZ = (coord_nz != nullptr) ? std::strtod(coord_nz, nullptr) : 0;
-
-	Data.Normals.add(Vector3d(NX, NY, NZ));
+	OBJEventBatcher Batcher(Visitor);
+	visit_obj_buffer(BufferStart, BufferEnd, Batcher, Options);
+	Batcher.Flush();
 }
 
-static void append_uv(char* String, GS::OBJFormatData& Data)
+
+/**
+ * Read the file at Path in blocks with a BlockReadAheadReader, and pass the lines of each block
+ * to Visitor while the next blocks are read in the background.
+ */
+static bool visit_obj_file_read_ahead(
+	const std::string& Path,
+	OBJReader::IOBJVisitor& Visitor,
+	const OBJReader::ReadOptions& Options)
 {
-	char* coord_u = find_after_next_space(String);
-	char* coord_v = find_after_next_space(coord_u);
-	//char* coord_z = find_after_next_space(coord_y);
-	double U = (coord_u != nullptr) ? std::strtod(coord_u, nullptr) : 0;
-	double V = (coord_v != nullptr) ? std::strtod(coord_v, nullptr) : 0;
-	//double Z = (coord_z != nullptr) ? std::strtod(coord_z, nullptr) : 0;
-
-	Data.UVs.add(Vector2d(U, V));
+	BlockReadAheadReader Reader;
+	if (!Reader.Open(Path, Options.ReadAheadBlockSize, Options.ReadAheadQueueDepth))
+		return false;
+
+	OBJEventBatcher Batcher(Visitor);
+	bool bReadOK = Reader.ReadLineRanges([&](const char* Start, const char* End) {
+		visit_obj_buffer(Start, End, Batcher, Options);
+		return true;
+	});
+	Batcher.Flush();
+	return bReadOK;
 }
 
 
-static int index_of_nonspace(const char* String, int start_index, char c)
+
+static void process_comment(
+	const char* Start, const char* End, OBJParsingState& ParsingState)
 {
-	int cur_index = start_index;
-	//bool bFound = false;
-	while (1)
+	int mmgid_index = index_of_substring(Start, End, "mm_gid");
+	if (mmgid_index >= 0)
 	{
-		if (String[cur_index] == c)
-			return cur_index;
-		cur_index++;
-		if (isspace(String[cur_index]) || String[cur_index] == null_char)
-			return -1;
+		const char* groupid_token = find_next_token(Start + mmgid_index, End);
+		if (groupid_token < End)
+		{
+			int GroupID = parse_int(groupid_token, End);
+			ParsingState.bHaveMeshmixerGroupIDs = true;
+			ParsingState.CurrentGroupID = GroupID;
+		}
 	}
 }
 
-static int index_of_substring(const char* String, const char* Substring)
+
+static void append_face(const OBJPolygon& Face, const OBJParsingState& ParsingState, OBJFormatData& OBJDataOut)
 {
-	// arbitrary max...
-	int M = (int)strnlen(Substring, 1024);
-	if (M >= 1023) return -1;
-	int i = 0;
-	while (String[i] != null_char)
-	{
-		if (String[i] == Substring[0])
-		{
-			int j = 1, iStart = i;
-			i++;
-			while (String[i] == Substring[j])
-			{
-				j++;
-				i++;
-				if (j == M)
-					return iStart;
-			}
+	const int* P = Face.Positions;
+	const int* N = Face.Normals;
+	const int* T = Face.UVs;
 
-		}
-		else
-			i++;
+	OBJFace NewFace;
+	NewFace.GroupID = ParsingState.CurrentGroupID;
+	if (Face.NumVertices == 3)
+	{
+		Index3i TriNormals, TriUVs;
+		if (N != nullptr)
+			TriNormals = Index3i(N[0], N[1], N[2]);
+		if (T != nullptr)
+			TriUVs = Index3i(T[0], T[1], T[2]);
+		NewFace.FaceType = 0;
+		NewFace.FaceIndex = (uint32_t)OBJDataOut.Triangles.add( Index3i(P[0], P[1], P[2]),
+			(N != nullptr) ? &TriNormals : nullptr, (T != nullptr) ? &TriUVs : nullptr );
+	}
+	else if (Face.NumVertices == 4)
+	{
+		Index4i QuadNormals, QuadUVs;
+		if (N != nullptr)
+			QuadNormals = Index4i(N[0], N[1], N[2], N[3]);
+		if (T != nullptr)
+			QuadUVs = Index4i(T[0], T[1], T[2], T[3]);
+		NewFace.FaceType = 1;
+		NewFace.FaceIndex = (uint32_t)OBJDataOut.Quads.add( Index4i(P[0], P[1], P[2], P[3]),
+			(N != nullptr) ? &QuadNormals : nullptr, (T != nullptr) ? &QuadUVs : nullptr );
+	}
+	else if (Face.NumVertices > 4)
+	{
+		NewFace.FaceType = 2;
+		NewFace.FaceIndex = (uint32_t)OBJDataOut.Polygons.add(Face.NumVertices, P, N, T);
 	}
-	return -1;
+	else
+		return;		// ignore degenerate faces
+
+	OBJDataOut.FaceStream.add(NewFace);
 }
 
-struct OBJParsedFace
+
+/**
+ * IOBJVisitor that builds OBJFormatData, ie the implementation of ReadOBJ()
+ */
+class OBJFormatDataBuilder : public OBJReader::IOBJVisitor
 {
-	std::vector<int> PositionIndices;
-	std::vector<int> NormalIndices;
-	std::vector<int> UVIndices;
+public:
+	OBJFormatData& OBJDataOut;
+	OBJParsingState& ParsingState;
+	bool bEnableMeshmixerTriGroupProcessing = true;
+
+	OBJFormatDataBuilder(OBJFormatData& DataIn, OBJParsingState& StateIn, const OBJReader::ReadOptions& Options)
+		: OBJDataOut(DataIn), ParsingState(StateIn)
+	{
+		bEnableMeshmixerTriGroupProcessing = Options.bEnableMeshmixerTriGroupProcessing;
+	}
+
+	virtual void OnVertices(const OBJReader::OBJVertex* Vertices, size_t Count) override
+	{
+		ParsingState.bMayBeInFileHeader = false;
+		for (size_t k = 0; k < Count; ++k)
+		{
+			OBJDataOut.VertexPositions.add(Vertices[k].Position);
+			if (Vertices[k].bHaveColor)
+				OBJDataOut.VertexColors.add(Vertices[k].Color);
+		}
+	}
+	virtual void OnNormals(const Vector3d* Normals, size_t Count) override
+	{
+		ParsingState.bMayBeInFileHeader = false;
+		for (size_t k = 0; k < Count; ++k)
+			OBJDataOut.Normals.add(Normals[k]);
+	}
+	virtual void OnUVs(const Vector2d* UVs, size_t Count) override
+	{
+		ParsingState.bMayBeInFileHeader = false;
+		for (size_t k = 0; k < Count; ++k)
+			OBJDataOut.UVs.add(UVs[k]);
+	}
+	virtual void OnFaces(const OBJPolygon* Faces, size_t Count) override
+	{
+		ParsingState.bMayBeInFileHeader = false;
+		for (size_t k = 0; k < Count; ++k)
+			append_face(Faces[k], ParsingState, OBJDataOut);
+	}
+	virtual void OnGroup(std::string_view /*GroupName*/) override
+	{
+		ParsingState.bMayBeInFileHeader = false;
+		// todo...
+		ParsingState.CurrentGroupID++;
+	}
+	virtual void OnMaterial(std::string_view /*MaterialName*/) override
+	{
+		ParsingState.bMayBeInFileHeader = false;
+	}
+	virtual void OnSkippedLines(size_t /*Count*/) override
+	{
+		// skipped vn/vt lines are data lines, so any later comments are not part of the header
+		ParsingState.bMayBeInFileHeader = false;
+	}
+	virtual void OnComment(std::string_view Comment) override
+	{
+		if (ParsingState.bMayBeInFileHeader) {
+			OBJDataOut.HeaderComments.push_back(std::string(Comment));
+		}
+		if (bEnableMeshmixerTriGroupProcessing)
+			process_comment(Comment.data(), Comment.data() + Comment.size(), ParsingState);
+		if (ParsingState.bHaveMeshmixerGroupIDs && ParsingState.NumFacesBeforeMeshmixerGroupID < 0)
+			ParsingState.NumFacesBeforeMeshmixerGroupID = (int)OBJDataOut.FaceStream.size();
+	}
+	virtual void OnOtherLine(std::string_view /*Line*/) override
+	{
+		ParsingState.bMayBeInFileHeader = false;
+	}
 };
 
-static void parse_face(char* String, OBJParsedFace& Face)
+
+/**
+ * Parse all lines in [BufferStart,BufferEnd) into OBJDataOut
+ */
+static void parse_obj_buffer(
+	const char* BufferStart, const char* BufferEnd,
+	OBJFormatData& OBJDataOut,
+	OBJParsingState& ParsingState,
+	const OBJReader::ReadOptions& Options)
 {
-	Face.PositionIndices.resize(0);
-	Face.NormalIndices.resize(0);
-	Face.UVIndices.resize(0);
+	OBJFormatDataBuilder Builder(OBJDataOut, ParsingState, Options);
+	visit_obj_buffer(BufferStart, BufferEnd, Builder, Options);
+}
 
-	// vertex group is either just an integer vertex index, or vertidx//normalidx, or vertidx/uvidx, or vertidx/uvidx/normalidx
-	char* next_vertex_group = find_after_next_space(String);
-	while (next_vertex_group != nullptr)
+
+
+/**
+ * Count the lines of each type in [BufferStart,BufferEnd), and the number of vertices of each
+ * face line, without parsing any values. The line and token classification exactly matches
+ * parse_obj_buffer() / parse_face(), so the counts are the sizes that parsing will produce.
+ */
+static void scan_obj_buffer(const char* BufferStart, const char* BufferEnd, OBJReader::OBJFileStats& Stats)
+{
+	const char* LineStart = BufferStart;
+	while (LineStart < BufferEnd)
 	{
-		int first_space_index = -1;
-		char* nextnext = find_after_next_space(next_vertex_group, &first_space_index);
+		// memchr() is vectorized in all the standard libraries we care about, so this
+		// loop mostly runs at memory bandwidth
+		const char* LineEnd = find_line_end(LineStart, BufferEnd);
+		const char* Start = LineStart;
+		const char* End = LineEnd;
+		LineStart = (LineEnd < BufferEnd) ? LineEnd + 1 : BufferEnd;
 
-		// insert null at first space character to terminate substring
-		next_vertex_group[first_space_index] = null_char;
+		trim_line_span(Start, End);
+		if (Start == End) continue;
 
-		int start_index = 0;
-		int first_slash_index = index_of_nonspace(next_vertex_group, start_index, '/');
-		if (first_slash_index == -1)
+		if (Start[0] == '#' || Start[0] == '/')
 		{
-			int VertexIndex = std::atoi(next_vertex_group);
-			Face.PositionIndices.push_back(VertexIndex);
+			Stats.NumCommentLines++;
 		}
-		else if (next_vertex_group[first_slash_index+1] == '/')
+		else if (Start[0] == 'v')
 		{
-			// have two slashes in a row, null-terminate the first substring and parse, and then parse the second
-			next_vertex_group[first_slash_index] = null_char;
-			int VertexIndex = std::atoi(next_vertex_group);
-			char* normal_token = &next_vertex_group[first_slash_index + 2];
-			int NormalIndex = std::atoi(normal_token);
-			Face.PositionIndices.push_back(VertexIndex);
-			Face.NormalIndices.push_back(NormalIndex);
+			char Next = (End - Start > 1) ? Start[1] : null_char;
+			if (Next == 'n')
+				Stats.NumNormals++;
+			else if (Next == 't')
+				Stats.NumUVs++;
+			else
+			{
+				if (Stats.NumVertexPositions == 0)
+				{
+					// colors are only used if all vertices have them, so checking the first vertex is sufficient
+					int NumTokens = 0;
+					for (const char* Token = find_next_token(Start, End); Token < End; Token = find_next_token(Token, End))
+						NumTokens++;
+					Stats.bHaveVertexColors = (NumTokens > 3);
+				}
+				Stats.NumVertexPositions++;
+			}
 		}
-		else
+		else if (Start[0] == 'f')
 		{
-			int second_slash_index = index_of_nonspace(next_vertex_group, first_slash_index + 1, '/');
-
-			next_vertex_group[first_slash_index] = null_char;
-			int VertexIndex = std::atoi(next_vertex_group);
-			Face.PositionIndices.push_back(VertexIndex);
-
-			char* uv_token = &next_vertex_group[first_slash_index+1];
-
-			if (second_slash_index == -1)
-			{
-				int UVIndex = std::atoi(uv_token);
-				Face.UVIndices.push_back(UVIndex);
+			const char* FirstGroup = find_next_token(Start, End);
+			int NumVertices = 0;
+			for (const char* Token = FirstGroup; Token < End; Token = find_next_token(Token, End))
+				NumVertices++;
+
+			if (NumVertices == 3)
+				Stats.NumTriangles++;
+			else if (NumVertices == 4)
+				Stats.NumQuads++;
+			else if (NumVertices > 4) {
+				Stats.NumPolygons++;
+				Stats.NumPolygonIndices += (size_t)NumVertices;
 			}
-			else
+
+			// only checking the first vertex group of each face, ie a capacity hint and not exact
+			if (NumVertices >= 3)
 			{
-				next_vertex_group[second_slash_index] = null_char;
-				int UVIndex = std::atoi(uv_token);
-				Face.UVIndices.push_back(UVIndex);
-				char* normal_token = &next_vertex_group[second_slash_index + 1];
-				int NormalIndex = std::atoi(normal_token);
-				Face.NormalIndices.push_back(NormalIndex);
+				const char* GroupEnd = find_token_end(FirstGroup, End);
+				const char* FirstSlash = find_char(FirstGroup, GroupEnd, '/');
+				if (FirstSlash < GroupEnd)
+				{
+					if (FirstSlash + 1 < GroupEnd && FirstSlash[1] == '/')
+						Stats.bHaveFaceNormals = true;
+					else
+					{
+						Stats.bHaveFaceUVs = true;
+						if (find_char(FirstSlash + 1, GroupEnd, '/') < GroupEnd)
+							Stats.bHaveFaceNormals = true;
+					}
+				}
 			}
 		}
-
-		next_vertex_group = nextnext;
+		else if (Start[0] == 'g')
+		{
+			Stats.NumGroupLines++;
+		}
 	}
+}
+
+// accumulate the counts of the next chunk of a file into Stats
+static void append_obj_stats(OBJReader::OBJFileStats& Stats, const OBJReader::OBJFileStats& ChunkStats)
+{
+	if (Stats.NumVertexPositions == 0)
+		Stats.bHaveVertexColors = ChunkStats.bHaveVertexColors;
+	Stats.NumVertexPositions += ChunkStats.NumVertexPositions;
+	Stats.NumNormals += ChunkStats.NumNormals;
+	Stats.NumUVs += ChunkStats.NumUVs;
+	Stats.NumTriangles += ChunkStats.NumTriangles;
+	Stats.NumQuads += ChunkStats.NumQuads;
+	Stats.NumPolygons += ChunkStats.NumPolygons;
+	Stats.NumPolygonIndices += ChunkStats.NumPolygonIndices;
+	Stats.NumGroupLines += ChunkStats.NumGroupLines;
+	Stats.NumCommentLines += ChunkStats.NumCommentLines;
+	Stats.bHaveFaceNormals = Stats.bHaveFaceNormals || ChunkStats.bHaveFaceNormals;
+	Stats.bHaveFaceUVs = Stats.bHaveFaceUVs || ChunkStats.bHaveFaceUVs;
+}
+
+// reserve all arrays of Data for the element counts in Stats, taking into account which attributes Options will skip
+static void reserve_obj_data(OBJFormatData& Data, const OBJReader::OBJFileStats& Stats, const OBJReader::ReadOptions& Options)
+{
+	bool bFaceNormals = Options.bNormals && Stats.bHaveFaceNormals;
+	bool bFaceUVs = Options.bUVs && Stats.bHaveFaceUVs;
+
+	Data.VertexPositions.reserve(Stats.NumVertexPositions);
+	if (Options.bVertexColors && Stats.bHaveVertexColors)
+		Data.VertexColors.reserve(Stats.NumVertexPositions);
+	if (Options.bNormals)
+		Data.Normals.reserve(Stats.NumNormals);
+	if (Options.bUVs)
+		Data.UVs.reserve(Stats.NumUVs);
+	Data.Triangles.reserve(Stats.NumTriangles, bFaceNormals, bFaceUVs);
+	Data.Quads.reserve(Stats.NumQuads, bFaceNormals, bFaceUVs);
+	if (Stats.NumPolygons > 0)
+		Data.Polygons.reserve(Stats.NumPolygons, Stats.NumPolygonIndices, bFaceNormals, bFaceUVs);
+	Data.FaceStream.reserve(Stats.GetFaceCount());
+}
 
 
-	if (Face.NormalIndices.size() != Face.PositionIndices.size())
-		Face.NormalIndices.resize(0);
-	if (Face.UVIndices.size() != Face.PositionIndices.size())
-		Face.UVIndices.resize(0);
+struct OBJParsedChunk
+{
+	OBJFormatData Data;
+	OBJParsingState ParsingState;
+};
+
+template<typename T>
+static void copy_to_offset(unsafe_vector<T>& Dest, size_t Offset, const unsafe_vector<T>& Source)
+{
+	size_t N = Source.size();
+	for (size_t k = 0; k < N; ++k)
+		Dest[Offset + k] = Source[k];
 }
 
+// copy triangles/quads into pre-allocated Dest starting at Offset. If Dest has normals/UVs
+// but Source does not, invalid indices are written
+template<typename FaceListType>
+static void copy_faces_to_offset(FaceListType& Dest, size_t Offset, const FaceListType& Source)
+{
+	size_t N = Source.size();
+	copy_to_offset(Dest.Positions, Offset, Source.Positions);
+	if (Dest.HasNormals()) {
+		for (size_t k = 0; k < N; ++k)
+			Dest.Normals[Offset + k] = (Source.HasNormals()) ? Source.Normals[k] : FaceListType::InvalidIndices();
+	}
+	if (Dest.HasUVs()) {
+		for (size_t k = 0; k < N; ++k)
+			Dest.UVs[Offset + k] = (Source.HasUVs()) ? Source.UVs[k] : FaceListType::InvalidIndices();
+	}
+}
 
+// copy polygons into pre-allocated Dest starting at polygon PolygonOffset / index IndexOffset
+static void copy_polygons_to_offset(OBJPolygonList& Dest, size_t PolygonOffset, size_t IndexOffset, const OBJPolygonList& Source)
+{
+	size_t NumPolygons = Source.size();
+	for (size_t pi = 0; pi < NumPolygons; ++pi)
+		Dest.Offsets[PolygonOffset + pi + 1] = Source.Offsets[pi + 1] + (int64_t)IndexOffset;
+
+	size_t NumIndices = Source.GetIndexCount();
+	bool bSourceNormals = Source.HasNormals(), bSourceUVs = Source.HasUVs();
+	for (size_t k = 0; k < NumIndices; ++k)
+		Dest.Positions[IndexOffset + k] = Source.Positions[k];
+	if (Dest.HasNormals())
+		for (size_t k = 0; k < NumIndices; ++k)
+			Dest.Normals[IndexOffset + k] = (bSourceNormals) ? Source.Normals[k] : -1;
+	if (Dest.HasUVs())
+		for (size_t k = 0; k < NumIndices; ++k)
+			Dest.UVs[IndexOffset + k] = (bSourceUVs) ? Source.UVs[k] : -1;
+}
 
-static void process_comment(
-	char* CommentString, int Length, OBJParsingState& ParsingState)
+// split [BufferStart,BufferEnd) into NumChunks ranges of roughly equal size, at line boundaries.
+// Returns NumChunks+1 pointers, chunk k is [Result[k],Result[k+1])
+static std::vector<const char*> split_buffer_at_lines(const char* BufferStart, const char* BufferEnd, int NumChunks)
 {
-	int mmgid_index = index_of_substring(CommentString, "mm_gid");
-	if (mmgid_index >= 0)
+	size_t BufferSize = (size_t)(BufferEnd - BufferStart);
+	std::vector<const char*> ChunkStarts;
+	ChunkStarts.push_back(BufferStart);
+	for (int k = 1; k < NumChunks; ++k)
 	{
-		char* groupid_token = find_after_next_space( &CommentString[mmgid_index] );
-		int GroupID = std::atoi(groupid_token);
-		ParsingState.bHaveMeshmixerGroupIDs = true;
-		ParsingState.CurrentGroupID = GroupID;
+		const char* Target = BufferStart + (BufferSize * (size_t)k) / (size_t)NumChunks;
+		Target = std::max(Target, ChunkStarts.back());
+		const char* LineEnd = find_line_end(Target, BufferEnd);
+		ChunkStarts.push_back( (LineEnd < BufferEnd) ? LineEnd+1 : BufferEnd );
 	}
+	ChunkStarts.push_back(BufferEnd);
+	return ChunkStarts;
 }
 
+// number of chunks to split a file of the given size into for parallel parsing/scanning.
+// Small files are not worth splitting up.
+static int get_num_parse_chunks(size_t BufferSize, int NumThreads)
+{
+	constexpr size_t MinParallelChunkSize = 4 << 20;
+	return (int)std::min((size_t)NumThreads, BufferSize / MinParallelChunkSize);
+}
+
+// scan_obj_buffer() over [BufferStart,BufferEnd), in parallel chunks for large buffers
+static void scan_obj_buffer_parallel(const char* BufferStart, const char* BufferEnd, int NumThreads, OBJReader::OBJFileStats& StatsOut)
+{
+	int NumChunks = std::max(get_num_parse_chunks((size_t)(BufferEnd - BufferStart), NumThreads), 1);
+	std::vector<const char*> ChunkStarts = split_buffer_at_lines(BufferStart, BufferEnd, NumChunks);
+	std::vector<OBJReader::OBJFileStats> ChunkStats(NumChunks);
+	parallel_for_blocks(NumChunks, NumThreads, [&](int k)
+	{
+		scan_obj_buffer(ChunkStarts[k], ChunkStarts[k+1], ChunkStats[k]);
+	});
+	for (const OBJReader::OBJFileStats& Stats : ChunkStats)
+		append_obj_stats(StatsOut, Stats);
+}
+
+/**
+ * Parse [BufferStart,BufferEnd) in NumChunks chunks split at line boundaries, in parallel,
+ * and then merge the per-chunk results in file order. The OBJ v/vn/vt indices in face lines
+ * are absolute, so only the FaceStream indices into the Triangles/Quads/Polygons arrays need
+ * to be rebased. Group IDs are relative to the start of each chunk until a Meshmixer mm_gid
+ * comment is found, and are resolved by carrying the group ID across chunks in order.
+ */
+static void parse_obj_buffer_parallel(
+	const char* BufferStart, const char* BufferEnd,
+	int NumChunks, int NumThreads,
+	OBJFormatData& OBJDataOut,
+	const OBJReader::ReadOptions& Options)
+{
+	std::vector<const char*> ChunkStarts = split_buffer_at_lines(BufferStart, BufferEnd, NumChunks);
+
+	std::vector<OBJParsedChunk> Chunks(NumChunks);
+	parallel_for_blocks(NumChunks, NumThreads, [&](int k)
+	{
+		if (Options.bPreScanForCapacity)
+		{
+			OBJReader::OBJFileStats ChunkStats;
+			scan_obj_buffer(ChunkStarts[k], ChunkStarts[k+1], ChunkStats);
+			reserve_obj_data(Chunks[k].Data, ChunkStats, Options);
+		}
+		parse_obj_buffer(ChunkStarts[k], ChunkStarts[k+1], Chunks[k].Data, Chunks[k].ParsingState, Options);
+	});
+
+	// compute output offsets of each chunk, and resolve header comments and group IDs in file order
+	struct ChunkOffsets
+	{
+		size_t Positions = 0, Colors = 0, Normals = 0, UVs = 0;
+		size_t Triangles = 0, Quads = 0, Polygons = 0, PolygonIndices = 0, Faces = 0;
+		bool bTriNormals = false, bTriUVs = false;
+		bool bQuadNormals = false, bQuadUVs = false;
+		bool bPolygonNormals = false, bPolygonUVs = false;
+	};
+	std::vector<ChunkOffsets> Offsets(NumChunks+1);
+	std::vector<int> ChunkBaseGroupID(NumChunks);
+	int CurrentGroupID = 0;
+	bool bMayBeInFileHeader = true;
+	for (int k = 0; k < NumChunks; ++k)
+	{
+		const OBJFormatData& Data = Chunks[k].Data;
+		const OBJParsingState& ChunkState = Chunks[k].ParsingState;
+
+		if (bMayBeInFileHeader)
+			for (const std::string& Comment : Data.HeaderComments)
+				OBJDataOut.HeaderComments.push_back(Comment);
+		bMayBeInFileHeader = bMayBeInFileHeader && ChunkState.bMayBeInFileHeader;
+
+		ChunkBaseGroupID[k] = CurrentGroupID;
+		CurrentGroupID = (ChunkState.bHaveMeshmixerGroupIDs) ?
+			ChunkState.CurrentGroupID : (CurrentGroupID + ChunkState.CurrentGroupID);
+
+		ChunkOffsets& Next = Offsets[k+1];
+		Next = Offsets[k];
+		Next.Positions += Data.VertexPositions.size();
+		Next.Colors += Data.VertexColors.size();
+		Next.Normals += Data.Normals.size();
+		Next.UVs += Data.UVs.size();
+		Next.Triangles += Data.Triangles.size();
+		Next.Quads += Data.Quads.size();
+		Next.Polygons += Data.Polygons.size();
+		Next.PolygonIndices += Data.Polygons.GetIndexCount();
+		Next.Faces += Data.FaceStream.size();
+		Next.bTriNormals = Next.bTriNormals || Data.Triangles.HasNormals();
+		Next.bTriUVs = Next.bTriUVs || Data.Triangles.HasUVs();
+		Next.bQuadNormals = Next.bQuadNormals || Data.Quads.HasNormals();
+		Next.bQuadUVs = Next.bQuadUVs || Data.Quads.HasUVs();
+		Next.bPolygonNormals = Next.bPolygonNormals || Data.Polygons.HasNormals();
+		Next.bPolygonUVs = Next.bPolygonUVs || Data.Polygons.HasUVs();
+	}
+
+	const ChunkOffsets& Totals = Offsets[NumChunks];
+	OBJDataOut.VertexPositions.resize(Totals.Positions);
+	OBJDataOut.VertexColors.resize(Totals.Colors);
+	OBJDataOut.Normals.resize(Totals.Normals);
+	OBJDataOut.UVs.resize(Totals.UVs);
+	OBJDataOut.Triangles.Positions.resize(Totals.Triangles);
+	OBJDataOut.Triangles.Normals.resize((Totals.bTriNormals) ? Totals.Triangles : 0);
+	OBJDataOut.Triangles.UVs.resize((Totals.bTriUVs) ? Totals.Triangles : 0);
+	OBJDataOut.Quads.Positions.resize(Totals.Quads);
+	OBJDataOut.Quads.Normals.resize((Totals.bQuadNormals) ? Totals.Quads : 0);
+	OBJDataOut.Quads.UVs.resize((Totals.bQuadUVs) ? Totals.Quads : 0);
+	if (Totals.Polygons > 0)
+	{
+		OBJPolygonList& Polygons = OBJDataOut.Polygons;
+		Polygons.Offsets.resize(Totals.Polygons + 1);
+		Polygons.Offsets[0] = 0;
+		Polygons.Positions.resize(Totals.PolygonIndices);
+		Polygons.Normals.resize((Totals.bPolygonNormals) ? Totals.PolygonIndices : 0);
+		Polygons.UVs.resize((Totals.bPolygonUVs) ? Totals.PolygonIndices : 0);
+	}
+	OBJDataOut.FaceStream.resize(Totals.Faces);
+
+	// chunks write to disjoint ranges of the output arrays, so they can be merged in parallel
+	parallel_for_blocks(NumChunks, NumThreads, [&](int k)
+	{
+		OBJFormatData& Data = Chunks[k].Data;
+		const OBJParsingState& ChunkState = Chunks[k].ParsingState;
+		const ChunkOffsets& Offset = Offsets[k];
+
+		copy_to_offset(OBJDataOut.VertexPositions, Offset.Positions, Data.VertexPositions);
+		copy_to_offset(OBJDataOut.VertexColors, Offset.Colors, Data.VertexColors);
+		copy_to_offset(OBJDataOut.Normals, Offset.Normals, Data.Normals);
+		copy_to_offset(OBJDataOut.UVs, Offset.UVs, Data.UVs);
+		copy_faces_to_offset(OBJDataOut.Triangles, Offset.Triangles, Data.Triangles);
+		copy_faces_to_offset(OBJDataOut.Quads, Offset.Quads, Data.Quads);
+		copy_polygons_to_offset(OBJDataOut.Polygons, Offset.Polygons, Offset.PolygonIndices, Data.Polygons);
+
+		size_t NumFaces = Data.FaceStream.size();
+		size_t NumRelativeGroupFaces = (ChunkState.bHaveMeshmixerGroupIDs) ?
+			(size_t)ChunkState.NumFacesBeforeMeshmixerGroupID : NumFaces;
+		const uint32_t TypeOffsets[3] = { (uint32_t)Offset.Triangles, (uint32_t)Offset.Quads, (uint32_t)Offset.Polygons };
+		for (size_t fi = 0; fi < NumFaces; ++fi)
+		{
+			OBJFace Face = Data.FaceStream[fi];
+			Face.FaceIndex = Face.FaceIndex + TypeOffsets[Face.FaceType];
+			if (fi < NumRelativeGroupFaces)
+				Face.GroupID += ChunkBaseGroupID[k];
+			OBJDataOut.FaceStream[Offset.Faces + fi] = Face;
+		}
+
+		Data = OBJFormatData();		// release chunk memory as early as possible
+	});
+}
 
 
 bool GS::OBJReader::ReadOBJ(
@@ -242,158 +894,366 @@ bool GS::OBJReader::ReadOBJ(
 	if (!std::filesystem::exists(FilePath))
 		return false;
 
-	// why is this using FILE* api...?
+	if (!Options.CacheDirectory.empty())
+	{
+		// only the options that change the parse result are part of the cache key
+		char OptionsKey[64];
+		snprintf(OptionsKey, sizeof(OptionsKey), "obj c%d n%d u%d g%d", (int)Options.bVertexColors, (int)Options.bNormals,
+			(int)Options.bUVs, (int)Options.bEnableMeshmixerTriGroupProcessing);
+		ReadOptions ParseOptions = Options;
+		ParseOptions.CacheDirectory.clear();
+		return ParseResultCache::read_through_cache(Options.CacheDirectory, Options.MaxCacheSizeBytes, Options.bCacheSampledContentHash, Path, OptionsKey, OBJDataOut,
+			[&](OBJFormatData& DataOut) { return ReadOBJ(Path, DataOut, ParseOptions); });
+	}
+
+	if (Options.bUseAsyncReadAhead)
+	{
+		OBJParsingState ParsingState;
+		OBJFormatDataBuilder Builder(OBJDataOut, ParsingState, Options);
+		if (!visit_obj_file_read_ahead(Path, Builder, Options))
+			return false;
+		if (OBJDataOut.VertexColors.size() != OBJDataOut.VertexPositions.size())
+			OBJDataOut.VertexColors.clear();
+		return true;
+	}
 
-	FILE* FilePtr = fopen(Path.c_str(), "r");
-	if (!FilePtr)
+	// regular files are mapped and parsed in-place, pipes/etc are read into memory
+	MappedFileBuffer FileBuffer;
+	if (!FileBuffer.Open(Path, Options.bUseMemoryMappedIO))
 		return false;
+	FileBuffer.AdviseSequential();
 
-	std::vector<char> LineBuffer;
-	const int BufferSize = 4096;
-	LineBuffer.resize(BufferSize);
+	const char* BufferStart = FileBuffer.Data();
+	const char* BufferEnd = BufferStart + FileBuffer.Size();
 
-	// face that we will parse into
-	OBJParsedFace CurFace;
-	CurFace.PositionIndices.reserve(32);
-	CurFace.NormalIndices.reserve(32);
-	CurFace.UVIndices.reserve(32);
-
-	// current parsing info
-	OBJParsingState ParsingState;
+	int NumThreads = get_num_worker_threads(Options.NumThreads);
+	int NumChunks = get_num_parse_chunks(FileBuffer.Size(), NumThreads);
 
-	bool bMayBeInFileHeader = true;
-	bool bLastLineReadOK = true;
-	while ( bLastLineReadOK && !feof(FilePtr) )
+	if (NumChunks > 1)
 	{
-		char* Result = fgets(&LineBuffer[0], BufferSize-1, FilePtr);
-		if (Result == nullptr) { bLastLineReadOK = false; continue; }
-
-		char* String = &LineBuffer[0];
-		int N = (int)strnlen(String, BufferSize);
-		if (N == 0) continue;		// empty line?
-		if (String[N] != null_char)
+		parse_obj_buffer_parallel(BufferStart, BufferEnd, NumChunks, NumThreads, OBJDataOut, Options);
+	}
+	else
+	{
+		if (Options.bPreScanForCapacity)
 		{
-			// this would happen if line is longer than buffer...
-			gs_runtime_assert(false);
-			bLastLineReadOK = false; continue;
+			OBJReader::OBJFileStats Stats;
+			scan_obj_buffer(BufferStart, BufferEnd, Stats);
+			reserve_obj_data(OBJDataOut, Stats, Options);
 		}
 
-		trim_start_end_in_place(String, N);
-		if (N == 0) continue;
+		// current parsing info
+		OBJParsingState ParsingState;
+		parse_obj_buffer(BufferStart, BufferEnd, OBJDataOut, ParsingState, Options);
+	}
 
-		if (String[0] == '#' || String[0] == '/') {
-			if (bMayBeInFileHeader) {
-				OBJDataOut.HeaderComments.push_back(std::string(String));
-			}
-			process_comment(String, N, ParsingState);
-			continue;
-		}
+	// currently not supporting partial color specification
+	if (OBJDataOut.VertexColors.size() != OBJDataOut.VertexPositions.size())
+		OBJDataOut.VertexColors.clear();
+
+	return true;
+}
+
+
+/**
+ * IOBJVisitor that writes vertex positions, triangles and groups directly into a DenseMesh,
+ * which has been allocated with the exact vertex/triangle counts from a scan_obj_buffer() pre-pass.
+ * The result is identical to ReadOBJ() followed by OBJFormatDataToDenseMesh().
+ *
+ * Normals/UVs are referenced by index from faces, so they are stored (as floats) while parsing.
+ * Faces almost always reference previously-defined normals/UVs, and those per-corner values are
+ * set immediately. Forward references are recorded and set after parsing. Vertex colors are
+ * only used if all vertices have colors, which is only known at the end of the file, so they
+ * are also set in a post-pass.
+ */
+class OBJDenseMeshBuilder : public OBJReader::IOBJVisitor
+{
+public:
+	DenseMesh& MeshOut;
+	OBJParsingState ParsingState;
+	bool bEnableMeshmixerTriGroupProcessing = true;
+
+	bool bWantNormals = false;
+	bool bWantUVs = false;
+	bool bWantVertexColors = false;
+	int TotalNumNormals = 0;
+	int TotalNumUVs = 0;
+
+	int NumVertices = 0;
+	int NumTriangles = 0;
 
-		// if the line wasn't a comment it must be a contents line, so header is done...
-		bMayBeInFileHeader = false;
+	unsafe_vector<Vector3f> Normals;
+	unsafe_vector<Vector2f> UVs;
+	unsafe_vector<Vector3f> VertexColors;
+	bool bAllVerticesHaveColors = true;
 
-		if (String[0] == 'v')
+	// (triangle, corner, attribute index) of per-corner normals/UVs that reference elements defined later in the file
+	struct DeferredCorner
+	{
+		int TriangleID;
+		int Corner;
+		int Index;
+	};
+	std::vector<DeferredCorner> DeferredNormals;
+	std::vector<DeferredCorner> DeferredUVs;
+
+	OBJDenseMeshBuilder(DenseMesh& MeshIn, const OBJReader::OBJFileStats& Stats,
+		const OBJReader::ReadOptions& ReadOptions, const OBJToDenseMeshOptions& MeshOptions)
+		: MeshOut(MeshIn)
+	{
+		bEnableMeshmixerTriGroupProcessing = ReadOptions.bEnableMeshmixerTriGroupProcessing;
+		TotalNumNormals = (ReadOptions.bNormals) ? (int)Stats.NumNormals : 0;
+		TotalNumUVs = (ReadOptions.bUVs) ? (int)Stats.NumUVs : 0;
+		bWantNormals = (MeshOptions.bIgnoreNormals == false && TotalNumNormals > 0);
+		bWantUVs = (MeshOptions.bIgnoreUVs == false && TotalNumUVs > 0);
+		bWantVertexColors = (MeshOptions.bIgnoreColors == false && ReadOptions.bVertexColors && Stats.bHaveVertexColors);
+
+		if (bWantNormals)
+			Normals.reserve(TotalNumNormals);
+		if (bWantUVs)
+			UVs.reserve(TotalNumUVs);
+		if (bWantVertexColors)
+			VertexColors.reserve(Stats.NumVertexPositions);
+	}
+
+	virtual void OnVertices(const OBJReader::OBJVertex* Vertices, size_t Count) override
+	{
+		for (size_t k = 0; k < Count; ++k)
 		{
-			if (String[1] == 'n')
-			{
-				append_normal(String, OBJDataOut);
-			}
-			else if (String[1] == 't')
-			{
-				append_uv(String, OBJDataOut);
-			}
-			else
+			MeshOut.SetPosition(NumVertices++, Vertices[k].Position);
+			if (bWantVertexColors && bAllVerticesHaveColors)
 			{
-				append_vertex(String, OBJDataOut);
+				if (Vertices[k].bHaveColor)
+					VertexColors.add(Vertices[k].Color);
+				else
+					bAllVerticesHaveColors = false;
 			}
 		}
-		else if (String[0] == 'f')
+	}
+	virtual void OnNormals(const Vector3d* NormalsIn, size_t Count) override
+	{
+		if (bWantNormals)
+			for (size_t k = 0; k < Count; ++k)
+				Normals.add((Vector3f)NormalsIn[k]);
+	}
+	virtual void OnUVs(const Vector2d* UVsIn, size_t Count) override
+	{
+		if (bWantUVs)
+			for (size_t k = 0; k < Count; ++k)
+				UVs.add((Vector2f)UVsIn[k]);
+	}
+	virtual void OnFaces(const OBJPolygon* Faces, size_t Count) override
+	{
+		for (size_t k = 0; k < Count; ++k)
 		{
-			parse_face(String, CurFace);
-			if (CurFace.PositionIndices.size() == 3)
-			{
-				uint32_t tri_index = (uint32_t)OBJDataOut.Triangles.size();
-
-				OBJTriangle NewTri;
-				NewTri.Positions = Index3i(CurFace.PositionIndices[0]-1, CurFace.PositionIndices[1]-1, CurFace.PositionIndices[2]-1);
-				if (CurFace.NormalIndices.size() == 3)
-					NewTri.Normals = Index3i(CurFace.NormalIndices[0]-1, CurFace.NormalIndices[1]-1, CurFace.NormalIndices[2]-1);
-				if (CurFace.UVIndices.size() == 3)
-					NewTri.UVs = Index3i(CurFace.UVIndices[0]-1, CurFace.UVIndices[1]-1, CurFace.UVIndices[2]-1);
-				OBJDataOut.Triangles.add(NewTri);
-
-				OBJFace NewFace;
-				NewFace.FaceType = 0;
-				NewFace.FaceIndex = tri_index;
-				NewFace.GroupID = ParsingState.CurrentGroupID;
-				OBJDataOut.FaceStream.add(NewFace);
-			}
-			else if (CurFace.PositionIndices.size() == 4)
+			// quads and polygons are tessellated as a fan, ie tris (0,1,2), (0,2,3), ...
+			const OBJPolygon& Face = Faces[k];
+			for (int i = 1; i < Face.NumVertices - 1; ++i)
+				append_triangle(Face, i);
+		}
+	}
+	virtual void OnGroup(std::string_view /*GroupName*/) override
+	{
+		ParsingState.CurrentGroupID++;
+	}
+	virtual void OnComment(std::string_view Comment) override
+	{
+		if (bEnableMeshmixerTriGroupProcessing)
+			process_comment(Comment.data(), Comment.data() + Comment.size(), ParsingState);
+	}
+
+	void Finish()
+	{
+		for (const DeferredCorner& Deferred : DeferredNormals)
+		{
+			TriVtxNormals TriNormals = MeshOut.GetTriVtxNormals(Deferred.TriangleID);
+			TriNormals[Deferred.Corner] = Normals[Deferred.Index];
+			MeshOut.SetTriVtxNormals(Deferred.TriangleID, TriNormals);
+		}
+		for (const DeferredCorner& Deferred : DeferredUVs)
+		{
+			TriVtxUVs TriUVs = MeshOut.GetTriVtxUVs(Deferred.TriangleID);
+			TriUVs[Deferred.Corner] = UVs[Deferred.Index];
+			MeshOut.SetTriVtxUVs(Deferred.TriangleID, TriUVs);
+		}
+
+		// currently not supporting partial color specification
+		if (bWantVertexColors && bAllVerticesHaveColors && VertexColors.size() > 0)
+		{
+			int NumColors = (int)VertexColors.size();
+			for (int tid = 0; tid < NumTriangles; ++tid)
 			{
-				uint32_t quad_index = (uint32_t)OBJDataOut.Quads.size();
-
-				OBJQuad NewQuad;
-				NewQuad.Positions = Index4i(CurFace.PositionIndices[0]-1, CurFace.PositionIndices[1]-1, CurFace.PositionIndices[2]-1, CurFace.PositionIndices[3]-1);
-				if (CurFace.NormalIndices.size() == 4)
-					NewQuad.Normals = Index4i(CurFace.NormalIndices[0]-1, CurFace.NormalIndices[1]-1, CurFace.NormalIndices[2]-1, CurFace.NormalIndices[3]-1);
-				if (CurFace.UVIndices.size() == 4)
-					NewQuad.UVs = Index4i(CurFace.UVIndices[0]-1, CurFace.UVIndices[1]-1, CurFace.UVIndices[2]-1, CurFace.UVIndices[3]-1);
-				OBJDataOut.Quads.add(NewQuad);
-
-				OBJFace NewFace;
-				NewFace.FaceType = 1;
-				NewFace.FaceIndex = quad_index;
-				NewFace.GroupID = ParsingState.CurrentGroupID;
-				OBJDataOut.FaceStream.add(NewFace);
+				Index3i Tri = MeshOut.GetTriangle(tid);
+				TriVtxColors TriColors;
+				for (int j = 0; j < 3; ++j) {
+					Vector3f Color = (Tri[j] >= 0 && Tri[j] < NumColors) ? VertexColors[Tri[j]] : Vector3f::UnitZ();
+					TriColors[j] = Color4b(Color);
+				}
+				MeshOut.SetTriVtxColors(tid, TriColors);
 			}
-			else if (CurFace.PositionIndices.size() > 4)
-			{
-				uint32_t poly_index = (uint32_t)OBJDataOut.Polygons.size();
-
-				int NV = (int)CurFace.PositionIndices.size();
-				OBJPolygon NewPoly;
-				NewPoly.Positions.resize(NV);
-				for ( int j = 0; j < NV; ++j )
-					NewPoly.Positions[j] = CurFace.PositionIndices[j]-1;
-				
-				bool bPolyNormalsValid = (CurFace.NormalIndices.size() == NV);
-				NewPoly.Normals.resize(NV);
-				for ( int j = 0; j < NV; ++j )
-					NewPoly.Normals[j] = (bPolyNormalsValid) ? (CurFace.NormalIndices[j]-1) : 0;
-
-				bool bPolyUVsValid = (CurFace.UVIndices.size() == NV);
-				NewPoly.UVs.resize(NV);
-				for (int j = 0; j < NV; ++j)
-					NewPoly.UVs[j] = (bPolyUVsValid) ? CurFace.UVIndices[j]-1 : 0;
-
-				OBJDataOut.Polygons.add(std::move(NewPoly));
-
-				OBJFace NewFace;
-				NewFace.FaceType = 2;
-				NewFace.FaceIndex = poly_index;
-				NewFace.GroupID = ParsingState.CurrentGroupID;
-				OBJDataOut.FaceStream.add(NewFace);
+		}
+	}
+
+protected:
+	void append_triangle(const OBJPolygon& Face, int i)
+	{
+		int tid = NumTriangles++;
+		const int Corners[3] = { 0, i, i+1 };
+		MeshOut.SetTriangle(tid, Index3i(Face.Positions[0], Face.Positions[i], Face.Positions[i+1]));
+		MeshOut.SetTriGroup(tid, ParsingState.CurrentGroupID);
+		if (bWantUVs)
+		{
+			TriVtxUVs TriUVs;
+			for (int j = 0; j < 3; ++j) {
+				int Index = (Face.UVs != nullptr) ? Face.UVs[Corners[j]] : -1;
+				TriUVs[j] = get_corner_value(UVs, Index, TotalNumUVs, tid, j, DeferredUVs, Vector2f::Zero());
 			}
+			MeshOut.SetTriVtxUVs(tid, TriUVs);
 		}
-		else if (String[0] == 'g')
+		if (bWantNormals)
 		{
+			TriVtxNormals TriNormals;
+			for (int j = 0; j < 3; ++j) {
+				int Index = (Face.Normals != nullptr) ? Face.Normals[Corners[j]] : -1;
+				TriNormals[j] = get_corner_value(Normals, Index, TotalNumNormals, tid, j, DeferredNormals, Vector3f::UnitZ());
+			}
+			MeshOut.SetTriVtxNormals(tid, TriNormals);
+		}
+	}
 
+	template<typename T>
+	static T get_corner_value(const unsafe_vector<T>& Values, int Index, int TotalCount,
+		int TriangleID, int Corner, std::vector<DeferredCorner>& Deferred, const T& DefaultValue)
+	{
+		if (Index < 0 || Index >= TotalCount)
+			return DefaultValue;
+		if (Index < (int)Values.size())
+			return Values[Index];
+		Deferred.push_back(DeferredCorner{ TriangleID, Corner, Index });
+		return DefaultValue;
+	}
+};
 
-			// todo...
-			ParsingState.CurrentGroupID++;
-		}
+
+bool GS::OBJReader::ReadOBJToDenseMesh(
+	const std::string& Path,
+	DenseMesh& MeshOut,
+	const ReadOptions& Options,
+	const OBJToDenseMeshOptions& MeshOptions)
+{
+	std::filesystem::path FilePath(Path);
+	if (!std::filesystem::exists(FilePath))
+		return false;
+
+	MappedFileBuffer FileBuffer;
+	if (!FileBuffer.Open(Path, Options.bUseMemoryMappedIO))
+		return false;
+	FileBuffer.AdviseSequential();
+
+	const char* BufferStart = FileBuffer.Data();
+	const char* BufferEnd = BufferStart + FileBuffer.Size();
+
+	// counting pass determines the exact size of the mesh
+	OBJFileStats Stats;
+	scan_obj_buffer_parallel(BufferStart, BufferEnd, get_num_worker_threads(Options.NumThreads), Stats);
+
+	size_t TotalNumTriangles = Stats.NumTriangles + 2 * Stats.NumQuads + (Stats.NumPolygonIndices - 2 * Stats.NumPolygons);
+
+	// Release the pages of a mapped file after the counting pass, and then again after each block
+	// (split at line ends) has been parsed, so that the file and the full mesh are never resident
+	// at the same time. The released pages are still in the OS file cache, so re-reading is cheap
+	FileBuffer.DiscardPages(0, FileBuffer.Size());
+	MeshOut.Resize((int)Stats.NumVertexPositions, (int)TotalNumTriangles);
+
+	constexpr size_t ParseBlockSize = 32 << 20;
+	OBJDenseMeshBuilder Builder(MeshOut, Stats, Options, MeshOptions);
+	OBJEventBatcher Batcher(Builder);
+	const char* BlockStart = BufferStart;
+	while (BlockStart < BufferEnd)
+	{
+		const char* BlockEnd = BlockStart + std::min(ParseBlockSize, (size_t)(BufferEnd - BlockStart));
+		BlockEnd = (BlockEnd < BufferEnd) ? find_line_end(BlockEnd, BufferEnd) : BufferEnd;
+		BlockEnd = (BlockEnd < BufferEnd) ? BlockEnd + 1 : BufferEnd;
+		visit_obj_buffer(BlockStart, BlockEnd, Batcher, Options);
+		FileBuffer.DiscardPages((size_t)(BlockStart - BufferStart), (size_t)(BlockEnd - BlockStart));
+		BlockStart = BlockEnd;
 	}
+	Batcher.Flush();
+	Builder.Finish();
 
-	// currently not supporting partial color specification
-	if (OBJDataOut.VertexColors.size() != OBJDataOut.VertexPositions.size())
-		OBJDataOut.VertexColors.clear();
+	gs_debug_assert(Builder.NumVertices == (int)Stats.NumVertexPositions && Builder.NumTriangles == (int)TotalNumTriangles);
+	return true;
+}
+
+
+bool GS::OBJReader::VisitOBJ(
+	const std::string& Path,
+	IOBJVisitor& Visitor,
+	const ReadOptions& Options)
+{
+	std::filesystem::path FilePath(Path);
+	if (!std::filesystem::exists(FilePath))
+		return false;
 
+	if (Options.bUseAsyncReadAhead)
+		return visit_obj_file_read_ahead(Path, Visitor, Options);
 
-	fclose(FilePtr);
+	MappedFileBuffer FileBuffer;
+	if (!FileBuffer.Open(Path, Options.bUseMemoryMappedIO))
+		return false;
+	FileBuffer.AdviseSequential();
+
+	visit_obj_buffer(FileBuffer.Data(), FileBuffer.Data() + FileBuffer.Size(), Visitor, Options);
+	return true;
+}
+
+
+bool GS::OBJReader::ProbeOBJ(
+	const std::string& Path,
+	OBJFileStats& StatsOut,
+	const ReadOptions& Options)
+{
+	StatsOut = OBJFileStats();
+
+	std::filesystem::path FilePath(Path);
+	if (!std::filesystem::exists(FilePath))
+		return false;
+
+	MappedFileBuffer FileBuffer;
+	if (!FileBuffer.Open(Path, Options.bUseMemoryMappedIO))
+		return false;
+	FileBuffer.AdviseSequential();
+
+	const char* BufferStart = FileBuffer.Data();
+	const char* BufferEnd = BufferStart + FileBuffer.Size();
+	StatsOut.FileSizeBytes = FileBuffer.Size();
+
+	scan_obj_buffer_parallel(BufferStart, BufferEnd, get_num_worker_threads(Options.NumThreads), StatsOut);
 	return true;
 }
 
 
+size_t GS::OBJReader::OBJFileStats::EstimateMemoryUsage(const ReadOptions& Options) const
+{
+	size_t NumBytes = NumVertexPositions * sizeof(Vector3d);
+	if (Options.bVertexColors && bHaveVertexColors)
+		NumBytes += NumVertexPositions * sizeof(Vector3f);
+	if (Options.bNormals)
+		NumBytes += NumNormals * sizeof(Vector3d);
+	if (Options.bUVs)
+		NumBytes += NumUVs * sizeof(Vector2d);
+
+	// position index arrays, plus normal/uv index arrays if they are present
+	size_t NumFaceArrays = 1 + ((Options.bNormals && bHaveFaceNormals) ? 1 : 0) + ((Options.bUVs && bHaveFaceUVs) ? 1 : 0);
+	NumBytes += NumFaceArrays * (NumTriangles * sizeof(Index3i) + NumQuads * sizeof(Index4i) + NumPolygonIndices * sizeof(int));
+	if (NumPolygons > 0)
+		NumBytes += (NumPolygons + 1) * sizeof(int64_t);
+
+	NumBytes += GetFaceCount() * sizeof(OBJFace);
+	return NumBytes;
+}
+
+
 #if defined(_MSC_VER)
 #pragma warning(pop)
 #endif
\ No newline at end of file
@@ -1,14 +1,16 @@
 // Copyright Gradientspace Corp. All Rights Reserved.
 #include "MeshIO/OBJWriter.h"
 
-#include <set>
 #include <vector>
 #include <unordered_map>
 #include <algorithm>
 
 #include "Mesh/MeshAttributeUtils.h"
+#include "MeshIO/number_formatting.h"
+#include "MeshIO/parallel_utils.h"
 
 using namespace GS;
+using namespace GS::NumberFormatting;
 
 
 template<typename AttribType>
@@ -57,6 +59,24 @@ struct AttributeVertexBlender
 };
 
 
+// append face vertex token "v", "v/t", "v//n" or "v/t/n", with 1-based indices
+static void append_face_vertex(TextFormatBuffer& Output, int Vertex, int UV, int Normal, bool bIncludeUVs, bool bIncludeNormals)
+{
+	Output.AppendInt(Vertex);
+	if (bIncludeUVs || bIncludeNormals)
+	{
+		Output.AppendChar('/');
+		if (bIncludeUVs)
+			Output.AppendInt(UV);
+		if (bIncludeNormals)
+		{
+			Output.AppendChar('/');
+			Output.AppendInt(Normal);
+		}
+	}
+}
+
+
 
 
 bool GS::OBJWriter::WriteOBJ(
@@ -64,7 +84,9 @@ bool GS::OBJWriter::WriteOBJ(
 	const GS::DenseMesh& Mesh,
 	const WriteOptions& Options)
 {
-	char line_buffer[1024];
+	int NumThreads = get_num_worker_threads(Options.NumThreads);
+	std::vector<TextFormatBuffer> ChunkBuffers(NumThreads, TextFormatBuffer(Options.RealFormat));
+	bool bWritesOK = true;
 
 	bool bWantNormals = Options.bNormals;
 	bool bWantUVs = Options.bUVs;
@@ -72,6 +94,7 @@ bool GS::OBJWriter::WriteOBJ(
 
 	int NumTriangles = Mesh.GetTriangleCount();
 	int NumVertices = Mesh.GetVertexCount();
+	size_t NumCorners = 3 * (size_t)NumTriangles;
 
 	AttributeVertexBlender<Vector3f> ColorBlender;
 	bool bHaveVtxColors = false;
@@ -89,154 +112,124 @@ bool GS::OBJWriter::WriteOBJ(
 	}
 
 
-	for (int vi = 0; vi < NumVertices; ++vi)
+	bWritesOK = write_text_chunks(TextWriter, ChunkBuffers, NumVertices, [&](TextFormatBuffer& Output, size_t Start, size_t End)
 	{
-		Vector3d Pos = Mesh.GetPosition(vi);
-		if (bHaveVtxColors)
+		for (size_t vi = Start; vi < End; ++vi)
 		{
-			Vector3f Color = ColorBlender.GetVertexValue(vi);
-			snprintf(line_buffer, 1023, "v %f %f %f %f %f %f", Pos.X, Pos.Y, Pos.Z, Color.X, Color.Y, Color.Z);
-		}
-		else
-		{
-			snprintf(line_buffer, 1023, "v %f %f %f", Pos.X, Pos.Y, Pos.Z);
+			Vector3d Pos = Mesh.GetPosition((int)vi);
+			Output.AppendChar('v');
+			Output.AppendReals(&Pos.X, 3);
+			if (bHaveVtxColors)
+			{
+				Vector3f Color = ColorBlender.GetVertexValue((int)vi);
+				Output.AppendReals(&Color.X, 3);
+			}
+			Output.AppendEndOfLine();
 		}
-		TextWriter.WriteLine(line_buffer);
-	}
-
-	struct MeshTri
-	{
-		int Index;
-		int Group;
-		bool operator<(const MeshTri& Other) const { return Group < Other.Group; }
-	};
-	std::vector<MeshTri> Triangles;
+	}) && bWritesOK;
 
-	std::set<int> AllGroupIDs;
-
-	for (int ti = 0; ti < NumTriangles; ++ti)
-	{
-		int GroupID = Mesh.GetTriGroup(ti);
-		AllGroupIDs.insert(GroupID);
-		Triangles.push_back({ ti, GroupID });
-	}
-
-	bool bHaveGroups = AllGroupIDs.size() > 1;
-	std::stable_sort(Triangles.begin(), Triangles.end());
+	// triangles are written sorted by group, in triangle order within each group
+	std::vector<int> SortedTriangles;
+	int NumGroupIDs = parallel_stable_sort_by_key((size_t)NumTriangles, NumThreads,
+		[&](size_t ti) { return Mesh.GetTriGroup((int)ti); }, SortedTriangles);
+	bool bHaveGroups = NumGroupIDs > 1;
 
 	// write out Normals
 	bool bHaveNormals = false;
-	AttributeCompressor<Vector3f> NormalsIndex;
+	std::vector<int> CornerNormals;
 	if (bWantNormals)
 	{
 		bHaveNormals = true;
-		for (int ti = 0; ti < NumTriangles; ++ti)
-		{
-			TriVtxNormals VtxNormals = Mesh.GetTriVtxNormals(ti);
-			for (int j = 0; j < 3; ++j)
-				NormalsIndex.InsertValue(VtxNormals[j]);
-		}
-		int NumNormals = (int)NormalsIndex.UniqueValues.size();
-		for (int ni = 0; ni < NumNormals; ++ni)
+		std::vector<uint32_t> NormalCorners;
+		int NumNormals = parallel_index_unique_keys<Vector3f>(NumCorners, NumThreads,
+			[&](size_t Corner) { return Mesh.GetTriVtxNormals((int)(Corner/3))[(int)(Corner%3)]; }, CornerNormals, &NormalCorners);
+		bWritesOK = write_text_chunks(TextWriter, ChunkBuffers, NumNormals, [&](TextFormatBuffer& Output, size_t Start, size_t End)
 		{
-			Vector3f N = NormalsIndex.UniqueValues[ni];
-			snprintf(line_buffer, 1023, "vn %f %f %f", N.X, N.Y, N.Z);
-			TextWriter.WriteLine(line_buffer);
-		}
+			for (size_t ni = Start; ni < End; ++ni)
+			{
+				Vector3f N = Mesh.GetTriVtxNormals((int)(NormalCorners[ni]/3))[(int)(NormalCorners[ni]%3)];
+				Output.AppendString("vn", 2);
+				Output.AppendReals(&N.X, 3);
+				Output.AppendEndOfLine();
+			}
+		}) && bWritesOK;
 	}
 
 	// write out UVs
 	bool bHaveUVs = false;
-	AttributeCompressor<Vector2f> UVsIndex;
+	std::vector<int> CornerUVs;
 	if (bWantUVs)
 	{
 		bHaveUVs = true;
-		for (int ui = 0; ui < NumTriangles; ++ui)
+		std::vector<uint32_t> UVCorners;
+		int NumUVs = parallel_index_unique_keys<Vector2f>(NumCorners, NumThreads,
+			[&](size_t Corner) { return Mesh.GetTriVtxUVs((int)(Corner/3))[(int)(Corner%3)]; }, CornerUVs, &UVCorners);
+		bWritesOK = write_text_chunks(TextWriter, ChunkBuffers, NumUVs, [&](TextFormatBuffer& Output, size_t Start, size_t End)
 		{
-			TriVtxUVs VtxUvs = Mesh.GetTriVtxUVs(ui);
-			for (int j = 0; j < 3; ++j)
-				UVsIndex.InsertValue(VtxUvs[j]);
-		}
-		int NumUVs = (int)UVsIndex.UniqueValues.size();
-		for (int ni = 0; ni < NumUVs; ++ni)
-		{
-			Vector2f UV = UVsIndex.UniqueValues[ni];
-			snprintf(line_buffer, 1023, "vt %f %f", UV.X, UV.Y);
-			TextWriter.WriteLine(line_buffer);
-		}
+			for (size_t ui = Start; ui < End; ++ui)
+			{
+				Vector2f UV = Mesh.GetTriVtxUVs((int)(UVCorners[ui]/3))[(int)(UVCorners[ui]%3)];
+				Output.AppendString("vt", 2);
+				Output.AppendReals(&UV.X, 2);
+				Output.AppendEndOfLine();
+			}
+		}) && bWritesOK;
 	}
 
 	int VertexOffset = 1;
 	int UVOffset = 1;
 	int NormalOffset = 1;
 
-	int CurGroupID = -99999;
-	for (MeshTri MeshTri : Triangles)
+	bWritesOK = write_text_chunks(TextWriter, ChunkBuffers, (size_t)NumTriangles, [&](TextFormatBuffer& Output, size_t Start, size_t End)
 	{
-		if (bHaveGroups && MeshTri.Group != CurGroupID)
+		// a group line is written whenever the group changes, so a chunk starts in the group of the previous triangle
+		int CurGroupID = (Start == 0) ? -99999 : Mesh.GetTriGroup(SortedTriangles[Start-1]);
+		for (size_t k = Start; k < End; ++k)
 		{
-			snprintf(line_buffer, 1023, "g %d", MeshTri.Group);
-			TextWriter.WriteLine(line_buffer);
-			CurGroupID = MeshTri.Group;
-		}
-
-		int ti = MeshTri.Index;
+			int ti = SortedTriangles[k];
+			int GroupID = Mesh.GetTriGroup(ti);
+			if (bHaveGroups && GroupID != CurGroupID)
+			{
+				Output.AppendString("g ", 2);
+				Output.AppendInt(GroupID);
+				Output.AppendEndOfLine();
+				CurGroupID = GroupID;
+			}
 
-		Index3i TriVertices = Mesh.GetTriangle(ti);
+			Index3i TriVertices = Mesh.GetTriangle(ti);
 
-		Index3i TriNormals = Index3i::Zero();
-		if (bHaveNormals)
-		{
-			TriVtxNormals VtxNormals = Mesh.GetTriVtxNormals(ti);
-			for (int j = 0; j < 3; ++j)
-				TriNormals[j] = NormalsIndex.GetIndexForValue(VtxNormals[j], false);
-		}
+			Index3i TriNormals = Index3i::Zero();
+			if (bHaveNormals)
+			{
+				for (int j = 0; j < 3; ++j)
+					TriNormals[j] = CornerNormals[3*(size_t)ti + j];
+			}
 
-		Index3i TriUVs = Index3i::Zero();
-		if (bHaveUVs)
-		{
-			TriVtxUVs VtxUvs = Mesh.GetTriVtxUVs(ti);
-			for (int j = 0; j < 3; ++j)
-				TriUVs[j] = UVsIndex.GetIndexForValue(VtxUvs[j], false);
-		}
+			Index3i TriUVs = Index3i::Zero();
+			if (bHaveUVs)
+			{
+				for (int j = 0; j < 3; ++j)
+					TriUVs[j] = CornerUVs[3*(size_t)ti + j];
+			}
 
-		if (Options.bReverseTriOrientation)
-		{
-			int tmp = TriVertices.A; TriVertices.A = TriVertices.B; TriVertices.B = tmp;
-			tmp = TriUVs.A; TriUVs.A = TriUVs.B; TriUVs.B = tmp;
-			tmp = TriNormals.A; TriNormals.A = TriNormals.B; TriNormals.B = tmp;
-		}
+			if (Options.bReverseTriOrientation)
+			{
+				int tmp = TriVertices.A; TriVertices.A = TriVertices.B; TriVertices.B = tmp;
+				tmp = TriUVs.A; TriUVs.A = TriUVs.B; TriUVs.B = tmp;
+				tmp = TriNormals.A; TriNormals.A = TriNormals.B; TriNormals.B = tmp;
+			}
 
-		if (bHaveUVs && bHaveNormals)
-		{
-			snprintf(line_buffer, 1023, "f %d/%d/%d %d/%d/%d %d/%d/%d",
-				(TriVertices.A + VertexOffset), (TriUVs.A + UVOffset), (TriNormals.A + NormalOffset),
-				(TriVertices.B + VertexOffset), (TriUVs.B + UVOffset), (TriNormals.B + NormalOffset),
-				(TriVertices.C + VertexOffset), (TriUVs.C + UVOffset), (TriNormals.C + NormalOffset));
-		}
-		else if (bHaveUVs)
-		{
-			snprintf(line_buffer, 1023, "f %d/%d %d/%d %d/%d",
-				(TriVertices.A + VertexOffset), (TriUVs.A + UVOffset),
-				(TriVertices.B + VertexOffset), (TriUVs.B + UVOffset),
-				(TriVertices.C + VertexOffset), (TriUVs.C + UVOffset));
-		}
-		else if (bHaveNormals)
-		{
-			snprintf(line_buffer, 1023, "f %d//%d %d//%d %d//%d",
-				(TriVertices.A + VertexOffset), (TriNormals.A + NormalOffset),
-				(TriVertices.B + VertexOffset), (TriNormals.B + NormalOffset),
-				(TriVertices.C + VertexOffset), (TriNormals.C + NormalOffset));
-		}
-		else
-		{
-			snprintf(line_buffer, 1023, "f %d %d %d",
-				(TriVertices.A + VertexOffset), (TriVertices.B + VertexOffset), (TriVertices.C + VertexOffset));
+			Output.AppendChar('f');
+			for (int j = 0; j < 3; ++j)
+			{
+				Output.AppendChar(' ');
+				append_face_vertex(Output, TriVertices[j] + VertexOffset, TriUVs[j] + UVOffset, TriNormals[j] + NormalOffset, bHaveUVs, bHaveNormals);
+			}
+			Output.AppendEndOfLine();
 		}
-		TextWriter.WriteLine(line_buffer);
-	}
+	}) && bWritesOK;
 
-	return true;
+	return bWritesOK;
 }
 
 
@@ -252,126 +245,121 @@ bool GS::OBJWriter::WriteOBJ(
 	const OBJFormatData& OBJData,
 	const WriteOptions& Options)
 {
-	char line_buffer[1024];
+	int NumThreads = get_num_worker_threads(Options.NumThreads);
+	std::vector<TextFormatBuffer> ChunkBuffers(NumThreads, TextFormatBuffer(Options.RealFormat));
+	bool bWritesOK = true;
 
 	bool bWantNormals = Options.bNormals;
 	bool bWantUVs = Options.bUVs;
 
 	int NumVertices = (int)OBJData.VertexPositions.size();
 	bool bHaveVtxColors = Options.bVertexColors && (OBJData.VertexColors.size() == NumVertices);
-	for (int vi = 0; vi < NumVertices; ++vi)
+	bWritesOK = write_text_chunks(TextWriter, ChunkBuffers, NumVertices, [&](TextFormatBuffer& Output, size_t Start, size_t End)
 	{
-		Vector3d Pos = OBJData.VertexPositions[vi];
-		if (bHaveVtxColors)
+		for (size_t vi = Start; vi < End; ++vi)
 		{
-			Vector3f Color = OBJData.VertexColors[vi];
-			snprintf(line_buffer, 1023, "v %f %f %f %f %f %f", Pos.X, Pos.Y, Pos.Z, Color.X, Color.Y, Color.Z);
-		}
-		else
-		{
-			snprintf(line_buffer, 1023, "v %f %f %f", Pos.X, Pos.Y, Pos.Z);
+			Vector3d Pos = OBJData.VertexPositions[vi];
+			Output.AppendChar('v');
+			Output.AppendReals(&Pos.X, 3);
+			if (bHaveVtxColors)
+			{
+				Vector3f Color = OBJData.VertexColors[vi];
+				Output.AppendReals(&Color.X, 3);
+			}
+			Output.AppendEndOfLine();
 		}
-		TextWriter.WriteLine(line_buffer);
-	}
+	}) && bWritesOK;
 
 	int NumNormals = (bWantNormals) ? (int)OBJData.Normals.size() : 0;
-	if (bWantNormals && NumNormals > 0)
+	bWritesOK = write_text_chunks(TextWriter, ChunkBuffers, NumNormals, [&](TextFormatBuffer& Output, size_t Start, size_t End)
 	{
-		for (int ni = 0; ni < NumNormals; ++ni)
+		for (size_t ni = Start; ni < End; ++ni)
 		{
 			Vector3d Normal = OBJData.Normals[ni];
-			snprintf(line_buffer, 1023, "vn %f %f %f", Normal.X, Normal.Y, Normal.Z);
-			TextWriter.WriteLine(line_buffer);
+			Output.AppendString("vn", 2);
+			Output.AppendReals(&Normal.X, 3);
+			Output.AppendEndOfLine();
 		}
-	}
+	}) && bWritesOK;
 	auto IsValidNormal = [NumNormals](int normal_index) { return normal_index >= 0 && normal_index < NumNormals; };
 
 	int NumUVs = (bWantUVs) ? (int)OBJData.UVs.size() : 0;
-	if (bWantUVs && NumUVs > 0)
+	bWritesOK = write_text_chunks(TextWriter, ChunkBuffers, NumUVs, [&](TextFormatBuffer& Output, size_t Start, size_t End)
 	{
-		for (int ui = 0; ui < NumUVs; ++ui)
+		for (size_t ui = Start; ui < End; ++ui)
 		{
 			Vector2d UV = OBJData.UVs[ui];
-			snprintf(line_buffer, 1023, "vt %f %f", UV.X, UV.Y);
-			TextWriter.WriteLine(line_buffer);
+			Output.AppendString("vt", 2);
+			Output.AppendReals(&UV.X, 2);
+			Output.AppendEndOfLine();
 		}
-	}
+	}) && bWritesOK;
 	auto IsValidUV = [NumUVs](int uv_index) { return uv_index >= 0 && uv_index < NumUVs; };
 
 
-	auto WriteVertexToken = [&](int Vertex, int Normal, int UV, bool bIncludeNormals, bool bIncludeUVs)
-	{
-		if (bIncludeUVs && bIncludeNormals) {
-			snprintf(line_buffer, 1023, "%d/%d/%d", Vertex + 1, UV + 1, Normal + 1);
-		}
-		else if (bIncludeUVs) {
-			snprintf(line_buffer, 1023, "%d/%d", Vertex + 1, UV + 1);
-		}
-		else if (bIncludeNormals) {
-			snprintf(line_buffer, 1023, "%d//%d", Vertex + 1, Normal + 1);
-		}
-		else
-			snprintf(line_buffer, 1023, "%d", Vertex + 1);
-		TextWriter.WriteToken(line_buffer);
-	};
-	auto WriteVertices = [&](int Num, const int* Vertices, const int* Normals, const int* UVs, bool bIncludeNormals, bool bIncludeUVs)
+	auto WriteVertices = [&](TextFormatBuffer& Output, int Num, const int* Vertices, const int* Normals, const int* UVs, bool bIncludeNormals, bool bIncludeUVs)
 	{
 		for (int j = 0; j < Num; ++j )
 		{ 
-			WriteVertexToken(Vertices[j], Normals[j], UVs[j], bIncludeNormals, bIncludeUVs);
-			if (j != Num-1) TextWriter.WriteToken(" ");
+			Output.AppendChar(' ');
+			append_face_vertex(Output, Vertices[j] + 1, (bIncludeUVs) ? UVs[j] + 1 : 0, (bIncludeNormals) ? Normals[j] + 1 : 0, bIncludeUVs, bIncludeNormals);
 		}
 	};
 
-	int CurGroupID = std::numeric_limits<int>::max();
 	uint32_t NumFaces = (uint32_t)OBJData.FaceStream.size();
 	uint32_t NumTriangles = (uint32_t)OBJData.Triangles.size();
 	uint32_t NumQuads = (uint32_t)OBJData.Quads.size();
 	uint32_t NumPolygons = (uint32_t)OBJData.Polygons.size();
-	for (uint32_t fi = 0; fi < NumFaces; ++fi)
+	bWritesOK = write_text_chunks(TextWriter, ChunkBuffers, NumFaces, [&](TextFormatBuffer& Output, size_t Start, size_t End)
 	{
-		const OBJFace& Face = OBJData.FaceStream[fi];
-		if (Face.GroupID != CurGroupID)
+		// a group line is written whenever the group changes, so a chunk starts in the group of the previous face
+		int CurGroupID = (Start == 0) ? std::numeric_limits<int>::max() : OBJData.FaceStream[Start-1].GroupID;
+		for (size_t fi = Start; fi < End; ++fi)
 		{
-			snprintf(line_buffer, 1023, "g %d", Face.GroupID);
-			TextWriter.WriteLine(line_buffer);
-			CurGroupID = Face.GroupID;
-		}
+			const OBJFace& Face = OBJData.FaceStream[fi];
+			if (Face.GroupID != CurGroupID)
+			{
+				Output.AppendString("g ", 2);
+				Output.AppendInt(Face.GroupID);
+				Output.AppendEndOfLine();
+				CurGroupID = Face.GroupID;
+			}
 
-		if (Face.FaceType == 0 && Face.FaceIndex < NumTriangles)
-		{
-			const OBJTriangle& Triangle = OBJData.Triangles[Face.FaceIndex];
-			bool bWriteNormals = IsValidNormal(Triangle.Normals.A) && IsValidNormal(Triangle.Normals.B) && IsValidNormal(Triangle.Normals.C);
-			bool bWriteUVs = IsValidUV(Triangle.UVs.A) && IsValidUV(Triangle.UVs.B) && IsValidUV(Triangle.UVs.C);
-			TextWriter.WriteToken("f ");
-			WriteVertices(3, &Triangle.Positions.A, &Triangle.Normals.A, &Triangle.UVs.A, bWriteNormals, bWriteUVs);
-			TextWriter.WriteEndOfLine();
-		}
-		else if (Face.FaceType == 1 && Face.FaceIndex < NumQuads)
-		{
-			const OBJQuad& Quad = OBJData.Quads[Face.FaceIndex];
-			bool bWriteNormals = IsValidNormal(Quad.Normals.A) && IsValidNormal(Quad.Normals.B) && IsValidNormal(Quad.Normals.C) && IsValidNormal(Quad.Normals.D);
-			bool bWriteUVs = IsValidUV(Quad.UVs.A) && IsValidUV(Quad.UVs.B) && IsValidUV(Quad.UVs.C) && IsValidUV(Quad.UVs.D);
-			TextWriter.WriteToken("f ");
-			WriteVertices(4, &Quad.Positions.A, &Quad.Normals.A, &Quad.UVs.A, bWriteNormals, bWriteUVs);
-			TextWriter.WriteEndOfLine();
-		}
-		else if (Face.FaceType == 2 && Face.FaceIndex < NumPolygons)
-		{
-			const OBJPolygon& Poly = OBJData.Polygons[Face.FaceIndex];
-			int NumPolyVerts = (int)Poly.Positions.size();
-			bool bWriteNormals = ((int)Poly.Normals.size() == NumPolyVerts);
-			bool bWriteUVs = ((int)Poly.UVs.size() == NumPolyVerts);
-			for (int j = 0; j < NumPolyVerts; ++j)
+			if (Face.FaceType == 0 && Face.FaceIndex < NumTriangles)
 			{
-				bWriteNormals = bWriteNormals && IsValidNormal(Poly.Normals[j]);
-				bWriteUVs = bWriteUVs && IsValidUV(Poly.UVs[j]);
+				const OBJTriangle& Triangle = OBJData.Triangles[Face.FaceIndex];
+				bool bWriteNormals = IsValidNormal(Triangle.Normals.A) && IsValidNormal(Triangle.Normals.B) && IsValidNormal(Triangle.Normals.C);
+				bool bWriteUVs = IsValidUV(Triangle.UVs.A) && IsValidUV(Triangle.UVs.B) && IsValidUV(Triangle.UVs.C);
+				Output.AppendChar('f');
+				WriteVertices(Output, 3, &Triangle.Positions.A, &Triangle.Normals.A, &Triangle.UVs.A, bWriteNormals, bWriteUVs);
+				Output.AppendEndOfLine();
+			}
+			else if (Face.FaceType == 1 && Face.FaceIndex < NumQuads)
+			{
+				const OBJQuad& Quad = OBJData.Quads[Face.FaceIndex];
+				bool bWriteNormals = IsValidNormal(Quad.Normals.A) && IsValidNormal(Quad.Normals.B) && IsValidNormal(Quad.Normals.C) && IsValidNormal(Quad.Normals.D);
+				bool bWriteUVs = IsValidUV(Quad.UVs.A) && IsValidUV(Quad.UVs.B) && IsValidUV(Quad.UVs.C) && IsValidUV(Quad.UVs.D);
+				Output.AppendChar('f');
+				WriteVertices(Output, 4, &Quad.Positions.A, &Quad.Normals.A, &Quad.UVs.A, bWriteNormals, bWriteUVs);
+				Output.AppendEndOfLine();
+			}
+			else if (Face.FaceType == 2 && Face.FaceIndex < NumPolygons)
+			{
+				OBJPolygon Poly = OBJData.Polygons[Face.FaceIndex];
+				int NumPolyVerts = Poly.NumVertices;
+				bool bWriteNormals = (Poly.Normals != nullptr);
+				bool bWriteUVs = (Poly.UVs != nullptr);
+				for (int j = 0; j < NumPolyVerts; ++j)
+				{
+					bWriteNormals = bWriteNormals && IsValidNormal(Poly.Normals[j]);
+					bWriteUVs = bWriteUVs && IsValidUV(Poly.UVs[j]);
+				}
+				Output.AppendChar('f');
+				WriteVertices(Output, NumPolyVerts, Poly.Positions, Poly.Normals, Poly.UVs, bWriteNormals, bWriteUVs);
+				Output.AppendEndOfLine();
 			}
-			TextWriter.WriteToken("f ");
-			WriteVertices(NumPolyVerts, &Poly.Positions[0], &Poly.Normals[0], &Poly.UVs[0], bWriteNormals, bWriteUVs);
-			TextWriter.WriteEndOfLine();
 		}
-	}
+	}) && bWritesOK;
 
-	return true;
+	return bWritesOK;
 }
@@ -0,0 +1,1114 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#include "MeshIO/PLYReader.h"
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <limits>
+
+#include "MeshIO/MappedFileBuffer.h"
+#include "MeshIO/parallel_utils.h"
+#include "MeshIO/parse_utils.h"
+#include "MeshIO/float_parsing.h"
+
+using namespace GS;
+using namespace GS::PLYReader;
+
+
+static const size_t PLYTypeSizes[] = { 1, 1, 2, 2, 4, 4, 4, 8 };
+
+static size_t get_type_size(EPLYPropertyType Type)
+{
+	return PLYTypeSizes[(int)Type];
+}
+
+static bool is_token(const char* Token, const char* TokenEnd, const char* String)
+{
+	size_t Length = strlen(String);
+	return (size_t)(TokenEnd - Token) == Length && memcmp(Token, String, Length) == 0;
+}
+
+static bool parse_property_type(const char* Token, const char* TokenEnd, EPLYPropertyType& TypeOut)
+{
+	// PLY 1.0 type names, and the sized names that many writers use instead
+	static const char* TypeNames[8][2] = {
+		{ "char", "int8" }, { "uchar", "uint8" }, { "short", "int16" }, { "ushort", "uint16" },
+		{ "int", "int32" }, { "uint", "uint32" }, { "float", "float32" }, { "double", "float64" } };
+	for (int k = 0; k < 8; ++k) {
+		if (is_token(Token, TokenEnd, TypeNames[k][0]) || is_token(Token, TokenEnd, TypeNames[k][1])) {
+			TypeOut = (EPLYPropertyType)k;
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool parse_element_count(const char* Token, const char* TokenEnd, uint64_t& CountOut)
+{
+	CountOut = 0;
+	if (Token == TokenEnd || TokenEnd - Token > 18)
+		return false;
+	for (const char* Cur = Token; Cur < TokenEnd; ++Cur) {
+		if ((unsigned)(*Cur - '0') >= 10u)
+			return false;
+		CountOut = CountOut * 10 + (uint64_t)(*Cur - '0');
+	}
+	return true;
+}
+
+/**
+ * Parse the PLY header at the start of [Data,Data+Size). Lines may end in \n or \r\n.
+ * Unknown header keywords are ignored.
+ */
+static bool parse_ply_header(const char* Data, size_t Size, PLYHeader& HeaderOut)
+{
+	HeaderOut = PLYHeader();
+	const char* Cur = Data;
+	const char* End = Data + Size;
+	bool bFirstLine = true;
+	bool bHaveFormat = false;
+	while (Cur < End)
+	{
+		const char* LineStart = Cur;
+		const char* LineEnd = find_line_end(Cur, End);
+		Cur = (LineEnd < End) ? LineEnd + 1 : End;
+		if (LineEnd > LineStart && LineEnd[-1] == '\r')
+			LineEnd--;
+		LineStart = skip_line_space(LineStart, LineEnd);
+
+		// split the line into up to 6 tokens
+		const char* Tokens[6];
+		const char* TokenEnds[6];
+		int NumTokens = 0;
+		const char* Token = LineStart;
+		while (Token < LineEnd && NumTokens < 6) {
+			Tokens[NumTokens] = Token;
+			TokenEnds[NumTokens] = find_token_end(Token, LineEnd);
+			Token = skip_line_space(TokenEnds[NumTokens], LineEnd);
+			NumTokens++;
+		}
+
+		if (bFirstLine) {
+			if (NumTokens != 1 || !is_token(Tokens[0], TokenEnds[0], "ply"))
+				return false;
+			bFirstLine = false;
+			continue;
+		}
+		if (NumTokens == 0)
+			continue;
+
+		if (is_token(Tokens[0], TokenEnds[0], "end_header"))
+		{
+			HeaderOut.DataOffset = (size_t)(Cur - Data);
+			return bHaveFormat;
+		}
+		else if (is_token(Tokens[0], TokenEnds[0], "format"))
+		{
+			if (NumTokens < 2)
+				return false;
+			if (is_token(Tokens[1], TokenEnds[1], "ascii"))
+				HeaderOut.Format = EPLYFormat::ASCII;
+			else if (is_token(Tokens[1], TokenEnds[1], "binary_little_endian"))
+				HeaderOut.Format = EPLYFormat::BinaryLittleEndian;
+			else if (is_token(Tokens[1], TokenEnds[1], "binary_big_endian"))
+				HeaderOut.Format = EPLYFormat::BinaryBigEndian;
+			else
+				return false;
+			bHaveFormat = true;
+		}
+		else if (is_token(Tokens[0], TokenEnds[0], "comment") || is_token(Tokens[0], TokenEnds[0], "obj_info"))
+		{
+			const char* CommentStart = skip_line_space(TokenEnds[0], LineEnd);
+			HeaderOut.Comments.push_back(std::string(CommentStart, LineEnd));
+		}
+		else if (is_token(Tokens[0], TokenEnds[0], "element"))
+		{
+			PLYElement Element;
+			if (NumTokens < 3 || !parse_element_count(Tokens[2], TokenEnds[2], Element.Count))
+				return false;
+			Element.Name = std::string(Tokens[1], TokenEnds[1]);
+			HeaderOut.Elements.push_back(Element);
+		}
+		else if (is_token(Tokens[0], TokenEnds[0], "property"))
+		{
+			if (HeaderOut.Elements.empty() || NumTokens < 3)
+				return false;
+			PLYProperty Property;
+			if (is_token(Tokens[1], TokenEnds[1], "list"))
+			{
+				Property.bIsList = true;
+				if (NumTokens < 5 || !parse_property_type(Tokens[2], TokenEnds[2], Property.ListCountType)
+					|| !parse_property_type(Tokens[3], TokenEnds[3], Property.Type))
+					return false;
+				Property.Name = std::string(Tokens[4], TokenEnds[4]);
+			}
+			else
+			{
+				if (!parse_property_type(Tokens[1], TokenEnds[1], Property.Type))
+					return false;
+				Property.Name = std::string(Tokens[2], TokenEnds[2]);
+			}
+			HeaderOut.Elements.back().Properties.push_back(Property);
+		}
+	}
+	return false;
+}
+
+
+
+//
+// record decoding
+//
+
+static bool is_little_endian_platform()
+{
+	uint16_t Value = 1;
+	uint8_t FirstByte = 0;
+	memcpy(&FirstByte, &Value, 1);
+	return FirstByte == 1;
+}
+
+template<typename T>
+static T load_binary(const char* Ptr, bool bSwapBytes)
+{
+	char Bytes[sizeof(T)];
+	memcpy(Bytes, Ptr, sizeof(T));
+	if (bSwapBytes)
+		std::reverse(Bytes, Bytes + sizeof(T));
+	T Value;
+	memcpy(&Value, Bytes, sizeof(T));
+	return Value;
+}
+
+template<typename T>
+static double load_binary_value(const char* Ptr, bool bSwapBytes)
+{
+	return (double)load_binary<T>(Ptr, bSwapBytes);
+}
+
+static double read_binary_value(const char* Ptr, EPLYPropertyType Type, bool bSwapBytes)
+{
+	switch (Type)
+	{
+	case EPLYPropertyType::Int8: return load_binary_value<int8_t>(Ptr, bSwapBytes);
+	case EPLYPropertyType::UInt8: return load_binary_value<uint8_t>(Ptr, bSwapBytes);
+	case EPLYPropertyType::Int16: return load_binary_value<int16_t>(Ptr, bSwapBytes);
+	case EPLYPropertyType::UInt16: return load_binary_value<uint16_t>(Ptr, bSwapBytes);
+	case EPLYPropertyType::Int32: return load_binary_value<int32_t>(Ptr, bSwapBytes);
+	case EPLYPropertyType::UInt32: return load_binary_value<uint32_t>(Ptr, bSwapBytes);
+	case EPLYPropertyType::Float32: return load_binary_value<float>(Ptr, bSwapBytes);
+	case EPLYPropertyType::Float64: return load_binary_value<double>(Ptr, bSwapBytes);
+	}
+	return 0;
+}
+
+// returns true if Value is a valid list count, ie a non-negative integer
+static bool is_valid_list_count(double Value)
+{
+	return Value >= 0 && Value <= (double)std::numeric_limits<int32_t>::max() && Value == std::floor(Value);
+}
+
+/**
+ * Decode the binary record at Cur. Scalar properties are stored in ScalarsOut[PropertyIndex], and the
+ * items of the list properties ListProperties[0,1] in ListsOut[0,1]. Outputs may be null, eg to skip a record.
+ * Returns the end of the record, or nullptr if the record extends past End or has an invalid list count.
+ */
+static const char* decode_binary_record(const char* Cur, const char* End, const PLYElement& Element, bool bSwapBytes,
+	double* ScalarsOut, const int* ListProperties, std::vector<double>* ListsOut)
+{
+	int NumProperties = (int)Element.Properties.size();
+	for (int pi = 0; pi < NumProperties; ++pi)
+	{
+		const PLYProperty& Property = Element.Properties[pi];
+		size_t ValueSize = get_type_size(Property.Type);
+		if (!Property.bIsList)
+		{
+			if ((size_t)(End - Cur) < ValueSize)
+				return nullptr;
+			if (ScalarsOut != nullptr)
+				ScalarsOut[pi] = read_binary_value(Cur, Property.Type, bSwapBytes);
+			Cur += ValueSize;
+			continue;
+		}
+
+		size_t CountSize = get_type_size(Property.ListCountType);
+		if ((size_t)(End - Cur) < CountSize)
+			return nullptr;
+		double CountValue = read_binary_value(Cur, Property.ListCountType, bSwapBytes);
+		Cur += CountSize;
+		if (!is_valid_list_count(CountValue) || (size_t)(End - Cur) / ValueSize < (size_t)CountValue)
+			return nullptr;
+		size_t Count = (size_t)CountValue;
+		int ListIndex = (ListProperties == nullptr) ? -1 : ((ListProperties[0] == pi) ? 0 : ((ListProperties[1] == pi) ? 1 : -1));
+		if (ListIndex >= 0)
+		{
+			std::vector<double>& List = ListsOut[ListIndex];
+			List.resize(Count);
+			for (size_t k = 0; k < Count; ++k)
+				List[k] = read_binary_value(Cur + k * ValueSize, Property.Type, bSwapBytes);
+		}
+		Cur += Count * ValueSize;
+	}
+	return Cur;
+}
+
+static bool is_ascii_space(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static const char* skip_ascii_space(const char* Cur, const char* End)
+{
+	while (Cur < End && is_ascii_space(*Cur))
+		Cur++;
+	return Cur;
+}
+
+// parse the next whitespace-separated number in [Cur,End). Returns pointer past the number, or nullptr if there is none
+static const char* parse_ascii_value(const char* Cur, const char* End, double& ValueOut)
+{
+	Cur = skip_ascii_space(Cur, End);
+	const char* NumberEnd = parse_real(Cur, End, ValueOut);
+	if (NumberEnd == Cur || (NumberEnd < End && !is_ascii_space(*NumberEnd)))
+		return nullptr;
+	return NumberEnd;
+}
+
+/**
+ * Decode the ASCII record in the line [Cur,LineEnd), with the same outputs as decode_binary_record().
+ * Any extra values at the end of the line are ignored. Returns false if the line has too few values.
+ */
+static bool decode_ascii_record(const char* Cur, const char* LineEnd, const PLYElement& Element,
+	double* ScalarsOut, const int* ListProperties, std::vector<double>* ListsOut)
+{
+	int NumProperties = (int)Element.Properties.size();
+	for (int pi = 0; pi < NumProperties; ++pi)
+	{
+		const PLYProperty& Property = Element.Properties[pi];
+		double Value = 0;
+		Cur = parse_ascii_value(Cur, LineEnd, Value);
+		if (Cur == nullptr)
+			return false;
+		if (!Property.bIsList)
+		{
+			if (ScalarsOut != nullptr)
+				ScalarsOut[pi] = Value;
+			continue;
+		}
+
+		// each list item takes at least 2 characters
+		if (!is_valid_list_count(Value) || (size_t)Value > (size_t)(LineEnd - Cur) / 2 + 1)
+			return false;
+		size_t Count = (size_t)Value;
+		int ListIndex = (ListProperties == nullptr) ? -1 : ((ListProperties[0] == pi) ? 0 : ((ListProperties[1] == pi) ? 1 : -1));
+		if (ListIndex >= 0)
+			ListsOut[ListIndex].resize(Count);
+		for (size_t k = 0; k < Count; ++k)
+		{
+			Cur = parse_ascii_value(Cur, LineEnd, Value);
+			if (Cur == nullptr)
+				return false;
+			if (ListIndex >= 0)
+				ListsOut[ListIndex][k] = Value;
+		}
+	}
+	return true;
+}
+
+
+
+//
+// element layout
+//
+
+/**
+ * Location of the records of an element in the file data. Records are decoded in blocks of RecordsPerBlock
+ * consecutive records. If all records have the same size (ie there are no list properties, or all lists
+ * have the same length), Stride is the record size and block starts are computed directly. Otherwise
+ * (and for ASCII, where each record is a line) the start of each block is found by a serial pass over the records.
+ */
+struct PLYElementLayout
+{
+	const char* Start = nullptr;
+	const char* End = nullptr;
+	size_t Stride = 0;
+	size_t RecordsPerBlock = 1;
+	int NumBlocks = 0;
+	std::vector<const char*> BlockStarts;
+
+	const char* GetBlockStart(int Block) const
+	{
+		return (Stride > 0) ? (Start + (size_t)Block * RecordsPerBlock * Stride) : BlockStarts[Block];
+	}
+};
+
+
+class PLYFileDecoder
+{
+public:
+	MappedFileBuffer FileBuffer;
+	PLYHeader Header;
+	bool bSwapBytes = false;
+	int NumThreads = 1;
+	std::vector<PLYElementLayout> Layouts;
+
+	int FindElement(const char* Name) const
+	{
+		for (int k = 0; k < (int)Header.Elements.size(); ++k)
+			if (Header.Elements[k].Name == Name)
+				return k;
+		return -1;
+	}
+
+	/**
+	 * Open the file, parse the header, and compute the layouts of elements [0,LastElement]
+	 */
+	bool Open(const std::string& Path, const ReadOptions& Options, int& VertexElementOut, int& FaceElementOut)
+	{
+		if (!FileBuffer.Open(Path, Options.bUseMemoryMappedIO))
+			return false;
+		FileBuffer.AdviseSequential();
+		if (!parse_ply_header(FileBuffer.Data(), FileBuffer.Size(), Header))
+			return false;
+		bSwapBytes = (Header.Format != EPLYFormat::ASCII)
+			&& ((Header.Format == EPLYFormat::BinaryLittleEndian) != is_little_endian_platform());
+		NumThreads = get_num_worker_threads(Options.NumThreads);
+
+		VertexElementOut = FindElement("vertex");
+		FaceElementOut = FindElement("face");
+		int LastElement = std::max(VertexElementOut, FaceElementOut);
+		const char* Cur = FileBuffer.Data() + Header.DataOffset;
+		const char* DataEnd = FileBuffer.Data() + FileBuffer.Size();
+		Layouts.resize(LastElement + 1);
+		for (int k = 0; k <= LastElement; ++k)
+		{
+			if (!ComputeLayout(Header.Elements[k], Cur, DataEnd, Layouts[k]))
+				return false;
+			Cur = Layouts[k].End;
+		}
+		return true;
+	}
+
+	/**
+	 * Decode the records of Element with index ElementIndex in parallel blocks, and call
+	 * RecordFunc(int Block, size_t RecordIndex, const double* Scalars, const std::vector<double>* Lists)
+	 * for each, in order within each block. Returns false if any record is invalid.
+	 */
+	template<typename RecordFuncType>
+	bool DecodeRecords(int ElementIndex, const int ListProperties[2], RecordFuncType&& RecordFunc) const
+	{
+		const PLYElement& Element = Header.Elements[ElementIndex];
+		const PLYElementLayout& Layout = Layouts[ElementIndex];
+		std::vector<uint8_t> BlockValid(Layout.NumBlocks, 1);
+		parallel_for_blocks(Layout.NumBlocks, NumThreads, [&](int Block)
+		{
+			std::vector<double> Scalars(Element.Properties.size(), 0.0);
+			std::vector<double> Lists[2];
+			size_t FirstRecord = (size_t)Block * Layout.RecordsPerBlock;
+			size_t EndRecord = std::min((size_t)Element.Count, FirstRecord + Layout.RecordsPerBlock);
+			const char* Cur = Layout.GetBlockStart(Block);
+			for (size_t r = FirstRecord; r < EndRecord; ++r)
+			{
+				Cur = DecodeRecord(Cur, Layout.End, Element, Scalars.data(), ListProperties, Lists);
+				if (Cur == nullptr) {
+					BlockValid[Block] = 0;
+					return;
+				}
+				RecordFunc(Block, r, Scalars.data(), (const std::vector<double>*)Lists);
+			}
+		});
+		return std::find(BlockValid.begin(), BlockValid.end(), 0) == BlockValid.end();
+	}
+
+	/**
+	 * Byte offset of each property of a binary element in its first record, which for a fixed-stride
+	 * element (ie Layouts[ElementIndex].Stride > 0) is the offset in every record. The offset of a list
+	 * property is the offset of its count. Element must have at least one record.
+	 */
+	std::vector<size_t> GetPropertyOffsets(int ElementIndex) const
+	{
+		const PLYElement& Element = Header.Elements[ElementIndex];
+		const char* Record = Layouts[ElementIndex].Start;
+		std::vector<size_t> Offsets;
+		size_t Offset = 0;
+		for (const PLYProperty& Property : Element.Properties)
+		{
+			Offsets.push_back(Offset);
+			if (Property.bIsList) {
+				size_t CountSize = get_type_size(Property.ListCountType);
+				Offset += CountSize + (size_t)read_binary_value(Record + Offset, Property.ListCountType, bSwapBytes) * get_type_size(Property.Type);
+			}
+			else
+				Offset += get_type_size(Property.Type);
+		}
+		return Offsets;
+	}
+
+protected:
+	// decode the record at Cur and return the start of the next record, or nullptr
+	const char* DecodeRecord(const char* Cur, const char* End, const PLYElement& Element,
+		double* ScalarsOut, const int* ListProperties, std::vector<double>* ListsOut) const
+	{
+		if (Header.Format != EPLYFormat::ASCII)
+			return decode_binary_record(Cur, End, Element, bSwapBytes, ScalarsOut, ListProperties, ListsOut);
+
+		Cur = skip_ascii_space(Cur, End);
+		const char* LineEnd = find_line_end(Cur, End);
+		if (Cur == End || !decode_ascii_record(Cur, LineEnd, Element, ScalarsOut, ListProperties, ListsOut))
+			return nullptr;
+		return (LineEnd < End) ? LineEnd + 1 : End;
+	}
+
+	bool ComputeLayout(const PLYElement& Element, const char* Start, const char* DataEnd, PLYElementLayout& Layout)
+	{
+		Layout.Start = Layout.End = Start;
+		if (Element.Count == 0)
+			return true;
+		Layout.NumBlocks = (int)std::min(Element.Count, (uint64_t)std::max(NumThreads, 1) * 4);
+		Layout.RecordsPerBlock = (size_t)((Element.Count + Layout.NumBlocks - 1) / Layout.NumBlocks);
+
+		if (Header.Format != EPLYFormat::ASCII && IsFixedStride(Element, Start, DataEnd, Layout.Stride))
+		{
+			if ((size_t)(DataEnd - Start) / Layout.Stride < Element.Count)
+				return false;
+			Layout.End = Start + (size_t)Element.Count * Layout.Stride;
+			return true;
+		}
+
+		// serial pass to find the start of each block
+		Layout.Stride = 0;
+		const char* Cur = Start;
+		for (uint64_t r = 0; r < Element.Count; ++r)
+		{
+			if (r % Layout.RecordsPerBlock == 0)
+				Layout.BlockStarts.push_back(Cur);
+			if (Header.Format != EPLYFormat::ASCII)
+			{
+				Cur = decode_binary_record(Cur, DataEnd, Element, bSwapBytes, nullptr, nullptr, nullptr);
+				if (Cur == nullptr)
+					return false;
+			}
+			else
+			{
+				Cur = skip_ascii_space(Cur, DataEnd);
+				if (Cur == DataEnd)
+					return false;
+				const char* LineEnd = find_line_end(Cur, DataEnd);
+				Cur = (LineEnd < DataEnd) ? LineEnd + 1 : DataEnd;
+			}
+		}
+		Layout.End = Cur;
+		return true;
+	}
+
+	/**
+	 * Returns true if all records of the binary Element have the size of the first record, ie if there are
+	 * no list properties, or each list has the same count in every record as in the first record.
+	 */
+	bool IsFixedStride(const PLYElement& Element, const char* Start, const char* DataEnd, size_t& StrideOut) const
+	{
+		const char* FirstEnd = decode_binary_record(Start, DataEnd, Element, bSwapBytes, nullptr, nullptr, nullptr);
+		if (FirstEnd == nullptr || FirstEnd == Start)
+			return false;
+		StrideOut = (size_t)(FirstEnd - Start);
+
+		// offset and size of each list count in the first record
+		std::vector<std::pair<size_t, size_t>> CountFields;
+		size_t Offset = 0;
+		for (const PLYProperty& Property : Element.Properties)
+		{
+			if (Property.bIsList) {
+				size_t CountSize = get_type_size(Property.ListCountType);
+				CountFields.push_back({ Offset, CountSize });
+				Offset += CountSize + (size_t)read_binary_value(Start + Offset, Property.ListCountType, bSwapBytes) * get_type_size(Property.Type);
+			}
+			else
+				Offset += get_type_size(Property.Type);
+		}
+		if (CountFields.empty())
+			return true;
+		if ((size_t)(DataEnd - Start) / StrideOut < Element.Count)
+			return false;
+
+		// all counts must be bitwise-identical to the first record
+		std::vector<uint8_t> BlockMatches(NumThreads * 4, 1);
+		parallel_for_ranges((size_t)Element.Count, (int)BlockMatches.size(), NumThreads, [&](int Block, size_t First, size_t End)
+		{
+			for (size_t r = First; r < End; ++r)
+			{
+				const char* Record = Start + r * StrideOut;
+				for (const std::pair<size_t, size_t>& Field : CountFields) {
+					if (memcmp(Record + Field.first, Start + Field.first, Field.second) != 0) {
+						BlockMatches[Block] = 0;
+						return;
+					}
+				}
+			}
+		});
+		return std::find(BlockMatches.begin(), BlockMatches.end(), 0) == BlockMatches.end();
+	}
+};
+
+
+
+//
+// mesh extraction
+//
+
+static int find_scalar_property(const PLYElement& Element, std::initializer_list<const char*> Names)
+{
+	for (const char* Name : Names)
+		for (int k = 0; k < (int)Element.Properties.size(); ++k)
+			if (Element.Properties[k].bIsList == false && Element.Properties[k].Name == Name)
+				return k;
+	return -1;
+}
+
+static int find_list_property(const PLYElement& Element, std::initializer_list<const char*> Names)
+{
+	for (const char* Name : Names)
+		for (int k = 0; k < (int)Element.Properties.size(); ++k)
+			if (Element.Properties[k].bIsList && Element.Properties[k].Name == Name)
+				return k;
+	return -1;
+}
+
+// scale that maps values of Type to [0,1], ie integer colors are divided by the max value of the type
+static double get_color_scale(EPLYPropertyType Type)
+{
+	switch (Type)
+	{
+	case EPLYPropertyType::Int8: return 1.0 / 127.0;
+	case EPLYPropertyType::UInt8: return 1.0 / 255.0;
+	case EPLYPropertyType::Int16: return 1.0 / 32767.0;
+	case EPLYPropertyType::UInt16: return 1.0 / 65535.0;
+	case EPLYPropertyType::Int32: return 1.0 / 2147483647.0;
+	case EPLYPropertyType::UInt32: return 1.0 / 4294967295.0;
+	default: return 1.0;
+	}
+}
+
+static uint8_t to_color_byte(double Value)
+{
+	return (uint8_t)std::clamp(std::floor(Value * 255.0 + 0.5), 0.0, 255.0);
+}
+
+struct PLYVertexProperties
+{
+	int Position[3] = { -1, -1, -1 };
+	int Normal[3] = { -1, -1, -1 };
+	int UV[2] = { -1, -1 };
+	int Color[4] = { -1, -1, -1, -1 };
+	double ColorScale[4] = { 1, 1, 1, 1 };
+	bool bHaveNormals = false;
+	bool bHaveUVs = false;
+	bool bHaveColors = false;
+
+	PLYVertexProperties(const PLYElement& Element, const ReadOptions& Options)
+	{
+		const char* PositionNames[3] = { "x", "y", "z" };
+		const char* NormalNames[3] = { "nx", "ny", "nz" };
+		const char* ColorNames[4][2] = { { "red", "diffuse_red" }, { "green", "diffuse_green" }, { "blue", "diffuse_blue" }, { "alpha", "diffuse_alpha" } };
+		for (int k = 0; k < 3; ++k) {
+			Position[k] = find_scalar_property(Element, { PositionNames[k] });
+			Normal[k] = find_scalar_property(Element, { NormalNames[k] });
+		}
+		UV[0] = find_scalar_property(Element, { "u", "s", "texture_u", "texture_s" });
+		UV[1] = find_scalar_property(Element, { "v", "t", "texture_v", "texture_t" });
+		for (int k = 0; k < 4; ++k) {
+			Color[k] = find_scalar_property(Element, { ColorNames[k][0], ColorNames[k][1] });
+			if (Color[k] >= 0)
+				ColorScale[k] = get_color_scale(Element.Properties[Color[k]].Type);
+		}
+		bHaveNormals = !Options.bIgnoreNormals && Normal[0] >= 0 && Normal[1] >= 0 && Normal[2] >= 0;
+		bHaveUVs = !Options.bIgnoreUVs && UV[0] >= 0 && UV[1] >= 0;
+		bHaveColors = !Options.bIgnoreColors && Color[0] >= 0 && Color[1] >= 0 && Color[2] >= 0;
+	}
+
+	bool HasPositions() const { return Position[0] >= 0 && Position[1] >= 0 && Position[2] >= 0; }
+
+	Vector3d GetPosition(const double* Scalars) const { return Vector3d(Scalars[Position[0]], Scalars[Position[1]], Scalars[Position[2]]); }
+	Vector3f GetNormal(const double* Scalars) const { return Vector3f((float)Scalars[Normal[0]], (float)Scalars[Normal[1]], (float)Scalars[Normal[2]]); }
+	Vector2f GetUV(const double* Scalars) const { return Vector2f((float)Scalars[UV[0]], (float)Scalars[UV[1]]); }
+	Color4b GetColor(const double* Scalars) const
+	{
+		Color4b Color;
+		Color.R = to_color_byte(Scalars[this->Color[0]] * ColorScale[0]);
+		Color.G = to_color_byte(Scalars[this->Color[1]] * ColorScale[1]);
+		Color.B = to_color_byte(Scalars[this->Color[2]] * ColorScale[2]);
+		Color.A = (this->Color[3] >= 0) ? to_color_byte(Scalars[this->Color[3]] * ColorScale[3]) : 255;
+		return Color;
+	}
+};
+
+// vertex attributes, stored per vertex while faces are converted
+struct PLYVertexAttributes
+{
+	std::vector<Vector3f> Normals;
+	std::vector<Vector2f> UVs;
+	std::vector<Color4b> Colors;
+};
+
+// faces decoded by one block of face records
+struct PLYFaceBlock
+{
+	std::vector<int> FaceSizes;
+	std::vector<int> Indices;
+	std::vector<Vector2f> UVs;		// per face-vertex, if the faces have a texcoord list
+	size_t NumTriangles = 0;
+};
+
+/**
+ * Decode the vertex_indices list (and texcoord list, if bWantFaceUVs) of each face record into per-block face lists.
+ * Returns false if a record is invalid or an index is not in [0,NumVertices). bHaveFaceUVsOut is set if the faces have texcoords.
+ */
+static bool decode_ply_faces(const PLYFileDecoder& File, int FaceElement, size_t NumVertices, bool bWantFaceUVs,
+	std::vector<PLYFaceBlock>& BlocksOut, bool& bHaveFaceUVsOut)
+{
+	bHaveFaceUVsOut = false;
+	if (FaceElement < 0 || File.Header.Elements[FaceElement].Count == 0)
+		return true;
+	const PLYElement& Element = File.Header.Elements[FaceElement];
+	int ListProperties[2] = { find_list_property(Element, { "vertex_indices", "vertex_index" }), -1 };
+	if (ListProperties[0] < 0)
+		return false;
+	if (bWantFaceUVs)
+		ListProperties[1] = find_list_property(Element, { "texcoord" });
+	bHaveFaceUVsOut = (ListProperties[1] >= 0);
+
+	BlocksOut.resize(File.Layouts[FaceElement].NumBlocks);
+	std::vector<uint8_t> BlockValid(BlocksOut.size(), 1);
+	bool bRecordsValid = File.DecodeRecords(FaceElement, ListProperties, [&](int Block, size_t, const double*, const std::vector<double>* Lists)
+	{
+		PLYFaceBlock& FaceBlock = BlocksOut[Block];
+		const std::vector<double>& Indices = Lists[0];
+		int FaceSize = (int)Indices.size();
+		for (double Index : Indices) {
+			if (!(Index >= 0 && Index < (double)NumVertices))
+				BlockValid[Block] = 0;
+			FaceBlock.Indices.push_back((int)Index);
+		}
+		FaceBlock.FaceSizes.push_back(FaceSize);
+		FaceBlock.NumTriangles += (size_t)std::max(FaceSize - 2, 0);
+		if (ListProperties[1] >= 0)
+		{
+			// texcoord lists that do not have a UV for each face-vertex are ignored
+			const std::vector<double>& TexCoords = Lists[1];
+			bool bValidTexCoords = (TexCoords.size() == 2 * (size_t)FaceSize);
+			for (int j = 0; j < FaceSize; ++j)
+				FaceBlock.UVs.push_back((bValidTexCoords) ? Vector2f((float)TexCoords[2*j], (float)TexCoords[2*j+1]) : Vector2f::Zero());
+		}
+	});
+	return bRecordsValid && std::find(BlockValid.begin(), BlockValid.end(), 0) == BlockValid.end();
+}
+
+
+
+//
+// typed decoding of fixed-stride binary records
+//
+
+// byte offsets of the vertex properties that are read, in fixed-stride binary vertex records
+struct PLYFixedVertexLayout
+{
+	EPLYPropertyType PositionType = EPLYPropertyType::Float32;
+	size_t Position[3] = { 0, 0, 0 };
+	size_t Normal[3] = { 0, 0, 0 };
+	size_t UV[2] = { 0, 0 };
+	size_t Color[4] = { 0, 0, 0, 0 };
+	bool bHaveAlpha = false;
+};
+
+/**
+ * Returns true if the vertex records can be decoded with typed loads at fixed offsets, ie they are binary and
+ * fixed-stride, x/y/z are all float or all double, and the normals/UVs that are read are float and the colors uchar
+ * (the layout that WritePLY() and most scanners write).
+ */
+static bool get_fixed_vertex_layout(const PLYFileDecoder& File, int VertexElement, const PLYVertexProperties& Properties, PLYFixedVertexLayout& LayoutOut)
+{
+	const PLYElement& Element = File.Header.Elements[VertexElement];
+	if (File.Header.Format == EPLYFormat::ASCII || Element.Count == 0 || File.Layouts[VertexElement].Stride == 0)
+		return false;
+	auto HasType = [&](const int* PropertyIndices, int Count, EPLYPropertyType Type) {
+		for (int k = 0; k < Count; ++k)
+			if (Element.Properties[PropertyIndices[k]].Type != Type)
+				return false;
+		return true;
+	};
+	LayoutOut.PositionType = Element.Properties[Properties.Position[0]].Type;
+	LayoutOut.bHaveAlpha = (Properties.Color[3] >= 0);
+	if ((LayoutOut.PositionType != EPLYPropertyType::Float32 && LayoutOut.PositionType != EPLYPropertyType::Float64)
+		|| !HasType(Properties.Position, 3, LayoutOut.PositionType)
+		|| (Properties.bHaveNormals && !HasType(Properties.Normal, 3, EPLYPropertyType::Float32))
+		|| (Properties.bHaveUVs && !HasType(Properties.UV, 2, EPLYPropertyType::Float32))
+		|| (Properties.bHaveColors && !HasType(Properties.Color, (LayoutOut.bHaveAlpha) ? 4 : 3, EPLYPropertyType::UInt8)))
+		return false;
+
+	std::vector<size_t> Offsets = File.GetPropertyOffsets(VertexElement);
+	for (int k = 0; k < 3; ++k) {
+		LayoutOut.Position[k] = Offsets[Properties.Position[k]];
+		LayoutOut.Normal[k] = (Properties.bHaveNormals) ? Offsets[Properties.Normal[k]] : 0;
+	}
+	for (int k = 0; k < 2; ++k)
+		LayoutOut.UV[k] = (Properties.bHaveUVs) ? Offsets[Properties.UV[k]] : 0;
+	for (int k = 0; k < 4; ++k)
+		LayoutOut.Color[k] = (Properties.bHaveColors && Properties.Color[k] >= 0) ? Offsets[Properties.Color[k]] : 0;
+	return true;
+}
+
+template<typename PositionType, typename SetPositionFuncType>
+static void decode_fixed_vertices(const PLYFileDecoder& File, int VertexElement, const PLYFixedVertexLayout& Fixed,
+	PLYVertexAttributes& Attributes, SetPositionFuncType& SetPosition)
+{
+	const PLYElementLayout& Layout = File.Layouts[VertexElement];
+	size_t NumVertices = (size_t)File.Header.Elements[VertexElement].Count;
+	bool bSwapBytes = File.bSwapBytes;
+	parallel_for_blocks(Layout.NumBlocks, File.NumThreads, [&](int Block)
+	{
+		size_t FirstRecord = (size_t)Block * Layout.RecordsPerBlock;
+		size_t EndRecord = std::min(NumVertices, FirstRecord + Layout.RecordsPerBlock);
+		for (size_t vid = FirstRecord; vid < EndRecord; ++vid)
+		{
+			const char* Record = Layout.Start + vid * Layout.Stride;
+			SetPosition(vid, Vector3d(
+				(double)load_binary<PositionType>(Record + Fixed.Position[0], bSwapBytes),
+				(double)load_binary<PositionType>(Record + Fixed.Position[1], bSwapBytes),
+				(double)load_binary<PositionType>(Record + Fixed.Position[2], bSwapBytes)));
+			if (!Attributes.Normals.empty())
+				Attributes.Normals[vid] = Vector3f(load_binary<float>(Record + Fixed.Normal[0], bSwapBytes),
+					load_binary<float>(Record + Fixed.Normal[1], bSwapBytes), load_binary<float>(Record + Fixed.Normal[2], bSwapBytes));
+			if (!Attributes.UVs.empty())
+				Attributes.UVs[vid] = Vector2f(load_binary<float>(Record + Fixed.UV[0], bSwapBytes), load_binary<float>(Record + Fixed.UV[1], bSwapBytes));
+			if (!Attributes.Colors.empty()) {
+				Color4b Color;
+				Color.R = (uint8_t)Record[Fixed.Color[0]];
+				Color.G = (uint8_t)Record[Fixed.Color[1]];
+				Color.B = (uint8_t)Record[Fixed.Color[2]];
+				Color.A = (Fixed.bHaveAlpha) ? (uint8_t)Record[Fixed.Color[3]] : 255;
+				Attributes.Colors[vid] = Color;
+			}
+		}
+	});
+}
+
+/**
+ * Decode the vertex records, passing each position to SetPosition(size_t VertexIndex, const Vector3d&) and storing
+ * the other attributes in the non-empty arrays of Attributes. Uses typed loads if get_fixed_vertex_layout() allows,
+ * otherwise DecodeRecords(). Returns false if a record is invalid.
+ */
+template<typename SetPositionFuncType>
+static bool decode_ply_vertices(const PLYFileDecoder& File, int VertexElement, const PLYVertexProperties& Properties,
+	PLYVertexAttributes& Attributes, SetPositionFuncType&& SetPosition)
+{
+	PLYFixedVertexLayout FixedLayout;
+	if (get_fixed_vertex_layout(File, VertexElement, Properties, FixedLayout))
+	{
+		if (FixedLayout.PositionType == EPLYPropertyType::Float32)
+			decode_fixed_vertices<float>(File, VertexElement, FixedLayout, Attributes, SetPosition);
+		else
+			decode_fixed_vertices<double>(File, VertexElement, FixedLayout, Attributes, SetPosition);
+		return true;
+	}
+
+	const int NoLists[2] = { -1, -1 };
+	return File.DecodeRecords(VertexElement, NoLists, [&](int, size_t vid, const double* Scalars, const std::vector<double>*)
+	{
+		SetPosition(vid, Properties.GetPosition(Scalars));
+		if (!Attributes.Normals.empty())
+			Attributes.Normals[vid] = Properties.GetNormal(Scalars);
+		if (!Attributes.UVs.empty())
+			Attributes.UVs[vid] = Properties.GetUV(Scalars);
+		if (!Attributes.Colors.empty())
+			Attributes.Colors[vid] = Properties.GetColor(Scalars);
+	});
+}
+
+/**
+ * Returns true if every face record is a triangle whose indices can be loaded directly, ie the records are binary
+ * and fixed-stride, the vertex_indices list has 3 int or uint items in every record, and no texcoord list is read.
+ * IndexOffsetOut is the offset of the first index in each record.
+ */
+static bool get_fixed_triangle_layout(const PLYFileDecoder& File, int FaceElement, bool bWantFaceUVs,
+	size_t& IndexOffsetOut, EPLYPropertyType& IndexTypeOut)
+{
+	if (FaceElement < 0 || File.Header.Format == EPLYFormat::ASCII)
+		return false;
+	const PLYElement& Element = File.Header.Elements[FaceElement];
+	if (Element.Count == 0 || File.Layouts[FaceElement].Stride == 0)
+		return false;
+	int IndicesProperty = find_list_property(Element, { "vertex_indices", "vertex_index" });
+	if (IndicesProperty < 0 || (bWantFaceUVs && find_list_property(Element, { "texcoord" }) >= 0))
+		return false;
+	const PLYProperty& Property = Element.Properties[IndicesProperty];
+	IndexTypeOut = Property.Type;
+	if (IndexTypeOut != EPLYPropertyType::Int32 && IndexTypeOut != EPLYPropertyType::UInt32)
+		return false;
+	size_t CountOffset = File.GetPropertyOffsets(FaceElement)[IndicesProperty];
+	if (read_binary_value(File.Layouts[FaceElement].Start + CountOffset, Property.ListCountType, File.bSwapBytes) != 3.0)
+		return false;
+	IndexOffsetOut = CountOffset + get_type_size(Property.ListCountType);
+	return true;
+}
+
+/**
+ * Load the 3 indices of each fixed-layout triangle record (see get_fixed_triangle_layout()) and pass them to
+ * EmitTriangle(int TriangleIndex, const Index3i&). Returns false if an index is not in [0,NumVertices).
+ */
+template<typename IndexType, typename EmitTriangleFuncType>
+static bool decode_fixed_triangles(const PLYFileDecoder& File, int FaceElement, size_t IndexOffset, size_t NumVertices,
+	EmitTriangleFuncType&& EmitTriangle)
+{
+	const PLYElementLayout& Layout = File.Layouts[FaceElement];
+	size_t NumTriangles = (size_t)File.Header.Elements[FaceElement].Count;
+	bool bSwapBytes = File.bSwapBytes;
+	std::vector<uint8_t> BlockValid(Layout.NumBlocks, 1);
+	parallel_for_blocks(Layout.NumBlocks, File.NumThreads, [&](int Block)
+	{
+		size_t FirstRecord = (size_t)Block * Layout.RecordsPerBlock;
+		size_t EndRecord = std::min(NumTriangles, FirstRecord + Layout.RecordsPerBlock);
+		for (size_t tid = FirstRecord; tid < EndRecord; ++tid)
+		{
+			const char* Indices = Layout.Start + tid * Layout.Stride + IndexOffset;
+			int64_t Tri[3];
+			for (int j = 0; j < 3; ++j)
+				Tri[j] = (int64_t)load_binary<IndexType>(Indices + j * sizeof(IndexType), bSwapBytes);
+			if (Tri[0] < 0 || Tri[1] < 0 || Tri[2] < 0 || Tri[0] >= (int64_t)NumVertices || Tri[1] >= (int64_t)NumVertices || Tri[2] >= (int64_t)NumVertices) {
+				BlockValid[Block] = 0;
+				return;
+			}
+			EmitTriangle((int)tid, Index3i((int)Tri[0], (int)Tri[1], (int)Tri[2]));
+		}
+	});
+	return std::find(BlockValid.begin(), BlockValid.end(), 0) == BlockValid.end();
+}
+
+
+bool GS::PLYReader::ReadPLYHeader(
+	const std::string& Path,
+	PLYHeader& HeaderOut)
+{
+	MappedFileBuffer FileBuffer;
+	if (!FileBuffer.Open(Path, true))
+		return false;
+	return parse_ply_header(FileBuffer.Data(), FileBuffer.Size(), HeaderOut);
+}
+
+
+bool GS::PLYReader::ReadPLY(
+	const std::string& Path,
+	DenseMesh& MeshOut,
+	const ReadOptions& Options)
+{
+	PLYFileDecoder File;
+	int VertexElement = -1, FaceElement = -1;
+	if (!File.Open(Path, Options, VertexElement, FaceElement) || VertexElement < 0)
+		return false;
+	PLYVertexProperties VertexProperties(File.Header.Elements[VertexElement], Options);
+	if (!VertexProperties.HasPositions())
+		return false;
+	size_t NumVertices = (size_t)File.Header.Elements[VertexElement].Count;
+
+	// triangle-only binary files are read directly from the records after the vertices, other faces are decoded into per-block lists first
+	size_t TriangleIndexOffset = 0;
+	EPLYPropertyType TriangleIndexType = EPLYPropertyType::Int32;
+	bool bFixedTriangles = get_fixed_triangle_layout(File, FaceElement, !Options.bIgnoreUVs, TriangleIndexOffset, TriangleIndexType);
+	std::vector<PLYFaceBlock> FaceBlocks;
+	bool bHaveFaceUVs = false;
+	if (!bFixedTriangles && !decode_ply_faces(File, FaceElement, NumVertices, !Options.bIgnoreUVs, FaceBlocks, bHaveFaceUVs))
+		return false;
+	std::vector<size_t> BlockTriangleOffsets(FaceBlocks.size() + 1, 0);
+	for (size_t k = 0; k < FaceBlocks.size(); ++k)
+		BlockTriangleOffsets[k+1] = BlockTriangleOffsets[k] + FaceBlocks[k].NumTriangles;
+	size_t NumTriangles = (bFixedTriangles) ? (size_t)File.Header.Elements[FaceElement].Count : BlockTriangleOffsets.back();
+	if (NumVertices > (size_t)std::numeric_limits<int>::max() || NumTriangles > (size_t)std::numeric_limits<int>::max())
+		return false;
+
+	// positions are decoded directly into the mesh, the other vertex attributes are needed to set the triangle-vertex attributes
+	MeshOut.Resize((int)NumVertices, (int)NumTriangles);
+	PLYVertexAttributes VertexAttributes;
+	if (VertexProperties.bHaveNormals)
+		VertexAttributes.Normals.resize(NumVertices);
+	if (VertexProperties.bHaveUVs && !bHaveFaceUVs)
+		VertexAttributes.UVs.resize(NumVertices);
+	if (VertexProperties.bHaveColors)
+		VertexAttributes.Colors.resize(NumVertices);
+	bool bVerticesValid = decode_ply_vertices(File, VertexElement, VertexProperties, VertexAttributes, [&](size_t vid, const Vector3d& Position)
+	{
+		MeshOut.SetPosition((int)vid, Position);
+	});
+	if (!bVerticesValid)
+		return false;
+
+	// set triangle tid and the triangle-vertex attributes that come from the vertices
+	auto SetTriangle = [&](int tid, const Index3i& Tri)
+	{
+		MeshOut.SetTriangle(tid, Tri);
+		if (!VertexAttributes.Normals.empty()) {
+			TriVtxNormals Normals;
+			for (int k = 0; k < 3; ++k)
+				Normals[k] = VertexAttributes.Normals[Tri[k]];
+			MeshOut.SetTriVtxNormals(tid, Normals);
+		}
+		if (!VertexAttributes.UVs.empty()) {
+			TriVtxUVs UVs;
+			for (int k = 0; k < 3; ++k)
+				UVs[k] = VertexAttributes.UVs[Tri[k]];
+			MeshOut.SetTriVtxUVs(tid, UVs);
+		}
+		if (!VertexAttributes.Colors.empty()) {
+			TriVtxColors Colors;
+			for (int k = 0; k < 3; ++k)
+				Colors[k] = VertexAttributes.Colors[Tri[k]];
+			MeshOut.SetTriVtxColors(tid, Colors);
+		}
+	};
+
+	if (bFixedTriangles)
+	{
+		return (TriangleIndexType == EPLYPropertyType::Int32) ?
+			decode_fixed_triangles<int32_t>(File, FaceElement, TriangleIndexOffset, NumVertices, SetTriangle) :
+			decode_fixed_triangles<uint32_t>(File, FaceElement, TriangleIndexOffset, NumVertices, SetTriangle);
+	}
+
+	// fan-tessellate the faces of each block into its range of triangles
+	parallel_for_blocks((int)FaceBlocks.size(), File.NumThreads, [&](int Block)
+	{
+		const PLYFaceBlock& FaceBlock = FaceBlocks[Block];
+		int tid = (int)BlockTriangleOffsets[Block];
+		size_t FaceStart = 0;
+		for (int FaceSize : FaceBlock.FaceSizes)
+		{
+			const int* Face = &FaceBlock.Indices[FaceStart];
+			for (int j = 1; j < FaceSize - 1; ++j, ++tid)
+			{
+				SetTriangle(tid, Index3i(Face[0], Face[j], Face[j+1]));
+				if (bHaveFaceUVs) {
+					TriVtxUVs UVs;
+					UVs[0] = FaceBlock.UVs[FaceStart];
+					UVs[1] = FaceBlock.UVs[FaceStart + j];
+					UVs[2] = FaceBlock.UVs[FaceStart + j + 1];
+					MeshOut.SetTriVtxUVs(tid, UVs);
+				}
+			}
+			FaceStart += (size_t)FaceSize;
+		}
+	});
+	return true;
+}
+
+
+bool GS::PLYReader::ReadPLY(
+	const std::string& Path,
+	PolyMesh& MeshOut,
+	const ReadOptions& Options)
+{
+	const int UseNormalSet = 0;
+	const int UseUVSet = 0;
+	const int UseColorSet = 0;
+
+	MeshOut = PolyMesh();
+	PLYFileDecoder File;
+	int VertexElement = -1, FaceElement = -1;
+	if (!File.Open(Path, Options, VertexElement, FaceElement) || VertexElement < 0)
+		return false;
+	PLYVertexProperties VertexProperties(File.Header.Elements[VertexElement], Options);
+	if (!VertexProperties.HasPositions())
+		return false;
+	size_t NumVertices = (size_t)File.Header.Elements[VertexElement].Count;
+
+	std::vector<PLYFaceBlock> FaceBlocks;
+	bool bHaveFaceUVs = false;
+	if (!decode_ply_faces(File, FaceElement, NumVertices, !Options.bIgnoreUVs, FaceBlocks, bHaveFaceUVs))
+		return false;
+	size_t NumTriangles = 0, NumQuads = 0, NumPolygons = 0;
+	for (const PLYFaceBlock& FaceBlock : FaceBlocks)
+		for (int FaceSize : FaceBlock.FaceSizes) {
+			NumTriangles += (FaceSize == 3) ? 1 : 0;
+			NumQuads += (FaceSize == 4) ? 1 : 0;
+			NumPolygons += (FaceSize > 4) ? 1 : 0;
+		}
+	if (NumVertices > (size_t)std::numeric_limits<int>::max() || NumTriangles + NumQuads + NumPolygons > (size_t)std::numeric_limits<int>::max())
+		return false;
+
+	// records are decoded in parallel, the PolyMesh is then built serially
+	std::vector<Vector3d> Positions(NumVertices);
+	PLYVertexAttributes VertexAttributes;
+	if (VertexProperties.bHaveNormals)
+		VertexAttributes.Normals.resize(NumVertices);
+	if (VertexProperties.bHaveUVs && !bHaveFaceUVs)
+		VertexAttributes.UVs.resize(NumVertices);
+	if (VertexProperties.bHaveColors)
+		VertexAttributes.Colors.resize(NumVertices);
+	bool bVerticesValid = decode_ply_vertices(File, VertexElement, VertexProperties, VertexAttributes, [&](size_t vid, const Vector3d& Position)
+	{
+		Positions[vid] = Position;
+	});
+	if (!bVerticesValid)
+		return false;
+
+	MeshOut.ReserveVertices((int)NumVertices);
+	MeshOut.ReserveFaces((int)NumTriangles, (int)NumQuads, (int)NumPolygons);
+	for (const Vector3d& Position : Positions)
+		MeshOut.AddVertex(Position);
+	Positions = std::vector<Vector3d>();
+
+	// vertex attributes have one element per vertex, so the element index of a face-vertex is the vertex index
+	bool bWantNormals = !VertexAttributes.Normals.empty();
+	bool bWantVertexUVs = !VertexAttributes.UVs.empty();
+	bool bWantColors = !VertexAttributes.Colors.empty();
+	if (bWantNormals)
+	{
+		MeshOut.SetNumNormalSets(UseNormalSet + 1);
+		for (const Vector3f& Normal : VertexAttributes.Normals)
+			MeshOut.AddNormal(Normal, UseNormalSet);
+	}
+	if (bWantVertexUVs || bHaveFaceUVs)
+	{
+		MeshOut.SetNumUVSets(UseUVSet + 1);
+		for (const Vector2f& UV : VertexAttributes.UVs)
+			MeshOut.AddUV(UV, UseUVSet);
+	}
+	if (bWantColors)
+	{
+		MeshOut.SetNumColorSets(UseColorSet + 1);
+		for (const Color4b& Color : VertexAttributes.Colors)
+			MeshOut.AddColor(Vector4f(Color.R / 255.0f, Color.G / 255.0f, Color.B / 255.0f, Color.A / 255.0f), UseColorSet);
+	}
+
+	std::vector<int> Polygon;
+	for (const PLYFaceBlock& FaceBlock : FaceBlocks)
+	{
+		size_t FaceStart = 0;
+		for (int FaceSize : FaceBlock.FaceSizes)
+		{
+			const int* Face = &FaceBlock.Indices[FaceStart];
+			int NewFaceIndex = -1;
+			if (FaceSize == 3)
+				NewFaceIndex = MeshOut.AddTriangle(Index3i(Face[0], Face[1], Face[2]));
+			else if (FaceSize == 4)
+				NewFaceIndex = MeshOut.AddQuad(Index4i(Face[0], Face[1], Face[2], Face[3]));
+			else if (FaceSize > 4) {
+				Polygon.assign(Face, Face + FaceSize);
+				NewFaceIndex = MeshOut.AddPolygon(Polygon);
+			}
+			if (NewFaceIndex >= 0)
+			{
+				PolyMesh::Face NewFace = MeshOut.GetFace(NewFaceIndex);
+				for (int j = 0; j < FaceSize; ++j)
+				{
+					if (bWantNormals)
+						MeshOut.SetFaceVertexNormalIndex(NewFace, j, Face[j], UseNormalSet);
+					if (bHaveFaceUVs)
+						MeshOut.SetFaceVertexUVIndex(NewFace, j, MeshOut.AddUV(FaceBlock.UVs[FaceStart + j], UseUVSet), UseUVSet);
+					else if (bWantVertexUVs)
+						MeshOut.SetFaceVertexUVIndex(NewFace, j, Face[j], UseUVSet);
+					if (bWantColors)
+						MeshOut.SetFaceVertexColorIndex(NewFace, j, Face[j], UseColorSet);
+				}
+			}
+			FaceStart += (size_t)FaceSize;
+		}
+	}
+	return true;
+}
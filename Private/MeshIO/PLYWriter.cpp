@@ -0,0 +1,326 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#include "MeshIO/PLYWriter.h"
+#include "MeshIO/MappedFileWriter.h"
+#include "MeshIO/number_formatting.h"
+#include "MeshIO/parallel_utils.h"
+
+#include <cstring>
+#include <vector>
+
+
+using namespace GS;
+using namespace GS::PLYWriter;
+using namespace GS::NumberFormatting;
+
+
+static constexpr size_t PLYFaceRecordSize = 13;		// uchar count, 3 x int index
+// records packed per block in streamed binary output
+static constexpr size_t PLYBlockRecords = 1 << 16;
+
+// attribute values of a PLY vertex, used to split mesh vertices. Keys are compared bitwise, so they are zero-filled and disabled attributes are zero
+struct PLYCornerKey
+{
+	int Vertex;
+	Vector3f Normal;
+	Vector2f UV;
+	Color4b Color;
+};
+
+/**
+ * Mapping from PLY vertices to the mesh. If bSplitVertices, PLY vertex i < VertexCorners.size() has the
+ * position and attributes of triangle-vertex VertexCorners[i], and the remaining PLY vertices are the
+ * UnusedVertices of the mesh. Otherwise PLY vertices are the mesh vertices.
+ */
+struct PLYVertexTable
+{
+	bool bNormals = false;
+	bool bUVs = false;
+	bool bColors = false;
+	bool bSplitVertices = false;
+
+	size_t NumVertices = 0;
+	std::vector<int> CornerVertices;
+	std::vector<uint32_t> VertexCorners;
+	std::vector<int> UnusedVertices;
+
+	void Build(const DenseMesh& Mesh, const WriteOptions& Options, int NumThreads)
+	{
+		bNormals = Options.bNormals;
+		bUVs = Options.bUVs;
+		bColors = Options.bVertexColors;
+		bSplitVertices = bNormals || bUVs || bColors;
+		NumVertices = (size_t)Mesh.GetVertexCount();
+		if (!bSplitVertices)
+			return;
+
+		size_t NumCorners = 3 * (size_t)Mesh.GetTriangleCount();
+		int NumKeys = parallel_index_unique_keys<PLYCornerKey>(NumCorners, NumThreads, [&](size_t Corner)
+		{
+			return GetCornerKey(Mesh, (int)(Corner / 3), (int)(Corner % 3));
+		}, CornerVertices, &VertexCorners);
+
+		std::vector<uint8_t> VertexUsed(NumVertices, 0);
+		for (int tid = 0; tid < Mesh.GetTriangleCount(); ++tid) {
+			Index3i Tri = Mesh.GetTriangle(tid);
+			VertexUsed[Tri.A] = VertexUsed[Tri.B] = VertexUsed[Tri.C] = 1;
+		}
+		for (int vid = 0; vid < (int)VertexUsed.size(); ++vid)
+			if (VertexUsed[vid] == 0)
+				UnusedVertices.push_back(vid);
+		NumVertices = (size_t)NumKeys + UnusedVertices.size();
+	}
+
+	PLYCornerKey GetCornerKey(const DenseMesh& Mesh, int tid, int j) const
+	{
+		PLYCornerKey Key;
+		memset((void*)&Key, 0, sizeof(PLYCornerKey));
+		Key.Vertex = Mesh.GetTriangle(tid)[j];
+		if (bNormals)
+			Key.Normal = Mesh.GetTriVtxNormals(tid)[j];
+		if (bUVs)
+			Key.UV = Mesh.GetTriVtxUVs(tid)[j];
+		if (bColors)
+			Key.Color = Mesh.GetTriVtxColors(tid)[j];
+		return Key;
+	}
+
+	PLYCornerKey GetVertex(const DenseMesh& Mesh, size_t PLYVertex) const
+	{
+		if (bSplitVertices && PLYVertex < VertexCorners.size())
+			return GetCornerKey(Mesh, (int)(VertexCorners[PLYVertex] / 3), (int)(VertexCorners[PLYVertex] % 3));
+
+		PLYCornerKey Key;
+		memset((void*)&Key, 0, sizeof(PLYCornerKey));
+		Key.Vertex = (bSplitVertices) ? UnusedVertices[PLYVertex - VertexCorners.size()] : (int)PLYVertex;
+		Key.Color.R = Key.Color.G = Key.Color.B = Key.Color.A = 255;
+		return Key;
+	}
+
+	Index3i GetTriangle(const DenseMesh& Mesh, int tid) const
+	{
+		if (!bSplitVertices)
+			return Mesh.GetTriangle(tid);
+		size_t Corner = 3 * (size_t)tid;
+		return Index3i(CornerVertices[Corner], CornerVertices[Corner + 1], CornerVertices[Corner + 2]);
+	}
+
+	size_t GetVertexRecordSize() const
+	{
+		return 3 * sizeof(float) + (bNormals ? 3 * sizeof(float) : 0) + (bUVs ? 2 * sizeof(float) : 0) + (bColors ? 4 : 0);
+	}
+};
+
+
+static std::string make_ply_header(const PLYVertexTable& Vertices, int NumTriangles, bool bBinary)
+{
+	std::string Header = "ply\n";
+	Header += (bBinary) ? "format binary_little_endian 1.0\n" : "format ascii 1.0\n";
+	Header += "comment gradientspace_ply\n";
+	Header += "element vertex " + std::to_string(Vertices.NumVertices) + "\n";
+	Header += "property float x\nproperty float y\nproperty float z\n";
+	if (Vertices.bNormals)
+		Header += "property float nx\nproperty float ny\nproperty float nz\n";
+	if (Vertices.bUVs)
+		Header += "property float s\nproperty float t\n";
+	if (Vertices.bColors)
+		Header += "property uchar red\nproperty uchar green\nproperty uchar blue\nproperty uchar alpha\n";
+	Header += "element face " + std::to_string(NumTriangles) + "\n";
+	Header += "property list uchar int vertex_indices\n";
+	Header += "end_header\n";
+	return Header;
+}
+
+// pack the binary records of PLY vertices [Start,End) into Dest. Binary PLY is written in native (little-endian) byte order
+static void pack_ply_vertex_records(const DenseMesh& Mesh, const PLYVertexTable& Vertices, size_t Start, size_t End, char* Dest)
+{
+	for (size_t i = Start; i < End; ++i)
+	{
+		PLYCornerKey Vertex = Vertices.GetVertex(Mesh, i);
+		Vector3f Position = (Vector3f)Mesh.GetPosition(Vertex.Vertex);
+		memcpy(Dest, &Position.X, 3 * sizeof(float));
+		Dest += 3 * sizeof(float);
+		if (Vertices.bNormals) {
+			memcpy(Dest, &Vertex.Normal.X, 3 * sizeof(float));
+			Dest += 3 * sizeof(float);
+		}
+		if (Vertices.bUVs) {
+			memcpy(Dest, &Vertex.UV.X, 2 * sizeof(float));
+			Dest += 2 * sizeof(float);
+		}
+		if (Vertices.bColors) {
+			uint8_t Color[4] = { Vertex.Color.R, Vertex.Color.G, Vertex.Color.B, Vertex.Color.A };
+			memcpy(Dest, Color, 4);
+			Dest += 4;
+		}
+	}
+}
+
+// pack the binary records of triangles [Start,End) into Dest
+static void pack_ply_face_records(const DenseMesh& Mesh, const PLYVertexTable& Vertices, size_t Start, size_t End, char* Dest)
+{
+	for (size_t tid = Start; tid < End; ++tid)
+	{
+		Index3i Tri = Vertices.GetTriangle(Mesh, (int)tid);
+		Dest[0] = 3;
+		memcpy(Dest + 1, &Tri.A, sizeof(int));
+		memcpy(Dest + 5, &Tri.B, sizeof(int));
+		memcpy(Dest + 9, &Tri.C, sizeof(int));
+		Dest += PLYFaceRecordSize;
+	}
+}
+
+/**
+ * Pack Count records of RecordSize bytes in batches of NumThreads blocks, each block packed by one thread
+ * via PackFunc(size_t Start, size_t End, char* Dest), and pass each batch to WriteFunc(const char* Data, size_t NumBytes) in file order.
+ */
+template<typename PackFuncType, typename WriteFuncType>
+static bool write_ply_records_blocked(size_t Count, size_t RecordSize, int NumThreads, PackFuncType PackFunc, WriteFuncType WriteFunc)
+{
+	size_t NumBlocks = (Count + PLYBlockRecords - 1) / PLYBlockRecords;
+	size_t BatchBlocks = std::max((size_t)1, std::min((size_t)NumThreads, NumBlocks));
+
+	std::vector<char> Buffer(BatchBlocks * PLYBlockRecords * RecordSize);
+	bool bWritesOK = true;
+	for (size_t BatchStart = 0; BatchStart < NumBlocks && bWritesOK; BatchStart += BatchBlocks)
+	{
+		int NumBatchBlocks = (int)std::min(BatchBlocks, NumBlocks - BatchStart);
+		size_t BatchStartRecord = BatchStart * PLYBlockRecords;
+		size_t BatchEndRecord = std::min(Count, (BatchStart + NumBatchBlocks) * PLYBlockRecords);
+		parallel_for_blocks(NumBatchBlocks, NumThreads, [&](int k)
+		{
+			size_t StartRecord = BatchStartRecord + (size_t)k * PLYBlockRecords;
+			size_t EndRecord = std::min(BatchEndRecord, StartRecord + PLYBlockRecords);
+			PackFunc(StartRecord, EndRecord, &Buffer[(size_t)k * PLYBlockRecords * RecordSize]);
+		});
+		bWritesOK = WriteFunc(Buffer.data(), (BatchEndRecord - BatchStartRecord) * RecordSize);
+	}
+	return bWritesOK;
+}
+
+// write the header, vertex records and face records of binary PLY via WriteFunc(const char* Data, size_t NumBytes)
+template<typename WriteFuncType>
+static bool write_ply_binary_blocked(const DenseMesh& Mesh, const PLYVertexTable& Vertices, int NumThreads, WriteFuncType WriteFunc)
+{
+	std::string Header = make_ply_header(Vertices, Mesh.GetTriangleCount(), true);
+	bool bWritesOK = WriteFunc(Header.data(), Header.size());
+	bWritesOK = bWritesOK && write_ply_records_blocked(Vertices.NumVertices, Vertices.GetVertexRecordSize(), NumThreads,
+		[&](size_t Start, size_t End, char* Dest) { pack_ply_vertex_records(Mesh, Vertices, Start, End, Dest); }, WriteFunc);
+	bWritesOK = bWritesOK && write_ply_records_blocked((size_t)Mesh.GetTriangleCount(), PLYFaceRecordSize, NumThreads,
+		[&](size_t Start, size_t End, char* Dest) { pack_ply_face_records(Mesh, Vertices, Start, End, Dest); }, WriteFunc);
+	return bWritesOK;
+}
+
+
+bool GS::PLYWriter::WritePLY(
+	const std::string& Filename,
+	const DenseMesh& Mesh,
+	const WriteOptions& Options)
+{
+	if (!Options.bWriteBinary) {
+		auto TextWriter = GS::FileTextWriter::OpenFile(Filename);
+		if (!TextWriter)
+			return false;
+		return GS::PLYWriter::WritePLY(TextWriter, Mesh, Options);
+	}
+
+	int NumThreads = get_num_worker_threads(Options.NumThreads);
+	PLYVertexTable Vertices;
+	Vertices.Build(Mesh, Options, NumThreads);
+
+	// records have fixed size, so the output size is known exactly and the file can be preallocated and optionally written through a mapping
+	std::string Header = make_ply_header(Vertices, Mesh.GetTriangleCount(), true);
+	size_t VertexRecordSize = Vertices.GetVertexRecordSize();
+	size_t VerticesSize = Vertices.NumVertices * VertexRecordSize;
+	size_t FileSize = Header.size() + VerticesSize + (size_t)Mesh.GetTriangleCount() * PLYFaceRecordSize;
+	MappedFileWriter Writer;
+	if (!Writer.Open(Filename, FileSize, Options.bUseMemoryMappedIO))
+		return false;
+	if (Writer.IsMapped()) {
+		char* Dest = Writer.Data();
+		memcpy(Dest, Header.data(), Header.size());
+		char* VertexDest = Dest + Header.size();
+		parallel_for_ranges(Vertices.NumVertices, NumThreads, NumThreads, [&](int, size_t Start, size_t End)
+		{
+			pack_ply_vertex_records(Mesh, Vertices, Start, End, VertexDest + Start * VertexRecordSize);
+		});
+		char* FaceDest = VertexDest + VerticesSize;
+		parallel_for_ranges((size_t)Mesh.GetTriangleCount(), NumThreads, NumThreads, [&](int, size_t Start, size_t End)
+		{
+			pack_ply_face_records(Mesh, Vertices, Start, End, FaceDest + Start * PLYFaceRecordSize);
+		});
+		return Writer.Close();
+	}
+	bool bWritesOK = write_ply_binary_blocked(Mesh, Vertices, NumThreads, [&](const char* Data, size_t NumBytes) {
+		return Writer.WriteBytes(Data, NumBytes);
+	});
+	return Writer.Close() && bWritesOK;
+}
+
+
+bool GS::PLYWriter::WritePLY(
+	ITextWriter& TextWriter,
+	const DenseMesh& Mesh,
+	const WriteOptions& Options)
+{
+	int NumThreads = get_num_worker_threads(Options.NumThreads);
+	PLYVertexTable Vertices;
+	Vertices.Build(Mesh, Options, NumThreads);
+
+	std::vector<TextFormatBuffer> ChunkBuffers(NumThreads, TextFormatBuffer(Options.RealFormat));
+	ChunkBuffers[0].AppendString(make_ply_header(Vertices, Mesh.GetTriangleCount(), false).c_str());
+	bool bWritesOK = ChunkBuffers[0].Flush(TextWriter);
+
+	bWritesOK = write_text_chunks(TextWriter, ChunkBuffers, Vertices.NumVertices, [&](TextFormatBuffer& Output, size_t Start, size_t End)
+	{
+		for (size_t i = Start; i < End; ++i)
+		{
+			PLYCornerKey Vertex = Vertices.GetVertex(Mesh, i);
+			Vector3f Position = (Vector3f)Mesh.GetPosition(Vertex.Vertex);
+			// AppendReals() starts each value with a space
+			Output.AppendReal(Position.X);
+			Output.AppendReals(&Position.Y, 2);
+			if (Vertices.bNormals)
+				Output.AppendReals(&Vertex.Normal.X, 3);
+			if (Vertices.bUVs)
+				Output.AppendReals(&Vertex.UV.X, 2);
+			if (Vertices.bColors) {
+				int Color[4] = { Vertex.Color.R, Vertex.Color.G, Vertex.Color.B, Vertex.Color.A };
+				for (int k = 0; k < 4; ++k) {
+					Output.AppendChar(' ');
+					Output.AppendInt(Color[k]);
+				}
+			}
+			Output.AppendEndOfLine();
+		}
+	}) && bWritesOK;
+
+	bWritesOK = write_text_chunks(TextWriter, ChunkBuffers, (size_t)Mesh.GetTriangleCount(), [&](TextFormatBuffer& Output, size_t Start, size_t End)
+	{
+		for (size_t tid = Start; tid < End; ++tid)
+		{
+			Index3i Tri = Vertices.GetTriangle(Mesh, (int)tid);
+			Output.AppendChar('3');
+			for (int j = 0; j < 3; ++j) {
+				Output.AppendChar(' ');
+				Output.AppendInt(Tri[j]);
+			}
+			Output.AppendEndOfLine();
+		}
+	}) && bWritesOK;
+
+	return bWritesOK;
+}
+
+
+bool GS::PLYWriter::WritePLY(
+	IBinaryWriter& BinaryWriter,
+	const DenseMesh& Mesh,
+	const WriteOptions& Options)
+{
+	int NumThreads = get_num_worker_threads(Options.NumThreads);
+	PLYVertexTable Vertices;
+	Vertices.Build(Mesh, Options, NumThreads);
+	return write_ply_binary_blocked(Mesh, Vertices, NumThreads, [&](const char* Data, size_t NumBytes) {
+		return BinaryWriter.WriteBytes(Data, NumBytes);
+	});
+}
@@ -0,0 +1,268 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#include "MeshIO/ParseResultCache.h"
+#include "MeshIO/parse_result_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+#include <stdio.h>
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable:4996) // disable secure-crt warnings for this file
+#endif
+
+using namespace GS;
+using namespace GS::ParseResultCache;
+
+namespace fs = std::filesystem;
+
+
+static std::atomic<uint64_t> CacheHits(0);
+static std::atomic<uint64_t> CacheMisses(0);
+static std::atomic<uint64_t> CacheStores(0);
+static std::atomic<uint64_t> CacheEvictions(0);
+
+static const char* CacheEntryExtension = ".gsmc";
+
+
+CacheStatistics GS::ParseResultCache::GetStatistics()
+{
+	CacheStatistics Stats;
+	Stats.Hits = CacheHits.load();
+	Stats.Misses = CacheMisses.load();
+	Stats.Stores = CacheStores.load();
+	Stats.Evictions = CacheEvictions.load();
+	return Stats;
+}
+
+void GS::ParseResultCache::ResetStatistics()
+{
+	CacheHits = 0;
+	CacheMisses = 0;
+	CacheStores = 0;
+	CacheEvictions = 0;
+}
+
+void GS::ParseResultCache::record_cache_event(ECacheEvent Event)
+{
+	switch (Event) {
+		case ECacheEvent::Hit: CacheHits++; break;
+		case ECacheEvent::Miss: CacheMisses++; break;
+		case ECacheEvent::Store: CacheStores++; break;
+		case ECacheEvent::Eviction: CacheEvictions++; break;
+	}
+}
+
+
+// FNV-1a, continuing from Hash
+static uint64_t hash_bytes(const void* Data, size_t NumBytes, uint64_t Hash)
+{
+	const uint8_t* Bytes = (const uint8_t*)Data;
+	for (size_t k = 0; k < NumBytes; ++k)
+		Hash = (Hash ^ Bytes[k]) * 0x100000001B3ull;
+	return Hash;
+}
+
+static bool seek_file(FILE* File, uint64_t Offset)
+{
+#if defined(_WIN32)
+	return _fseeki64(File, (__int64)Offset, SEEK_SET) == 0;
+#else
+	return fseeko(File, (off_t)Offset, SEEK_SET) == 0;
+#endif
+}
+
+// multiply-rotate hash of 8-byte words (and FNV-1a of any tail bytes), continuing from Hash. Much faster than hash_bytes() for large inputs
+static uint64_t hash_words(const char* Data, size_t NumBytes, uint64_t Hash)
+{
+	const uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+	const uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+	size_t Offset = 0;
+	for (; Offset + 8 <= NumBytes; Offset += 8)
+	{
+		uint64_t Word;
+		memcpy(&Word, Data + Offset, 8);
+		uint64_t Mixed = Hash ^ (Word * Prime2);
+		Hash = ((Mixed << 31) | (Mixed >> 33)) * Prime1;
+	}
+	return hash_bytes(Data + Offset, NumBytes - Offset, Hash);
+}
+
+/**
+ * Hash of the full contents of the file, read in large blocks. Blocks are a multiple of 8 bytes,
+ * so only the final block can have tail bytes.
+ */
+static bool compute_full_content_hash(const std::string& Path, uint64_t FileSize, uint64_t& HashOut)
+{
+	FILE* File = fopen(Path.c_str(), "rb");
+	if (File == nullptr)
+		return false;
+
+	const size_t BlockSize = 1 << 20;
+	std::vector<char> Buffer(BlockSize);
+	uint64_t Hash = 0xCBF29CE484222325ull;
+	uint64_t TotalBytes = 0;
+	size_t NumBytes = 0;
+	while ((NumBytes = fread(Buffer.data(), 1, BlockSize, File)) > 0)
+	{
+		Hash = hash_words(Buffer.data(), NumBytes, Hash);
+		TotalBytes += NumBytes;
+	}
+	bool bReadOK = (ferror(File) == 0) && (TotalBytes == FileSize);
+	fclose(File);
+	HashOut = Hash;
+	return bReadOK;
+}
+
+/**
+ * Hash of the first and last 64K of the file, and of 14 evenly-spaced 64K blocks in between.
+ * Hashing all of a multi-GB file costs as much I/O as a cold-cache parse, so this can be used instead
+ * (along with the size and modification time) to detect modified files, at the cost of missing
+ * in-place edits outside the sampled blocks.
+ */
+static bool compute_sampled_content_hash(const std::string& Path, uint64_t FileSize, uint64_t& HashOut)
+{
+	FILE* File = fopen(Path.c_str(), "rb");
+	if (File == nullptr)
+		return false;
+
+	const uint64_t BlockSize = 1 << 16;
+	const int NumBlocks = 16;
+	std::vector<char> Buffer(BlockSize);
+	uint64_t Hash = 0xCBF29CE484222325ull;
+	bool bReadOK = true;
+	for (int k = 0; k < NumBlocks && bReadOK; ++k)
+	{
+		uint64_t Offset = (FileSize > BlockSize) ? ((FileSize - BlockSize) * k / (NumBlocks - 1)) : 0;
+		size_t NumBytes = (size_t)std::min(BlockSize, FileSize);
+		bReadOK = seek_file(File, Offset) && (fread(Buffer.data(), 1, NumBytes, File) == NumBytes);
+		Hash = hash_bytes(Buffer.data(), NumBytes, Hash);
+		if (FileSize <= BlockSize)
+			break;
+	}
+	fclose(File);
+	HashOut = Hash;
+	return bReadOK;
+}
+
+bool GS::ParseResultCache::GetCacheEntryPath(const std::string& CacheDirectory, const std::string& SourcePath, const std::string& OptionsKey, std::string& EntryPathOut,
+	bool bSampledContentHash)
+{
+	std::error_code ErrorCode;
+	fs::path Source(SourcePath);
+	uintmax_t FileSize = fs::file_size(Source, ErrorCode);
+	if (ErrorCode)
+		return false;
+	fs::file_time_type ModifiedTime = fs::last_write_time(Source, ErrorCode);
+	if (ErrorCode)
+		return false;
+	fs::path CanonicalSource = fs::weakly_canonical(Source, ErrorCode);
+	if (ErrorCode)
+		CanonicalSource = Source;
+
+	uint64_t ContentHash = 0;
+	bool bHashOK = (bSampledContentHash) ?
+		compute_sampled_content_hash(SourcePath, (uint64_t)FileSize, ContentHash) : compute_full_content_hash(SourcePath, (uint64_t)FileSize, ContentHash);
+	if (!bHashOK)
+		return false;
+
+	fs::create_directories(CacheDirectory, ErrorCode);
+	if (!fs::is_directory(CacheDirectory, ErrorCode))
+		return false;
+
+	std::string Key = CanonicalSource.string();
+	uint64_t KeyValues[5] = { (uint64_t)FileSize, (uint64_t)ModifiedTime.time_since_epoch().count(), ContentHash, BinaryMeshCache::FormatVersion, (bSampledContentHash) ? 1ull : 0ull };
+	Key.append((const char*)KeyValues, sizeof(KeyValues));
+	Key.append(OptionsKey);
+
+	// two 64-bit hashes with different offset bases, so that accidental collisions are negligible
+	uint64_t HashA = hash_bytes(Key.data(), Key.size(), 0xCBF29CE484222325ull);
+	uint64_t HashB = hash_bytes(Key.data(), Key.size(), 0x84222325CBF29CE4ull ^ HashA);
+	char EntryName[64];
+	snprintf(EntryName, sizeof(EntryName), "%016llx%016llx%s", (unsigned long long)HashA, (unsigned long long)HashB, CacheEntryExtension);
+
+	EntryPathOut = (fs::path(CacheDirectory) / EntryName).string();
+	return true;
+}
+
+
+void GS::ParseResultCache::touch_cache_entry(const std::string& EntryPath)
+{
+	std::error_code ErrorCode;
+	fs::last_write_time(EntryPath, fs::file_time_type::clock::now(), ErrorCode);
+}
+
+std::string GS::ParseResultCache::make_temp_entry_path(const std::string& EntryPath)
+{
+	static std::atomic<uint64_t> TempCounter(0);
+	static const uint64_t ProcessTag = []() { std::random_device Random; return ((uint64_t)Random() << 32) | Random(); }();
+	char Suffix[64];
+	snprintf(Suffix, sizeof(Suffix), ".%016llx.%llu.tmp", (unsigned long long)ProcessTag, (unsigned long long)TempCounter++);
+	return EntryPath + Suffix;
+}
+
+bool GS::ParseResultCache::commit_temp_entry(const std::string& TempPath, const std::string& EntryPath, bool bWriteOK)
+{
+	std::error_code ErrorCode;
+	if (bWriteOK)
+	{
+		// rename replaces any existing entry atomically, so concurrent readers see either the old or the new file
+		fs::rename(TempPath, EntryPath, ErrorCode);
+		if (!ErrorCode)
+			return true;
+	}
+	fs::remove(TempPath, ErrorCode);
+	return false;
+}
+
+
+void GS::ParseResultCache::TrimCacheDirectory(const std::string& CacheDirectory, uint64_t MaxSizeBytes)
+{
+	struct CacheEntry
+	{
+		fs::path Path;
+		uint64_t Size;
+		fs::file_time_type LastUsedTime;
+	};
+	std::vector<CacheEntry> Entries;
+	uint64_t TotalSize = 0;
+
+	std::error_code ErrorCode;
+	for (fs::directory_iterator It(CacheDirectory, ErrorCode), End; !ErrorCode && It != End; It.increment(ErrorCode))
+	{
+		const fs::path& Path = It->path();
+		if (Path.extension() != CacheEntryExtension)
+			continue;		// temporary files of in-progress writes are not touched
+		std::error_code EntryError;
+		uint64_t Size = (uint64_t)It->file_size(EntryError);
+		fs::file_time_type Time = It->last_write_time(EntryError);
+		if (EntryError)
+			continue;
+		Entries.push_back({ Path, Size, Time });
+		TotalSize += Size;
+	}
+	if (TotalSize <= MaxSizeBytes)
+		return;
+
+	std::sort(Entries.begin(), Entries.end(), [](const CacheEntry& A, const CacheEntry& B) { return A.LastUsedTime < B.LastUsedTime; });
+	for (const CacheEntry& Entry : Entries)
+	{
+		if (TotalSize <= MaxSizeBytes)
+			break;
+		// removal can fail if another process already evicted the entry (or has it open, on Windows)
+		std::error_code RemoveError;
+		if (fs::remove(Entry.Path, RemoveError))
+			record_cache_event(ECacheEvent::Eviction);
+		TotalSize -= Entry.Size;
+	}
+}
+
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
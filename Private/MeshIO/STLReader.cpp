@@ -2,14 +2,22 @@
 #include "MeshIO/STLReader.h"
 
 #include <vector>
+#include <algorithm>
+#include <cstddef>
 #include <cstdlib>
-#include <charconv>
+#include <cstring>
+#include <cmath>
+#include <type_traits>
 
 #include <filesystem>
 
-#include "Core/TextIO.h"
 #include "Core/BinaryIO.h"
+#include "MeshIO/BlockReadAheadReader.h"
+#include "MeshIO/MappedFileBuffer.h"
+#include "MeshIO/parallel_utils.h"
+#include "MeshIO/parse_result_cache.h"
 #include "MeshIO/parse_utils.h"
+#include "MeshIO/float_parsing.h"
 
 #if defined(_MSC_VER)
 #pragma warning(push)
@@ -19,40 +27,6 @@
 using namespace GS;
 using namespace GS::STLReader;
 
-static constexpr int MaxLineBufferSize = 4096;
-static constexpr int MaxTokenSize = 64;
-
-
-static bool get_next_token(const char* LineString, int& index, char* tokenOut, int& tokenLen) 
-{
-	tokenLen = 0;
-
-	// find start of token
-	while (is_line_space(LineString[index]) && index < MaxLineBufferSize) 
-		index++;
-	if (is_end_of_line(LineString[index]))
-		return false;
-
-	// extract token until more whitespace or EOL
-	while ( !is_line_space(LineString[index]) 
-		&& !is_end_of_line(LineString[index])
-		&& (tokenLen < (MaxTokenSize-1)) )
-	{
-		tokenOut[tokenLen++] = LineString[index];
-		index++;
-	}
-	tokenOut[tokenLen] = null_char;
-
-	return true;
-}
-
-
-static bool is_same(const std::vector<char>& token, const char* expected)
-{
-	// should we to-upper??
-	return strncmp(token.data(), expected, MaxTokenSize) == 0;
-}
-
 enum class ETokenSequence
 {
 	SOLID = 0,
@@ -70,33 +44,6 @@ enum class ETokenSequence
 	ENDFACET = 21,
 	ENDSOLID = 22
 };
-bool is_float_token(ETokenSequence token)
-{
-	return (token >= ETokenSequence::NORMAL_X && token <= ETokenSequence::NORMAL_Z)
-		|| (token >= ETokenSequence::VERTEX1_X && token <= ETokenSequence::VERTEX1_Z)
-		|| (token >= ETokenSequence::VERTEX2_X && token <= ETokenSequence::VERTEX2_Z)
-		|| (token >= ETokenSequence::VERTEX3_X && token <= ETokenSequence::VERTEX3_Z);
-}
-void set_float(STLTriangle& triangle, ETokenSequence token, float value)
-{
-	switch (token) {
-	case ETokenSequence::NORMAL_X: triangle.Normal.X = value; break;
-	case ETokenSequence::NORMAL_Y: triangle.Normal.Y = value; break;
-	case ETokenSequence::NORMAL_Z: triangle.Normal.Z = value; break;
-	case ETokenSequence::VERTEX1_X: triangle.Vertex1.X = value; break;
-	case ETokenSequence::VERTEX1_Y: triangle.Vertex1.Y = value; break;
-	case ETokenSequence::VERTEX1_Z: triangle.Vertex1.Z = value; break;
-	case ETokenSequence::VERTEX2_X: triangle.Vertex2.X = value; break;
-	case ETokenSequence::VERTEX2_Y: triangle.Vertex2.Y = value; break;
-	case ETokenSequence::VERTEX2_Z: triangle.Vertex2.Z = value; break;
-	case ETokenSequence::VERTEX3_X: triangle.Vertex3.X = value; break;
-	case ETokenSequence::VERTEX3_Y: triangle.Vertex3.Y = value; break;
-	case ETokenSequence::VERTEX3_Z: triangle.Vertex3.Z = value; break;
-	default:
-		gs_debug_assert(false); // should not be here
-		break;
-	}
-}
 
 static const char* TokenStrings[] = {
 	"solid",
@@ -116,173 +63,398 @@ static const char* TokenStrings[] = {
 	"endsolid"
 };
 
+static const size_t TokenStringLengths[] = {
+	5, 5, 6,
+	0, 0, 0,
+	5, 4, 6,
+	0, 0, 0,
+	6,
+	0, 0, 0,
+	6,
+	0, 0, 0,
+	7, 8, 8
+};
 
+// index of each float token in the 12 floats of a facet (normal, vertex1, vertex2, vertex3), or -1 for keywords
+static const int TokenFloatIndex[] = {
+	-1, -1, -1,
+	0, 1, 2,
+	-1, -1, -1,
+	3, 4, 5,
+	-1,
+	6, 7, 8,
+	-1,
+	9, 10, 11,
+	-1, -1, -1
+};
 
 
-static bool ReadSTL_Ascii(
-	ITextReader& Reader,
-	STLMeshData& STLMeshOut)
+/**
+ * Single-pass parser for ASCII STL text. The text is tokenized in-place, keywords are
+ * checked against the expected ETokenSequence keyword with a length+memcmp compare, and the
+ * 12 floats of each facet are parsed directly into the output triangle.
+ *
+ * ScanLines() can be called repeatedly with consecutive ranges of the file, as long as each
+ * range ends at a line boundary (or the end of the file). Multiple solids in one file are
+ * concatenated.
+ */
+class STLAsciiScanner
 {
-	std::vector<char> LineBuffer;
-	LineBuffer.resize(MaxLineBufferSize);
-	int cur_index = -1;
-	std::vector<char> Token;
-	Token.resize(MaxTokenSize);
+public:
+	STLMeshData& STLMeshOut;
+	size_t FileSize = 0;
 
 	ETokenSequence NextToken = ETokenSequence::SOLID;
-	STLTriangle CurTriangle;
-
-	// read initial line
-	bool bNextLineNeeded = true;
-	bool bDoneFile = false;
+	float FacetFloats[12] = { 0,0,0, 0,0,0, 0,0,0, 0,0,0 };		// normal, vertex1, vertex2, vertex3
 	int Error = 0;
-	while (!Reader.IsEndOfFile() && !bDoneFile)
+	bool bDone = false;
+
+	STLAsciiScanner(STLMeshData& MeshOut, size_t FileSizeIn) : STLMeshOut(MeshOut), FileSize(FileSizeIn)
 	{
-		if (bNextLineNeeded) {
-			if ( Reader.ReadLine(&LineBuffer[0], MaxLineBufferSize - 1) == false) {
-				bDoneFile = false; 
-				continue; 
-			}
-			cur_index = 0;
-			bNextLineNeeded = false;
+	}
+
+	bool IsFinished() const { return bDone || Error != 0; }
+
+	void ScanLines(const char* Start, const char* End)
+	{
+		const char* LineStart = Start;
+		while (LineStart < End && !IsFinished())
+		{
+			const char* LineEnd = find_line_end(LineStart, End);
+			scan_line(LineStart, LineEnd);
+			if (!bHaveReserved && STLMeshOut.Triangles.size() == NumTrianglesForEstimate)
+				reserve_from_estimate(BytesScanned + (size_t)(LineEnd - Start));
+			LineStart = (LineEnd < End) ? LineEnd + 1 : End;
 		}
+		BytesScanned += (size_t)(End - Start);
+	}
+
+protected:
+	static constexpr size_t NumTrianglesForEstimate = 1024;
+	size_t BytesScanned = 0;
+	bool bHaveReserved = false;
 
-		int tokenLen = 0;
-		if (NextToken == ETokenSequence::SOLID) {
-			if (get_next_token(LineBuffer.data(), cur_index, Token.data(), tokenLen) == false) { 
-				Error = 1; break; 
+	// a '\r' or null character also ends a line (as in the original fgets()-based parser)
+	static bool is_line_terminator(char c) {
+		return c == '\r' || c == null_char;
+	}
+
+	// returns pointer to start of next token in line, or LineEnd
+	static const char* skip_to_token(const char* Cur, const char* LineEnd)
+	{
+		while (Cur < LineEnd && is_line_space(*Cur))
+			Cur++;
+		return (Cur < LineEnd && is_line_terminator(*Cur)) ? LineEnd : Cur;
+	}
+	static const char* find_stl_token_end(const char* Cur, const char* LineEnd)
+	{
+		while (Cur < LineEnd && !is_line_space(*Cur) && !is_line_terminator(*Cur))
+			Cur++;
+		return Cur;
+	}
+	static bool is_keyword(const char* Token, const char* TokenEnd, ETokenSequence Keyword)
+	{
+		size_t Length = TokenStringLengths[(int)Keyword];
+		return (size_t)(TokenEnd - Token) == Length && memcmp(Token, TokenStrings[(int)Keyword], Length) == 0;
+	}
+
+	void scan_line(const char* Cur, const char* LineEnd)
+	{
+		Cur = skip_to_token(Cur, LineEnd);
+
+		if (NextToken == ETokenSequence::SOLID || NextToken == ETokenSequence::ENDSOLID)
+		{
+			// after an endsolid, blank lines are skipped and another solid may follow
+			bool bAfterSolid = (NextToken == ETokenSequence::ENDSOLID);
+			if (Cur == LineEnd) {
+				if (!bAfterSolid)
+					Error = 1;
+				return;
 			}
-			if (is_same(Token, TokenStrings[(int)NextToken]) == false) {
-				Error = 2; break; 
+			if (!is_keyword(Cur, find_stl_token_end(Cur, LineEnd), ETokenSequence::SOLID)) {
+				if (bAfterSolid)
+					bDone = true;
+				else
+					Error = 2;
+				return;
 			}
+			// skip rest of line (solid name)
 			NextToken = ETokenSequence::FACET;
-			// skip rest of line
-			bNextLineNeeded = true;
-			continue;
+			return;
 		}
 
-		// extract next token string
-		if (get_next_token(LineBuffer.data(), cur_index, Token.data(), tokenLen) == false)
-			{ bNextLineNeeded = true; continue; }
-
-		// if next token is a float, parse it and set in triangle
-		if (is_float_token(NextToken)) {
-			float f = 0;
-#if defined(__APPLE__) || (defined(__linux__) && !defined(__cpp_lib_to_chars))
-			// Apple Clang may not support std::from_chars for float
-			char* end = nullptr;
-			f = std::strtof(Token.data(), &end);
-			if (end == Token.data()) {
-				Error = 3; break;
+		while (Cur < LineEnd)
+		{
+			const char* TokenEnd = find_stl_token_end(Cur, LineEnd);
+
+			// if next token is a float, parse it and set in triangle
+			int FloatIndex = TokenFloatIndex[(int)NextToken];
+			if (FloatIndex >= 0)
+			{
+				float Value = 0;
+				if (parse_real(Cur, TokenEnd, Value) == Cur) {
+					Error = 3; return;
+				}
+				FacetFloats[FloatIndex] = Value;
+				NextToken = (ETokenSequence)((int)NextToken + 1);
 			}
-#else
-			std::from_chars_result result = std::from_chars(Token.data(), Token.data() + tokenLen, f);
-			if (result.ec != std::errc()) {
-				Error = 3; break;
+			// if next token is FACET but we got ENDSOLID, this solid is done (ignore rest of line)
+			else if (NextToken == ETokenSequence::FACET && is_keyword(Cur, TokenEnd, ETokenSequence::ENDSOLID))
+			{
+				NextToken = ETokenSequence::ENDSOLID;
+				return;
 			}
-#endif
-			set_float(CurTriangle, NextToken, f);
-			NextToken = (ETokenSequence)((int)NextToken + 1);
-			bNextLineNeeded = check_eol(LineBuffer.data(), cur_index);
-			continue;
-		}
+			// otherwise make sure we got the string we are expecting
+			else if (is_keyword(Cur, TokenEnd, NextToken) == false)
+			{
+				Error = 3; return;
+			}
+			// if we finished a triangle, save it
+			else if (NextToken == ETokenSequence::ENDFACET)
+			{
+				STLTriangle Triangle = STLTriangle();
+				memcpy(&Triangle.Normal, FacetFloats, sizeof(FacetFloats));
+				STLMeshOut.Triangles.push_back(Triangle);
+				NextToken = ETokenSequence::FACET;
+			}
+			else
+				NextToken = (ETokenSequence)((int)NextToken + 1);
 
-		// if next token is FACET but we got ENDSOLID, we are done
-		if (NextToken == ETokenSequence::FACET && is_same(Token, TokenStrings[(int)ETokenSequence::ENDSOLID])) {
-			NextToken = ETokenSequence::ENDSOLID;
-			bDoneFile = true;
-			continue;
+			Cur = skip_to_token(TokenEnd, LineEnd);
 		}
+	}
 
-		// otherwise make sure we got the string we are expecting
-		if (is_same(Token, TokenStrings[(int)NextToken]) == false) {
-			Error = 3; break;
-		}
+	// once the first facets have been parsed, reserve the triangle list based on the average bytes per facet so far
+	void reserve_from_estimate(size_t BytesSoFar)
+	{
+		bHaveReserved = true;
+		if (FileSize == 0 || BytesSoFar == 0)
+			return;
+		double BytesPerTriangle = (double)BytesSoFar / (double)STLMeshOut.Triangles.size();
+		size_t EstimatedTriangles = (size_t)(1.05 * (double)FileSize / BytesPerTriangle) + 16;
+		STLMeshOut.Triangles.reserve(EstimatedTriangles);
+	}
+};
 
-		// if we finished a triangle, save it
-		if (NextToken == ETokenSequence::ENDFACET) {
-			STLMeshOut.Triangles.push_back(CurTriangle);
-			CurTriangle = STLTriangle();
-		}
 
-		if (NextToken == ETokenSequence::ENDFACET) {
-			NextToken = ETokenSequence::FACET;
-		} else {
-			NextToken = (ETokenSequence)((int)NextToken + 1);
+// returns start of the first line at or after Cur whose first token is "facet", or End
+static const char* find_next_facet_line(const char* Cur, const char* End)
+{
+	while (Cur < End)
+	{
+		const char* LineStart = skip_line_space(Cur, End);
+		if (End - LineStart >= 5 && memcmp(LineStart, "facet", 5) == 0
+			&& (End - LineStart == 5 || is_line_space(LineStart[5]) || is_end_of_line(LineStart[5])))
+			return Cur;
+		const char* LineEnd = find_line_end(Cur, End);
+		Cur = (LineEnd < End) ? LineEnd + 1 : End;
+	}
+	return End;
+}
+
+/**
+ * Parse ASCII STL in [BufferStart,BufferEnd) by splitting it into chunks that start at "facet" lines,
+ * scanning the chunks in parallel, and concatenating the per-chunk triangles in order.
+ *
+ * Chunks after the first one are scanned starting in the FACET state. This matches the serial
+ * parse as long as each chunk ends in the FACET state (ie after an endfacet, or after an endsolid
+ * followed by another solid). If it does not (unterminated facet, trailing endsolid, etc), or a
+ * chunk hits an error or the end of the data, the following chunks are discarded and that chunk
+ * continues serially to the end of the buffer, so the result is always identical to the serial parse.
+ */
+static bool parse_stl_ascii_buffer_parallel(
+	const char* BufferStart, const char* BufferEnd, int NumThreads, STLMeshData& STLMeshOut)
+{
+	// small files are not worth splitting up
+	constexpr size_t MinParallelChunkSize = 4 << 20;
+	size_t BufferSize = (size_t)(BufferEnd - BufferStart);
+	int NumChunks = (int)std::min((size_t)NumThreads, BufferSize / MinParallelChunkSize);
+	if (NumChunks <= 1)
+	{
+		STLAsciiScanner Scanner(STLMeshOut, BufferSize);
+		Scanner.ScanLines(BufferStart, BufferEnd);
+		return (Scanner.Error == 0);
+	}
+
+	std::vector<const char*> ChunkStarts;
+	ChunkStarts.push_back(BufferStart);
+	for (int k = 1; k < NumChunks; ++k)
+	{
+		const char* Target = BufferStart + (BufferSize * (size_t)k) / (size_t)NumChunks;
+		Target = std::max(Target, ChunkStarts.back());
+		const char* LineEnd = find_line_end(Target, BufferEnd);
+		const char* NextLine = (LineEnd < BufferEnd) ? LineEnd + 1 : BufferEnd;
+		ChunkStarts.push_back( find_next_facet_line(NextLine, BufferEnd) );
+	}
+	ChunkStarts.push_back(BufferEnd);
+
+	std::vector<STLMeshData> ChunkMeshes(NumChunks);
+	std::vector<STLAsciiScanner> Scanners;
+	Scanners.reserve(NumChunks);
+	for (int k = 0; k < NumChunks; ++k)
+	{
+		Scanners.emplace_back(ChunkMeshes[k], (size_t)(ChunkStarts[k+1] - ChunkStarts[k]));
+		if (k > 0)
+			Scanners[k].NextToken = ETokenSequence::FACET;
+	}
+	parallel_for_blocks(NumChunks, NumThreads, [&](int k)
+	{
+		Scanners[k].ScanLines(ChunkStarts[k], ChunkStarts[k+1]);
+	});
+
+	int NumUsedChunks = NumChunks;
+	for (int k = 0; k < NumChunks - 1; ++k)
+	{
+		if (Scanners[k].IsFinished()) {
+			NumUsedChunks = k + 1;
+			break;
+		}
+		if (Scanners[k].NextToken != ETokenSequence::FACET) {
+			Scanners[k].ScanLines(ChunkStarts[k+1], BufferEnd);
+			NumUsedChunks = k + 1;
+			break;
 		}
-		bNextLineNeeded = check_eol(LineBuffer.data(), cur_index);
 	}
 
-	// todo verify that we got ENDSOLID??
+	std::vector<size_t> ChunkOffsets(NumUsedChunks + 1);
+	ChunkOffsets[0] = STLMeshOut.Triangles.size();
+	for (int k = 0; k < NumUsedChunks; ++k)
+		ChunkOffsets[k+1] = ChunkOffsets[k] + ChunkMeshes[k].Triangles.size();
+	STLMeshOut.Triangles.resize(ChunkOffsets[NumUsedChunks]);
+	parallel_for_blocks(NumUsedChunks, NumThreads, [&](int k)
+	{
+		std::copy(ChunkMeshes[k].Triangles.begin(), ChunkMeshes[k].Triangles.end(), STLMeshOut.Triangles.begin() + ChunkOffsets[k]);
+		ChunkMeshes[k].Triangles = std::vector<STLTriangle>();
+	});
 
-	return true;
+	return (Scanners[NumUsedChunks-1].Error == 0);
 }
 
 
+// binary STL is an 80-byte header, uint32 triangle count, and then 50-byte packed triangle records
+static constexpr size_t BinarySTLHeaderSize = 84;
+static constexpr size_t BinarySTLRecordSize = 50;
 
+// STLTriangle is padded to 52 bytes, but the normal and vertices are contiguous floats like in the file records
+static_assert(offsetof(STLTriangle, Vertex3) + sizeof(Vector3f) == 48, "STLTriangle float layout must match binary STL record");
+static_assert(offsetof(STLTriangle, Attribute) == 48, "STLTriangle float layout must match binary STL record");
+
+/**
+ * Parse binary STL from the in-memory (or mapped) file contents. The file size is validated
+ * against the declared triangle count before anything is unpacked. If the file is truncated,
+ * all complete triangle records are returned, but the function returns false.
+ */
 static bool ReadSTL_Binary(
-	IBinaryReader& Reader,
+	const char* Buffer, size_t BufferSize,
 	STLMeshData& STLMeshOut)
 {
-	bool bIncomplete = false;
+	if (BufferSize < BinarySTLHeaderSize)
+		return false;
 
 	STLMeshOut.Header.resize(80);
-	Reader.ReadBytes(STLMeshOut.Header.data(), 80);
+	memcpy(STLMeshOut.Header.data(), Buffer, 80);
 
 	uint32_t numTriangles = 0;
-	Reader.ReadBytes(&numTriangles, 4);
+	memcpy(&numTriangles, Buffer + 80, 4);
 
-	STLMeshOut.Triangles.resize(numTriangles);
-	for (uint32_t tid = 0; tid < numTriangles; ++tid)
+	size_t NumCompleteRecords = (BufferSize - BinarySTLHeaderSize) / BinarySTLRecordSize;
+	bool bIncomplete = (NumCompleteRecords < (size_t)numTriangles);
+	size_t NumTriangles = std::min((size_t)numTriangles, NumCompleteRecords);
+
+	// fixed-size memcpy()s compile to a few (unaligned) vector loads/stores per record
+	STLMeshOut.Triangles.resize(NumTriangles);
+	STLTriangle* Triangles = STLMeshOut.Triangles.data();
+	const char* Record = Buffer + BinarySTLHeaderSize;
+	for (size_t tid = 0; tid < NumTriangles; ++tid, Record += BinarySTLRecordSize)
 	{
-		STLTriangle& tri = STLMeshOut.Triangles[tid];
-		Reader.ReadBytes(&tri.Normal, 4 * 3);
-		Reader.ReadBytes(&tri.Vertex1, 4 * 3);
-		Reader.ReadBytes(&tri.Vertex2, 4 * 3);
-		Reader.ReadBytes(&tri.Vertex3, 4 * 3);
-		Reader.ReadBytes(&tri.Attribute, 2);
-
-		if (Reader.IsEndOfFile()) {
-			if (tid != numTriangles)
-				bIncomplete = true;
-			break;
-		}
+		memcpy(&Triangles[tid].Normal, Record, 48);
+		memcpy(&Triangles[tid].Attribute, Record + 48, 2);
 	}
 
-	// indicate some error if we got bIncomplete?
-
-	return true;
+	return !bIncomplete;
 }
 
 
 bool GS::STLReader::ReadSTL(
 	const std::string& Path,
-	STLMeshData& STLMeshOut)
+	STLMeshData& STLMeshOut,
+	const ReadOptions& Options)
 {
 	std::filesystem::path FilePath(Path);
 	if (!std::filesystem::exists(FilePath))
 		return false;
 
+	if (!Options.CacheDirectory.empty())
+	{
+		// the parse result does not depend on any of the ReadOptions
+		ReadOptions ParseOptions = Options;
+		ParseOptions.CacheDirectory.clear();
+		return ParseResultCache::read_through_cache(Options.CacheDirectory, Options.MaxCacheSizeBytes, Options.bCacheSampledContentHash, Path, "stl", STLMeshOut,
+			[&](STLMeshData& DataOut) { return ReadSTL(Path, DataOut, ParseOptions); });
+	}
+
 	// create temporary binary reader to figure out binary or ascii
 	FileBinaryReader binaryReader = FileBinaryReader::OpenFile(Path);
 	if (!binaryReader)
 		return false;	
 	
-	char header[7];
-	binaryReader.ReadBytes(header, 5);
-	header[5] = null_char;
+	char header[BinarySTLHeaderSize];
+	memset(header, 0, BinarySTLHeaderSize);
+	binaryReader.ReadBytes(header, BinarySTLHeaderSize);
+	binaryReader.CloseFile();
 	bool bIsAscii = (strncmp(header, "solid", 5) == 0);
 
-	if (bIsAscii) {
-		binaryReader.CloseFile();
-		FileTextReader textReader = FileTextReader::OpenFile(Path);
-		if (!textReader)
+	// some exporters write binary STL with a header that starts with "solid", so if the
+	// file size exactly matches the binary triangle count, assume it is binary
+	std::error_code ErrorCode;
+	uintmax_t FileSize = std::filesystem::file_size(FilePath, ErrorCode);
+	if (bIsAscii && !ErrorCode && FileSize >= BinarySTLHeaderSize)
+	{
+		uint32_t numTriangles = 0;
+		memcpy(&numTriangles, header + 80, 4);
+		bIsAscii = (FileSize != BinarySTLHeaderSize + BinarySTLRecordSize * (uintmax_t)numTriangles);
+	}
+
+	if (!bIsAscii) {
+		MappedFileBuffer FileBuffer;
+		if (!FileBuffer.Open(Path, Options.bUseMemoryMappedIO))
+			return false;
+		FileBuffer.AdviseSequential();
+		return ReadSTL_Binary(FileBuffer.Data(), FileBuffer.Size(), STLMeshOut);
+	}
+
+	int NumThreads = get_num_worker_threads(Options.NumThreads);
+	if (NumThreads > 1)
+	{
+		MappedFileBuffer FileBuffer;
+		if (!FileBuffer.Open(Path, Options.bUseMemoryMappedIO))
+			return false;
+		FileBuffer.AdviseSequential();
+		return parse_stl_ascii_buffer_parallel(FileBuffer.Data(), FileBuffer.Data() + FileBuffer.Size(), NumThreads, STLMeshOut);
+	}
+
+	STLAsciiScanner Scanner(STLMeshOut, (ErrorCode) ? 0 : (size_t)FileSize);
+	if (Options.bUseAsyncReadAhead)
+	{
+		BlockReadAheadReader Reader;
+		if (!Reader.Open(Path, Options.ReadAheadBlockSize, Options.ReadAheadQueueDepth))
+			return false;
+		bool bReadOK = Reader.ReadLineRanges([&](const char* Start, const char* End) {
+			Scanner.ScanLines(Start, End);
+			return !Scanner.IsFinished();
+		});
+		if (!bReadOK)
 			return false;
-		return ReadSTL_Ascii(textReader, STLMeshOut);
-	} else {
-		binaryReader.SetPosition(0);			
-		return ReadSTL_Binary(binaryReader, STLMeshOut);
 	}
+	else
+	{
+		MappedFileBuffer FileBuffer;
+		if (!FileBuffer.Open(Path, Options.bUseMemoryMappedIO))
+			return false;
+		FileBuffer.AdviseSequential();
+		Scanner.ScanLines(FileBuffer.Data(), FileBuffer.Data() + FileBuffer.Size());
+	}
+	return (Scanner.Error == 0);
 
 	//// why is this using FILE* api...?
 	//FILE* FilePtr = fopen(Path.c_str(), "r");
@@ -368,8 +540,127 @@ bool GS::STLReader::ReadSTL(
 
 
 
-void GS::STLReader::STLMeshToDenseMesh(const STLMeshData& STLMesh, DenseMesh& MeshOut)
+// corner j of STL triangle
+static const Vector3f& get_corner_position(const STLTriangle& Triangle, int j)
+{
+	return (j == 0) ? Triangle.Vertex1 : ((j == 1) ? Triangle.Vertex2 : Triangle.Vertex3);
+}
+
+// position key of a triangle corner, 32-bit or 64-bit per coordinate
+template<typename GridValueType>
+struct STLWeldKey
+{
+	GridValueType Key[3];
+};
+
+/**
+ * Number the distinct position keys of the corners of Triangles (see parallel_index_unique_keys()).
+ * If GridScale > 0, finite coordinates with round(|Value| * GridScale) below 2^(N-2) (N = bits of GridValueType) are
+ * quantized to signed grid coordinates. Other coordinates are matched by their float bits, in a key range above
+ * the grid coordinates. If GridScale == 0, all coordinates are matched by their float bits, with -0 == +0.
+ */
+template<typename GridValueType>
+static int index_stl_corner_keys(const std::vector<STLTriangle>& Triangles, double GridScale, int NumThreads,
+	std::vector<int>& VertexIDs, std::vector<uint32_t>& FirstCorners)
+{
+	using SignedGridValueType = std::make_signed_t<GridValueType>;
+	constexpr GridValueType HighKeyRange = (GridValueType)1 << (8*sizeof(GridValueType) - 2);
+	const double GridLimit = (double)HighKeyRange;
+	bool bQuantize = (GridScale > 0);
+
+	auto GetCornerKey = [&](size_t Corner)
+	{
+		const Vector3f& Position = get_corner_position(Triangles[Corner/3], (int)(Corner%3));
+		STLWeldKey<GridValueType> Key;
+		for (int k = 0; k < 3; ++k)
+		{
+			float Value = (&Position.X)[k];
+			double GridValue = std::floor((double)Value * GridScale + 0.5);
+			if (bQuantize && std::abs(GridValue) < GridLimit)		// false for inf/NaN
+			{
+				SignedGridValueType IntValue = (SignedGridValueType)GridValue;
+				memcpy(&Key.Key[k], &IntValue, sizeof(GridValueType));
+			}
+			else if (bQuantize)
+			{
+				// past the grid range the float spacing is much larger than the grid spacing, so matching float bits
+				// welds the same positions as rounding would. inf/NaN cannot be quantized and are matched the same way.
+				uint32_t Bits;
+				memcpy(&Bits, &Value, 4);
+				if constexpr (sizeof(GridValueType) == 4)
+					Key.Key[k] = HighKeyRange | ((Bits >> 8) & 0x800000u) | (Bits & 0x7fffffu);	// only inf/NaN, exponent bits are all set
+				else
+					Key.Key[k] = HighKeyRange | (GridValueType)Bits;
+			}
+			else
+			{
+				Value = (Value == 0) ? 0.0f : Value;		// -0 and +0 are the same position
+				Key.Key[k] = 0;
+				memcpy(&Key.Key[k], &Value, 4);
+			}
+		}
+		return Key;
+	};
+	return parallel_index_unique_keys<STLWeldKey<GridValueType>>(3 * Triangles.size(), NumThreads, GetCornerKey, VertexIDs, &FirstCorners);
+}
+
+/**
+ * Weld the corners of the STL triangles that have equal position keys. Each distinct key becomes
+ * one vertex, which is numbered in order of its first corner and has the position of that corner.
+ * parallel_index_unique_keys() is deterministic, so the result does not depend on NumThreads.
+ */
+static void weld_stl_to_dense_mesh(const STLMeshData& STLMesh, DenseMesh& MeshOut, const STLToDenseMeshOptions& Options)
+{
+	int NumThreads = get_num_worker_threads(Options.NumThreads);
+	const std::vector<STLTriangle>& Triangles = STLMesh.Triangles;
+	size_t NumTriangles = Triangles.size();
+	int NumBlocks = std::max(NumThreads, 1) * 4;
+
+	// quantized coordinates use 32-bit keys if all finite coordinates are within 2^30 grid steps of the origin, otherwise 64-bit keys
+	double GridScale = (Options.WeldTolerance > 0) ? (1.0 / Options.WeldTolerance) : 0.0;
+	bool bWideKeys = false;
+	if (GridScale > 0)
+	{
+		float MaxAbsValue = 0;
+		for (const STLTriangle& Triangle : Triangles)
+			for (int j = 0; j < 3; ++j)
+				for (int k = 0; k < 3; ++k) {
+					float Value = (&get_corner_position(Triangle, j).X)[k];
+					if (std::isfinite(Value))
+						MaxAbsValue = std::max(MaxAbsValue, std::abs(Value));
+				}
+		bWideKeys = (std::floor((double)MaxAbsValue * GridScale + 0.5) >= 1073741824.0);
+	}
+
+	std::vector<int> VertexIDs;
+	std::vector<uint32_t> FirstCorners;
+	int NumVertices = (bWideKeys) ?
+		index_stl_corner_keys<uint64_t>(Triangles, GridScale, NumThreads, VertexIDs, FirstCorners) :
+		index_stl_corner_keys<uint32_t>(Triangles, GridScale, NumThreads, VertexIDs, FirstCorners);
+
+	MeshOut.Resize(NumVertices, (int)NumTriangles);
+
+	parallel_for_ranges((size_t)NumVertices, NumBlocks, NumThreads, [&](int, size_t Start, size_t End)
+	{
+		for (size_t vid = Start; vid < End; ++vid)
+			MeshOut.SetPosition((int)vid, (Vector3d)get_corner_position(Triangles[FirstCorners[vid]/3], (int)(FirstCorners[vid]%3)));
+	});
+	parallel_for_ranges(NumTriangles, NumBlocks, NumThreads, [&](int, size_t Start, size_t End)
+	{
+		for (size_t tid = Start; tid < End; ++tid)
+			MeshOut.SetTriangle((int)tid, Index3i(VertexIDs[3*tid], VertexIDs[3*tid+1], VertexIDs[3*tid+2]));
+	});
+}
+
+
+void GS::STLReader::STLMeshToDenseMesh(const STLMeshData& STLMesh, DenseMesh& MeshOut, const STLToDenseMeshOptions& Options)
 {
+	if (Options.bWeldVertices)
+	{
+		weld_stl_to_dense_mesh(STLMesh, MeshOut, Options);
+		return;
+	}
+
 	int NumTriangles = (int)STLMesh.Triangles.size();
 	int NumVertices = NumTriangles * 3;
 
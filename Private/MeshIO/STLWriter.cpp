@@ -1,23 +1,107 @@
 // Copyright Gradientspace Corp. All Rights Reserved.
 #include "MeshIO/STLWriter.h"
+#include "MeshIO/MappedFileWriter.h"
+#include "MeshIO/number_formatting.h"
+#include "MeshIO/parallel_utils.h"
 
+#include <cstring>
 #include <vector>
 
 
 using namespace GS;
+using namespace GS::NumberFormatting;
+
+
+static constexpr size_t BinarySTLHeaderSize = 84;
+static constexpr size_t BinarySTLRecordSize = 50;
+// triangles packed per block, ie ~3MB of output
+static constexpr int BinarySTLBlockTriangles = 1 << 16;
+
+static void pack_stl_binary_header(char* Dest, int TriCount)
+{
+	memset(Dest, 0, 80);
+	snprintf(Dest, 80, "gradientspace_stl");
+	memcpy(Dest + 80, &TriCount, 4);
+}
+
+// pack the 50-byte records of triangles [StartTri,EndTri) into Dest
+static void pack_stl_binary_records(const DenseMesh& Mesh, int StartTri, int EndTri, char* Dest)
+{
+	uint16_t attribute = 0;
+	for (int i = StartTri; i < EndTri; ++i) {
+		Index3i tri = Mesh.GetTriangle(i);
+		Vector3f A = (Vector3f)Mesh.GetPosition(tri.A), B = (Vector3f)Mesh.GetPosition(tri.B), C = (Vector3f)Mesh.GetPosition(tri.C);
+		Vector3f Normal = GS::Normal(A, B, C);
+		memcpy(Dest, &Normal.X, sizeof(float) * 3);
+		memcpy(Dest + 12, &A.X, sizeof(float) * 3);
+		memcpy(Dest + 24, &B.X, sizeof(float) * 3);
+		memcpy(Dest + 36, &C.X, sizeof(float) * 3);
+		memcpy(Dest + 48, &attribute, 2);
+		Dest += BinarySTLRecordSize;
+	}
+}
+
+/**
+ * Pack the binary STL records in batches of NumThreads blocks, each block packed by one thread,
+ * and pass each batch to WriteFunc(const char* Data, size_t NumBytes) in file order.
+ */
+template<typename WriteFuncType>
+static bool write_stl_binary_records_blocked(const DenseMesh& Mesh, int NumThreads, WriteFuncType WriteFunc)
+{
+	int TriCount = Mesh.GetTriangleCount();
+	int NumBlocks = (TriCount + BinarySTLBlockTriangles - 1) / BinarySTLBlockTriangles;
+	int BatchBlocks = std::max(1, std::min(NumThreads, NumBlocks));
+
+	std::vector<char> Buffer((size_t)BatchBlocks * BinarySTLBlockTriangles * BinarySTLRecordSize);
+	bool bWritesOK = true;
+	for (int BatchStart = 0; BatchStart < NumBlocks && bWritesOK; BatchStart += BatchBlocks)
+	{
+		int NumBatchBlocks = std::min(BatchBlocks, NumBlocks - BatchStart);
+		int BatchStartTri = BatchStart * BinarySTLBlockTriangles;
+		int BatchEndTri = std::min(TriCount, (BatchStart + NumBatchBlocks) * BinarySTLBlockTriangles);
+		parallel_for_blocks(NumBatchBlocks, NumThreads, [&](int k)
+		{
+			int StartTri = BatchStartTri + k * BinarySTLBlockTriangles;
+			int EndTri = std::min(BatchEndTri, StartTri + BinarySTLBlockTriangles);
+			pack_stl_binary_records(Mesh, StartTri, EndTri, &Buffer[(size_t)k * BinarySTLBlockTriangles * BinarySTLRecordSize]);
+		});
+		bWritesOK = WriteFunc(Buffer.data(), (size_t)(BatchEndTri - BatchStartTri) * BinarySTLRecordSize);
+	}
+	return bWritesOK;
+}
 
 
 bool GS::STLWriter::WriteSTL(
 	const std::string& Filename,
 	const DenseMesh& Mesh,
 	const std::string& MeshName,
-	bool bWriteBinary)
+	bool bWriteBinary,
+	const BinaryWriteOptions& BinaryOptions)
 {
 	if (bWriteBinary) {
-		auto BinaryWriter = GS::FileBinaryWriter::OpenFile(Filename);
-		if (!BinaryWriter)
+		// output size is known exactly, so the file can be preallocated and optionally written through a mapping
+		int TriCount = Mesh.GetTriangleCount();
+		size_t FileSize = BinarySTLHeaderSize + (size_t)TriCount * BinarySTLRecordSize;
+		MappedFileWriter Writer;
+		if (!Writer.Open(Filename, FileSize, BinaryOptions.bUseMemoryMappedIO))
 			return false;
-		return GS::STLWriter::WriteSTL(BinaryWriter, Mesh);
+		int NumThreads = get_num_worker_threads(BinaryOptions.NumThreads);
+		if (Writer.IsMapped()) {
+			char* Dest = Writer.Data();
+			pack_stl_binary_header(Dest, TriCount);
+			parallel_for_ranges((size_t)TriCount, NumThreads, NumThreads, [&](int, size_t StartTri, size_t EndTri)
+			{
+				pack_stl_binary_records(Mesh, (int)StartTri, (int)EndTri, Dest + BinarySTLHeaderSize + StartTri * BinarySTLRecordSize);
+			});
+			return Writer.Close();
+		}
+		char header[BinarySTLHeaderSize];
+		pack_stl_binary_header(header, TriCount);
+		bool bWritesOK = Writer.WriteBytes(header, BinarySTLHeaderSize);
+		bWritesOK = bWritesOK && write_stl_binary_records_blocked(Mesh, NumThreads, [&](const char* Data, size_t NumBytes) {
+			return Writer.WriteBytes(Data, NumBytes);
+		});
+		return Writer.Close() && bWritesOK;
 	}
 	else {
 		auto TextWriter = GS::FileTextWriter::OpenFile(Filename);
@@ -31,63 +115,59 @@ bool GS::STLWriter::WriteSTL(
 bool GS::STLWriter::WriteSTL(
 	ITextWriter& TextWriter,
 	const DenseMesh& Mesh,
-	const std::string& MeshName )
+	const std::string& MeshName,
+	const RealFormatOptions& RealFormat)
 {
-	char line_buffer[1024];
+	TextFormatBuffer Output(RealFormat);
+	bool bWritesOK = true;
 	int TriCount = Mesh.GetTriangleCount();
 
-	TextWriter.WriteToken("solid ");
-	TextWriter.WriteToken(MeshName.c_str());
-	TextWriter.WriteEndOfLine();
+	Output.AppendString("solid ");
+	Output.AppendString(MeshName.c_str());
+	Output.AppendEndOfLine();
 
+	// values are written as float, as in binary STL
 	for (int i = 0; i < TriCount; ++i) {
 		Index3i tri = Mesh.GetTriangle(i);
 		Vector3d A = Mesh.GetPosition(tri.A), B = Mesh.GetPosition(tri.B), C = Mesh.GetPosition(tri.C);
-		Vector3d Normal = GS::Normal(A, B, C);
-		snprintf(line_buffer, 1023, "facet normal %f %f %f", (float)Normal.X, (float)Normal.Y, (float)Normal.Z);
-		TextWriter.WriteLine(line_buffer);
-		TextWriter.WriteLine(" outer loop");
-		snprintf(line_buffer, 1023, "  vertex %f %f %f", (float)A.X, (float)A.Y, (float)A.Z);
-		TextWriter.WriteLine(line_buffer);
-		snprintf(line_buffer, 1023, "  vertex %f %f %f", (float)B.X, (float)B.Y, (float)B.Z);
-		TextWriter.WriteLine(line_buffer);
-		snprintf(line_buffer, 1023, "  vertex %f %f %f", (float)C.X, (float)C.Y, (float)C.Z);
-		TextWriter.WriteLine(line_buffer);
-		TextWriter.WriteLine(" endloop");
-		TextWriter.WriteLine("endfacet");
+		Vector3f Normal = (Vector3f)GS::Normal(A, B, C);
+		Vector3f Vertices[3] = { (Vector3f)A, (Vector3f)B, (Vector3f)C };
+		Output.AppendString("facet normal");
+		Output.AppendReals(&Normal.X, 3);
+		Output.AppendEndOfLine();
+		Output.AppendString(" outer loop\n");
+		for (int j = 0; j < 3; ++j) {
+			Output.AppendString("  vertex");
+			Output.AppendReals(&Vertices[j].X, 3);
+			Output.AppendEndOfLine();
+		}
+		Output.AppendString(" endloop\nendfacet\n");
+		bWritesOK = Output.FlushIfFull(TextWriter) && bWritesOK;
 	}
 
-	TextWriter.WriteToken("endsolid ");
-	TextWriter.WriteToken(MeshName.c_str());
-	TextWriter.WriteEndOfLine();
+	Output.AppendString("endsolid ");
+	Output.AppendString(MeshName.c_str());
+	Output.AppendEndOfLine();
 
-	return true;
+	return Output.Flush(TextWriter) && bWritesOK;
 }
 
 
 bool GS::STLWriter::WriteSTL(
 	IBinaryWriter& BinaryWriter,
-	const DenseMesh& Mesh)
+	const DenseMesh& Mesh,
+	const BinaryWriteOptions& BinaryOptions)
 {
 	int TriCount = Mesh.GetTriangleCount();
 
-	char header[80];
-	memset(header, 0, 80);
-	snprintf(header, 80, "gradientspace_stl");
-	bool bWritesOK = BinaryWriter.WriteBytes(header, 80);
-	bWritesOK &= BinaryWriter.WriteBytes(&TriCount, 4);
+	char header[BinarySTLHeaderSize];
+	pack_stl_binary_header(header, TriCount);
+	bool bWritesOK = BinaryWriter.WriteBytes(header, BinarySTLHeaderSize);
 
-	uint16_t attribute = 0;
-	for (int i = 0; i < TriCount; ++i) {
-		Index3i tri = Mesh.GetTriangle(i);
-		Vector3f A = (Vector3f)Mesh.GetPosition(tri.A), B = (Vector3f)Mesh.GetPosition(tri.B), C = (Vector3f)Mesh.GetPosition(tri.C);
-		Vector3f Normal = GS::Normal(A, B, C);
-		bWritesOK &= BinaryWriter.WriteBytes(&Normal.X, sizeof(float) * 3);
-		bWritesOK &= BinaryWriter.WriteBytes(&A.X, sizeof(float) * 3);
-		bWritesOK &= BinaryWriter.WriteBytes(&B.X, sizeof(float) * 3);
-		bWritesOK &= BinaryWriter.WriteBytes(&C.X, sizeof(float) * 3);
-		bWritesOK &= BinaryWriter.WriteBytes(&attribute, 2);
-	}
+	int NumThreads = get_num_worker_threads(BinaryOptions.NumThreads);
+	bWritesOK = bWritesOK && write_stl_binary_records_blocked(Mesh, NumThreads, [&](const char* Data, size_t NumBytes) {
+		return BinaryWriter.WriteBytes(Data, NumBytes);
+	});
 
 	return bWritesOK;
 }
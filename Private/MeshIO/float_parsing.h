@@ -0,0 +1,354 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+//
+// Locale-independent, correctly-rounded decimal-to-binary floating point parsing.
+//
+// Numbers are parsed into a 64-bit decimal mantissa w and base-10 exponent q, and then
+// converted with (1) Clinger's exact fast path if w and 10^q are both exactly representable,
+// or (2) the Eisel-Lemire algorithm, which computes the correctly-rounded result from a
+// 128-bit truncated approximation of w*5^q in the vast majority of cases. Inputs that neither
+// path can handle (>19 significant digits, inf/nan/hex, or the rare ambiguous Eisel-Lemire
+// case) fall back to parse_real_fallback(), which uses std::from_chars where available.
+//
+// All functions operate on [Cur,End) ranges and never read at or past End.
+//
+
+namespace GS::FloatParsing
+{
+	// 128-bit truncated powers of five, 5^-342 to 5^308 (high, low) pairs, see float_parsing.cpp
+	extern const uint64_t PowerOfFive128[];
+	static constexpr int SmallestPowerOfFive = -342;
+	static constexpr int LargestPowerOfFive = 308;
+
+	template<typename RealType> struct real_traits;
+	template<> struct real_traits<double>
+	{
+		using bits_type = uint64_t;
+		static constexpr int mantissa_explicit_bits = 52;
+		static constexpr int minimum_exponent = -1023;
+		static constexpr int infinite_power = 0x7FF;
+		static constexpr int sign_index = 63;
+		static constexpr int min_exponent_round_to_even = -4;
+		static constexpr int max_exponent_round_to_even = 23;
+		static constexpr int smallest_power_of_ten = -342;
+		static constexpr int largest_power_of_ten = 308;
+		static constexpr int max_exponent_fast_path = 22;
+		static constexpr uint64_t max_mantissa_fast_path = uint64_t(2) << 52;
+		static double exact_power_of_ten(int64_t Power)
+		{
+			static constexpr double Powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+				1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+			return Powers[Power];
+		}
+	};
+	template<> struct real_traits<float>
+	{
+		using bits_type = uint32_t;
+		static constexpr int mantissa_explicit_bits = 23;
+		static constexpr int minimum_exponent = -127;
+		static constexpr int infinite_power = 0xFF;
+		static constexpr int sign_index = 31;
+		static constexpr int min_exponent_round_to_even = -17;
+		static constexpr int max_exponent_round_to_even = 10;
+		static constexpr int smallest_power_of_ten = -65;
+		static constexpr int largest_power_of_ten = 38;
+		static constexpr int max_exponent_fast_path = 10;
+		static constexpr uint64_t max_mantissa_fast_path = uint64_t(2) << 23;
+		static float exact_power_of_ten(int64_t Power)
+		{
+			static constexpr float Powers[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+			return Powers[Power];
+		}
+	};
+
+	struct value128
+	{
+		uint64_t low;
+		uint64_t high;
+	};
+
+	inline value128 full_multiplication(uint64_t a, uint64_t b)
+	{
+		value128 answer;
+#if defined(__SIZEOF_INT128__)
+		__uint128_t r = ((__uint128_t)a) * b;
+		answer.low = uint64_t(r);
+		answer.high = uint64_t(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+		answer.low = _umul128(a, b, &answer.high);
+#else
+		uint64_t a_lo = (uint32_t)a, a_hi = a >> 32, b_lo = (uint32_t)b, b_hi = b >> 32;
+		uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+		uint64_t cross = (lo_lo >> 32) + (uint32_t)hi_lo + lo_hi;
+		answer.high = hi_hi + (hi_lo >> 32) + (cross >> 32);
+		answer.low = (cross << 32) | (uint32_t)lo_lo;
+#endif
+		return answer;
+	}
+
+	inline int leading_zeroes(uint64_t Value)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		return __builtin_clzll(Value);
+#elif defined(_MSC_VER) && defined(_M_X64)
+		unsigned long Index = 0;
+		_BitScanReverse64(&Index, Value);
+		return 63 - (int)Index;
+#else
+		int Count = 0;
+		if ((Value & 0xFFFFFFFF00000000ull) == 0) { Count += 32; Value <<= 32; }
+		if ((Value & 0xFFFF000000000000ull) == 0) { Count += 16; Value <<= 16; }
+		if ((Value & 0xFF00000000000000ull) == 0) { Count += 8; Value <<= 8; }
+		if ((Value & 0xF000000000000000ull) == 0) { Count += 4; Value <<= 4; }
+		if ((Value & 0xC000000000000000ull) == 0) { Count += 2; Value <<= 2; }
+		if ((Value & 0x8000000000000000ull) == 0) { Count += 1; }
+		return Count;
+#endif
+	}
+
+	/**
+	 * Eisel-Lemire conversion of w * 10^q (w != 0) to a binary float. Returns false if the
+	 * result cannot be determined unambiguously from the 128-bit approximation.
+	 */
+	template<typename RealType>
+	bool eisel_lemire(int64_t q, uint64_t w, bool bNegative, RealType& ValueOut)
+	{
+		using traits = real_traits<RealType>;
+		using bits_type = typename traits::bits_type;
+
+		uint64_t mantissa = 0;
+		int32_t power2 = 0;
+		if (q < traits::smallest_power_of_ten)
+		{
+			mantissa = 0; power2 = 0;
+		}
+		else if (q > traits::largest_power_of_ten)
+		{
+			mantissa = 0; power2 = traits::infinite_power;
+		}
+		else
+		{
+			int lz = leading_zeroes(w);
+			w <<= lz;
+
+			// compute w * 5^q, using second half of the 128-bit power if the truncated bits matter
+			constexpr int bit_precision = traits::mantissa_explicit_bits + 3;
+			constexpr uint64_t precision_mask = 0xFFFFFFFFFFFFFFFFull >> bit_precision;
+			int index = 2 * int(q - SmallestPowerOfFive);
+			value128 product = full_multiplication(w, PowerOfFive128[index]);
+			if ((product.high & precision_mask) == precision_mask)
+			{
+				value128 second = full_multiplication(w, PowerOfFive128[index + 1]);
+				product.low += second.high;
+				if (second.high > product.low)
+					product.high++;
+			}
+			if (product.low == 0xFFFFFFFFFFFFFFFFull && (q < -27 || q > 55))
+				return false;		// ambiguous, need exact fallback
+
+			int upperbit = int(product.high >> 63);
+			int shift = upperbit + 64 - traits::mantissa_explicit_bits - 3;
+			mantissa = product.high >> shift;
+			int32_t power_of_ten_to_two = (((152170 + 65536) * int32_t(q)) >> 16) + 63;
+			power2 = power_of_ten_to_two + upperbit - lz - traits::minimum_exponent;
+
+			if (power2 <= 0)
+			{
+				// subnormal result
+				if (-power2 + 1 >= 64)
+				{
+					mantissa = 0; power2 = 0;
+				}
+				else
+				{
+					mantissa >>= -power2 + 1;
+					mantissa += (mantissa & 1);
+					mantissa >>= 1;
+					power2 = (mantissa < (uint64_t(1) << traits::mantissa_explicit_bits)) ? 0 : 1;
+				}
+			}
+			else
+			{
+				// exactly halfway between two floats, round to even
+				if (product.low <= 1 && q >= traits::min_exponent_round_to_even && q <= traits::max_exponent_round_to_even
+					&& (mantissa & 3) == 1)
+				{
+					if ((mantissa << shift) == product.high)
+						mantissa &= ~uint64_t(1);
+				}
+				mantissa += (mantissa & 1);
+				mantissa >>= 1;
+				if (mantissa >= (uint64_t(2) << traits::mantissa_explicit_bits))
+				{
+					mantissa = (uint64_t(1) << traits::mantissa_explicit_bits);
+					power2++;
+				}
+				mantissa &= ~(uint64_t(1) << traits::mantissa_explicit_bits);
+				if (power2 >= traits::infinite_power)
+				{
+					mantissa = 0; power2 = traits::infinite_power;
+				}
+			}
+		}
+
+		bits_type bits = (bits_type)mantissa | ((bits_type)power2 << traits::mantissa_explicit_bits);
+		if (bNegative)
+			bits |= (bits_type(1) << traits::sign_index);
+		memcpy(&ValueOut, &bits, sizeof(RealType));
+		return true;
+	}
+
+	// parse number at [Cur,End) with the platform's exact parser. Returns pointer past the parsed characters, or Cur on failure
+	const char* parse_real_fallback(const char* Cur, const char* End, double& ValueOut);
+	const char* parse_real_fallback(const char* Cur, const char* End, float& ValueOut);
+}
+
+
+/**
+ * Parse a decimal floating-point number from the start of [Cur,End), in the C locale.
+ * Returns a pointer to the character after the number, or Cur if no number could be parsed
+ * (in which case ValueOut is set to 0).
+ */
+template<typename RealType>
+inline const char* parse_real(const char* Cur, const char* End, RealType& ValueOut)
+{
+	using namespace GS::FloatParsing;
+	using traits = real_traits<RealType>;
+
+	const char* Start = Cur;
+	bool bNegative = false;
+	if (Cur < End && (*Cur == '-' || *Cur == '+'))
+	{
+		bNegative = (*Cur == '-');
+		Cur++;
+	}
+	const char* NumberStart = Cur;
+
+	// accumulate digits into the mantissa. If there are more than 19 significant digits w
+	// overflows, but in that case the fallback path is used and w is ignored
+	uint64_t w = 0;
+	int64_t q = 0;
+	int NumDigits = 0;
+	while (Cur < End && *Cur == '0') {
+		Cur++; NumDigits++;
+	}
+	const char* SignificantStart = Cur;
+	while (Cur < End && (unsigned)(*Cur - '0') < 10u) {
+		w = w * 10 + (uint64_t)(*Cur - '0');
+		Cur++;
+	}
+	int NumSignificantDigits = (int)(Cur - SignificantStart);
+	NumDigits += NumSignificantDigits;
+	if (Cur < End && *Cur == '.')
+	{
+		Cur++;
+		const char* FractionStart = Cur;
+		if (NumSignificantDigits == 0) {
+			while (Cur < End && *Cur == '0')		// leading zeros of 0.000xyz are not significant
+				Cur++;
+			SignificantStart = Cur;
+		}
+		const char* FractionDigitsStart = Cur;
+		while (Cur < End && (unsigned)(*Cur - '0') < 10u) {
+			w = w * 10 + (uint64_t)(*Cur - '0');
+			Cur++;
+		}
+		NumSignificantDigits += (int)(Cur - FractionDigitsStart);
+		NumDigits += (int)(Cur - FractionStart);
+		q = -(int64_t)(Cur - FractionStart);
+	}
+	if (NumDigits == 0)
+	{
+		// no digits, may be inf/nan/hex/garbage
+		const char* FallbackEnd = parse_real_fallback(NumberStart, End, ValueOut);
+		if (FallbackEnd == NumberStart) {
+			ValueOut = 0;
+			return Start;
+		}
+		if (bNegative) ValueOut = -ValueOut;
+		return FallbackEnd;
+	}
+	if (Cur < End && (*Cur == 'e' || *Cur == 'E'))
+	{
+		const char* ExponentStart = Cur;
+		Cur++;
+		bool bNegativeExponent = false;
+		if (Cur < End && (*Cur == '-' || *Cur == '+'))
+		{
+			bNegativeExponent = (*Cur == '-');
+			Cur++;
+		}
+		if (Cur < End && (unsigned)(*Cur - '0') < 10u)
+		{
+			int64_t Exponent = 0;
+			while (Cur < End && (unsigned)(*Cur - '0') < 10u)
+			{
+				if (Exponent < 0x10000000)
+					Exponent = Exponent * 10 + (*Cur - '0');
+				Cur++;
+			}
+			q += (bNegativeExponent) ? -Exponent : Exponent;
+		}
+		else
+			Cur = ExponentStart;	// 'e' is not followed by an exponent, so it is not part of the number
+	}
+
+	if (w == 0)
+	{
+		ValueOut = (bNegative) ? -RealType(0) : RealType(0);
+		return Cur;
+	}
+
+	if (NumSignificantDigits <= 19)
+	{
+		// Clinger fast path, w and 10^|q| are exact so a single IEEE multiply/divide is correctly rounded
+		if (w <= traits::max_mantissa_fast_path && q >= -traits::max_exponent_fast_path && q <= traits::max_exponent_fast_path)
+		{
+			RealType Value = (RealType)w;
+			Value = (q < 0) ? (Value / traits::exact_power_of_ten(-q)) : (Value * traits::exact_power_of_ten(q));
+			ValueOut = (bNegative) ? -Value : Value;
+			return Cur;
+		}
+		if (eisel_lemire<RealType>(q, w, bNegative, ValueOut))
+			return Cur;
+	}
+
+	// too many digits, or ambiguous rounding
+	RealType Value = 0;
+	parse_real_fallback(NumberStart, Cur, Value);
+	ValueOut = (bNegative) ? -Value : Value;
+	return Cur;
+}
+
+
+/**
+ * Parse up to MaxCount whitespace-separated numbers from [Cur,End) in a single pass,
+ * with strtod() semantics per token (ie any trailing non-numeric characters of a token are
+ * ignored and a non-numeric token parses to 0). Cur is advanced past the parsed tokens.
+ * Returns the number of tokens consumed.
+ */
+template<typename RealType>
+inline int parse_real_list(const char*& Cur, const char* End, RealType* ValuesOut, int MaxCount)
+{
+	int NumParsed = 0;
+	while (NumParsed < MaxCount && Cur < End)
+	{
+		const char* TokenEnd = parse_real(Cur, End, ValuesOut[NumParsed]);
+		while (TokenEnd < End && *TokenEnd != ' ' && *TokenEnd != '\t')
+			TokenEnd++;
+		while (TokenEnd < End && (*TokenEnd == ' ' || *TokenEnd == '\t'))
+			TokenEnd++;
+		Cur = TokenEnd;
+		NumParsed++;
+	}
+	return NumParsed;
+}
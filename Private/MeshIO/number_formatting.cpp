@@ -0,0 +1,139 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#include "MeshIO/number_formatting.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <type_traits>
+
+#if defined(__APPLE__) || (defined(__linux__) && !defined(__cpp_lib_to_chars))
+#include <locale.h>
+#if defined(__APPLE__)
+#include <xlocale.h>
+#endif
+#define GSIO_NUMBER_FORMATTING_USE_SNPRINTF
+#endif
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable:4996) // disable secure-crt warnings for this file
+#endif
+
+using namespace GS;
+using namespace GS::NumberFormatting;
+
+
+const char GS::NumberFormatting::DigitPairs[200] = {
+	'0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+	'1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+	'2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+	'3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+	'4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+	'5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+	'6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+	'7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+	'8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+	'9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9'
+};
+
+
+#ifdef GSIO_NUMBER_FORMATTING_USE_SNPRINTF
+// Apple Clang (and older libstdc++) may not support std::to_chars for floating point.
+// Use snprintf with the C locale set for this thread, so that the decimal point does not depend on the global locale
+static locale_t get_c_locale()
+{
+	static locale_t CLocale = newlocale(LC_ALL_MASK, "C", (locale_t)0);
+	return CLocale;
+}
+
+template<typename RealType>
+static char* format_real_impl(char* Dest, RealType Value, const RealFormatOptions& Options)
+{
+	locale_t PrevLocale = uselocale(get_c_locale());
+	int Length = 0;
+	if (Options.Mode == ERealPrecisionMode::FixedDigits)
+	{
+		int Digits = std::clamp(Options.FixedDigits, 0, MaxFixedDigits);
+		Length = snprintf(Dest, MaxRealLength, "%.*f", Digits, (double)Value);
+	}
+	else
+	{
+		// increase precision until the string parses back to Value
+		constexpr int MaxPrecision = std::is_same_v<RealType, float> ? 9 : 17;
+		for (int Precision = 1; Precision <= MaxPrecision; ++Precision)
+		{
+			Length = snprintf(Dest, MaxRealLength, "%.*g", Precision, (double)Value);
+			RealType ParsedValue = (std::is_same_v<RealType, float>) ? (RealType)strtof(Dest, nullptr) : (RealType)strtod(Dest, nullptr);
+			if (ParsedValue == Value)
+				break;
+		}
+	}
+	uselocale(PrevLocale);
+	return Dest + std::clamp(Length, 0, MaxRealLength - 1);
+}
+
+#else
+
+template<typename RealType>
+static char* format_real_impl(char* Dest, RealType Value, const RealFormatOptions& Options)
+{
+	std::to_chars_result Result;
+	if (Options.Mode == ERealPrecisionMode::FixedDigits)
+	{
+		// float->double is exact, so this is the same as formatting the float
+		int Digits = std::clamp(Options.FixedDigits, 0, MaxFixedDigits);
+		Result = std::to_chars(Dest, Dest + MaxRealLength, (double)Value, std::chars_format::fixed, Digits);
+	}
+	else
+	{
+		Result = std::to_chars(Dest, Dest + MaxRealLength, Value);
+	}
+	return Result.ptr;
+}
+
+#endif
+
+
+char* GS::NumberFormatting::format_real(char* Dest, double Value, const RealFormatOptions& Options)
+{
+	if (Options.Mode == ERealPrecisionMode::Float32)
+		return format_real_impl(Dest, (float)Value, Options);
+	return format_real_impl(Dest, Value, Options);
+}
+
+char* GS::NumberFormatting::format_real(char* Dest, float Value, const RealFormatOptions& Options)
+{
+	return format_real_impl(Dest, Value, Options);
+}
+
+
+bool TextFormatBuffer::Flush(ITextWriter& Writer)
+{
+	if (UsedSize == 0)
+		return true;
+	char* End = Reserve(0);
+	char* Cur = Buffer.data();
+	bool bOK = true;
+	while (bOK && Cur < End)
+	{
+		// lines are null-terminated in-place, the buffer is cleared afterwards
+		char* LineEnd = (char*)memchr(Cur, '\n', (size_t)(End - Cur));
+		if (LineEnd == nullptr)
+		{
+			*End = '\0';
+			bOK = Writer.WriteToken(Cur);
+			break;
+		}
+		*LineEnd = '\0';
+		bOK = Writer.WriteLine(Cur);
+		Cur = LineEnd + 1;
+	}
+	UsedSize = 0;
+	return bOK;
+}
+
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
@@ -0,0 +1,178 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#pragma once
+
+#include "MeshIO/TextFormatOptions.h"
+#include "MeshIO/parallel_utils.h"
+#include "Core/TextIO.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+//
+// Locale-independent integer and floating point to text conversion, and a growable text
+// buffer that is written to an ITextWriter in large blocks.
+//
+// Real values are formatted with std::to_chars (shortest round-trip or fixed precision,
+// both correctly rounded) where available, and snprintf in the C locale otherwise.
+//
+
+namespace GS::NumberFormatting
+{
+	//! max length of a string written by format_real(), ie fixed-format 1e308 with MaxFixedDigits digits
+	static constexpr int MaxRealLength = 384;
+	static constexpr int MaxFixedDigits = 32;
+	//! max length of a string written by format_int(), ie "-2147483648"
+	static constexpr int MaxIntLength = 11;
+
+	// "00", "01", ..., "99"
+	extern const char DigitPairs[200];
+
+	inline int count_digits(uint32_t Value)
+	{
+		int NumDigits = 1;
+		for (;;)
+		{
+			if (Value < 10) return NumDigits;
+			if (Value < 100) return NumDigits + 1;
+			if (Value < 1000) return NumDigits + 2;
+			if (Value < 10000) return NumDigits + 3;
+			Value /= 10000;
+			NumDigits += 4;
+		}
+	}
+
+	// write decimal Value to Dest, returns pointer past the last character written (no null terminator)
+	inline char* format_uint(char* Dest, uint32_t Value)
+	{
+		int NumDigits = count_digits(Value);
+		char* Cur = Dest + NumDigits;
+		while (Value >= 100)
+		{
+			uint32_t PairIndex = (Value % 100) * 2;
+			Value /= 100;
+			Cur -= 2;
+			memcpy(Cur, &DigitPairs[PairIndex], 2);
+		}
+		if (Value >= 10)
+			memcpy(Cur - 2, &DigitPairs[Value * 2], 2);
+		else
+			Cur[-1] = (char)('0' + Value);
+		return Dest + NumDigits;
+	}
+
+	inline char* format_int(char* Dest, int Value)
+	{
+		uint32_t AbsValue = (uint32_t)Value;
+		if (Value < 0)
+		{
+			*Dest++ = '-';
+			AbsValue = 0u - AbsValue;
+		}
+		return format_uint(Dest, AbsValue);
+	}
+
+	// write Value to Dest (which must have space for MaxRealLength characters), returns pointer past the last character written
+	char* format_real(char* Dest, double Value, const RealFormatOptions& Options);
+	char* format_real(char* Dest, float Value, const RealFormatOptions& Options);
+
+
+	/**
+	 * Growable text buffer that numbers and strings are formatted directly into.
+	 * Lines are terminated with '\n' in the buffer, and Flush() passes each line to the ITextWriter
+	 * with WriteLine(), so the end-of-line sequence in the output is the one the writer uses.
+	 */
+	class TextFormatBuffer
+	{
+	public:
+		//! FlushIfFull() writes the buffer once it reaches this size
+		static constexpr size_t DefaultFlushSize = 1 << 20;
+
+		explicit TextFormatBuffer(const RealFormatOptions& RealFormatIn = RealFormatOptions())
+			: RealFormat(RealFormatIn) {}
+
+		size_t Size() const { return UsedSize; }
+		const char* Data() const { return Buffer.data(); }
+		void Clear() { UsedSize = 0; }
+
+		//! ensure MaxChars characters can be written at End(), and return End()
+		char* Reserve(size_t MaxChars)
+		{
+			// +1 for the null terminator added by Flush()
+			if (UsedSize + MaxChars + 1 > Buffer.size())
+				Buffer.resize(std::max(Buffer.size() * 2, std::max(UsedSize + MaxChars + 1, (size_t)4096)));
+			return Buffer.data() + UsedSize;
+		}
+		//! set End() after writing into the pointer returned by Reserve()
+		void Commit(char* NewEnd) { UsedSize = (size_t)(NewEnd - Buffer.data()); }
+
+		void AppendChar(char c) { *Reserve(1) = c; UsedSize++; }
+		//! end the current line, see Flush()
+		void AppendEndOfLine() { AppendChar('\n'); }
+		void AppendString(const char* String, size_t Length)
+		{
+			memcpy(Reserve(Length), String, Length);
+			UsedSize += Length;
+		}
+		void AppendString(const char* String) { AppendString(String, strlen(String)); }
+		void AppendBuffer(const TextFormatBuffer& Other) { AppendString(Other.Data(), Other.Size()); }
+
+		void AppendInt(int Value) { Commit(format_int(Reserve(MaxIntLength), Value)); }
+		void AppendReal(double Value) { Commit(format_real(Reserve(MaxRealLength), Value, RealFormat)); }
+		void AppendReal(float Value) { Commit(format_real(Reserve(MaxRealLength), Value, RealFormat)); }
+
+		//! append each of the Count values with a preceding space
+		template<typename RealType>
+		void AppendReals(const RealType* Values, int Count)
+		{
+			for (int k = 0; k < Count; ++k)
+			{
+				AppendChar(' ');
+				AppendReal(Values[k]);
+			}
+		}
+
+		//! write the buffer contents to Writer and clear the buffer. Complete lines are written with WriteLine(), and any unterminated text at the end with WriteToken(). Returns false if a write failed
+		bool Flush(ITextWriter& Writer);
+		//! Flush() if the buffer contains at least FlushSize characters
+		bool FlushIfFull(ITextWriter& Writer, size_t FlushSize = DefaultFlushSize)
+		{
+			return (UsedSize < FlushSize) || Flush(Writer);
+		}
+
+	protected:
+		std::vector<char> Buffer;
+		size_t UsedSize = 0;
+		RealFormatOptions RealFormat;
+	};
+
+
+	/**
+	 * Format the lines of a section of Count elements (eg vertices, faces) in chunks of ChunkSize elements,
+	 * by calling FormatRange(Buffer, ChunkStart, ChunkEnd). Each round formats up to ChunkBuffers.size() chunks
+	 * in parallel, one per buffer, and then writes the buffers to TextWriter in chunk order, so the output
+	 * is identical for any number of buffers.
+	 */
+	template<typename FormatRangeFuncType>
+	bool write_text_chunks(ITextWriter& TextWriter, std::vector<TextFormatBuffer>& ChunkBuffers, size_t Count, FormatRangeFuncType FormatRange)
+	{
+		constexpr size_t ChunkSize = 1 << 15;
+		size_t NumChunks = (Count + ChunkSize - 1) / ChunkSize;
+		int NumBuffers = (int)ChunkBuffers.size();
+		bool bWritesOK = true;
+		for (size_t RoundStart = 0; RoundStart < NumChunks; RoundStart += NumBuffers)
+		{
+			int NumRoundChunks = (int)std::min((size_t)NumBuffers, NumChunks - RoundStart);
+			parallel_for_blocks(NumRoundChunks, NumBuffers, [&](int k)
+			{
+				size_t ChunkStart = (RoundStart + k) * ChunkSize;
+				ChunkBuffers[k].Clear();
+				FormatRange(ChunkBuffers[k], ChunkStart, std::min(Count, ChunkStart + ChunkSize));
+			});
+			for (int k = 0; k < NumRoundChunks; ++k)
+				bWritesOK = ChunkBuffers[k].Flush(TextWriter) && bWritesOK;
+		}
+		return bWritesOK;
+	}
+}
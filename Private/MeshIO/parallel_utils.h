@@ -0,0 +1,299 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+// returns number of worker threads to use for a requested thread count.
+// RequestedThreads <= 0 means "use all hardware threads"
+inline int get_num_worker_threads(int RequestedThreads)
+{
+	if (RequestedThreads > 0)
+		return RequestedThreads;
+	int HardwareThreads = (int)std::thread::hardware_concurrency();
+	return std::max(HardwareThreads, 1);
+}
+
+
+/**
+ * Call BlockFunc(BlockIndex) for each BlockIndex in [0,NumBlocks), using up to NumThreads
+ * threads (including the calling thread). Blocks are handed out dynamically, so BlockFunc
+ * must not depend on which thread runs a block, or in what order blocks are processed.
+ * Returns after all blocks have completed.
+ */
+template<typename BlockFuncType>
+void parallel_for_blocks(int NumBlocks, int NumThreads, BlockFuncType&& BlockFunc)
+{
+	int UseThreads = std::min(std::max(NumThreads, 1), NumBlocks);
+	if (UseThreads <= 1)
+	{
+		for (int k = 0; k < NumBlocks; ++k)
+			BlockFunc(k);
+		return;
+	}
+
+	std::atomic<int> NextBlock(0);
+	auto WorkerFunc = [&]()
+	{
+		int BlockIndex = NextBlock.fetch_add(1);
+		while (BlockIndex < NumBlocks)
+		{
+			BlockFunc(BlockIndex);
+			BlockIndex = NextBlock.fetch_add(1);
+		}
+	};
+
+	std::vector<std::thread> Workers;
+	Workers.reserve(UseThreads - 1);
+	for (int k = 0; k < UseThreads - 1; ++k)
+		Workers.emplace_back(WorkerFunc);
+	WorkerFunc();
+	for (std::thread& Worker : Workers)
+		Worker.join();
+}
+
+
+/**
+ * Split [0,Count) into NumBlocks contiguous ranges of near-equal size and call
+ * RangeFunc(BlockIndex, RangeStart, RangeEnd) for each, in parallel
+ */
+template<typename RangeFuncType>
+void parallel_for_ranges(size_t Count, int NumBlocks, int NumThreads, RangeFuncType&& RangeFunc)
+{
+	NumBlocks = (int)std::max((size_t)1, std::min((size_t)std::max(NumBlocks, 1), Count));
+	parallel_for_blocks(NumBlocks, NumThreads, [&](int BlockIndex)
+	{
+		size_t RangeStart = (Count * (size_t)BlockIndex) / (size_t)NumBlocks;
+		size_t RangeEnd = (Count * (size_t)(BlockIndex+1)) / (size_t)NumBlocks;
+		RangeFunc(BlockIndex, RangeStart, RangeEnd);
+	});
+}
+
+
+/**
+ * Sort Values with strict weak ordering LessFunc, using up to NumThreads threads. Blocks of Values
+ * are sorted in parallel and then merged pairwise. If LessFunc is a total order (ie no two distinct
+ * elements compare equal), the result is identical to std::sort for any thread count.
+ */
+template<typename T, typename LessFuncType>
+void parallel_sort(std::vector<T>& Values, int NumThreads, LessFuncType LessFunc)
+{
+	constexpr size_t MinParallelSortSize = 1 << 16;
+	size_t Count = Values.size();
+	int NumBlocks = (Count < MinParallelSortSize) ? 1 : std::max(NumThreads, 1);
+	if (NumBlocks <= 1)
+	{
+		std::sort(Values.begin(), Values.end(), LessFunc);
+		return;
+	}
+
+	std::vector<size_t> BlockStarts(NumBlocks + 1);
+	for (int k = 0; k <= NumBlocks; ++k)
+		BlockStarts[k] = (Count * (size_t)k) / (size_t)NumBlocks;
+	parallel_for_blocks(NumBlocks, NumThreads, [&](int k)
+	{
+		std::sort(Values.begin() + BlockStarts[k], Values.begin() + BlockStarts[k+1], LessFunc);
+	});
+
+	// merge sorted runs of Width blocks pairwise, ping-ponging between Values and Temp
+	std::vector<T> Temp(Count);
+	for (int Width = 1; Width < NumBlocks; Width *= 2)
+	{
+		int NumPairs = (NumBlocks + 2*Width - 1) / (2*Width);
+		parallel_for_blocks(NumPairs, NumThreads, [&](int PairIndex)
+		{
+			int First = PairIndex * 2 * Width;
+			size_t Start = BlockStarts[First];
+			size_t Middle = BlockStarts[std::min(First + Width, NumBlocks)];
+			size_t End = BlockStarts[std::min(First + 2*Width, NumBlocks)];
+			std::merge(Values.begin() + Start, Values.begin() + Middle,
+				Values.begin() + Middle, Values.begin() + End, Temp.begin() + Start, LessFunc);
+		});
+		std::swap(Values, Temp);
+	}
+}
+
+
+/**
+ * Number the distinct keys of elements [0,Count) in order of first occurrence, ie the same numbering
+ * as inserting GetKey(0), GetKey(1), ... into a map, and set IndicesOut[i] to the number of the key of
+ * element i. GetKey(i) must return a trivially-copyable KeyType, keys are compared bitwise, so float
+ * keys should be canonicalized first (eg -0 to +0) if equal values must match.
+ * Keys are sorted with parallel_sort, so the result does not depend on NumThreads.
+ * If FirstElementsOut is not null, it is set to the first element with each key.
+ * Returns the number of distinct keys.
+ */
+template<typename KeyType, typename GetKeyFuncType>
+int parallel_index_unique_keys(size_t Count, int NumThreads, GetKeyFuncType GetKey,
+	std::vector<int>& IndicesOut, std::vector<uint32_t>* FirstElementsOut = nullptr)
+{
+	struct ElementKey
+	{
+		KeyType Key;
+		uint32_t Element;
+	};
+	int NumBlocks = std::max(NumThreads, 1) * 4;
+
+	std::vector<ElementKey> Keys(Count);
+	parallel_for_ranges(Count, NumBlocks, NumThreads, [&](int, size_t Start, size_t End)
+	{
+		for (size_t i = Start; i < End; ++i)
+			Keys[i] = ElementKey{ GetKey(i), (uint32_t)i };
+	});
+	// sort by key and then element, so each run of equal keys starts with its first element
+	parallel_sort(Keys, NumThreads, [](const ElementKey& A, const ElementKey& B)
+	{
+		int KeyCompare = memcmp(&A.Key, &B.Key, sizeof(KeyType));
+		return (KeyCompare != 0) ? (KeyCompare < 0) : (A.Element < B.Element);
+	});
+
+	std::vector<uint32_t> FirstElement(Count);
+	parallel_for_ranges(Count, NumBlocks, NumThreads, [&](int, size_t Start, size_t End)
+	{
+		size_t RunStart = Start;
+		while (RunStart > 0 && memcmp(&Keys[RunStart-1].Key, &Keys[Start].Key, sizeof(KeyType)) == 0)
+			RunStart--;
+		for (size_t i = Start; i < End; ++i)
+		{
+			if (memcmp(&Keys[i].Key, &Keys[RunStart].Key, sizeof(KeyType)) != 0)
+				RunStart = i;
+			FirstElement[Keys[i].Element] = Keys[RunStart].Element;
+		}
+	});
+	Keys = std::vector<ElementKey>();
+
+	// number the first elements in element order, via a blocked prefix sum
+	std::vector<int> BlockOffsets(NumBlocks + 1, 0);
+	parallel_for_ranges(Count, NumBlocks, NumThreads, [&](int BlockIndex, size_t Start, size_t End)
+	{
+		int NumFirst = 0;
+		for (size_t i = Start; i < End; ++i)
+			NumFirst += (FirstElement[i] == (uint32_t)i) ? 1 : 0;
+		BlockOffsets[BlockIndex+1] = NumFirst;
+	});
+	for (int k = 0; k < NumBlocks; ++k)
+		BlockOffsets[k+1] += BlockOffsets[k];
+	int NumUnique = BlockOffsets[NumBlocks];
+
+	IndicesOut.resize(Count);
+	if (FirstElementsOut != nullptr)
+		FirstElementsOut->resize(NumUnique);
+	parallel_for_ranges(Count, NumBlocks, NumThreads, [&](int BlockIndex, size_t Start, size_t End)
+	{
+		int NextIndex = BlockOffsets[BlockIndex];
+		for (size_t i = Start; i < End; ++i)
+		{
+			if (FirstElement[i] == (uint32_t)i)
+			{
+				if (FirstElementsOut != nullptr)
+					(*FirstElementsOut)[NextIndex] = (uint32_t)i;
+				IndicesOut[i] = NextIndex++;
+			}
+		}
+	});
+	// first elements may be in an earlier block, so the remaining elements are set after all first elements are numbered
+	parallel_for_ranges(Count, NumBlocks, NumThreads, [&](int, size_t Start, size_t End)
+	{
+		for (size_t i = Start; i < End; ++i)
+		{
+			if (FirstElement[i] != (uint32_t)i)
+				IndicesOut[i] = IndicesOut[FirstElement[i]];
+		}
+	});
+	return NumUnique;
+}
+
+
+/**
+ * Compute the permutation SortedIndicesOut that sorts elements [0,Count) by integer key GetKey(i),
+ * keeping elements with equal keys in element order (ie the same order as std::stable_sort by key).
+ * Uses a parallel counting sort over the distinct keys, or parallel_sort if there are many distinct keys.
+ * Returns the number of distinct keys.
+ */
+template<typename GetKeyFuncType>
+int parallel_stable_sort_by_key(size_t Count, int NumThreads, GetKeyFuncType GetKey, std::vector<int>& SortedIndicesOut)
+{
+	int NumBlocks = std::max(NumThreads, 1);
+	std::vector<int> Keys(Count);
+	std::vector<std::vector<int>> BlockDistinctKeys(NumBlocks);
+	parallel_for_ranges(Count, NumBlocks, NumThreads, [&](int BlockIndex, size_t Start, size_t End)
+	{
+		std::vector<int>& DistinctKeys = BlockDistinctKeys[BlockIndex];
+		for (size_t i = Start; i < End; ++i)
+		{
+			Keys[i] = GetKey(i);
+			if (DistinctKeys.empty() || DistinctKeys.back() != Keys[i])
+				DistinctKeys.push_back(Keys[i]);
+		}
+		std::sort(DistinctKeys.begin(), DistinctKeys.end());
+		DistinctKeys.erase(std::unique(DistinctKeys.begin(), DistinctKeys.end()), DistinctKeys.end());
+	});
+	std::vector<int> DistinctKeys;
+	for (const std::vector<int>& BlockKeys : BlockDistinctKeys)
+		DistinctKeys.insert(DistinctKeys.end(), BlockKeys.begin(), BlockKeys.end());
+	std::sort(DistinctKeys.begin(), DistinctKeys.end());
+	DistinctKeys.erase(std::unique(DistinctKeys.begin(), DistinctKeys.end()), DistinctKeys.end());
+	int NumKeys = (int)DistinctKeys.size();
+
+	SortedIndicesOut.resize(Count);
+
+	// per-block count tables would be larger than the input, sort (key,element) pairs instead
+	if ((size_t)NumKeys * (size_t)NumBlocks > Count + 1024)
+	{
+		std::vector<std::pair<int,int>> KeyElements(Count);
+		parallel_for_ranges(Count, NumBlocks, NumThreads, [&](int, size_t Start, size_t End)
+		{
+			for (size_t i = Start; i < End; ++i)
+				KeyElements[i] = std::pair<int,int>(Keys[i], (int)i);
+		});
+		parallel_sort(KeyElements, NumThreads, [](const std::pair<int,int>& A, const std::pair<int,int>& B) { return A < B; });
+		parallel_for_ranges(Count, NumBlocks, NumThreads, [&](int, size_t Start, size_t End)
+		{
+			for (size_t i = Start; i < End; ++i)
+				SortedIndicesOut[i] = KeyElements[i].second;
+		});
+		return NumKeys;
+	}
+
+	std::unordered_map<int, int> KeyRanks;
+	KeyRanks.reserve(NumKeys);
+	for (int k = 0; k < NumKeys; ++k)
+		KeyRanks[DistinctKeys[k]] = k;
+
+	// replace keys with ranks and count the elements of each rank in each block
+	std::vector<size_t> BlockRankOffsets((size_t)NumBlocks * NumKeys, 0);
+	parallel_for_ranges(Count, NumBlocks, NumThreads, [&](int BlockIndex, size_t Start, size_t End)
+	{
+		size_t* RankCounts = &BlockRankOffsets[(size_t)BlockIndex * NumKeys];
+		for (size_t i = Start; i < End; ++i)
+		{
+			Keys[i] = KeyRanks.find(Keys[i])->second;
+			RankCounts[Keys[i]]++;
+		}
+	});
+	// elements of rank r in block b start after all elements of lower rank, and elements of rank r in earlier blocks
+	size_t RunningOffset = 0;
+	for (int r = 0; r < NumKeys; ++r)
+	{
+		for (int b = 0; b < NumBlocks; ++b)
+		{
+			size_t BlockCount = BlockRankOffsets[(size_t)b * NumKeys + r];
+			BlockRankOffsets[(size_t)b * NumKeys + r] = RunningOffset;
+			RunningOffset += BlockCount;
+		}
+	}
+	parallel_for_ranges(Count, NumBlocks, NumThreads, [&](int BlockIndex, size_t Start, size_t End)
+	{
+		size_t* RankOffsets = &BlockRankOffsets[(size_t)BlockIndex * NumKeys];
+		for (size_t i = Start; i < End; ++i)
+			SortedIndicesOut[RankOffsets[Keys[i]]++] = (int)i;
+	});
+	return NumKeys;
+}
@@ -0,0 +1,71 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#pragma once
+
+#include "MeshIO/ParseResultCache.h"
+#include "MeshIO/BinaryMeshCache.h"
+
+#include <string>
+
+
+namespace GS::ParseResultCache
+{
+
+enum class ECacheEvent
+{
+	Hit,
+	Miss,
+	Store,
+	Eviction
+};
+
+void record_cache_event(ECacheEvent Event);
+
+//! update the modification time of an entry, which is used as its last-access time for eviction
+void touch_cache_entry(const std::string& EntryPath);
+
+//! unique temporary file path in the directory of EntryPath
+std::string make_temp_entry_path(const std::string& EntryPath);
+
+//! if bWriteOK, atomically replace EntryPath with TempPath. Otherwise, or if that fails, remove TempPath and return false
+bool commit_temp_entry(const std::string& TempPath, const std::string& EntryPath, bool bWriteOK);
+
+/**
+ * Load DataOut from the cache entry for SourcePath if it exists (and passes checksum verification),
+ * otherwise call Parse(DataOut) and, if it succeeds, store the result in the cache. Falls back to
+ * Parse() if the cache cannot be used.
+ */
+template<typename DataType, typename ParseFunc>
+bool read_through_cache(const std::string& CacheDirectory, uint64_t MaxCacheSizeBytes, bool bSampledContentHash,
+	const std::string& SourcePath, const std::string& OptionsKey, DataType& DataOut, ParseFunc Parse)
+{
+	std::string EntryPath;
+	if (!GetCacheEntryPath(CacheDirectory, SourcePath, OptionsKey, EntryPath, bSampledContentHash))
+		return Parse(DataOut);
+
+	// entries are shared between processes and live indefinitely, so they are not trusted to be intact
+	BinaryMeshCache::ReadOptions EntryReadOptions;
+	EntryReadOptions.bVerifyChecksums = true;
+	if (BinaryMeshCache::ReadCacheFile(EntryPath, DataOut, EntryReadOptions))
+	{
+		touch_cache_entry(EntryPath);
+		record_cache_event(ECacheEvent::Hit);
+		return true;
+	}
+
+	record_cache_event(ECacheEvent::Miss);
+	if (!Parse(DataOut))
+		return false;
+
+	// failure to store the entry is not an error, the result is still valid
+	std::string TempPath = make_temp_entry_path(EntryPath);
+	bool bWriteOK = BinaryMeshCache::WriteCacheFile(TempPath, DataOut);
+	if (commit_temp_entry(TempPath, EntryPath, bWriteOK))
+	{
+		record_cache_event(ECacheEvent::Store);
+		if (MaxCacheSizeBytes > 0)
+			TrimCacheDirectory(CacheDirectory, MaxCacheSizeBytes);
+	}
+	return true;
+}
+
+}  // end namespace GS::ParseResultCache
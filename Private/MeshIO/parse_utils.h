@@ -1,6 +1,11 @@
 // Copyright Gradientspace Corp. All Rights Reserved.
 #pragma once
 
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+
 static constexpr char null_char = '\0';
 
 
@@ -10,28 +15,98 @@ inline bool is_line_space(char c) {
 inline bool is_end_of_line(char c) {
 	return c == '\r' || c == '\n' || c == null_char;
 }
-inline bool check_eol(const char* LineString, int index) { 
+inline bool check_eol(const char* LineString, int index) {
 	return is_end_of_line(LineString[index]);
 }
 
 
 
+//
+// Length-bounded parsing helpers. These operate on [Cur,End) ranges of a
+// (possibly memory-mapped, read-only) buffer and never read at or past End,
+// so the buffer does not need to be null-terminated.
+//
 
-inline void trim_start_end_in_place(char*& String, int& N)
+// returns pointer to the next '\n' character, or End if there is none
+inline const char* find_line_end(const char* Cur, const char* End)
 {
-	if (String[N - 1] == '\n') {
-		N--;
-		String[N] = null_char;
-	}
-	if (String[N - 1] == '\r') {
-		N--;
-		String[N] = null_char;
+	const char* Found = (const char*)memchr(Cur, '\n', (size_t)(End - Cur));
+	return (Found != nullptr) ? Found : End;
+}
+
+// strip trailing \n and \r (at most one of each) and leading spaces/tabs from line [Start,End)
+inline void trim_line_span(const char*& Start, const char*& End)
+{
+	if (End > Start && End[-1] == '\n')
+		End--;
+	if (End > Start && End[-1] == '\r')
+		End--;
+	while (Start < End && is_line_space(*Start))
+		Start++;
+}
+
+inline const char* skip_line_space(const char* Cur, const char* End)
+{
+	while (Cur < End && is_line_space(*Cur))
+		Cur++;
+	return Cur;
+}
+
+// returns pointer to first space/tab character at or after Cur, or End
+inline const char* find_token_end(const char* Cur, const char* End)
+{
+	while (Cur < End && !is_line_space(*Cur))
+		Cur++;
+	return Cur;
+}
+
+// returns pointer to start of token after the token at Cur, or End if there is no next token
+inline const char* find_next_token(const char* Cur, const char* End)
+{
+	return skip_line_space(find_token_end(Cur, End), End);
+}
+
+// returns pointer to first occurrence of c in [Cur,End), or End
+inline const char* find_char(const char* Cur, const char* End, char c)
+{
+	while (Cur < End && *Cur != c)
+		Cur++;
+	return Cur;
+}
+
+// atoi() semantics over [Cur,End): optional sign followed by decimal digits, parsing stops at
+// the first non-digit character. Returns 0 if there are no digits. Values outside [-INT_MAX,INT_MAX]
+// (eg long digit runs in corrupt files) saturate to -INT_MAX/INT_MAX, so they fail later index range checks
+inline int parse_int(const char* Cur, const char* End)
+{
+	bool bNegative = false;
+	if (Cur < End && (*Cur == '-' || *Cur == '+'))
+	{
+		bNegative = (*Cur == '-');
+		Cur++;
 	}
-	// trim empty space
-	while (is_line_space(String[0]) && N > 0)
+	int64_t Value = 0;
+	while (Cur < End && (unsigned)(*Cur - '0') < 10u)
 	{
-		String++;
-		N--;
+		Value = Value * 10 + (*Cur - '0');
+		if (Value > INT_MAX)
+			Value = INT_MAX;
+		Cur++;
 	}
+	return (bNegative) ? -(int)Value : (int)Value;
 }
 
+// returns index of first occurrence of Substring in [Cur,End), or -1
+inline int index_of_substring(const char* Cur, const char* End, const char* Substring)
+{
+	size_t M = strlen(Substring);
+	size_t N = (size_t)(End - Cur);
+	if (M == 0 || M > N)
+		return -1;
+	for (size_t i = 0; i <= N - M; ++i)
+	{
+		if (Cur[i] == Substring[0] && memcmp(Cur + i, Substring, M) == 0)
+			return (int)i;
+	}
+	return -1;
+}
@@ -0,0 +1,203 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#pragma once
+
+#include "GradientspaceIOPlatform.h"
+#include "Mesh/DenseMesh.h"
+#include "MeshIO/OBJFormatData.h"
+#include "MeshIO/STLReader.h"
+
+#include <memory>
+#include <string>
+
+namespace GS
+{
+class MappedFileBuffer;
+}
+
+/**
+ * Native binary container for OBJFormatData, STLMeshData and DenseMesh, intended as a fast-loading
+ * cache of parsed mesh files. The file is a fixed-size header, followed by a table of sections, each of
+ * which is a flat array of fixed-size elements starting at a 64-byte aligned offset. Arrays are stored
+ * in native (little-endian) memory layout, so loading is a bounds-checked copy (or no copy at all, via
+ * BinaryMeshCacheView), rather than a parse. Each section can optionally store a checksum of its contents.
+ *
+ * This is a cache format, not an interchange format: files written on a platform with a different
+ * endianness or element layout are rejected when read, and the Version is incremented on any layout change.
+ */
+namespace GS::BinaryMeshCache
+{
+
+static constexpr uint32_t FormatVersion = 2;
+static constexpr size_t SectionAlignment = 64;
+
+enum class EContentType : uint32_t
+{
+	OBJFormatData = 1,
+	STLMeshData = 2,
+	DenseMesh = 3
+};
+
+enum class ESection : uint32_t
+{
+	// OBJFormatData
+	HeaderComments = 1,			// string table
+	VertexPositions = 2,		// Vector3d
+	VertexColors = 3,			// Vector3f
+	Normals = 4,				// Vector3d
+	UVs = 5,					// Vector2d
+	TrianglePositions = 6,		// Index3i
+	TriangleNormals = 7,		// Index3i
+	TriangleUVs = 8,			// Index3i
+	QuadPositions = 9,			// Index4i
+	QuadNormals = 10,			// Index4i
+	QuadUVs = 11,				// Index4i
+	PolygonOffsets = 12,		// int64_t
+	PolygonPositions = 13,		// int
+	PolygonNormals = 14,		// int
+	PolygonUVs = 15,			// int
+	FaceStream = 16,			// PackedFace
+	GroupNames = 17,			// string table
+	MaterialNames = 18,			// string table
+
+	// STLMeshData
+	STLHeader = 32,				// char
+	STLTriangles = 33,			// STLReader::STLTriangle
+
+	// DenseMesh
+	MeshPositions = 64,			// Vector3d
+	MeshTriangles = 65,			// Index3i
+	MeshTriGroups = 66,			// int
+	MeshTriVtxUVs = 67,			// 3 x (float u, float v)
+	MeshTriVtxNormals = 68,		// 3 x (float x, float y, float z)
+	MeshTriVtxColors = 69		// 3 x (uint8_t r, g, b, a)
+};
+
+/**
+ * Fixed-layout version of OBJFace stored in the FaceStream section.
+ * TypeAndIndex is (FaceType | FaceIndex << 4).
+ */
+struct GRADIENTSPACEIO_API PackedFace
+{
+	uint32_t TypeAndIndex;
+	uint32_t GroupID;
+};
+
+struct GRADIENTSPACEIO_API FileHeader
+{
+	char Magic[8];					// "GSMCACHE"
+	uint32_t Version;
+	uint32_t ContentType;			// EContentType
+	uint32_t ByteOrderMark;			// 0x01020304 in native byte order
+	uint32_t NumSections;
+	uint32_t Flags;					// FileHeader::FlagChecksums
+	uint32_t Reserved0;
+	uint64_t SectionTableOffset;
+	uint64_t FileSize;
+	uint64_t Reserved[2];
+
+	static constexpr uint32_t FlagChecksums = 1;
+};
+
+struct GRADIENTSPACEIO_API SectionEntry
+{
+	uint32_t SectionID;				// ESection
+	uint32_t ElementSize;
+	uint64_t ElementCount;
+	uint64_t Offset;				// from start of file, multiple of SectionAlignment
+	uint64_t Checksum;				// 0 if the file does not have FlagChecksums
+};
+
+
+struct GRADIENTSPACEIO_API WriteOptions
+{
+	//! if true, a 64-bit checksum of each section is stored, which can be verified on read with ReadOptions::bVerifyChecksums
+	bool bWriteChecksums = true;
+	//! if true, the output file is preallocated and memory-mapped, and sections are copied directly into it. Otherwise it is written with large sequential writes
+	bool bUseMemoryMappedIO = false;
+};
+
+struct GRADIENTSPACEIO_API ReadOptions
+{
+	//! if true, the file is memory-mapped. Otherwise it is read into memory in large blocks
+	bool bUseMemoryMappedIO = true;
+	//! if true, and the file has checksums, the checksum of each section is verified before it is used
+	bool bVerifyChecksums = false;
+};
+
+
+GRADIENTSPACEIO_API
+bool WriteCacheFile(const std::string& Path, const OBJFormatData& OBJData, const WriteOptions& Options = WriteOptions());
+
+GRADIENTSPACEIO_API
+bool WriteCacheFile(const std::string& Path, const STLReader::STLMeshData& STLMesh, const WriteOptions& Options = WriteOptions());
+
+GRADIENTSPACEIO_API
+bool WriteCacheFile(const std::string& Path, const DenseMesh& Mesh, const WriteOptions& Options = WriteOptions());
+
+/**
+ * Read a cache file written by the matching WriteCacheFile(). Returns false if the file cannot be opened,
+ * is not a valid cache file for this platform and FormatVersion, has a different content type, fails
+ * checksum verification, or has inconsistent contents (eg polygon offsets, FaceStream entries or triangle
+ * vertex indices out of range). In that case the output is cleared (OBJFormatData/STLMeshData) or unmodified (DenseMesh).
+ */
+GRADIENTSPACEIO_API
+bool ReadCacheFile(const std::string& Path, OBJFormatData& OBJDataOut, const ReadOptions& Options = ReadOptions());
+
+GRADIENTSPACEIO_API
+bool ReadCacheFile(const std::string& Path, STLReader::STLMeshData& STLMeshOut, const ReadOptions& Options = ReadOptions());
+
+GRADIENTSPACEIO_API
+bool ReadCacheFile(const std::string& Path, DenseMesh& MeshOut, const ReadOptions& Options = ReadOptions());
+
+
+/**
+ * Zero-copy read-only view of a cache file. The file is memory-mapped (unless disabled) and the header
+ * and section table are validated on Open(), after which GetSection() returns pointers directly into the
+ * mapped file. Pointers are valid until Close() or destruction.
+ */
+class GRADIENTSPACEIO_API BinaryMeshCacheView
+{
+public:
+	BinaryMeshCacheView();
+	~BinaryMeshCacheView();
+
+	BinaryMeshCacheView(const BinaryMeshCacheView&) = delete;
+	BinaryMeshCacheView& operator=(const BinaryMeshCacheView&) = delete;
+
+	bool Open(const std::string& Path, const ReadOptions& Options = ReadOptions());
+	void Close();
+
+	bool IsOpen() const { return Header != nullptr; }
+	EContentType GetContentType() const { return (EContentType)Header->ContentType; }
+	bool HasChecksums() const { return (Header->Flags & FileHeader::FlagChecksums) != 0; }
+
+	//! returns null if the section does not exist
+	const SectionEntry* FindSection(ESection Section) const;
+
+	/**
+	 * Returns a pointer to the elements of the section and sets CountOut, or returns null (and CountOut=0)
+	 * if the section does not exist, is empty, or its element size is not sizeof(ElementType)
+	 */
+	template<typename ElementType>
+	const ElementType* GetSection(ESection Section, size_t& CountOut) const
+	{
+		CountOut = 0;
+		const SectionEntry* Entry = FindSection(Section);
+		if (Entry == nullptr || Entry->ElementSize != sizeof(ElementType) || Entry->ElementCount == 0)
+			return nullptr;
+		CountOut = (size_t)Entry->ElementCount;
+		return reinterpret_cast<const ElementType*>(FileData + Entry->Offset);
+	}
+
+	//! returns false if the file has no checksums or the section checksum does not match
+	bool VerifySectionChecksum(const SectionEntry& Entry) const;
+
+protected:
+	std::unique_ptr<MappedFileBuffer> File;
+	const char* FileData = nullptr;
+	const FileHeader* Header = nullptr;
+	const SectionEntry* Sections = nullptr;
+};
+
+
+}  // end namespace GS::BinaryMeshCache
@@ -0,0 +1,80 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#pragma once
+
+#include "GradientspaceIOPlatform.h"
+#include "Mesh/DenseMesh.h"
+#include "MeshIO/OBJFormatData.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * Compact lossy encoding of a DenseMesh, for storage and transfer.
+ *
+ * Positions are quantized to a grid over the bounding box, per-corner normals are octahedral-encoded,
+ * and per-corner UVs are quantized over the UV bounding box. Triangles are (optionally) sorted along a
+ * space-filling curve and vertices are renumbered in order of first use. Each attribute is then written
+ * to its own stream as deltas from a prediction, ie the previous vertex for positions, and the previous
+ * corner of the same vertex for per-corner attributes. Each stream is entropy-coded with an order-0
+ * rANS coder, so the encoding is self-contained and has no external dependencies.
+ *
+ * Decoded meshes have the same triangles, groups and attributes as the source, up to quantization
+ * error, but vertices are renumbered and (if EncodeOptions::bReorderTriangles) triangles are reordered.
+ */
+namespace GS::CompressedMesh
+{
+
+struct GRADIENTSPACEIO_API EncodeOptions
+{
+	//! bits per axis of quantized positions, in [1,30]. Max error per axis is half the grid spacing, ie (bounding-box extent) / (2^PositionBits - 1) / 2
+	int PositionBits = 16;
+	//! bits per component of octahedral-encoded normals, in [2,16]. 0 = normals are not stored
+	int NormalBits = 10;
+	//! bits per component of quantized UVs, in [1,24]. Max error is half the grid spacing over the UV bounding box. 0 = UVs are not stored
+	int UVBits = 12;
+	bool bStoreColors = true;
+	bool bStoreGroups = true;
+
+	//! if true, triangles are sorted along a space-filling curve, so compression does not depend on the input triangle order. Otherwise triangle order is preserved, which compresses better if the input order is already spatially coherent
+	bool bReorderTriangles = true;
+
+	//! number of threads used to entropy-code the attribute streams. Result is identical for any thread count. 0 = use all hardware threads
+	int NumThreads = 1;
+};
+
+struct GRADIENTSPACEIO_API DecodeOptions
+{
+	//! number of threads used to decode the attribute streams. 0 = use all hardware threads
+	int NumThreads = 1;
+};
+
+
+/**
+ * Encode Mesh into EncodedOut. Returns false if Options are out of range, or if any vertex position or
+ * (when UVBits > 0) triangle-vertex UV is inf/NaN, as these cannot be quantized. Zero or non-finite normals are encoded as +Z.
+ */
+GRADIENTSPACEIO_API
+bool EncodeMesh(const DenseMesh& Mesh, std::vector<uint8_t>& EncodedOut, const EncodeOptions& Options = EncodeOptions());
+
+/**
+ * Encode the DenseMesh that OBJFormatDataToDenseMesh() produces from OBJData
+ */
+GRADIENTSPACEIO_API
+bool EncodeMesh(const OBJFormatData& OBJData, std::vector<uint8_t>& EncodedOut, const EncodeOptions& Options = EncodeOptions());
+
+/**
+ * Decode a mesh written by EncodeMesh(). Returns false if the data is truncated or invalid. Attributes
+ * that were not stored are left at their DenseMesh defaults. Decoded normals are unit-length.
+ */
+GRADIENTSPACEIO_API
+bool DecodeMesh(const uint8_t* Data, size_t NumBytes, DenseMesh& MeshOut, const DecodeOptions& Options = DecodeOptions());
+
+
+GRADIENTSPACEIO_API
+bool WriteCompressedMesh(const std::string& Path, const DenseMesh& Mesh, const EncodeOptions& Options = EncodeOptions());
+
+GRADIENTSPACEIO_API
+bool ReadCompressedMesh(const std::string& Path, DenseMesh& MeshOut, const DecodeOptions& Options = DecodeOptions());
+
+
+}  // end namespace GS::CompressedMesh
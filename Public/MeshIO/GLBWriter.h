@@ -0,0 +1,56 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#pragma once
+
+#include "GradientspaceIOPlatform.h"
+#include "Core/BinaryIO.h"
+#include "Mesh/DenseMesh.h"
+
+#include <string>
+
+namespace GS::GLBWriter
+{
+
+struct GRADIENTSPACEIO_API WriteOptions
+{
+	bool bVertexColors = true;
+	bool bNormals = true;
+	bool bUVs = true;
+
+	//! if true, UVs are written as (u, 1-v), ie converted from the bottom-left UV origin of OBJ to the top-left origin of glTF
+	bool bFlipUVs = true;
+
+	//! number of threads used to split vertices and pack the binary buffer. Output is identical for any thread count. 0 = use all hardware threads
+	int NumThreads = 1;
+	//! if true, WriteGLB(Filename,...) writes directly into a memory-mapped output file
+	bool bUseMemoryMappedIO = false;
+};
+
+
+/**
+ * Write Mesh as a binary glTF 2.0 (.glb) file, with a single node and mesh.
+ *
+ * glTF attributes are per-vertex, so each mesh vertex is split into one glTF vertex per distinct set of
+ * triangle-vertex attribute values. The vertex attributes are tightly-packed float POSITION, NORMAL and
+ * TEXCOORD_0 and normalized unsigned-byte COLOR_0 arrays, shared by all primitives. Triangles are sorted
+ * by group, and each triangle group is a separate primitive with its own range of the index array, which
+ * is unsigned short if there are at most 65535 vertices, and unsigned int otherwise.
+ * Normals are normalized as glTF requires, and zero-length normals are written as +Z.
+ *
+ * The file size is computed before anything is written, so the output is written in a single pass.
+ */
+GRADIENTSPACEIO_API
+bool WriteGLB(
+	const std::string& Filename,
+	const DenseMesh& Mesh,
+	const WriteOptions& Options = WriteOptions()
+);
+
+GRADIENTSPACEIO_API
+bool WriteGLB(
+	IBinaryWriter& BinaryWriter,
+	const DenseMesh& Mesh,
+	const WriteOptions& Options = WriteOptions()
+);
+
+
+}
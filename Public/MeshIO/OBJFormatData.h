@@ -29,11 +29,164 @@ struct GRADIENTSPACEIO_API OBJQuad
 	Index4i UVs;
 };
 
+/**
+ * Storage for fixed-size OBJ faces (triangles or quads), as separate position/normal/UV
+ * index arrays. The Normals and UVs arrays are only allocated once a face with normals/UVs
+ * is added, and then have the same size as Positions, with all -1 indices for faces that
+ * do not have them. So files without normals/UVs, or read with those attributes disabled,
+ * only store position indices.
+ */
+template<typename FaceType, typename IndexType, int FaceVertexCount>
+struct OBJFixedFaceList
+{
+	unsafe_vector<IndexType> Positions;
+	unsafe_vector<IndexType> Normals;
+	unsafe_vector<IndexType> UVs;
+
+	size_t size() const { return Positions.size(); }
+	bool HasNormals() const { return Normals.size() > 0; }
+	bool HasUVs() const { return UVs.size() > 0; }
+
+	static IndexType InvalidIndices()
+	{
+		IndexType Result;
+		for (int j = 0; j < FaceVertexCount; ++j)
+			Result[j] = -1;
+		return Result;
+	}
+	static bool IsValid(const IndexType& Indices)
+	{
+		for (int j = 0; j < FaceVertexCount; ++j)
+			if (Indices[j] < 0) return false;
+		return true;
+	}
+
+	//! returns a copy of the face. The copy is const, so that eg Triangles[i].Normals = X does not compile, use set() to modify a face
+	const FaceType operator[](size_t FaceIndex) const
+	{
+		FaceType Face;
+		Face.Positions = Positions[FaceIndex];
+		Face.Normals = (Normals.size() > 0) ? Normals[FaceIndex] : InvalidIndices();
+		Face.UVs = (UVs.size() > 0) ? UVs[FaceIndex] : InvalidIndices();
+		return Face;
+	}
+
+	void clear()
+	{
+		Positions.clear();
+		Normals.clear();
+		UVs.clear();
+	}
+
+	void reserve(size_t NumFaces, bool bNormals, bool bUVs)
+	{
+		Positions.reserve(NumFaces);
+		if (bNormals)
+			Normals.reserve(NumFaces);
+		if (bUVs)
+			UVs.reserve(NumFaces);
+	}
+
+	//! append a face and return its index. FaceNormals and FaceUVs may be null.
+	size_t add(const IndexType& FacePositions, const IndexType* FaceNormals = nullptr, const IndexType* FaceUVs = nullptr)
+	{
+		size_t FaceIndex = Positions.add(FacePositions);
+		add_attribute(Normals, FaceIndex, FaceNormals);
+		add_attribute(UVs, FaceIndex, FaceUVs);
+		return FaceIndex;
+	}
+
+	//! append a face and return its index. Normals/UVs are only stored if they are valid (ie non-negative)
+	size_t add(const FaceType& Face)
+	{
+		return add(Face.Positions,
+			IsValid(Face.Normals) ? &Face.Normals : nullptr,
+			IsValid(Face.UVs) ? &Face.UVs : nullptr);
+	}
+
+	//! replace face FaceIndex (which must be < size()). As in add(), Normals/UVs are allocated for all faces by the first face that has valid values
+	void set(size_t FaceIndex, const FaceType& Face)
+	{
+		Positions[FaceIndex] = Face.Positions;
+		set_attribute(Normals, Positions.size(), FaceIndex, Face.Normals);
+		set_attribute(UVs, Positions.size(), FaceIndex, Face.UVs);
+	}
+
+protected:
+	static void set_attribute(unsafe_vector<IndexType>& Attribute, size_t NumFaces, size_t FaceIndex, const IndexType& FaceValue)
+	{
+		bool bValid = IsValid(FaceValue);
+		if (Attribute.size() == 0)
+		{
+			if (!bValid)
+				return;
+			// first face with this attribute, allocate it for all faces
+			Attribute.resize(NumFaces);
+			for (size_t k = 0; k < NumFaces; ++k)
+				Attribute[k] = InvalidIndices();
+		}
+		Attribute[FaceIndex] = (bValid) ? FaceValue : InvalidIndices();
+	}
+
+	static void add_attribute(unsafe_vector<IndexType>& Attribute, size_t FaceIndex, const IndexType* FaceValue)
+	{
+		if (FaceValue == nullptr && Attribute.size() == 0)
+			return;
+		if (Attribute.size() < FaceIndex)
+		{
+			// first face with this attribute, allocate it for all previous faces
+			size_t PrevCount = Attribute.size();
+			Attribute.resize(FaceIndex);
+			for (size_t k = PrevCount; k < FaceIndex; ++k)
+				Attribute[k] = InvalidIndices();
+		}
+		Attribute.add( (FaceValue != nullptr) ? *FaceValue : InvalidIndices() );
+	}
+};
+
+using OBJTriangleList = OBJFixedFaceList<OBJTriangle, Index3i, 3>;
+using OBJQuadList = OBJFixedFaceList<OBJQuad, Index4i, 4>;
+
+
+/**
+ * View of a single polygon (5+ vertices) in an OBJPolygonList.
+ * Normals and UVs are null if the polygon list has no normals/UVs.
+ */
 struct GRADIENTSPACEIO_API OBJPolygon
 {
-	std::vector<int> Positions;
-	std::vector<int> Normals;
-	std::vector<int> UVs;
+	int NumVertices = 0;
+	const int* Positions = nullptr;
+	const int* Normals = nullptr;
+	const int* UVs = nullptr;
+};
+
+/**
+ * Flat (CSR) storage for OBJ polygons. The vertex indices of polygon i are
+ * [Offsets[i], Offsets[i+1]) in Positions. Offsets are 64-bit, as the total index
+ * count of a large file can exceed the range of int. The Normals and UVs arrays are only
+ * allocated once a polygon with normals/UVs is added, and then have the same
+ * size as Positions, with -1 entries for polygons that do not have them.
+ */
+struct GRADIENTSPACEIO_API OBJPolygonList
+{
+	unsafe_vector<int64_t> Offsets;
+	unsafe_vector<int> Positions;
+	unsafe_vector<int> Normals;
+	unsafe_vector<int> UVs;
+
+	size_t size() const { return (Offsets.size() > 0) ? (Offsets.size() - 1) : 0; }
+	size_t GetIndexCount() const { return Positions.size(); }
+	bool HasNormals() const { return Normals.size() > 0; }
+	bool HasUVs() const { return UVs.size() > 0; }
+
+	int GetVertexCount(size_t PolygonIndex) const { return (int)(Offsets[PolygonIndex+1] - Offsets[PolygonIndex]); }
+	OBJPolygon operator[](size_t PolygonIndex) const;
+
+	void clear();
+	void reserve(size_t NumPolygons, size_t NumIndices, bool bNormals, bool bUVs);
+
+	//! append a polygon and return its index. NormalIndices and UVIndices may be null.
+	size_t add(int NumVertices, const int* PositionIndices, const int* NormalIndices = nullptr, const int* UVIndices = nullptr);
 };
 
 struct GRADIENTSPACEIO_API OBJGroup
@@ -63,9 +216,9 @@ struct GRADIENTSPACEIO_API OBJFormatData
 	unsafe_vector<Vector3d> Normals;
 	unsafe_vector<Vector2d> UVs;
 
-	unsafe_vector<OBJTriangle> Triangles;
-	unsafe_vector<OBJQuad> Quads;
-	unsafe_vector<OBJPolygon> Polygons;
+	OBJTriangleList Triangles;
+	OBJQuadList Quads;
+	OBJPolygonList Polygons;
 
 	// ordered indexing into Triangles/Quads/Polygons
 	unsafe_vector<OBJFace> FaceStream;
@@ -75,11 +228,18 @@ struct GRADIENTSPACEIO_API OBJFormatData
 };
 
 
+struct GRADIENTSPACEIO_API DenseMeshToOBJOptions
+{
+	//! number of threads used to sort triangles by group and deduplicate normals/UVs. Result is identical for any thread count. 0 = use all hardware threads
+	int NumThreads = 1;
+};
+
 /**
- * Convert a DenseMesh to OBJFormatData for writing/export
+ * Convert a DenseMesh to OBJFormatData for writing/export.
+ * Normals and UVs are deduplicated (by exact value), and numbered in order of first use.
  */
 GRADIENTSPACEIO_API
-void DenseMeshToOBJFormatData(const DenseMesh& Mesh, OBJFormatData& OBJDataOut);
+void DenseMeshToOBJFormatData(const DenseMesh& Mesh, OBJFormatData& OBJDataOut, const DenseMeshToOBJOptions& Options = DenseMeshToOBJOptions());
 
 
 struct GRADIENTSPACEIO_API OBJToDenseMeshOptions
@@ -87,6 +247,9 @@ struct GRADIENTSPACEIO_API OBJToDenseMeshOptions
 	bool bIgnoreUVs = false;
 	bool bIgnoreNormals = false;
 	bool bIgnoreColors = false;
+
+	//! number of threads used to fill the DenseMesh. Result is identical for any thread count. 0 = use all hardware threads
+	int NumThreads = 1;
 };
 
 /**
@@ -97,6 +260,23 @@ GRADIENTSPACEIO_API
 void OBJFormatDataToDenseMesh(const OBJFormatData& OBJData, DenseMesh& MeshOut,
 	const OBJToDenseMeshOptions& Options = OBJToDenseMeshOptions());
 
+struct GRADIENTSPACEIO_API OBJToPolyMeshOptions
+{
+	bool bIgnoreUVs = false;
+	bool bIgnoreNormals = false;
+	bool bIgnoreColors = false;
+};
+
+/**
+ * Extract a PolyMesh out of OBJFormatData, preserving Quads and Polygons (ie no tessellation).
+ * Faces are added in FaceStream order, with the OBJ group in face group set 0. Normals/UVs are
+ * copied to set 0 with the OBJ indexing, and vertex colors become per-vertex entries of color set 0.
+ * Missing or invalid attribute indices reference a default element (UnitZ normal, zero UV, white color).
+ */
+GRADIENTSPACEIO_API
+void OBJFormatDataToPolyMesh(const OBJFormatData& OBJData, PolyMesh& MeshOut,
+	const OBJToPolyMeshOptions& Options = OBJToPolyMeshOptions());
+
 /**
  * Convert a PolyMesh to OBJFormatData for writing/export
  */
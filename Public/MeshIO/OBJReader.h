@@ -6,6 +6,7 @@
 #include "MeshIO/OBJFormatData.h"
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 
@@ -19,6 +20,64 @@ struct GRADIENTSPACEIO_API ReadOptions
 	bool bUVs = true;
 
 	bool bEnableMeshmixerTriGroupProcessing = true;
+
+	//! if true, regular files are memory-mapped and parsed in-place. Otherwise (or for pipes/etc) the file is read into memory with buffered reads
+	bool bUseMemoryMappedIO = true;
+
+	//! number of threads used to parse the file. Large files are split into chunks at line boundaries, parsed concurrently and merged in file order. Result is identical to single-threaded parse. 0 = use all hardware threads
+	int NumThreads = 1;
+
+	//! if true, a fast counting pass over the file is done before parsing, and all OBJFormatData arrays are reserved to their final size. This avoids repeated reallocation (and the associated peak memory) during parsing of large files.
+	bool bPreScanForCapacity = false;
+
+	//! if true, the file is read in large blocks on a background thread while previously-read blocks are parsed, so that I/O and parsing overlap (useful for network or cold-cache storage). Parsing is single-threaded in this mode, and bUseMemoryMappedIO/bPreScanForCapacity/NumThreads are ignored. Not used by ReadOBJToDenseMesh.
+	bool bUseAsyncReadAhead = false;
+	//! size in bytes of the blocks read by bUseAsyncReadAhead
+	size_t ReadAheadBlockSize = 4 << 20;
+	//! number of blocks in the bUseAsyncReadAhead buffer ring, ie up to (ReadAheadQueueDepth-1) blocks are read ahead of the parser
+	int ReadAheadQueueDepth = 3;
+
+	//! if non-empty, parse results are cached in this directory and reused while the source file is unchanged (see ParseResultCache.h)
+	std::string CacheDirectory;
+	//! maximum total size of the entries in CacheDirectory, least-recently-used entries are evicted when a new entry is stored. 0 = no limit
+	uint64_t MaxCacheSizeBytes = 0;
+	//! if true, cache entries are identified by a hash of sampled blocks of the source file, rather than all of it. Faster for large files, but in-place edits outside the sampled blocks are not detected (see ParseResultCache.h)
+	bool bCacheSampledContentHash = false;
+};
+
+
+/**
+ * Element counts of an OBJ file, as computed by a fast line-type scan (see ProbeOBJ).
+ * Counts correspond to what ReadOBJ would store in OBJFormatData with all attributes enabled.
+ */
+struct GRADIENTSPACEIO_API OBJFileStats
+{
+	size_t FileSizeBytes = 0;
+
+	size_t NumVertexPositions = 0;
+	size_t NumNormals = 0;
+	size_t NumUVs = 0;
+
+	size_t NumTriangles = 0;
+	size_t NumQuads = 0;
+	size_t NumPolygons = 0;
+	//! total number of vertices of all faces in NumPolygons
+	size_t NumPolygonIndices = 0;
+
+	size_t NumGroupLines = 0;
+	size_t NumCommentLines = 0;
+
+	//! true if the first vertex line has more than 3 values (ie vertex colors)
+	bool bHaveVertexColors = false;
+	//! true if any face references normals
+	bool bHaveFaceNormals = false;
+	//! true if any face references UVs
+	bool bHaveFaceUVs = false;
+
+	size_t GetFaceCount() const { return NumTriangles + NumQuads + NumPolygons; }
+
+	//! approximate size in bytes of the OBJFormatData that ReadOBJ would return for this file with the given Options
+	size_t EstimateMemoryUsage(const ReadOptions& Options = ReadOptions()) const;
 };
 
 
@@ -30,4 +89,84 @@ bool ReadOBJ(
 );
 
 
+/**
+ * Read the OBJ file at Path directly into MeshOut, without storing an intermediate OBJFormatData.
+ * A fast counting pass is done first so that MeshOut can be allocated with its final size.
+ * The result is identical to ReadOBJ() followed by OBJFormatDataToDenseMesh(), with much lower peak memory.
+ * Options.NumThreads is only used for the counting pass.
+ */
+GRADIENTSPACEIO_API
+bool ReadOBJToDenseMesh(
+	const std::string& Path,
+	DenseMesh& MeshOut,
+	const ReadOptions& Options = ReadOptions(),
+	const OBJToDenseMeshOptions& MeshOptions = OBJToDenseMeshOptions()
+);
+
+
+/**
+ * Vertex event of IOBJVisitor. Color is only valid if bHaveColor is true.
+ */
+struct GRADIENTSPACEIO_API OBJVertex
+{
+	Vector3d Position;
+	Vector3f Color;
+	bool bHaveColor = false;
+};
+
+/**
+ * Visitor/callback interface for streaming through an OBJ file without storing it (see VisitOBJ).
+ * Events are delivered in file order. Consecutive vertices, normals, UVs and faces are
+ * delivered in batches, so the virtual call overhead is amortized over many elements.
+ * Pointers passed to the event functions are only valid for the duration of the call.
+ */
+class GRADIENTSPACEIO_API IOBJVisitor
+{
+public:
+	virtual ~IOBJVisitor() {}
+
+	virtual void OnVertices(const OBJVertex* /*Vertices*/, size_t /*Count*/) {}
+	virtual void OnNormals(const Vector3d* /*Normals*/, size_t /*Count*/) {}
+	virtual void OnUVs(const Vector2d* /*UVs*/, size_t /*Count*/) {}
+
+	//! Face vertex indices are 0-based. Normals/UVs of a face are null if the face (or the parse options) does not include them
+	virtual void OnFaces(const OBJPolygon* /*Faces*/, size_t /*Count*/) {}
+
+	//! 'g' line. GroupName is the rest of the line after the 'g'
+	virtual void OnGroup(std::string_view /*GroupName*/) {}
+	//! 'usemtl' line
+	virtual void OnMaterial(std::string_view /*MaterialName*/) {}
+	//! full comment line, including the leading '#'
+	virtual void OnComment(std::string_view /*Comment*/) {}
+	//! any other non-empty line (mtllib, o, s, etc)
+	virtual void OnOtherLine(std::string_view /*Line*/) {}
+	//! Count vn/vt lines were not parsed because Options.bNormals/bUVs is false. Reported after the vertex/normal/UV/face batch they occurred in, and before the next unbatched event
+	virtual void OnSkippedLines(size_t /*Count*/) {}
+};
+
+/**
+ * Parse the OBJ file at Path and pass its contents to Visitor, without storing them.
+ * Options.bNormals/bUVs/bVertexColors control which attributes are parsed, Options.NumThreads is ignored.
+ */
+GRADIENTSPACEIO_API
+bool VisitOBJ(
+	const std::string& Path,
+	IOBJVisitor& Visitor,
+	const ReadOptions& Options = ReadOptions()
+);
+
+
+/**
+ * Count the lines of each type (and the face sizes) in an OBJ file, without parsing any
+ * numeric values. This is much cheaper than ReadOBJ and can be used to estimate memory
+ * requirements before loading a file. Options.bUseMemoryMappedIO and Options.NumThreads are used.
+ */
+GRADIENTSPACEIO_API
+bool ProbeOBJ(
+	const std::string& Path,
+	OBJFileStats& StatsOut,
+	const ReadOptions& Options = ReadOptions()
+);
+
+
 }  // end namespace GS::OBJReader
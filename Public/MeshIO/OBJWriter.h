@@ -5,6 +5,7 @@
 #include "Core/TextIO.h"
 #include "Mesh/DenseMesh.h"
 #include "MeshIO/OBJFormatData.h"
+#include "MeshIO/TextFormatOptions.h"
 
 #include <string>
 
@@ -19,6 +20,12 @@ struct GRADIENTSPACEIO_API WriteOptions
 
 	//! if true, triangle orientation will be inverted on write (by swapping A and B in each tri)
 	bool bReverseTriOrientation = false;
+
+	//! how positions, normals, UVs and colors are converted to text. Default is 6 fixed digits, ie printf("%f")
+	RealFormatOptions RealFormat;
+
+	//! number of threads used to sort/deduplicate attributes and format text. Output is identical for any thread count. 0 = use all hardware threads
+	int NumThreads = 1;
 };
 
 GRADIENTSPACEIO_API
@@ -0,0 +1,113 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#pragma once
+
+#include "GradientspaceIOPlatform.h"
+#include "Mesh/DenseMesh.h"
+#include "Mesh/PolyMesh.h"
+
+#include <string>
+#include <vector>
+
+namespace GS::PLYReader
+{
+
+enum class EPLYFormat
+{
+	ASCII = 0,
+	BinaryLittleEndian = 1,
+	BinaryBigEndian = 2
+};
+
+enum class EPLYPropertyType
+{
+	Int8 = 0,		// char
+	UInt8 = 1,		// uchar
+	Int16 = 2,		// short
+	UInt16 = 3,		// ushort
+	Int32 = 4,		// int
+	UInt32 = 5,		// uint
+	Float32 = 6,	// float
+	Float64 = 7		// double
+};
+
+struct GRADIENTSPACEIO_API PLYProperty
+{
+	std::string Name;
+	EPLYPropertyType Type = EPLYPropertyType::Float32;
+	//! if true, the property is a list of Type values, preceded by a count of type ListCountType
+	bool bIsList = false;
+	EPLYPropertyType ListCountType = EPLYPropertyType::UInt8;
+};
+
+struct GRADIENTSPACEIO_API PLYElement
+{
+	std::string Name;
+	uint64_t Count = 0;
+	std::vector<PLYProperty> Properties;
+};
+
+struct GRADIENTSPACEIO_API PLYHeader
+{
+	EPLYFormat Format = EPLYFormat::ASCII;
+	std::vector<std::string> Comments;
+	std::vector<PLYElement> Elements;
+	//! offset in bytes of the element data, ie the first byte after the end_header line
+	size_t DataOffset = 0;
+};
+
+
+struct GRADIENTSPACEIO_API ReadOptions
+{
+	//! if true, the file is memory-mapped and element records are decoded directly from the mapping. Otherwise (or for pipes/etc) the file is read into memory in large blocks
+	bool bUseMemoryMappedIO = true;
+
+	//! number of threads used to decode vertex and face records. Result is identical for any thread count. 0 = use all hardware threads
+	int NumThreads = 1;
+
+	bool bIgnoreNormals = false;
+	bool bIgnoreUVs = false;
+	bool bIgnoreColors = false;
+};
+
+
+/**
+ * Parse the header of a PLY file. Returns false if the file cannot be opened or the header is invalid.
+ */
+GRADIENTSPACEIO_API
+bool ReadPLYHeader(
+	const std::string& Path,
+	PLYHeader& HeaderOut
+);
+
+/**
+ * Read an ASCII or binary (little- or big-endian) PLY file into a DenseMesh.
+ *
+ * Positions are read from the vertex x/y/z properties, and faces from the vertex_indices (or vertex_index)
+ * list of the face element. Faces with more than 3 vertices are tessellated as a fan, ie tris (0,1,2), (0,2,3), ...
+ * Vertex normals (nx/ny/nz), UVs (u/v, s/t or texture_u/texture_v) and colors (red/green/blue/alpha, as
+ * uchar in [0,255] or real in [0,1]) are copied to every triangle-vertex of the vertex, and per-face-vertex
+ * UVs in a face texcoord list replace the vertex UVs. Other elements and properties are skipped.
+ *
+ * Returns false if the file cannot be read, is truncated, or a face references a vertex that does not exist.
+ */
+GRADIENTSPACEIO_API
+bool ReadPLY(
+	const std::string& Path,
+	DenseMesh& MeshOut,
+	const ReadOptions& Options = ReadOptions()
+);
+
+/**
+ * Read a PLY file into a PolyMesh, preserving quads and polygons. Vertex normals, UVs and colors are stored
+ * in attribute set 0 with one element per vertex, or per face-vertex for a face texcoord list.
+ * Faces with less than 3 vertices are skipped. Return value is the same as the DenseMesh version.
+ */
+GRADIENTSPACEIO_API
+bool ReadPLY(
+	const std::string& Path,
+	PolyMesh& MeshOut,
+	const ReadOptions& Options = ReadOptions()
+);
+
+
+}
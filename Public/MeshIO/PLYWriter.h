@@ -0,0 +1,66 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#pragma once
+
+#include "GradientspaceIOPlatform.h"
+#include "Core/TextIO.h"
+#include "Core/BinaryIO.h"
+#include "Mesh/DenseMesh.h"
+#include "MeshIO/TextFormatOptions.h"
+
+#include <string>
+
+namespace GS::PLYWriter
+{
+
+struct GRADIENTSPACEIO_API WriteOptions
+{
+	//! if true, WritePLY(Filename,...) writes binary_little_endian PLY, otherwise ASCII
+	bool bWriteBinary = true;
+
+	bool bVertexColors = true;
+	bool bNormals = true;
+	bool bUVs = true;
+
+	//! how positions, normals and UVs are converted to text in ASCII PLY. Default is 6 fixed digits, ie printf("%f")
+	RealFormatOptions RealFormat;
+
+	//! number of threads used to split vertices and pack/format vertex and face records. Output is identical for any thread count. 0 = use all hardware threads
+	int NumThreads = 1;
+	//! if true, WritePLY(Filename,...) writes binary PLY directly into a memory-mapped output file
+	bool bUseMemoryMappedIO = false;
+};
+
+
+/**
+ * Write Mesh as a PLY file with a vertex element (float x/y/z, and optionally float nx/ny/nz, float s/t and
+ * uchar red/green/blue/alpha) and a face element (list uchar int vertex_indices).
+ *
+ * PLY attributes are per-vertex, so if any attributes are written, each mesh vertex is split into one PLY
+ * vertex per distinct set of triangle-vertex attribute values. Vertices not used by any triangle are
+ * written with zero normal/UV and white color.
+ */
+GRADIENTSPACEIO_API
+bool WritePLY(
+	const std::string& Filename,
+	const DenseMesh& Mesh,
+	const WriteOptions& Options = WriteOptions()
+);
+
+//! write ASCII PLY, ignores Options.bWriteBinary
+GRADIENTSPACEIO_API
+bool WritePLY(
+	ITextWriter& TextWriter,
+	const DenseMesh& Mesh,
+	const WriteOptions& Options = WriteOptions()
+);
+
+//! write binary_little_endian PLY, ignores Options.bWriteBinary
+GRADIENTSPACEIO_API
+bool WritePLY(
+	IBinaryWriter& BinaryWriter,
+	const DenseMesh& Mesh,
+	const WriteOptions& Options = WriteOptions()
+);
+
+
+}
@@ -0,0 +1,63 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#pragma once
+
+#include "GradientspaceIOPlatform.h"
+
+#include <cstdint>
+#include <string>
+
+/**
+ * On-disk cache of parse results, used by OBJReader::ReadOBJ() and STLReader::ReadSTL() when
+ * ReadOptions::CacheDirectory is set. Entries are BinaryMeshCache files, named by a 128-bit hash of
+ * the source file path, size, modification time, a hash of the file contents and the result-affecting read options.
+ * By default the content hash covers the whole file, which costs a full read of the source on each lookup
+ * (but no parsing). A sampled content hash (the first and last 64K, and 14 evenly-spaced 64K blocks in between)
+ * can be used instead, which makes lookups of large files much cheaper, but then a file that is modified in
+ * place outside the sampled blocks, without a change in size or modification time, returns a stale entry.
+ *
+ * Entries are loaded with checksum verification and content validation, so a corrupt entry is treated as a miss.
+ *
+ * On a miss the source is parsed and the entry is written to a temporary file in the cache directory,
+ * which is then renamed to the entry name, so concurrent readers (and writers of the same entry) never
+ * see a partially-written entry. The modification time of an entry is updated on each hit, and is used
+ * for least-recently-used eviction when a size limit is set.
+ */
+namespace GS::ParseResultCache
+{
+
+struct GRADIENTSPACEIO_API CacheStatistics
+{
+	//! number of reads that were loaded from the cache
+	uint64_t Hits = 0;
+	//! number of reads that had to parse the source file
+	uint64_t Misses = 0;
+	//! number of entries written to the cache
+	uint64_t Stores = 0;
+	//! number of entries removed by size-limit eviction
+	uint64_t Evictions = 0;
+};
+
+//! process-wide counters for all cache directories
+GRADIENTSPACEIO_API
+CacheStatistics GetStatistics();
+
+GRADIENTSPACEIO_API
+void ResetStatistics();
+
+/**
+ * Compute the path of the cache entry for SourcePath in CacheDirectory, and create CacheDirectory if necessary.
+ * OptionsKey must uniquely identify the read options that affect the parse result. If bSampledContentHash
+ * is true, only sampled blocks of the source file are hashed (see above), otherwise the whole file is.
+ * Returns false if the source file cannot be read or the cache directory cannot be created.
+ */
+GRADIENTSPACEIO_API
+bool GetCacheEntryPath(const std::string& CacheDirectory, const std::string& SourcePath, const std::string& OptionsKey, std::string& EntryPathOut,
+	bool bSampledContentHash = false);
+
+/**
+ * Remove the least-recently-used entries of CacheDirectory until the total size of its entries is at most MaxSizeBytes
+ */
+GRADIENTSPACEIO_API
+void TrimCacheDirectory(const std::string& CacheDirectory, uint64_t MaxSizeBytes);
+
+}  // end namespace GS::ParseResultCache
@@ -31,21 +31,67 @@ struct GRADIENTSPACEIO_API STLMeshData
 };
 
 
+struct GRADIENTSPACEIO_API ReadOptions
+{
+	//! if true, binary STL files are memory-mapped and unpacked directly. Otherwise (or for pipes/etc) the file is read into memory in large blocks
+	bool bUseMemoryMappedIO = true;
+
+	//! if true, ASCII STL files are read in large blocks on a background thread while previously-read blocks are parsed, so that I/O and parsing overlap
+	bool bUseAsyncReadAhead = true;
+	//! size in bytes of the blocks read by bUseAsyncReadAhead
+	size_t ReadAheadBlockSize = 4 << 20;
+	//! number of blocks in the bUseAsyncReadAhead buffer ring, ie up to (ReadAheadQueueDepth-1) blocks are read ahead of the parser
+	int ReadAheadQueueDepth = 3;
+
+	//! number of threads used to parse ASCII STL. Large files are split into chunks at facet boundaries, parsed concurrently and concatenated in order. Result is identical to single-threaded parse. If > 1, the file is always memory-mapped (bUseAsyncReadAhead is ignored). 0 = use all hardware threads
+	int NumThreads = 1;
+
+	//! if non-empty, parse results are cached in this directory and reused while the source file is unchanged (see ParseResultCache.h)
+	std::string CacheDirectory;
+	//! maximum total size of the entries in CacheDirectory, least-recently-used entries are evicted when a new entry is stored. 0 = no limit
+	uint64_t MaxCacheSizeBytes = 0;
+	//! if true, cache entries are identified by a hash of sampled blocks of the source file, rather than all of it. Faster for large files, but in-place edits outside the sampled blocks are not detected (see ParseResultCache.h)
+	bool bCacheSampledContentHash = false;
+};
+
+
+/**
+ * Read an ASCII or binary STL file. Binary files whose size does not match the triangle count
+ * in the header are considered truncated: the complete triangles are returned in STLMeshOut,
+ * but the function returns false.
+ */
 GRADIENTSPACEIO_API
 bool ReadSTL(
 	const std::string& Path,
-	STLMeshData& STLMeshOut
+	STLMeshData& STLMeshOut,
+	const ReadOptions& Options = ReadOptions()
 );
 
 
 
 
+struct GRADIENTSPACEIO_API STLToDenseMeshOptions
+{
+	//! if false, each STL triangle gets 3 unique vertices (ie a triangle soup). If true, corners with matching positions share a single vertex
+	bool bWeldVertices = false;
+	/**
+	 * If > 0, positions are quantized to a grid with this spacing before matching, ie positions that round to the same grid point are welded. If 0, only exactly-equal positions are welded.
+	 * Welding uses 32-bit grid coordinates if max|coordinate| / WeldTolerance is below 2^30, and otherwise 64-bit grid coordinates (slower, and more temporary memory).
+	 * Coordinates beyond 2^62 grid steps, and inf/NaN coordinates, are only welded if exactly equal. At that magnitude the float spacing is at least 2^39 grid steps, so this is the same result as rounding.
+	 */
+	double WeldTolerance = 0;
+	//! number of threads used for welding. Result is identical for any thread count. 0 = use all hardware threads
+	int NumThreads = 1;
+};
+
 /**
- * Extract a DenseMesh out of OBJFormatData.
- * Currently Quads and Polygons are tessellated strictly topologically, ie tris (0,1,2), (0,2,3), ...
+ * Extract a DenseMesh out of STLMeshData.
+ * If Options.bWeldVertices, welded vertices are numbered in order of their first corner in the
+ * triangle list, and keep the position of that corner. Triangles that become degenerate are not removed.
  */
 GRADIENTSPACEIO_API
-void STLMeshToDenseMesh(const STLMeshData& STLMesh, DenseMesh& MeshOut);
+void STLMeshToDenseMesh(const STLMeshData& STLMesh, DenseMesh& MeshOut,
+	const STLToDenseMeshOptions& Options = STLToDenseMeshOptions());
 
 
 
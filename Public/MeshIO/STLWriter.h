@@ -5,19 +5,29 @@
 #include "Core/TextIO.h"
 #include "Core/BinaryIO.h"
 #include "Mesh/DenseMesh.h"
+#include "MeshIO/TextFormatOptions.h"
 
 #include <string>
 
 namespace GS::STLWriter
 {
 
+struct GRADIENTSPACEIO_API BinaryWriteOptions
+{
+	//! number of threads used to compute normals and pack triangle records. 0 = use all hardware threads
+	int NumThreads = 1;
+	//! if true, WriteSTL(Filename,...) writes binary STL directly into a memory-mapped output file
+	bool bUseMemoryMappedIO = false;
+};
+
 
 GRADIENTSPACEIO_API
 bool WriteSTL(
 	const std::string& Filename,
 	const DenseMesh& Mesh,
 	const std::string& MeshName = "mesh",
-	bool bWriteBinary = true
+	bool bWriteBinary = true,
+	const BinaryWriteOptions& BinaryOptions = BinaryWriteOptions()
 );
 
 
@@ -25,14 +35,16 @@ GRADIENTSPACEIO_API
 bool WriteSTL(
 	ITextWriter& TextWriter,
 	const DenseMesh& Mesh,
-	const std::string& MeshName = "mesh"
+	const std::string& MeshName = "mesh",
+	const RealFormatOptions& RealFormat = RealFormatOptions()
 );
 
 
 GRADIENTSPACEIO_API
 bool WriteSTL(
 	IBinaryWriter& BinaryWriter,
-	const DenseMesh& Mesh
+	const DenseMesh& Mesh,
+	const BinaryWriteOptions& BinaryOptions = BinaryWriteOptions()
 );
 
 
@@ -0,0 +1,27 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#pragma once
+
+#include "GradientspaceIOPlatform.h"
+
+namespace GS
+{
+
+//! how real-valued numbers are converted to text by the text-format mesh writers
+enum class ERealPrecisionMode
+{
+	//! write FixedDigits digits after the decimal point, ie the same as printf("%.6f") for the default of 6 digits
+	FixedDigits = 0,
+	//! write the shortest string that parses back to exactly the same value. Values stored as float are written with float precision
+	ShortestRoundTrip = 1,
+	//! write the shortest string that parses back to the same value after conversion to 32-bit float
+	Float32 = 2
+};
+
+struct GRADIENTSPACEIO_API RealFormatOptions
+{
+	ERealPrecisionMode Mode = ERealPrecisionMode::FixedDigits;
+	//! number of digits after the decimal point for ERealPrecisionMode::FixedDigits, clamped to [0,32]
+	int FixedDigits = 6;
+};
+
+}
@@ -0,0 +1,256 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#if defined(GSIO_TEST_BUILD)
+
+#include "MeshIO/CompressedMesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+using namespace GS;
+
+/**
+ * Round-trip tests for CompressedMesh::EncodeMesh/DecodeMesh. Checks that the decoded attributes are
+ * within the quantization error bounds documented in EncodeOptions, and that truncated or inconsistent
+ * encodings and non-finite positions/UVs are rejected. Returns nonzero if any check fails.
+ */
+
+static int NumFailures = 0;
+
+#define GSIO_TEST_CHECK(Condition, ...) \
+	do { if (!(Condition)) { NumFailures++; printf("FAILED (line %d): ", __LINE__); printf(__VA_ARGS__); printf("\n"); } } while(0)
+
+
+// NumU x NumV torus with a UV seam, per-vertex normals and colors, and one group per quarter
+static void make_torus(int NumU, int NumV, DenseMesh& MeshOut)
+{
+	const double R = 10.0, r = 3.0, TwoPi = 6.283185307179586;
+	MeshOut.Resize(NumU * NumV, 2 * NumU * NumV);
+	std::vector<Vector3f> Normals(NumU * NumV);
+	for (int i = 0; i < NumU; ++i) {
+		double u = TwoPi * (double)i / (double)NumU;
+		for (int j = 0; j < NumV; ++j) {
+			double v = TwoPi * (double)j / (double)NumV;
+			MeshOut.SetPosition(i * NumV + j, Vector3d((R + r * std::cos(v)) * std::cos(u), (R + r * std::cos(v)) * std::sin(u), r * std::sin(v)));
+			Normals[i * NumV + j] = Vector3f((float)(std::cos(v) * std::cos(u)), (float)(std::cos(v) * std::sin(u)), (float)std::sin(v));
+		}
+	}
+	int ti = 0;
+	for (int i = 0; i < NumU; ++i) {
+		for (int j = 0; j < NumV; ++j) {
+			int CellI[4] = { i, i + 1, i + 1, i };
+			int CellJ[4] = { j, j, j + 1, j + 1 };
+			const int TriCorners[2][3] = { {0, 1, 2}, {0, 2, 3} };
+			for (int k = 0; k < 2; ++k) {
+				Index3i Tri;
+				TriVtxUVs UVs; TriVtxNormals TriNormals; TriVtxColors Colors;
+				for (int m = 0; m < 3; ++m) {
+					int Corner = TriCorners[k][m];
+					int Vertex = (CellI[Corner] % NumU) * NumV + (CellJ[Corner] % NumV);
+					Tri[m] = Vertex;
+					UVs[m] = Vector2f((float)CellI[Corner] / (float)NumU, (float)CellJ[Corner] / (float)NumV);
+					TriNormals[m] = Normals[Vertex];
+					Colors[m] = Color4b((uint8_t)(CellI[Corner] * 255 / NumU), (uint8_t)(CellJ[Corner] * 255 / NumV), (uint8_t)(ti % 256), 255);
+				}
+				MeshOut.SetTriangle(ti, Tri);
+				MeshOut.SetTriGroup(ti, (i * 4) / NumU);
+				MeshOut.SetTriVtxUVs(ti, UVs);
+				MeshOut.SetTriVtxNormals(ti, TriNormals);
+				MeshOut.SetTriVtxColors(ti, Colors);
+				ti++;
+			}
+		}
+	}
+}
+
+static double angle_between(const Vector3f& A, const Vector3f& B)
+{
+	double LengthA = std::sqrt((double)A.X * A.X + (double)A.Y * A.Y + (double)A.Z * A.Z);
+	double LengthB = std::sqrt((double)B.X * B.X + (double)B.Y * B.Y + (double)B.Z * B.Z);
+	double CosAngle = ((double)A.X * B.X + (double)A.Y * B.Y + (double)A.Z * B.Z) / (LengthA * LengthB);
+	return std::acos(std::clamp(CosAngle, -1.0, 1.0));
+}
+
+
+static void test_round_trip_bounds(const DenseMesh& Mesh, int PositionBits, int NormalBits, int UVBits)
+{
+	CompressedMesh::EncodeOptions EncodeOptions;
+	EncodeOptions.PositionBits = PositionBits;
+	EncodeOptions.NormalBits = NormalBits;
+	EncodeOptions.UVBits = UVBits;
+	EncodeOptions.bReorderTriangles = false;		// so that triangle IDs can be compared directly
+	std::vector<uint8_t> Encoded;
+	GSIO_TEST_CHECK(CompressedMesh::EncodeMesh(Mesh, Encoded, EncodeOptions), "EncodeMesh %d/%d/%d bits", PositionBits, NormalBits, UVBits);
+
+	DenseMesh Decoded;
+	bool bDecoded = CompressedMesh::DecodeMesh(Encoded.data(), Encoded.size(), Decoded);
+	GSIO_TEST_CHECK(bDecoded, "DecodeMesh %d/%d/%d bits", PositionBits, NormalBits, UVBits);
+	if (!bDecoded || Decoded.GetTriangleCount() != Mesh.GetTriangleCount() || Decoded.GetVertexCount() != Mesh.GetVertexCount()) {
+		GSIO_TEST_CHECK(false, "decoded mesh size does not match");
+		return;
+	}
+
+	// max error per axis is half the grid spacing, see EncodeOptions
+	double BoundsMin[3] = { INFINITY, INFINITY, INFINITY }, BoundsMax[3] = { -INFINITY, -INFINITY, -INFINITY };
+	for (int vid = 0; vid < Mesh.GetVertexCount(); ++vid) {
+		Vector3d Position = Mesh.GetPosition(vid);
+		double Values[3] = { Position.X, Position.Y, Position.Z };
+		for (int k = 0; k < 3; ++k) {
+			BoundsMin[k] = std::min(BoundsMin[k], Values[k]);
+			BoundsMax[k] = std::max(BoundsMax[k], Values[k]);
+		}
+	}
+	double MaxPositionError[3];
+	for (int k = 0; k < 3; ++k)
+		MaxPositionError[k] = 0.5 * (BoundsMax[k] - BoundsMin[k]) / (double)((1ull << PositionBits) - 1) + 1e-9;
+
+	// octahedral components have error <= 1/(2^NormalBits-1). This moves the point on the octahedron by
+	// at most sqrt(6) times that, and the octahedron is at least 1/sqrt(3) from the origin
+	double MaxNormalAngle = 3.0 * std::sqrt(2.0) / (double)((1 << NormalBits) - 1) + 1e-5;
+
+	float UVMin[2] = { INFINITY, INFINITY }, UVMax[2] = { -INFINITY, -INFINITY };
+	for (int tid = 0; tid < Mesh.GetTriangleCount(); ++tid) {
+		TriVtxUVs UVs = Mesh.GetTriVtxUVs(tid);
+		for (int j = 0; j < 3; ++j) {
+			UVMin[0] = std::min(UVMin[0], UVs[j].X); UVMax[0] = std::max(UVMax[0], UVs[j].X);
+			UVMin[1] = std::min(UVMin[1], UVs[j].Y); UVMax[1] = std::max(UVMax[1], UVs[j].Y);
+		}
+	}
+	double MaxUVError[2];
+	for (int c = 0; c < 2; ++c)
+		MaxUVError[c] = 0.5 * (double)(UVMax[c] - UVMin[c]) / (double)((1ull << UVBits) - 1) + 1e-6;
+
+	double PositionError = 0, NormalAngle = 0, UVError = 0;
+	bool bPositionsOK = true, bNormalsOK = true, bUVsOK = true, bColorsOK = true, bGroupsOK = true;
+	for (int tid = 0; tid < Mesh.GetTriangleCount(); ++tid)
+	{
+		Index3i SourceTri = Mesh.GetTriangle(tid), DecodedTri = Decoded.GetTriangle(tid);
+		TriVtxNormals SourceNormals = Mesh.GetTriVtxNormals(tid), DecodedNormals = Decoded.GetTriVtxNormals(tid);
+		TriVtxUVs SourceUVs = Mesh.GetTriVtxUVs(tid), DecodedUVs = Decoded.GetTriVtxUVs(tid);
+		TriVtxColors SourceColors = Mesh.GetTriVtxColors(tid), DecodedColors = Decoded.GetTriVtxColors(tid);
+		for (int j = 0; j < 3; ++j)
+		{
+			Vector3d A = Mesh.GetPosition(SourceTri[j]), B = Decoded.GetPosition(DecodedTri[j]);
+			double Errors[3] = { std::abs(A.X - B.X), std::abs(A.Y - B.Y), std::abs(A.Z - B.Z) };
+			for (int k = 0; k < 3; ++k) {
+				PositionError = std::max(PositionError, Errors[k]);
+				bPositionsOK = bPositionsOK && (Errors[k] <= MaxPositionError[k]);
+			}
+
+			double Angle = angle_between(SourceNormals[j], DecodedNormals[j]);
+			NormalAngle = std::max(NormalAngle, Angle);
+			bNormalsOK = bNormalsOK && (Angle <= MaxNormalAngle);
+
+			double UVErrors[2] = { std::abs((double)SourceUVs[j].X - DecodedUVs[j].X), std::abs((double)SourceUVs[j].Y - DecodedUVs[j].Y) };
+			for (int c = 0; c < 2; ++c) {
+				UVError = std::max(UVError, UVErrors[c]);
+				bUVsOK = bUVsOK && (UVErrors[c] <= MaxUVError[c]);
+			}
+
+			bColorsOK = bColorsOK && SourceColors[j].R == DecodedColors[j].R && SourceColors[j].G == DecodedColors[j].G
+				&& SourceColors[j].B == DecodedColors[j].B && SourceColors[j].A == DecodedColors[j].A;
+		}
+		bGroupsOK = bGroupsOK && (Mesh.GetTriGroup(tid) == Decoded.GetTriGroup(tid));
+	}
+	GSIO_TEST_CHECK(bPositionsOK, "%d position bits: max error %g, bound %g", PositionBits, PositionError, MaxPositionError[0]);
+	GSIO_TEST_CHECK(bNormalsOK, "%d normal bits: max angle %g, bound %g", NormalBits, NormalAngle, MaxNormalAngle);
+	GSIO_TEST_CHECK(bUVsOK, "%d UV bits: max error %g, bound %g", UVBits, UVError, MaxUVError[0]);
+	GSIO_TEST_CHECK(bColorsOK, "colors are not identical");
+	GSIO_TEST_CHECK(bGroupsOK, "groups are not identical");
+
+	// result does not depend on the number of decode threads
+	CompressedMesh::DecodeOptions DecodeOptions;
+	DecodeOptions.NumThreads = 4;
+	DenseMesh DecodedParallel;
+	bool bParallelOK = CompressedMesh::DecodeMesh(Encoded.data(), Encoded.size(), DecodedParallel, DecodeOptions);
+	for (int tid = 0; tid < Mesh.GetTriangleCount() && bParallelOK; ++tid) {
+		TriVtxNormals A = Decoded.GetTriVtxNormals(tid), B = DecodedParallel.GetTriVtxNormals(tid);
+		TriVtxUVs UVA = Decoded.GetTriVtxUVs(tid), UVB = DecodedParallel.GetTriVtxUVs(tid);
+		for (int j = 0; j < 3; ++j)
+			bParallelOK = bParallelOK && A[j].X == B[j].X && A[j].Y == B[j].Y && A[j].Z == B[j].Z && UVA[j].X == UVB[j].X && UVA[j].Y == UVB[j].Y;
+	}
+	GSIO_TEST_CHECK(bParallelOK, "4-thread DecodeMesh does not match 1-thread result");
+}
+
+
+static void test_invalid_data_rejected(const DenseMesh& Mesh)
+{
+	std::vector<uint8_t> Encoded;
+	CompressedMesh::EncodeMesh(Mesh, Encoded);
+
+	// every truncation must fail, rather than read past the end
+	int NumAccepted = 0;
+	for (size_t NumBytes = 0; NumBytes < Encoded.size(); NumBytes += std::max(Encoded.size() / 200, (size_t)1)) {
+		std::vector<uint8_t> Truncated(Encoded.begin(), Encoded.begin() + NumBytes);
+		DenseMesh Decoded;
+		if (CompressedMesh::DecodeMesh(Truncated.data(), Truncated.size(), Decoded))
+			NumAccepted++;
+	}
+	GSIO_TEST_CHECK(NumAccepted == 0, "%d truncated encodings were accepted", NumAccepted);
+
+	// header vertex/triangle counts (at bytes 8 and 12) that are much larger than the streams can hold
+	// must be rejected before the mesh is allocated
+	std::vector<uint8_t> Inflated = Encoded;
+	uint32_t HugeCount = 1u << 30;
+	memcpy(&Inflated[8], &HugeCount, sizeof(HugeCount));
+	memcpy(&Inflated[12], &HugeCount, sizeof(HugeCount));
+	DenseMesh Decoded;
+	GSIO_TEST_CHECK(!CompressedMesh::DecodeMesh(Inflated.data(), Inflated.size(), Decoded), "inflated header counts were accepted");
+	GSIO_TEST_CHECK(Decoded.GetTriangleCount() == 0 && Decoded.GetVertexCount() == 0, "mesh was allocated for inflated header counts");
+}
+
+
+static void test_non_finite_rejected(const DenseMesh& Mesh)
+{
+	const double NonFiniteValues[3] = { std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity() };
+	for (double Value : NonFiniteValues)
+	{
+		std::vector<uint8_t> Encoded;
+		DenseMesh BadPosition = Mesh;
+		Vector3d Position = BadPosition.GetPosition(7);
+		Position[1] = Value;
+		BadPosition.SetPosition(7, Position);
+		GSIO_TEST_CHECK(!CompressedMesh::EncodeMesh(BadPosition, Encoded), "position %f was accepted", Value);
+		GSIO_TEST_CHECK(Encoded.empty(), "output was not empty for position %f", Value);
+
+		DenseMesh BadUV = Mesh;
+		TriVtxUVs UVs = BadUV.GetTriVtxUVs(11);
+		UVs[2].X = (float)Value;
+		BadUV.SetTriVtxUVs(11, UVs);
+		GSIO_TEST_CHECK(!CompressedMesh::EncodeMesh(BadUV, Encoded), "UV %f was accepted", Value);
+		CompressedMesh::EncodeOptions NoUVs;
+		NoUVs.UVBits = 0;
+		GSIO_TEST_CHECK(CompressedMesh::EncodeMesh(BadUV, Encoded, NoUVs), "UV %f was rejected with UVBits = 0", Value);
+	}
+
+	// finite positions whose bounding box extent overflows cannot be quantized either
+	DenseMesh HugeRange = Mesh;
+	HugeRange.SetPosition(0, Vector3d(-1e308, 0, 0));
+	HugeRange.SetPosition(1, Vector3d(1e308, 0, 0));
+	std::vector<uint8_t> Encoded;
+	GSIO_TEST_CHECK(!CompressedMesh::EncodeMesh(HugeRange, Encoded), "overflowing position range was accepted");
+}
+
+
+int main()
+{
+	DenseMesh Mesh;
+	make_torus(64, 24, Mesh);
+
+	test_round_trip_bounds(Mesh, 16, 10, 12);
+	test_round_trip_bounds(Mesh, 24, 16, 20);
+	test_round_trip_bounds(Mesh, 8, 4, 6);
+	test_invalid_data_rejected(Mesh);
+	test_non_finite_rejected(Mesh);
+
+	if (NumFailures > 0)
+		printf("CompressedMeshTests: %d checks failed\n", NumFailures);
+	else
+		printf("CompressedMeshTests: all checks passed\n");
+	return (NumFailures > 0) ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,164 @@
+// Copyright Gradientspace Corp. All Rights Reserved.
+#if defined(GSIO_TEST_BUILD)
+
+#include "MeshIO/OBJFormatData.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <vector>
+
+using namespace GS;
+
+/**
+ * Tests for DenseMeshToOBJFormatData. Checks that the deduplicated normals/UVs and the face indices
+ * are the same as inserting the corner values in order into a by-value map (the sequential
+ * AttributeCompressor path), for any thread count. Returns nonzero if any check fails.
+ */
+
+static int NumFailures = 0;
+
+#define GSIO_TEST_CHECK(Condition, ...) \
+	do { if (!(Condition)) { NumFailures++; printf("FAILED (line %d): ", __LINE__); printf(__VA_ARGS__); printf("\n"); } } while(0)
+
+
+// NumTriangles triangles whose corner normals/UVs are drawn from a small set of values, including
+// -0/+0 pairs and NaNs with different payloads, so that many corners share a value
+static void make_attribute_mesh(int NumTriangles, DenseMesh& MeshOut)
+{
+	float NaN = std::numeric_limits<float>::quiet_NaN();
+	uint32_t OtherNaNBits = 0xffc01234u;
+	float OtherNaN;
+	memcpy(&OtherNaN, &OtherNaNBits, sizeof(float));
+	const float Values[] = { 0.0f, -0.0f, 0.5f, -0.5f, 1.0f, NaN, OtherNaN, 0.25f };
+	const int NumValues = (int)(sizeof(Values) / sizeof(Values[0]));
+
+	MeshOut.Resize(3 * NumTriangles, NumTriangles);
+	uint32_t Random = 12345;
+	auto NextValue = [&]() { Random = Random * 1664525u + 1013904223u; return Values[(Random >> 16) % NumValues]; };
+	for (int ti = 0; ti < NumTriangles; ++ti)
+	{
+		TriVtxNormals Normals;
+		TriVtxUVs UVs;
+		for (int j = 0; j < 3; ++j)
+		{
+			MeshOut.SetPosition(3*ti + j, Vector3d((double)ti, (double)j, 0));
+			Normals[j] = Vector3f(NextValue(), NextValue(), NextValue());
+			UVs[j] = Vector2f(NextValue(), NextValue());
+		}
+		MeshOut.SetTriangle(ti, Index3i(3*ti, 3*ti + 1, 3*ti + 2));
+		MeshOut.SetTriGroup(ti, ti % 3);
+		MeshOut.SetTriVtxNormals(ti, Normals);
+		MeshOut.SetTriVtxUVs(ti, UVs);
+	}
+}
+
+// value compare of float components, with all NaNs equal (a map cannot hold NaN keys otherwise)
+template<int NumComponents>
+struct FloatValueLess
+{
+	bool operator()(const std::vector<float>& A, const std::vector<float>& B) const
+	{
+		for (int k = 0; k < NumComponents; ++k)
+		{
+			bool bNaNA = std::isnan(A[k]), bNaNB = std::isnan(B[k]);
+			if (bNaNA != bNaNB) return bNaNA < bNaNB;
+			if (!bNaNA && A[k] != B[k]) return A[k] < B[k];
+		}
+		return false;
+	}
+};
+
+// index of each corner value in order of first occurrence, ie the sequential insert-into-a-map path
+template<int NumComponents, typename GetValueFuncType>
+static std::vector<int> index_values_sequential(size_t NumCorners, GetValueFuncType GetValue, std::vector<std::vector<float>>& UniqueOut)
+{
+	std::map<std::vector<float>, int, FloatValueLess<NumComponents>> ValueIndex;
+	std::vector<int> CornerIndices(NumCorners);
+	for (size_t Corner = 0; Corner < NumCorners; ++Corner)
+	{
+		std::vector<float> Value = GetValue(Corner);
+		auto Found = ValueIndex.find(Value);
+		if (Found == ValueIndex.end())
+		{
+			Found = ValueIndex.insert({ Value, (int)UniqueOut.size() }).first;
+			UniqueOut.push_back(Value);
+		}
+		CornerIndices[Corner] = Found->second;
+	}
+	return CornerIndices;
+}
+
+static bool same_value(double A, float B)
+{
+	return (std::isnan(A) && std::isnan(B)) || (A == (double)B && std::signbit(A) == std::signbit(B));
+}
+
+static void test_matches_sequential_dedup(const DenseMesh& Mesh, int NumThreads)
+{
+	int NumTriangles = Mesh.GetTriangleCount();
+	size_t NumCorners = 3 * (size_t)NumTriangles;
+
+	std::vector<std::vector<float>> ExpectedNormals, ExpectedUVs;
+	std::vector<int> CornerNormals = index_values_sequential<3>(NumCorners, [&](size_t Corner) {
+		Vector3f Normal = Mesh.GetTriVtxNormals((int)(Corner/3))[(int)(Corner%3)];
+		return std::vector<float>{ Normal.X, Normal.Y, Normal.Z };
+	}, ExpectedNormals);
+	std::vector<int> CornerUVs = index_values_sequential<2>(NumCorners, [&](size_t Corner) {
+		Vector2f UV = Mesh.GetTriVtxUVs((int)(Corner/3))[(int)(Corner%3)];
+		return std::vector<float>{ UV.X, UV.Y };
+	}, ExpectedUVs);
+
+	OBJFormatData OBJData;
+	DenseMeshToOBJOptions Options;
+	Options.NumThreads = NumThreads;
+	DenseMeshToOBJFormatData(Mesh, OBJData, Options);
+
+	GSIO_TEST_CHECK(OBJData.Normals.size() == ExpectedNormals.size(), "%d threads: %d normals, expected %d", NumThreads, (int)OBJData.Normals.size(), (int)ExpectedNormals.size());
+	GSIO_TEST_CHECK(OBJData.UVs.size() == ExpectedUVs.size(), "%d threads: %d UVs, expected %d", NumThreads, (int)OBJData.UVs.size(), (int)ExpectedUVs.size());
+	if (OBJData.Normals.size() != ExpectedNormals.size() || OBJData.UVs.size() != ExpectedUVs.size())
+		return;
+
+	// each unique value is the value of its first corner, including the sign of zero
+	for (size_t i = 0; i < ExpectedNormals.size(); ++i)
+		GSIO_TEST_CHECK(same_value(OBJData.Normals[i].X, ExpectedNormals[i][0]) && same_value(OBJData.Normals[i].Y, ExpectedNormals[i][1])
+			&& same_value(OBJData.Normals[i].Z, ExpectedNormals[i][2]), "%d threads: normal %d differs", NumThreads, (int)i);
+	for (size_t i = 0; i < ExpectedUVs.size(); ++i)
+		GSIO_TEST_CHECK(same_value(OBJData.UVs[i].X, ExpectedUVs[i][0]) && same_value(OBJData.UVs[i].Y, ExpectedUVs[i][1]),
+			"%d threads: UV %d differs", NumThreads, (int)i);
+
+	// faces are sorted by group, so the corner of each face is found via the positions (vertex 3*ti+j is corner j of triangle ti)
+	GSIO_TEST_CHECK(OBJData.Triangles.size() == (size_t)NumTriangles, "%d threads: %d triangles, expected %d", NumThreads, (int)OBJData.Triangles.size(), NumTriangles);
+	int NumIndexMismatches = 0;
+	for (size_t fi = 0; fi < OBJData.Triangles.size(); ++fi)
+	{
+		OBJTriangle Triangle = OBJData.Triangles[fi];
+		for (int j = 0; j < 3; ++j)
+		{
+			int Corner = Triangle.Positions[j];
+			if (Triangle.Normals[j] != CornerNormals[Corner] || Triangle.UVs[j] != CornerUVs[Corner])
+				NumIndexMismatches++;
+		}
+	}
+	GSIO_TEST_CHECK(NumIndexMismatches == 0, "%d threads: %d corner normal/UV indices differ", NumThreads, NumIndexMismatches);
+}
+
+
+int main()
+{
+	DenseMesh Mesh;
+	make_attribute_mesh(20000, Mesh);
+
+	for (int NumThreads : { 1, 2, 7 })
+		test_matches_sequential_dedup(Mesh, NumThreads);
+
+	if (NumFailures > 0)
+		printf("OBJFormatDataTests: %d checks failed\n", NumFailures);
+	else
+		printf("OBJFormatDataTests: all checks passed\n");
+	return (NumFailures > 0) ? 1 : 0;
+}
+
+#endif